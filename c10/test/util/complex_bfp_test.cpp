@@ -0,0 +1,180 @@
+#include <c10/test/util/complex_test_common.h>
+#include <c10/util/complex_bfp.h>
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <limits>
+#include <mutex>
+#include <random>
+#include <stdexcept>
+#include <vector>
+
+namespace bfp {
+
+// |a - b| within the quantization step of a block whose largest part is m
+bool close(c10::complex<float> a, c10::complex<float> b, float m, int bits, float steps = 0.5f) {
+  int e;
+  std::frexp(m, &e);
+  const float step = std::ldexp(1.0f, e - (bits - 1));
+  return std::abs(a.real() - b.real()) <= steps * step && std::abs(a.imag() - b.imag()) <= steps * step;
+}
+
+float block_max(const std::vector<c10::complex<float>>& x, int64_t b, int64_t block_size) {
+  float m = 0;
+  for (int64_t i = b * block_size; i < std::min<int64_t>(x.size(), (b + 1) * block_size); i++) {
+    m = std::max({m, std::abs(x[i].real()), std::abs(x[i].imag())});
+  }
+  return m;
+}
+
+void test_round_trip() {
+  std::mt19937 gen(5);
+  std::normal_distribution<float> normal;
+  std::vector<c10::complex<float>> x(1000);
+  for (size_t i = 0; i < x.size(); i++) {
+    // a dynamic range that changes between blocks
+    const float scale = std::ldexp(1.0f, static_cast<int>(i / 64) * 9 - 60);
+    x[i] = c10::complex<float>(normal(gen) * scale, normal(gen) * scale);
+  }
+  x[5] = c10::complex<float>(0, 0);
+  x[999] = c10::complex<float>(-std::numeric_limits<float>::max(), 1);
+  for (int bits : {8, 12, 16}) {
+    c10::complex_bfp b(x.data(), x.size(), bits);
+    ASSERT_EQ(b.bytes(), static_cast<int64_t>(x.size() * bits / 4 + b.num_blocks() * 2));
+    ASSERT_EQ(b.num_blocks(), 16);
+    auto y = b.decode();
+    for (size_t i = 0; i < x.size(); i++) {
+      // a whole step where the largest part rounds up to 2^(bits - 1)
+      ASSERT_EQ(close(y[i], x[i], block_max(x, i / 64, 64), bits, i == 999 ? 1.0f : 0.5f), true);
+      ASSERT_EQ(b[i], y[i]);
+    }
+    ASSERT_EQ(y[5], c10::complex<float>(0, 0));
+  }
+  // exact for small integers, subnormals and an all zero block
+  std::vector<c10::complex<float>> small = {{1, -2}, {3, 127}, {-127, 0}};
+  c10::complex_bfp s(small.data(), small.size(), 8, 2);
+  for (size_t i = 0; i < small.size(); i++) {
+    ASSERT_EQ(s[i], small[i]);
+  }
+  const float tiny = std::numeric_limits<float>::denorm_min();
+  std::vector<c10::complex<float>> sub = {{tiny * 3, -tiny}, {0, 0}};
+  c10::complex_bfp t(sub.data(), 2, 16, 1);
+  ASSERT_EQ(t[0], sub[0]);
+  ASSERT_EQ(t[1], sub[1]);
+
+  bool thrown = false;
+  try {
+    std::vector<c10::complex<float>> bad = {{1, std::numeric_limits<float>::infinity()}};
+    c10::complex_bfp(bad.data(), 1);
+  } catch (const std::invalid_argument&) {
+    thrown = true;
+  }
+  ASSERT_EQ(thrown, true);
+  // a NaN before a larger finite part
+  thrown = false;
+  try {
+    std::vector<c10::complex<float>> bad = {{std::numeric_limits<float>::quiet_NaN(), 1}, {0.5f, 0.25f}};
+    c10::complex_bfp(bad.data(), 2);
+  } catch (const std::invalid_argument&) {
+    thrown = true;
+  }
+  ASSERT_EQ(thrown, true);
+}
+
+void test_kernels() {
+  std::mt19937 gen(6);
+  std::uniform_real_distribution<float> u(-1, 1);
+  const int64_t n = 300, block = 32;
+  std::vector<c10::complex<float>> x(n), y(n);
+  for (int64_t i = 0; i < n; i++) {
+    x[i] = c10::complex<float>(u(gen), u(gen)) * 1000.0f;
+    y[i] = c10::complex<float>(u(gen), u(gen)) * (i < 64 ? 1e-3f : 1.0f);
+  }
+  for (int bits : {8, 12, 16}) {
+    const c10::complex_bfp bx(x.data(), n, bits, block), by(y.data(), n, bits, block);
+    const auto dx = bx.decode(), dy = by.decode();
+    c10::complex_bfp out;
+    c10::bulk::mul(bx, by, out);
+    std::vector<c10::complex<float>> expected(n);
+    for (int64_t i = 0; i < n; i++) {
+      expected[i] = dx[i] * dy[i];
+    }
+    auto r = out.decode();
+    for (int64_t i = 0; i < n; i++) {
+      // exact products of the decoded values, rounded once
+      ASSERT_EQ(close(r[i], expected[i], block_max(expected, i / block, block), bits, 1.0f), true);
+    }
+    c10::bulk::add(bx, by, out);
+    for (int64_t i = 0; i < n; i++) {
+      expected[i] = dx[i] + dy[i];
+    }
+    r = out.decode();
+    for (int64_t i = 0; i < n; i++) {
+      ASSERT_EQ(close(r[i], expected[i], block_max(expected, i / block, block), bits, 1.0f), true);
+    }
+    c10::complex_bfp c = bx;
+    c10::bulk::conj(c, c);
+    c.ldexp(-3);
+    for (int64_t i = 0; i < n; i++) {
+      ASSERT_EQ(c[i], std::conj(dx[i]) / 8.0f);
+    }
+    // in place
+    c = bx;
+    c10::bulk::mul(c, by, c);
+    c10::bulk::mul(bx, by, out);
+    for (int64_t i = 0; i < n; i++) {
+      ASSERT_EQ(c[i], out[i]);
+    }
+  }
+  bool thrown = false;
+  try {
+    c10::complex_bfp a(x.data(), n, 8), b(y.data(), n, 16), out;
+    c10::bulk::add(a, b, out);
+  } catch (const std::invalid_argument&) {
+    thrown = true;
+  }
+  ASSERT_EQ(thrown, true);
+}
+
+void test_parallel() {
+  std::vector<c10::complex<float>> x(300000);
+  for (size_t i = 0; i < x.size(); i++) {
+    x[i] = c10::complex<float>(std::sin(i * 0.01f), std::cos(i * 0.013f));
+  }
+  c10::set_num_threads(1);
+  c10::complex_bfp a(x.data(), x.size(), 12);
+  c10::set_num_threads(4);
+  c10::complex_bfp b(x.data(), x.size(), 12);
+  ASSERT_EQ(std::equal(a.mantissas(), a.mantissas() + x.size() * 3, b.mantissas()), true);
+  auto y = b.decode();
+  for (size_t i = 0; i < x.size(); i += 997) {
+    ASSERT_EQ(y[i], a[i]);
+  }
+  // buffers can be placed like the blocks are split between threads
+  const c10::numa_options options = c10::bfp_numa_options(c10::bfp_default_block_size);
+  const size_t bytes = x.size() * sizeof(c10::complex<float>);
+  std::vector<size_t> chunks;
+  std::mutex mutex;
+  c10::parallel_for(0, b.num_blocks(), b.block_grain(), [&](int64_t begin, int64_t) {
+    std::lock_guard<std::mutex> guard(mutex);
+    chunks.push_back(begin * b.block_size() * sizeof(c10::complex<float>));
+  });
+  std::sort(chunks.begin(), chunks.end());
+  chunks.push_back(bytes);
+  ASSERT_EQ(c10::detail::numa_chunk_offsets(bytes, sizeof(c10::complex<float>), options), chunks);
+  c10::complex_buffer<float> placed(x.size(), options);
+  b.decode(placed.data());
+  for (size_t i = 0; i < x.size(); i += 997) {
+    ASSERT_EQ(placed[i], y[i]);
+  }
+  c10::set_num_threads(0);
+}
+
+} // namespace bfp
+
+int main() {
+  bfp::test_round_trip();
+  bfp::test_kernels();
+  bfp::test_parallel();
+}
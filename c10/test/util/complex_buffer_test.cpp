@@ -0,0 +1,171 @@
+#include <c10/test/util/complex_test_common.h>
+#include <c10/util/complex_buffer.h>
+#include <c10/util/complex_span.h>
+
+#include <algorithm>
+#include <cstdint>
+#include <mutex>
+#include <thread>
+#include <utility>
+#include <vector>
+
+namespace buffer {
+
+template<typename scalar_t>
+void test_buffer_() {
+  c10::complex_buffer<scalar_t> empty;
+  ASSERT_EQ(empty.size(), 0);
+  ASSERT_EQ(empty.data(), nullptr);
+
+  c10::complex_buffer<scalar_t> b(100, c10::complex<scalar_t>(1, 2));
+  ASSERT_EQ(b.size(), 100);
+  ASSERT_EQ(reinterpret_cast<uintptr_t>(b.data()) % c10::buffer_alignment, 0);
+  for (const auto& z : b) {
+    ASSERT_EQ(z, c10::complex<scalar_t>(1, 2));
+  }
+  // buffers are containers for c10::span
+  c10::span<c10::complex<scalar_t>> s = b;
+  ASSERT_EQ(s.data(), b.data());
+  ASSERT_EQ(s.size(), 100);
+
+  // moving keeps the data
+  auto data = b.data();
+  c10::complex_buffer<scalar_t> moved = std::move(b);
+  ASSERT_EQ(moved.data(), data);
+  ASSERT_EQ(b.data(), nullptr);
+  b = std::move(moved);
+  ASSERT_EQ(b.data(), data);
+}
+
+void test_buffer() {
+  test_buffer_<c10::Half>();
+  test_buffer_<float>();
+  test_buffer_<double>();
+}
+
+void test_pool() {
+  c10::release_cached_buffers();
+  auto before = c10::get_buffer_stats();
+  const c10::complex<double>* first;
+  {
+    c10::complex_buffer<double> b(1000);
+    first = b.data();
+  }
+  // the same size class reuses the block
+  for (int i = 0; i < 10; i++) {
+    c10::complex_buffer<double> b(900 + i);
+    ASSERT_EQ(b.data(), first);
+  }
+  auto after = c10::get_buffer_stats();
+  ASSERT_EQ(after.requests - before.requests, 11);
+  ASSERT_EQ(after.reused - before.reused, 10);
+  ASSERT_EQ(after.system_allocations - before.system_allocations, 1);
+  ASSERT_EQ(after.cached_bytes, before.cached_bytes + 16384);
+  // two buffers alive at the same time need two blocks
+  {
+    c10::complex_buffer<double> b1(1000), b2(1000);
+    ASSERT_EQ(b1.data() != b2.data(), true);
+  }
+  c10::release_cached_buffers();
+  ASSERT_EQ(c10::get_buffer_stats().cached_bytes, before.cached_bytes);
+
+  // buffers can be freed by another thread, which then caches the block
+  c10::complex_buffer<float> shared(5000);
+  std::thread([&] {
+    shared.reset();
+    ASSERT_EQ(c10::get_buffer_stats().cached_bytes > before.cached_bytes, true);
+  }).join();
+  // and the thread's cache is freed when it exits
+  ASSERT_EQ(c10::get_buffer_stats().cached_bytes, before.cached_bytes);
+}
+
+void test_huge_pages() {
+  // blocks of 2 MiB and more are aligned to 2 MiB
+  c10::complex_buffer<double> b(int64_t(1) << 18);
+  ASSERT_EQ(reinterpret_cast<uintptr_t>(b.data()) % c10::buffer_huge_page_size, 0);
+  b[(int64_t(1) << 18) - 1] = c10::complex<double>(1, 1);
+  // blocks larger than the pool limit are not cached
+  auto before = c10::get_buffer_stats();
+  {
+    c10::complex_buffer<float> big((c10::buffer_max_pooled_bytes / sizeof(c10::complex<float>)) + 1);
+  }
+  ASSERT_EQ(c10::get_buffer_stats().cached_bytes, before.cached_bytes);
+  // and are only rounded up to their alignment, not to a power of two
+  const size_t mib = size_t(1) << 20;
+  ASSERT_EQ(c10::detail::buffer_block_size(300 * mib), 300 * mib);
+  ASSERT_EQ(c10::detail::buffer_block_size(300 * mib + 1), 302 * mib);
+  ASSERT_EQ(c10::detail::buffer_block_size(3 * mib), 4 * mib);
+  ASSERT_EQ(c10::detail::buffer_block_size(c10::buffer_max_pooled_bytes), c10::buffer_max_pooled_bytes);
+  ASSERT_EQ(c10::detail::buffer_block_size(1), c10::buffer_alignment);
+}
+
+void test_numa() {
+  ASSERT_EQ(c10::get_numa_num_nodes() >= 1, true);
+  c10::set_num_threads(4);
+  const int64_t n = 300001;
+  for (auto placement : {c10::numa_placement::none, c10::numa_placement::interleave, c10::numa_placement::partition}) {
+    auto before = c10::get_buffer_stats();
+    {
+      c10::numa_options options;
+      options.placement = placement;
+      options.grain_size = 1000;
+      c10::complex_buffer<double> b(n, options);
+      ASSERT_EQ(b.size(), n);
+      ASSERT_EQ(reinterpret_cast<uintptr_t>(b.data()) % c10::buffer_huge_page_size, 0);
+      // first touch zeroes every element
+      for (const auto& z : b) {
+        ASSERT_EQ(z, c10::complex<double>(0, 0));
+      }
+      b[n - 1] = c10::complex<double>(1, 2);
+      c10::complex_buffer<double> moved = std::move(b);
+      ASSERT_EQ(moved[n - 1], c10::complex<double>(1, 2));
+    }
+    // NUMA buffers do not use the pool
+    auto after = c10::get_buffer_stats();
+    ASSERT_EQ(after.requests - before.requests, 1);
+    ASSERT_EQ(after.reused, before.reused);
+    ASSERT_EQ(after.cached_bytes, before.cached_bytes);
+    ASSERT_EQ(after.numa_placed - before.numa_placed <= 1, true);
+    if (placement == c10::numa_placement::none) {
+      ASSERT_EQ(after.numa_placed, before.numa_placed);
+    }
+  }
+  // the partition is that of parallel_for over the units of the options
+  for (size_t unit : {size_t(0), size_t(8), size_t(1000)}) {
+    c10::numa_options options;
+    options.grain_size = 100;
+    options.unit_bytes = unit;
+    const size_t bytes = n * sizeof(c10::complex<double>);
+    const size_t u = unit == 0 ? sizeof(c10::complex<double>) : unit;
+    std::vector<size_t> expected;
+    std::mutex mutex;
+    c10::parallel_for(0, (bytes + u - 1) / u, options.grain_size, [&](int64_t begin, int64_t) {
+      std::lock_guard<std::mutex> guard(mutex);
+      expected.push_back(begin * u);
+    });
+    std::sort(expected.begin(), expected.end());
+    expected.push_back(bytes);
+    ASSERT_EQ(c10::detail::numa_chunk_offsets(bytes, sizeof(c10::complex<double>), options), expected);
+    // and first touch zeroes the partial last unit
+    c10::complex_buffer<double> b(n, options);
+    for (const auto& z : b) {
+      ASSERT_EQ(z, c10::complex<double>(0, 0));
+    }
+  }
+  // small buffers, without first touch
+  c10::numa_options options;
+  options.first_touch = false;
+  c10::complex_buffer<float> small(3, options);
+  small[2] = c10::complex<float>(3, 4);
+  ASSERT_EQ(small[2], c10::complex<float>(3, 4));
+  c10::set_num_threads(0);
+}
+
+} // namespace buffer
+
+int main() {
+  buffer::test_buffer();
+  buffer::test_pool();
+  buffer::test_huge_pages();
+  buffer::test_numa();
+}
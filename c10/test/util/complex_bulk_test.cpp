@@ -0,0 +1,343 @@
+#include <c10/test/util/complex_test_common.h>
+#include <c10/util/complex_bulk.h>
+
+#include <cmath>
+#include <limits>
+#include <random>
+#include <vector>
+
+namespace bulk_common {
+
+template<typename scalar_t>
+scalar_t tolerance() {
+  return std::is_same<scalar_t, float>::value ? scalar_t(2e-6) : scalar_t(1e-14);
+}
+
+template<typename scalar_t>
+bool same_nan(scalar_t a, scalar_t b) {
+  return std::isnan(a) && std::isnan(b);
+}
+
+// Checks that actual is within tolerance of expected relative to |expected|.
+// Special values (inf and nan) have to match exactly
+template<typename scalar_t>
+bool close(c10::complex<scalar_t> actual, c10::complex<scalar_t> expected, scalar_t tol = tolerance<scalar_t>()) {
+  for (int part = 0; part < 2; part++) {
+    scalar_t a = part == 0 ? actual.real() : actual.imag();
+    scalar_t e = part == 0 ? expected.real() : expected.imag();
+    if (!std::isfinite(e) || !std::isfinite(a)) {
+      if (!(a == e || same_nan(a, e))) {
+        return false;
+      }
+    }
+  }
+  if (!std::isfinite(expected.real()) || !std::isfinite(expected.imag())) {
+    return true;
+  }
+  scalar_t scale = std::max(std::abs(expected), std::numeric_limits<scalar_t>::min());
+  return std::abs(actual - expected) <= tol * scale;
+}
+
+// Random values with magnitudes spread over [10^-lo, 10^hi] and random signs
+template<typename scalar_t>
+std::vector<c10::complex<scalar_t>> random_inputs(int64_t n, scalar_t lo, scalar_t hi, unsigned seed = 0) {
+  std::mt19937 gen(seed);
+  std::uniform_real_distribution<scalar_t> exponent(-lo, hi);
+  std::bernoulli_distribution sign(0.5);
+  std::vector<c10::complex<scalar_t>> result(n);
+  for (auto& v : result) {
+    scalar_t re = std::pow(scalar_t(10), exponent(gen));
+    scalar_t im = std::pow(scalar_t(10), exponent(gen));
+    v = c10::complex<scalar_t>(sign(gen) ? re : -re, sign(gen) ? im : -im);
+  }
+  return result;
+}
+
+template<typename scalar_t>
+std::vector<c10::complex<scalar_t>> special_inputs() {
+  const scalar_t inf = std::numeric_limits<scalar_t>::infinity();
+  const scalar_t nan = std::numeric_limits<scalar_t>::quiet_NaN();
+  const scalar_t big = std::numeric_limits<scalar_t>::max();
+  const scalar_t tiny = std::numeric_limits<scalar_t>::denorm_min();
+  std::vector<scalar_t> values = {scalar_t(0), -scalar_t(0), scalar_t(1), scalar_t(-1), scalar_t(0.5), inf, -inf, nan, big, -big, tiny, -tiny};
+  std::vector<c10::complex<scalar_t>> result;
+  for (scalar_t re : values) {
+    for (scalar_t im : values) {
+      result.emplace_back(re, im);
+    }
+  }
+  return result;
+}
+
+// Runs a bulk unary function on inputs and compares with the scalar function
+template<typename scalar_t, typename Bulk, typename Scalar>
+void check_unary(const std::vector<c10::complex<scalar_t>>& inputs, Bulk bulk, Scalar scalar, scalar_t tol = tolerance<scalar_t>()) {
+  std::vector<c10::complex<scalar_t>> out(inputs.size());
+  bulk(inputs.data(), out.data(), static_cast<int64_t>(inputs.size()));
+  for (size_t i = 0; i < inputs.size(); i++) {
+    if (!close(out[i], scalar(inputs[i]), tol)) {
+      std::cerr << "input " << inputs[i] << ": got " << out[i] << ", expected " << scalar(inputs[i]) << std::endl;
+      assert(false);
+    }
+  }
+  // in-place
+  std::vector<c10::complex<scalar_t>> inplace = inputs;
+  bulk(inplace.data(), inplace.data(), static_cast<int64_t>(inplace.size()));
+  for (size_t i = 0; i < inputs.size(); i++) {
+    ASSERT_EQ(std::memcmp(&inplace[i], &out[i], sizeof(out[i])), 0);
+  }
+}
+
+} // namespace bulk_common
+
+namespace bulk_exp_log_pow {
+
+using namespace bulk_common;
+
+template<typename scalar_t>
+void test_exp_() {
+  auto bulk = [](const c10::complex<scalar_t>* x, c10::complex<scalar_t>* out, int64_t n) { c10::bulk::exp(x, out, n); };
+  auto scalar = [](c10::complex<scalar_t> x) { return std::exp(x); };
+  check_unary(random_inputs<scalar_t>(1001, 3, 1.5), bulk, scalar);
+  check_unary(special_inputs<scalar_t>(), bulk, scalar);
+  // e^re overflows, e^re * cos(im) does not
+  scalar_t big = std::is_same<scalar_t, float>::value ? scalar_t(89) : scalar_t(710);
+  check_unary(std::vector<c10::complex<scalar_t>>{{big, scalar_t(1.2)}, {-big, scalar_t(3)}}, bulk, scalar);
+}
+
+template<typename scalar_t>
+void test_log_() {
+  auto bulk = [](const c10::complex<scalar_t>* x, c10::complex<scalar_t>* out, int64_t n) { c10::bulk::log(x, out, n); };
+  auto scalar = [](c10::complex<scalar_t> x) { return std::log(x); };
+  check_unary(random_inputs<scalar_t>(1001, 30, 30), bulk, scalar);
+  check_unary(special_inputs<scalar_t>(), bulk, scalar);
+}
+
+template<typename scalar_t>
+void test_pow_() {
+  auto x = random_inputs<scalar_t>(333, 2, 2, 1);
+  auto y = random_inputs<scalar_t>(333, 2, 0.5, 2);
+  std::vector<c10::complex<scalar_t>> out(x.size());
+  scalar_t tol = tolerance<scalar_t>() * 50;  // exp(y * log(x)) amplifies the error of the product
+  c10::bulk::pow(x.data(), y.data(), out.data(), static_cast<int64_t>(x.size()));
+  for (size_t i = 0; i < x.size(); i++) {
+    assert(close(out[i], std::pow(x[i], y[i]), tol));
+  }
+  c10::bulk::pow(x.data(), y[0], out.data(), static_cast<int64_t>(x.size()));
+  for (size_t i = 0; i < x.size(); i++) {
+    assert(close(out[i], std::pow(x[i], y[0]), tol));
+  }
+  c10::bulk::pow(x.data(), scalar_t(2.5), out.data(), static_cast<int64_t>(x.size()));
+  for (size_t i = 0; i < x.size(); i++) {
+    assert(close(out[i], std::pow(x[i], scalar_t(2.5)), tol));
+  }
+  auto special = special_inputs<scalar_t>();
+  std::vector<c10::complex<scalar_t>> ones(special.size(), c10::complex<scalar_t>(1, 1));
+  out.resize(special.size());
+  c10::bulk::pow(special.data(), ones.data(), out.data(), static_cast<int64_t>(special.size()));
+  for (size_t i = 0; i < special.size(); i++) {
+    assert(close(out[i], std::pow(special[i], ones[i]), tol));
+  }
+}
+
+void test_exp_log_pow() {
+  test_exp_<float>();
+  test_exp_<double>();
+  test_log_<float>();
+  test_log_<double>();
+  test_pow_<float>();
+  test_pow_<double>();
+}
+
+} // namespace bulk_exp_log_pow
+
+namespace bulk_trig {
+
+using namespace bulk_common;
+
+#define CHECK_BULK_UNARY(func, inputs)                                                          \
+  check_unary(inputs,                                                                           \
+      [](const c10::complex<scalar_t>* x, c10::complex<scalar_t>* out, int64_t n) { c10::bulk::func(x, out, n); }, \
+      [](c10::complex<scalar_t> x) { return std::func(x); })
+
+template<typename scalar_t>
+void test_trig_() {
+  for (auto inputs : {random_inputs<scalar_t>(1001, 4, 1.5), special_inputs<scalar_t>()}) {
+    CHECK_BULK_UNARY(sin, inputs);
+    CHECK_BULK_UNARY(cos, inputs);
+    CHECK_BULK_UNARY(tan, inputs);
+    CHECK_BULK_UNARY(sinh, inputs);
+    CHECK_BULK_UNARY(cosh, inputs);
+    CHECK_BULK_UNARY(tanh, inputs);
+  }
+}
+
+void test_trig() {
+  test_trig_<float>();
+  test_trig_<double>();
+}
+
+} // namespace bulk_trig
+
+namespace bulk_sqrt {
+
+using namespace bulk_common;
+
+template<typename scalar_t>
+void test_sqrt_() {
+  // magnitudes close to the overflow and underflow thresholds
+  scalar_t range = std::numeric_limits<scalar_t>::max_exponent10 - 1;
+  // in long double, where 1 / sqrt(z) is computed without overflow
+  auto rsqrt = [](c10::complex<scalar_t> x) {
+    auto r = 1.0L / std::sqrt(std::complex<long double>(x.real(), x.imag()));
+    return c10::complex<scalar_t>(static_cast<scalar_t>(r.real()), static_cast<scalar_t>(r.imag()));
+  };
+  auto bulk_rsqrt = [](const c10::complex<scalar_t>* x, c10::complex<scalar_t>* out, int64_t n) { c10::bulk::rsqrt(x, out, n); };
+  for (auto inputs : {random_inputs<scalar_t>(1001, 3, 3), random_inputs<scalar_t>(1001, range, range, 1), special_inputs<scalar_t>()}) {
+    CHECK_BULK_UNARY(sqrt, inputs);
+    check_unary(inputs, bulk_rsqrt, rsqrt);
+  }
+  // the small part of the result does not underflow in the scaled domain
+  scalar_t big = std::numeric_limits<scalar_t>::max() / 4;
+  scalar_t small = std::numeric_limits<scalar_t>::min() * 4;
+  CHECK_BULK_UNARY(sqrt, (std::vector<c10::complex<scalar_t>>{{big, small}, {-big, small}, {small, -big}, {-small, big}}));
+}
+
+void test_sqrt() {
+  test_sqrt_<float>();
+  test_sqrt_<double>();
+}
+
+} // namespace bulk_sqrt
+
+namespace bulk_inverse {
+
+using namespace bulk_common;
+
+template<typename scalar_t>
+void test_inverse_() {
+  // around the crossovers of the main region, and the exception regions
+  std::vector<c10::complex<scalar_t>> edges;
+  for (scalar_t re : {scalar_t(0.3), scalar_t(0.9), scalar_t(1), scalar_t(1.1), scalar_t(3)}) {
+    for (scalar_t im : {scalar_t(1e-20), scalar_t(1e-3), scalar_t(0.5), scalar_t(2), scalar_t(1e20)}) {
+      edges.emplace_back(re, im);
+      edges.emplace_back(-re, -im);
+    }
+  }
+  for (auto inputs : {random_inputs<scalar_t>(1001, 5, 5), special_inputs<scalar_t>(), edges}) {
+    CHECK_BULK_UNARY(asin, inputs);
+    CHECK_BULK_UNARY(acos, inputs);
+    CHECK_BULK_UNARY(atan, inputs);
+    CHECK_BULK_UNARY(asinh, inputs);
+    CHECK_BULK_UNARY(acosh, inputs);
+    CHECK_BULK_UNARY(atanh, inputs);
+  }
+}
+
+void test_inverse() {
+  test_inverse_<float>();
+  test_inverse_<double>();
+}
+
+} // namespace bulk_inverse
+
+namespace bulk_fma {
+
+using namespace bulk_common;
+
+template<typename scalar_t>
+void test_fma_() {
+  const scalar_t eps = std::numeric_limits<scalar_t>::epsilon();
+  // sizes around the block size, with tails
+  for (int64_t n : {0, 1, 7, 16, 33, 1001}) {
+    auto x = random_inputs<scalar_t>(n, 1, 1, 2);
+    auto y = random_inputs<scalar_t>(n, 1, 1, 3);
+    const c10::complex<scalar_t> alpha(scalar_t(0.75), scalar_t(-1.25));
+    auto out = y;
+    c10::bulk::axpy(alpha, x.data(), out.data(), n);
+    std::complex<long double> dot(0, 0), vdot(0, 0);
+    long double bound = 0;
+    for (int64_t i = 0; i < n; i++) {
+      // the products may be rounded before the addition, see [Bulk multiply-add]
+      scalar_t scale = std::abs(alpha) * std::abs(x[i]) + std::abs(y[i]);
+      ASSERT_EQ(std::abs(out[i] - c10::fma(alpha, x[i], y[i])) <= 4 * eps * scale, true);
+      std::complex<long double> xl(x[i].real(), x[i].imag()), yl(y[i].real(), y[i].imag());
+      dot += xl * yl;
+      vdot += std::conj(xl) * yl;
+      bound += std::abs(xl) * std::abs(yl);
+    }
+    auto to_long = [](c10::complex<scalar_t> z) { return std::complex<long double>(z.real(), z.imag()); };
+    const long double tol = 4 * (n + 1) * eps * bound;
+    ASSERT_EQ(std::abs(to_long(c10::bulk::dot(x.data(), y.data(), n)) - dot) <= tol, true);
+    ASSERT_EQ(std::abs(to_long(c10::bulk::vdot(x.data(), y.data(), n)) - vdot) <= tol, true);
+  }
+  // products are fused when the target has FMA instructions
+#if defined(__FP_FAST_FMA) || defined(__FMA__)
+  const scalar_t e = std::ldexp(scalar_t(1), -(std::numeric_limits<scalar_t>::digits / 2 + 1));
+  std::vector<c10::complex<scalar_t>> x(20, c10::complex<scalar_t>(1 + e, 0));
+  std::vector<c10::complex<scalar_t>> y(20, c10::complex<scalar_t>(-1, 0));
+  c10::bulk::axpy(c10::complex<scalar_t>(1 - e, 0), x.data(), y.data(), 20);
+  for (auto v : y) {
+    ASSERT_EQ(v, c10::complex<scalar_t>(-e * e, 0));
+  }
+#endif
+}
+
+void test_fma() {
+  test_fma_<float>();
+  test_fma_<double>();
+}
+
+} // namespace bulk_fma
+
+namespace bulk_stream {
+
+using namespace bulk_common;
+
+// non-temporal stores give the same results as normal stores
+template<typename scalar_t>
+void test_stream_() {
+  auto x = random_inputs<scalar_t>(1000, 3, 3, 1);
+  auto specials = special_inputs<scalar_t>();
+  x.insert(x.begin() + 100, specials.begin(), specials.end());
+  auto y = random_inputs<scalar_t>(x.size(), 1, 1, 2);
+  const int64_t n = x.size();
+  std::vector<c10::complex<scalar_t>> expected_exp(n), expected_pow(n);
+  c10::bulk::exp(x.data(), expected_exp.data(), n);
+  c10::bulk::pow(x.data(), y.data(), expected_pow.data(), n);
+
+  c10::bulk::set_streaming_threshold(0);
+  // outputs with every alignment, and sizes that end within a block
+  for (int offset = 0; offset < 8; offset++) {
+    for (int64_t size : {n, n - 3, int64_t(5)}) {
+      std::vector<c10::complex<scalar_t>> out(n + offset);
+      c10::bulk::exp(x.data(), out.data() + offset, size);
+      ASSERT_EQ(std::memcmp(out.data() + offset, expected_exp.data(), size * sizeof(out[0])), 0);
+      c10::bulk::pow(x.data(), y.data(), out.data() + offset, size);
+      ASSERT_EQ(std::memcmp(out.data() + offset, expected_pow.data(), size * sizeof(out[0])), 0);
+    }
+  }
+  // in-place kernels do not stream, but give the same result
+  auto inplace = x;
+  c10::bulk::exp(inplace.data(), inplace.data(), n);
+  ASSERT_EQ(std::memcmp(inplace.data(), expected_exp.data(), n * sizeof(inplace[0])), 0);
+  c10::bulk::set_streaming_threshold(-1);
+}
+
+void test_stream() {
+  ASSERT_EQ(c10::bulk::get_streaming_threshold(), c10::bulk::default_streaming_threshold);
+  test_stream_<float>();
+  test_stream_<double>();
+  ASSERT_EQ(c10::bulk::get_streaming_threshold(), c10::bulk::default_streaming_threshold);
+}
+
+} // namespace bulk_stream
+
+int main() {
+  bulk_exp_log_pow::test_exp_log_pow();
+  bulk_trig::test_trig();
+  bulk_sqrt::test_sqrt();
+  bulk_inverse::test_inverse();
+  bulk_fma::test_fma();
+  bulk_stream::test_stream();
+}
@@ -0,0 +1,229 @@
+#include <c10/test/util/complex_test_common.h>
+#include <c10/util/complex_codec.h>
+
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <limits>
+#include <random>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+namespace codec {
+
+const std::string path = "complex_codec_test.c10z";
+const std::string raw_path = "complex_codec_test.c10c";
+
+template<typename scalar_t>
+bool same_bits(const c10::complex<scalar_t>& a, const c10::complex<scalar_t>& b) {
+  return std::memcmp(&a, &b, sizeof(a)) == 0;
+}
+
+// A slowly changing signal with noise in the low bits
+template<typename scalar_t>
+std::vector<c10::complex<scalar_t>> make_signal(int64_t n) {
+  std::mt19937 gen(7);
+  std::normal_distribution<double> noise(0, 1e-4);
+  std::vector<c10::complex<scalar_t>> v(n);
+  for (int64_t i = 0; i < n; i++) {
+    v[i] = c10::complex<scalar_t>(scalar_t(std::cos(i * 1e-3) + noise(gen)), scalar_t(std::sin(i * 1e-3) + noise(gen)));
+  }
+  return v;
+}
+
+int64_t file_size(const std::string& p) {
+  std::FILE* f = std::fopen(p.c_str(), "rb");
+  std::fseek(f, 0, SEEK_END);
+  const int64_t size = std::ftell(f);
+  std::fclose(f);
+  return size;
+}
+
+template<typename scalar_t>
+void test_round_trip_(const std::vector<c10::complex<scalar_t>>& v, int64_t block_size) {
+  {
+    c10::complex_codec_writer<scalar_t> w(path, {}, block_size);
+    w.append(v.data(), v.size());
+  }
+  std::vector<int64_t> shape;
+  auto b = c10::load_compressed_complex_file<scalar_t>(path, &shape);
+  ASSERT_EQ(shape, std::vector<int64_t>({static_cast<int64_t>(v.size())}));
+  ASSERT_EQ(b.size(), static_cast<int64_t>(v.size()));
+  for (size_t i = 0; i < v.size(); i++) {
+    ASSERT_EQ(same_bits(b[i], v[i]), true);
+  }
+}
+
+void test_round_trip() {
+  for (int64_t block_size : {int64_t(1), int64_t(7), int64_t(1000), c10::codec_default_block_size}) {
+    test_round_trip_(make_signal<float>(5000), block_size);
+    test_round_trip_(make_signal<double>(5000), block_size);
+    test_round_trip_(make_signal<c10::Half>(300), block_size);
+  }
+  // random bits, special values and NaN payloads
+  std::mt19937_64 gen(8);
+  std::vector<c10::complex<double>> d(3001);
+  for (auto& z : d) {
+    z = c10::complex<double>(0, 0);
+    uint64_t bits[2] = {gen(), gen() >> (gen() % 64)};
+    std::memcpy(&z, bits, sizeof(z));
+  }
+  d[1] = c10::complex<double>(std::numeric_limits<double>::infinity(), -0.0);
+  d[2] = c10::complex<double>(std::numeric_limits<double>::quiet_NaN(), std::numeric_limits<double>::denorm_min());
+  test_round_trip_(d, 1024);
+  // constant and empty
+  test_round_trip_(std::vector<c10::complex<float>>(10000, c10::complex<float>(1, -1)), 4096);
+  test_round_trip_(std::vector<c10::complex<float>>(), 4096);
+  // the rANS planes of bytes with skewed frequencies
+  std::vector<c10::complex<float>> skewed(20000);
+  for (size_t i = 0; i < skewed.size(); i++) {
+    const int k = gen() % 1000 == 0 ? static_cast<int>(gen() % 256) : static_cast<int>(gen() % 3);
+    skewed[i] = c10::complex<float>(static_cast<float>(k), static_cast<float>(i % 5));
+  }
+  test_round_trip_(skewed, 8192);
+}
+
+void test_compression() {
+  auto v = make_signal<double>(200000);
+  {
+    c10::complex_codec_writer<double> w(path);
+    w.append(v.data(), v.size());
+  }
+  // the noise leaves about 36 of the 52 bits of the mantissas random
+  const int64_t size = file_size(path);
+  ASSERT_EQ(size < static_cast<int64_t>(v.size() * sizeof(v[0]) * 3 / 4), true);
+  std::vector<c10::complex<float>> slow(200000);
+  for (size_t i = 0; i < slow.size(); i++) {
+    slow[i] = c10::complex<float>(std::floor(i / 100.0f), 1);
+  }
+  {
+    c10::complex_codec_writer<float> w(path);
+    w.append(slow.data(), slow.size());
+  }
+  ASSERT_EQ(file_size(path) < static_cast<int64_t>(slow.size() * sizeof(slow[0]) / 20), true);
+}
+
+void test_streaming() {
+  auto v = make_signal<float>(300000);
+  c10::set_num_threads(3);
+  {
+    c10::complex_codec_writer<float> w(path, {2, 5}, 1000);
+    w.append(v.data(), 10);
+    w.flush();
+    ASSERT_EQ(c10::complex_codec_reader<float>(path).remaining(), 10);
+    w.append(c10::make_span(v).subspan(10, 100000));
+    w.append(v.data() + 100010, v.size() - 100010);
+    ASSERT_EQ(w.size(), 300000);
+    bool thrown = false;
+    try {
+      w.append(v.data(), 3);
+    } catch (const std::invalid_argument&) {
+      thrown = true;
+    }
+    ASSERT_EQ(thrown, true);
+  }
+  c10::complex_codec_reader<float> r(path);
+  ASSERT_EQ(r.header().shape, std::vector<int64_t>({30000, 2, 5}));
+  ASSERT_EQ(r.block_size(), 1000);
+  std::vector<c10::complex<float>> out(v.size());
+  int64_t i = 0;
+  for (int64_t n = 1; r.remaining() > 0; n = n * 3 + 1) {
+    i += r.read(out.data() + i, n);
+  }
+  ASSERT_EQ(i, 300000);
+  ASSERT_EQ(r.read(out.data(), 1), 0);
+  for (size_t j = 0; j < v.size(); j++) {
+    ASSERT_EQ(same_bits(out[j], v[j]), true);
+  }
+
+  // assigning over a writer compresses its pending elements and closes it
+  const std::string other = path + ".2";
+  {
+    c10::complex_codec_writer<float> w(path, {}, 1000);
+    w.append(v.data(), 1500);
+    w = c10::complex_codec_writer<float>(other, {}, 1000);
+    w.append(v.data(), 10);
+  }
+  c10::complex_codec_reader<float> first(path);
+  ASSERT_EQ(first.header().shape, std::vector<int64_t>({1500}));
+  ASSERT_EQ(first.read(out.data(), out.size()), 1500);
+  for (int64_t j = 0; j < 1500; j++) {
+    ASSERT_EQ(same_bits(out[j], v[j]), true);
+  }
+  ASSERT_EQ(c10::complex_codec_reader<float>(other).remaining(), 10);
+  std::remove(other.c_str());
+  c10::set_num_threads(0);
+}
+
+void test_files() {
+  auto v = make_signal<double>(12000);
+  c10::save_complex_file(raw_path, v.data(), {3, 4000});
+  c10::compress_complex_file(raw_path, path, 512);
+  std::remove(raw_path.c_str());
+  c10::decompress_complex_file(path, raw_path);
+  std::vector<int64_t> shape;
+  auto b = c10::load_complex_file<double>(raw_path, &shape);
+  ASSERT_EQ(shape, std::vector<int64_t>({3, 4000}));
+  for (size_t i = 0; i < v.size(); i++) {
+    ASSERT_EQ(same_bits(b[i], v[i]), true);
+  }
+  std::remove(raw_path.c_str());
+}
+
+void test_errors() {
+  auto v = make_signal<float>(5000);
+  {
+    c10::complex_codec_writer<float> w(path, {}, 1024);
+    w.append(v.data(), v.size());
+  }
+  bool thrown = false;
+  try {
+    c10::complex_codec_reader<double> r(path);
+  } catch (const std::runtime_error&) {
+    thrown = true;
+  }
+  ASSERT_EQ(thrown, true);
+
+  // every truncation and a corrupted byte in each block throw or decode
+  std::vector<char> bytes(file_size(path));
+  {
+    std::FILE* f = std::fopen(path.c_str(), "rb");
+    ASSERT_EQ(std::fread(bytes.data(), 1, bytes.size(), f), bytes.size());
+    std::fclose(f);
+  }
+  auto try_load = [&](const std::vector<char>& contents) {
+    std::FILE* f = std::fopen(path.c_str(), "wb");
+    if (!contents.empty()) {
+      std::fwrite(contents.data(), 1, contents.size(), f);
+    }
+    std::fclose(f);
+    try {
+      c10::load_compressed_complex_file<float>(path);
+      return false;
+    } catch (const std::runtime_error&) {
+      return true;
+    }
+  };
+  for (size_t size : {size_t(0), size_t(10), size_t(20), bytes.size() / 2, bytes.size() - 1}) {
+    ASSERT_EQ(try_load(std::vector<char>(bytes.begin(), bytes.begin() + size)), true);
+  }
+  std::mt19937 gen(9);
+  for (int k = 0; k < 200; k++) {
+    std::vector<char> corrupted = bytes;
+    corrupted[24 + gen() % (bytes.size() - 24)] ^= static_cast<char>(1 + gen() % 255);
+    try_load(corrupted);
+  }
+  std::remove(path.c_str());
+}
+
+} // namespace codec
+
+int main() {
+  codec::test_round_trip();
+  codec::test_compression();
+  codec::test_streaming();
+  codec::test_files();
+  codec::test_errors();
+}
@@ -0,0 +1,196 @@
+#include <c10/test/util/complex_test_common.h>
+#include <c10/util/complex_convert.h>
+
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <cstring>
+#include <limits>
+#include <mutex>
+#include <random>
+#include <stdexcept>
+#include <vector>
+
+namespace parallel {
+
+void test_parallel_for() {
+  for (int threads : {1, 3, 0}) {
+    c10::set_num_threads(threads);
+    for (int64_t n : {0, 1, 1000, 100003}) {
+      std::vector<std::atomic<int>> visits(n);
+      for (auto& v : visits) {
+        v = 0;
+      }
+      c10::parallel_for(0, n, 1000, [&](int64_t begin, int64_t end) {
+        ASSERT_EQ(begin < end, true);
+        for (int64_t i = begin; i < end; i++) {
+          visits[i]++;
+        }
+      });
+      for (auto& v : visits) {
+        ASSERT_EQ(v.load(), 1);
+      }
+    }
+  }
+  // the first exception is rethrown on the calling thread
+  c10::set_num_threads(4);
+  bool thrown = false;
+  try {
+    c10::parallel_for(0, 4000, 1000, [](int64_t begin, int64_t) {
+      if (begin > 0) {
+        throw std::runtime_error("chunk failed");
+      }
+    });
+  } catch (const std::runtime_error&) {
+    thrown = true;
+  }
+  ASSERT_EQ(thrown, true);
+  c10::set_num_threads(0);
+}
+
+} // namespace parallel
+
+namespace convert {
+
+template<typename scalar_t>
+std::vector<c10::complex<scalar_t>> random_values(int64_t n, double range, unsigned seed) {
+  std::mt19937 gen(seed);
+  std::uniform_real_distribution<double> value(-range, range);
+  std::vector<c10::complex<scalar_t>> result(n);
+  for (auto& v : result) {
+    v = c10::complex<scalar_t>(static_cast<scalar_t>(value(gen)), static_cast<scalar_t>(value(gen)));
+  }
+  return result;
+}
+
+template<typename from_t, typename to_t>
+void check_same_as_constructor(const std::vector<c10::complex<from_t>>& x) {
+  const int64_t n = x.size();
+  std::vector<c10::complex<to_t>> out(n + 1), streamed(n + 1);
+  c10::bulk::convert(x.data(), out.data(), n);
+  // not aligned to 16 bytes
+  c10::bulk::convert_options options;
+  options.nontemporal = true;
+  c10::bulk::convert(x.data(), streamed.data() + 1, n, options);
+  for (int64_t i = 0; i < n; i++) {
+    ASSERT_EQ(out[i], static_cast<c10::complex<to_t>>(x[i]));
+    ASSERT_EQ(streamed[i + 1], out[i]);
+  }
+}
+
+template<typename from_t>
+void test_default_() {
+  // the sizes cover the tail of a block and more than one thread
+  for (int64_t n : {0, 1, 17, 1000, 300001}) {
+    auto x = random_values<from_t>(n, 30000, n);
+    check_same_as_constructor<from_t, c10::Half>(x);
+    check_same_as_constructor<from_t, float>(x);
+    check_same_as_constructor<from_t, double>(x);
+  }
+}
+
+void test_default() {
+  test_default_<c10::Half>();
+  test_default_<float>();
+  test_default_<double>();
+}
+
+void test_saturate() {
+  const double inf = std::numeric_limits<double>::infinity();
+  const double nan = std::numeric_limits<double>::quiet_NaN();
+  const float fmax = std::numeric_limits<float>::max();
+  c10::bulk::convert_options options;
+  options.saturate = true;
+
+  std::vector<c10::complex<double>> x = {{1e300, -1e300}, {inf, -inf}, {1.5, -2.5}, {nan, 3e38}};
+  std::vector<c10::complex<float>> f(x.size());
+  c10::bulk::convert(x.data(), f.data(), x.size(), options);
+  ASSERT_EQ(f[0], c10::complex<float>(fmax, -fmax));
+  ASSERT_EQ(f[1], c10::complex<float>(inf, -inf));
+  ASSERT_EQ(f[2], c10::complex<float>(1.5, -2.5));
+  ASSERT_EQ(std::isnan(f[3].real()), true);
+  ASSERT_EQ(f[3].imag(), 3e38f);
+
+  std::vector<c10::complex<c10::Half>> h(x.size());
+  c10::bulk::convert(x.data(), h.data(), x.size(), options);
+  ASSERT_EQ(h[0], c10::complex<c10::Half>(32767, -32768));
+  ASSERT_EQ(h[1], c10::complex<c10::Half>(32767, -32768));
+  ASSERT_EQ(h[2], c10::complex<c10::Half>(1, -2));
+  ASSERT_EQ(h[3], c10::complex<c10::Half>(0, 32767));
+  c10::bulk::convert(f.data(), h.data(), f.size(), options);
+  ASSERT_EQ(h[0], c10::complex<c10::Half>(32767, -32768));
+  ASSERT_EQ(h[3], c10::complex<c10::Half>(0, 32767));
+}
+
+// results are the two neighbors of the exact value, with the exact value as mean
+template<typename from_t, typename to_t>
+void check_stochastic(from_t value, to_t below, to_t above) {
+  const int64_t n = 300000;
+  std::vector<c10::complex<from_t>> x(n, c10::complex<from_t>(value, -value));
+  std::vector<c10::complex<to_t>> out(n), again(n);
+  c10::bulk::convert_options options;
+  options.stochastic_rounding = true;
+  options.seed = 42;
+  c10::set_num_threads(4);
+  c10::bulk::convert(x.data(), out.data(), n, options);
+  double sum_re = 0, sum_im = 0;
+  for (const auto& v : out) {
+    ASSERT_EQ(v.real() == below || v.real() == above, true);
+    ASSERT_EQ(v.imag() == to_t(0 - below) || v.imag() == to_t(0 - above), true);
+    sum_re += v.real();
+    sum_im += v.imag();
+  }
+  const double spacing = static_cast<double>(above) - static_cast<double>(below);
+  ASSERT_LT(std::abs(sum_re / n - static_cast<double>(value)), 0.01 * spacing);
+  ASSERT_LT(std::abs(sum_im / n + static_cast<double>(value)), 0.01 * spacing);
+  // the same seed gives the same result with any number of threads
+  c10::set_num_threads(1);
+  c10::bulk::convert(x.data(), again.data(), n, options);
+  c10::set_num_threads(0);
+  ASSERT_EQ(std::memcmp(out.data(), again.data(), n * sizeof(out[0])), 0);
+}
+
+void test_stochastic() {
+  // a quarter of the way between two floats
+  const double x = 1.0 + std::ldexp(1.0, -25);
+  check_stochastic<double, float>(x, 1.0f, 1.0f + std::ldexp(1.0f, -23));
+  const float big = 1e30f, next = std::nextafter(big, 2e30f);
+  check_stochastic<double, float>(big + (static_cast<double>(next) - big) / 4, big, next);
+  check_stochastic<double, c10::Half>(2.3, 2, 3);
+  check_stochastic<float, c10::Half>(-7.75f, -8, -7);
+  check_stochastic<float, c10::Half>(100.5f, 100, 101);
+}
+
+void test_numa() {
+  // buffers can be placed like convert splits them between threads
+  c10::set_num_threads(4);
+  const int64_t n = 300001;
+  const c10::numa_options options = c10::bulk::convert_numa_options<float>();
+  const size_t bytes = n * sizeof(c10::complex<float>);
+  std::vector<size_t> chunks;
+  std::mutex mutex;
+  c10::parallel_for(0, 2 * n, c10::bulk::convert_grain_size, [&](int64_t begin, int64_t) {
+    std::lock_guard<std::mutex> guard(mutex);
+    chunks.push_back(begin * sizeof(float));
+  });
+  std::sort(chunks.begin(), chunks.end());
+  chunks.push_back(bytes);
+  ASSERT_EQ(c10::detail::numa_chunk_offsets(bytes, sizeof(c10::complex<float>), options), chunks);
+  auto x = random_values<double>(n, 100, 5);
+  c10::complex_buffer<float> placed(n, options);
+  c10::bulk::convert(x.data(), placed.data(), n);
+  for (int64_t i = 0; i < n; i += 997) {
+    ASSERT_EQ(placed[i], static_cast<c10::complex<float>>(x[i]));
+  }
+  c10::set_num_threads(0);
+}
+
+} // namespace convert
+
+int main() {
+  parallel::test_parallel_for();
+  convert::test_default();
+  convert::test_saturate();
+  convert::test_stochastic();
+  convert::test_numa();
+}
@@ -0,0 +1,170 @@
+#include <c10/test/util/complex_test_common.h>
+#include <c10/util/complex_convolution.h>
+
+#include <cmath>
+#include <cstdint>
+#include <stdexcept>
+#include <vector>
+
+namespace convolution {
+
+using test_data::make_signal;
+using test_data::make_taps;
+using test_data::widen;
+
+// sum_k h[k] x[i - k], or sum_k conj(h[k]) x[i - (K - 1) + k], for i in
+// [0, count)
+template<typename scalar_t, typename tap_t>
+std::vector<c10::complex<double>> reference(const std::vector<c10::complex<scalar_t>>& x, const std::vector<tap_t>& h, bool correlation, int64_t count) {
+  const int64_t K = h.size();
+  std::vector<c10::complex<double>> y(count);
+  for (int64_t i = 0; i < count; i++) {
+    c10::complex<double> sum(0, 0);
+    for (int64_t k = 0; k < K; k++) {
+      const int64_t j = correlation ? i - (K - 1) + k : i - k;
+      if (j >= 0 && j < static_cast<int64_t>(x.size())) {
+        const c10::complex<double> t = widen(h[k]);
+        sum += (correlation ? c10::complex<double>(t.real(), -t.imag()) : t) * widen(x[j]);
+      }
+    }
+    y[i] = sum;
+  }
+  return y;
+}
+
+// FFT convolutions have errors of about eps log2(N) sqrt(K) times the
+// largest output
+template<typename scalar_t>
+bool close(const std::vector<c10::complex<scalar_t>>& y, const std::vector<c10::complex<double>>& expected, int64_t num_taps) {
+  const double eps = std::is_same<scalar_t, float>::value ? 1e-6 : 1e-15;
+  if (y.size() != expected.size()) {
+    return false;
+  }
+  for (size_t i = 0; i < y.size(); i++) {
+    if (std::abs(widen(y[i]) - expected[i]) > 32 * eps * num_taps) {
+      return false;
+    }
+  }
+  return true;
+}
+
+// Chunk sizes that cross the blocks
+const std::vector<int64_t> chunks = {1, 7, 100, 5000, 3, 4096, 10000};
+
+template<typename scalar_t, typename tap_t>
+void test_convolver_() {
+  const auto x = make_signal<scalar_t>(23000, 1);
+  for (int64_t num_taps : {1, 5, 33, 300}) {
+    const auto h = make_taps<tap_t>(num_taps, 2);
+    for (auto kind : {c10::convolution_kind::convolution, c10::convolution_kind::correlation}) {
+      const auto expected = reference(x, h, kind == c10::convolution_kind::correlation, x.size());
+      for (auto method : {c10::overlap_method::overlap_save, c10::overlap_method::overlap_add}) {
+        for (int64_t fft_size : {int64_t(0), 2 * c10::detail::fft_next_power_of_two(num_taps)}) {
+          c10::fft_convolver<scalar_t, tap_t> f(h, kind, method, fft_size);
+          ASSERT_EQ(f.num_taps(), num_taps);
+          ASSERT_EQ(f.block_size(), f.fft_size() - num_taps + 1);
+          // all at once, in place
+          auto y = x;
+          f.filter(y.data(), y.data(), y.size());
+          ASSERT_EQ(close(y, expected, num_taps), true);
+          // streaming
+          f.reset();
+          std::vector<c10::complex<scalar_t>> z(x.size());
+          int64_t i = 0;
+          for (size_t c = 0; i < static_cast<int64_t>(x.size()); c++) {
+            const int64_t n = std::min<int64_t>(chunks[c % chunks.size()], x.size() - i);
+            f.filter(x.data() + i, z.data() + i, n);
+            i += n;
+          }
+          ASSERT_EQ(close(z, expected, num_taps), true);
+        }
+      }
+    }
+  }
+}
+
+template<typename scalar_t, typename tap_t>
+void test_full_() {
+  for (int64_t nx : {0, 1, 50, 3000}) {
+    const auto x = make_signal<scalar_t>(nx, 3);
+    for (int64_t num_taps : {1, 7, 64, 1000}) {
+      const auto h = make_taps<tap_t>(num_taps, 4);
+      for (auto method : {c10::convolution_method::automatic, c10::convolution_method::direct, c10::convolution_method::fft}) {
+        std::vector<c10::complex<scalar_t>> y(nx + num_taps - 1);
+        c10::convolve(x.data(), nx, h.data(), num_taps, y.data(), method);
+        ASSERT_EQ(close(y, reference(x, h, false, y.size()), num_taps), true);
+        c10::correlate(x.data(), nx, h.data(), num_taps, y.data(), method);
+        ASSERT_EQ(close(y, reference(x, h, true, y.size()), num_taps), true);
+      }
+    }
+  }
+}
+
+template<typename scalar_t>
+void test_types_() {
+  test_convolver_<scalar_t, scalar_t>();
+  test_convolver_<scalar_t, c10::complex<scalar_t>>();
+  test_full_<scalar_t, scalar_t>();
+  test_full_<scalar_t, c10::complex<scalar_t>>();
+}
+
+void test_matched_filter() {
+  // a pulse hidden at 1000 peaks at 1000 + K - 1
+  const auto h = make_signal<float>(64, 5);
+  auto x = make_signal<float>(5000, 6);
+  for (auto& z : x) {
+    z *= 0.1f;
+  }
+  for (size_t k = 0; k < h.size(); k++) {
+    x[1000 + k] += h[k];
+  }
+  c10::fft_convolver<float, c10::complex<float>> f(h, c10::convolution_kind::correlation);
+  std::vector<c10::complex<float>> y(x.size());
+  f.filter(x.data(), y.data(), x.size());
+  size_t peak = 0;
+  for (size_t i = 0; i < y.size(); i++) {
+    if (std::abs(y[i]) > std::abs(y[peak])) {
+      peak = i;
+    }
+  }
+  ASSERT_EQ(peak, 1000 + h.size() - 1);
+}
+
+void test_preferred() {
+  ASSERT_EQ((c10::fft_convolution_preferred<float, float>(4)), false);
+  ASSERT_EQ((c10::fft_convolution_preferred<float, float>(1000)), true);
+  ASSERT_EQ((c10::fft_convolution_preferred<double, c10::complex<double>>(1000)), true);
+  // too few outputs to pay for the transforms
+  ASSERT_EQ((c10::fft_convolution_preferred<float, float>(1000, 1)), false);
+}
+
+void test_errors() {
+  int thrown = 0;
+  std::vector<float> none, taps(10);
+  try {
+    c10::fft_convolver<float> f(none);
+  } catch (const std::invalid_argument&) {
+    thrown++;
+  }
+  try {
+    c10::fft_convolver<float> f(taps, c10::convolution_kind::convolution, c10::overlap_method::overlap_save, 16);
+  } catch (const std::invalid_argument&) {
+    thrown++;
+  }
+  try {
+    c10::fft_convolver<float> f(taps, c10::convolution_kind::convolution, c10::overlap_method::overlap_save, 48);
+  } catch (const std::invalid_argument&) {
+    thrown++;
+  }
+  ASSERT_EQ(thrown, 3);
+}
+
+} // namespace convolution
+
+int main() {
+  convolution::test_types_<float>();
+  convolution::test_types_<double>();
+  convolution::test_matched_filter();
+  convolution::test_preferred();
+  convolution::test_errors();
+}
@@ -0,0 +1,148 @@
+#include <c10/test/util/complex_test_common.h>
+#include <c10/util/complex_fft.h>
+
+#include <cmath>
+#include <cstdint>
+#include <stdexcept>
+#include <vector>
+
+namespace fft {
+
+using test_data::make_signal;
+
+// sum_j x[j] exp(sign 2 pi i j k / n), in long double
+template<typename scalar_t>
+std::vector<c10::complex<double>> dft(const std::vector<c10::complex<scalar_t>>& x, int sign) {
+  const int64_t n = x.size();
+  const long double pi = 3.141592653589793238462643383279502884L;
+  std::vector<c10::complex<double>> y(n);
+  for (int64_t k = 0; k < n; k++) {
+    long double re = 0, im = 0;
+    for (int64_t j = 0; j < n; j++) {
+      const long double a = sign * 2 * pi * static_cast<long double>((j * k) % n) / n;
+      const long double c = std::cos(a), s = std::sin(a);
+      re += x[j].real() * c - x[j].imag() * s;
+      im += x[j].real() * s + x[j].imag() * c;
+    }
+    y[k] = c10::complex<double>(static_cast<double>(re), static_cast<double>(im));
+  }
+  return y;
+}
+
+// The largest error relative to the norm of the transform
+template<typename scalar_t>
+double error(const std::vector<c10::complex<scalar_t>>& y, const std::vector<c10::complex<double>>& expected) {
+  double norm = 0, err = 0;
+  for (size_t i = 0; i < y.size(); i++) {
+    const c10::complex<double> d(y[i].real() - expected[i].real(), y[i].imag() - expected[i].imag());
+    err = std::max(err, std::abs(d));
+    norm = std::max(norm, std::abs(expected[i]));
+  }
+  return err / norm;
+}
+
+template<typename scalar_t>
+void test_dft_() {
+  const double eps = std::is_same<scalar_t, float>::value ? 1e-6 : 1e-15;
+  for (int64_t n : {1, 2, 3, 4, 5, 8, 12, 16, 17, 60, 64, 100, 256, 1000, 1024}) {
+    const auto x = make_signal<scalar_t>(n, static_cast<unsigned>(n));
+    c10::fft_plan<scalar_t> plan(n);
+    ASSERT_EQ(plan.size(), n);
+    std::vector<c10::complex<scalar_t>> y(n);
+    plan.forward(x.data(), y.data());
+    ASSERT_EQ(error(y, dft(x, -1)) < 20 * eps * std::log2(2 * n), true);
+    plan.inverse(x.data(), y.data());
+    ASSERT_EQ(error(y, dft(x, 1)) < 20 * eps * std::log2(2 * n), true);
+  }
+}
+
+template<typename scalar_t>
+void test_round_trip_() {
+  const double eps = std::is_same<scalar_t, float>::value ? 1e-6 : 1e-15;
+  for (int64_t n : {7, 4096, 3000, 65536}) {
+    const auto x = make_signal<scalar_t>(n, 3);
+    c10::fft_plan<scalar_t> plan(n);
+    // in place
+    auto y = x;
+    plan.forward(y.data(), y.data());
+    plan.inverse(y.data(), y.data());
+    double err = 0;
+    for (int64_t i = 0; i < n; i++) {
+      err = std::max<double>(err, std::abs(y[i] / static_cast<scalar_t>(n) - x[i]));
+    }
+    ASSERT_EQ(err < 20 * eps * std::log2(2 * n), true);
+  }
+}
+
+template<typename scalar_t>
+void test_exact_() {
+  // an impulse at 1 gives the twiddles exactly, and a constant an impulse
+  const int64_t n = 64;
+  std::vector<c10::complex<scalar_t>> x(n, c10::complex<scalar_t>(0, 0)), y(n);
+  x[1] = c10::complex<scalar_t>(1, 0);
+  c10::fft_plan<scalar_t> plan(n);
+  plan.forward(x.data(), y.data());
+  ASSERT_EQ(y[0], c10::complex<scalar_t>(1, 0));
+  ASSERT_EQ(y[16], c10::complex<scalar_t>(0, -1));
+  ASSERT_EQ(y[32], c10::complex<scalar_t>(-1, 0));
+  std::fill(x.begin(), x.end(), c10::complex<scalar_t>(1, 0));
+  plan.forward(x.data(), y.data());
+  ASSERT_EQ(y[0], c10::complex<scalar_t>(n, 0));
+  for (int64_t k = 1; k < n; k++) {
+    ASSERT_EQ(y[k], c10::complex<scalar_t>(0, 0));
+  }
+}
+
+template<typename scalar_t>
+void test_windowed_() {
+  const double eps = std::is_same<scalar_t, float>::value ? 1e-6 : 1e-15;
+  for (int64_t n : {64, 100}) {
+    for (int64_t count : {n, n / 2 + 3}) {
+      const auto x = make_signal<scalar_t>(count, 4);
+      std::vector<scalar_t> window(count);
+      for (int64_t j = 0; j < count; j++) {
+        window[j] = static_cast<scalar_t>(0.5 + j % 7);
+      }
+      // the window applied beforehand, padded with zeros
+      std::vector<c10::complex<scalar_t>> padded(n, c10::complex<scalar_t>(0, 0)), expected(n), y(n);
+      for (int64_t j = 0; j < count; j++) {
+        padded[j] = x[j] * window[j];
+      }
+      c10::fft_plan<scalar_t> plan(n);
+      plan.forward(padded.data(), expected.data());
+      plan.forward_windowed(x.data(), window.data(), count, y.data());
+      for (int64_t k = 0; k < n; k++) {
+        ASSERT_EQ(std::abs(y[k] - expected[k]) < 100 * eps * n, true);
+      }
+    }
+  }
+}
+
+void test_errors() {
+  int thrown = 0;
+  try {
+    c10::fft_plan<float> plan(0);
+  } catch (const std::invalid_argument&) {
+    thrown++;
+  }
+  try {
+    c10::fft_plan<double> plan(-4);
+  } catch (const std::invalid_argument&) {
+    thrown++;
+  }
+  ASSERT_EQ(thrown, 2);
+}
+
+} // namespace fft
+
+int main() {
+  fft::test_dft_<float>();
+  fft::test_dft_<double>();
+  fft::test_round_trip_<float>();
+  fft::test_round_trip_<double>();
+  fft::test_exact_<float>();
+  fft::test_exact_<double>();
+  fft::test_windowed_<float>();
+  fft::test_windowed_<double>();
+  fft::test_errors();
+}
@@ -0,0 +1,203 @@
+#include <c10/test/util/complex_test_common.h>
+#include <c10/util/complex_file.h>
+
+#include <cstdint>
+#include <cstdio>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+namespace file {
+
+const std::string path = "complex_file_test.c10c";
+
+template<typename scalar_t>
+std::vector<c10::complex<scalar_t>> make_data(int64_t n) {
+  std::vector<c10::complex<scalar_t>> v(n);
+  for (int64_t i = 0; i < n; i++) {
+    v[i] = c10::complex<scalar_t>(scalar_t(i), scalar_t(-i));
+  }
+  return v;
+}
+
+template<typename scalar_t>
+void test_round_trip_() {
+  auto v = make_data<scalar_t>(60);
+  c10::save_complex_file(path, v.data(), {3, 4, 5});
+
+  auto header = c10::read_complex_file_header(path);
+  ASSERT_EQ(header.dtype, c10::complex_dtype_of<scalar_t>::value);
+  ASSERT_EQ(header.shape, std::vector<int64_t>({3, 4, 5}));
+  ASSERT_EQ(header.data_offset % c10::complex_file_alignment, 0);
+
+  // mapped
+  {
+    c10::mapped_complex_file<scalar_t> f(path);
+    ASSERT_EQ(f.size(), 60);
+    ASSERT_EQ(reinterpret_cast<uintptr_t>(f.data()) % c10::complex_file_alignment, 0);
+    for (int64_t i = 0; i < 60; i++) {
+      ASSERT_EQ(f[i], v[i]);
+    }
+    c10::span<const c10::complex<scalar_t>> s = f;
+    ASSERT_EQ(s.size(), 60);
+  }
+
+  // loaded
+  std::vector<int64_t> shape;
+  auto b = c10::load_complex_file<scalar_t>(path, &shape);
+  ASSERT_EQ(shape, header.shape);
+  ASSERT_EQ(b.size(), 60);
+  for (int64_t i = 0; i < 60; i++) {
+    ASSERT_EQ(b[i], v[i]);
+  }
+}
+
+void test_round_trip() {
+  test_round_trip_<c10::Half>();
+  test_round_trip_<float>();
+  test_round_trip_<double>();
+}
+
+void test_writer() {
+  auto v = make_data<double>(100);
+  {
+    c10::complex_file_writer<double> w(path, {2});
+    w.append(v.data(), 10);
+    w.flush();
+    // a file that is being written can be read up to the last flush
+    c10::mapped_complex_file<double> f(path);
+    ASSERT_EQ(f.shape(), std::vector<int64_t>({5, 2}));
+    ASSERT_EQ(f[9], v[9]);
+    w.append(c10::make_span(v).subspan(10, 90));
+    ASSERT_EQ(w.size(), 100);
+    bool thrown = false;
+    try {
+      w.append(v.data(), 3);
+    } catch (const std::invalid_argument&) {
+      thrown = true;
+    }
+    ASSERT_EQ(thrown, true);
+  }
+  // the destructor closes the file
+  c10::complex_file_reader<double> r(path);
+  ASSERT_EQ(r.header().shape, std::vector<int64_t>({50, 2}));
+  std::vector<c10::complex<double>> chunk(30);
+  int64_t total = 0;
+  int64_t count;
+  while ((count = r.read(chunk.data(), chunk.size())) > 0) {
+    for (int64_t i = 0; i < count; i++) {
+      ASSERT_EQ(chunk[i], v[total + i]);
+    }
+    total += count;
+  }
+  ASSERT_EQ(total, 100);
+  ASSERT_EQ(r.remaining(), 0);
+
+  // assigning over a writer closes its file first
+  const std::string other = path + ".2";
+  {
+    c10::complex_file_writer<double> w(path);
+    w.append(v.data(), 6);
+    w = c10::complex_file_writer<double>(other);
+    w.append(v.data(), 4);
+  }
+  ASSERT_EQ(c10::read_complex_file_header(path).shape, std::vector<int64_t>({6}));
+  ASSERT_EQ(c10::read_complex_file_header(other).shape, std::vector<int64_t>({4}));
+  std::remove(other.c_str());
+
+  // empty files
+  c10::save_complex_file<float>(path, nullptr, {0});
+  c10::mapped_complex_file<float> f(path);
+  ASSERT_EQ(f.size(), 0);
+  ASSERT_EQ(f.begin(), f.end());
+}
+
+void test_byte_order() {
+  auto v = make_data<float>(8);
+  c10::save_complex_file(path, v.data(), {8});
+  // swap the bytes of the shape and of the data
+  std::vector<char> bytes;
+  {
+    std::FILE* f = std::fopen(path.c_str(), "rb");
+    char c;
+    while (std::fread(&c, 1, 1, f) == 1) {
+      bytes.push_back(c);
+    }
+    std::fclose(f);
+  }
+  const int64_t offset = c10::read_complex_file_header(path).data_offset;
+  bytes[10] = c10::detail::host_little_endian() ? '>' : '<';
+  c10::detail::swap_bytes(&bytes[16], 1, 8);
+  c10::detail::swap_bytes(&bytes[offset], 16, 4);
+  {
+    std::FILE* f = std::fopen(path.c_str(), "wb");
+    std::fwrite(bytes.data(), 1, bytes.size(), f);
+    std::fclose(f);
+  }
+
+  std::vector<int64_t> shape;
+  auto b = c10::load_complex_file<float>(path, &shape);
+  ASSERT_EQ(shape, std::vector<int64_t>({8}));
+  for (int64_t i = 0; i < 8; i++) {
+    ASSERT_EQ(b[i], v[i]);
+  }
+  // can not be mapped
+  bool thrown = false;
+  try {
+    c10::mapped_complex_file<float> f(path);
+  } catch (const std::runtime_error&) {
+    thrown = true;
+  }
+  ASSERT_EQ(thrown, true);
+}
+
+void test_errors() {
+  auto v = make_data<float>(4);
+  c10::save_complex_file(path, v.data(), {4});
+  bool thrown = false;
+  try {
+    c10::mapped_complex_file<double> f(path);
+  } catch (const std::runtime_error&) {
+    thrown = true;
+  }
+  ASSERT_EQ(thrown, true);
+  thrown = false;
+  try {
+    c10::load_complex_file<float>("does/not/exist.c10c");
+  } catch (const std::runtime_error&) {
+    thrown = true;
+  }
+  ASSERT_EQ(thrown, true);
+  // truncated data
+  {
+    std::FILE* f = std::fopen(path.c_str(), "wb");
+    const std::string header = c10::detail::encode_complex_file_header(c10::complex_dtype::complex_float, {4});
+    std::fwrite(header.data(), 1, header.size(), f);
+    std::fwrite(v.data(), sizeof(v[0]), 3, f);
+    std::fclose(f);
+  }
+  thrown = false;
+  try {
+    c10::mapped_complex_file<float> f(path);
+  } catch (const std::runtime_error&) {
+    thrown = true;
+  }
+  ASSERT_EQ(thrown, true);
+  thrown = false;
+  try {
+    c10::load_complex_file<float>(path);
+  } catch (const std::runtime_error&) {
+    thrown = true;
+  }
+  ASSERT_EQ(thrown, true);
+}
+
+} // namespace file
+
+int main() {
+  file::test_round_trip();
+  file::test_writer();
+  file::test_byte_order();
+  file::test_errors();
+  std::remove(file::path.c_str());
+}
@@ -0,0 +1,210 @@
+#include <c10/test/util/complex_test_common.h>
+#include <c10/util/complex_fir.h>
+
+#include <cmath>
+#include <cstdint>
+#include <stdexcept>
+#include <vector>
+
+namespace fir {
+
+using test_data::make_signal;
+using test_data::make_taps;
+using test_data::widen;
+
+// (h * (x upsampled by up))[j down] for j in [0, count)
+template<typename scalar_t, typename tap_t>
+std::vector<c10::complex<double>> reference(const std::vector<c10::complex<scalar_t>>& x, const std::vector<tap_t>& h, int64_t up, int64_t down, int64_t count) {
+  std::vector<c10::complex<double>> y(count);
+  for (int64_t j = 0; j < count; j++) {
+    c10::complex<double> sum(0, 0);
+    for (int64_t k = 0; k < static_cast<int64_t>(h.size()); k++) {
+      const int64_t m = j * down - k;
+      if (m >= 0 && m % up == 0 && m / up < static_cast<int64_t>(x.size())) {
+        sum += widen(h[k]) * widen(x[m / up]);
+      }
+    }
+    y[j] = sum;
+  }
+  return y;
+}
+
+template<typename scalar_t>
+bool close(const std::vector<c10::complex<scalar_t>>& y, const std::vector<c10::complex<double>>& expected, int64_t num_taps) {
+  const double eps = std::is_same<scalar_t, float>::value ? 1e-6 : 1e-15;
+  if (y.size() != expected.size()) {
+    return false;
+  }
+  for (size_t i = 0; i < y.size(); i++) {
+    if (std::abs(widen(y[i]) - expected[i]) > 8 * eps * num_taps) {
+      return false;
+    }
+  }
+  return true;
+}
+
+// Chunk sizes that cross the internal chunks of 4096 inputs
+const std::vector<int64_t> chunks = {1, 7, 100, 5000, 3, 4096, 10000};
+
+template<typename scalar_t, typename tap_t>
+void test_filter_() {
+  const auto x = make_signal<scalar_t>(23000, 1);
+  for (int64_t num_taps : {1, 5, 33, 100}) {
+    const auto h = make_taps<tap_t>(num_taps, 2);
+    const auto expected = reference(x, h, 1, 1, x.size());
+    c10::fir_filter<scalar_t, tap_t> f(h);
+    ASSERT_EQ(f.num_taps(), num_taps);
+    // all at once, in place
+    auto y = x;
+    f.filter(y.data(), y.data(), y.size());
+    ASSERT_EQ(close(y, expected, num_taps), true);
+    // streaming
+    f.reset();
+    std::vector<c10::complex<scalar_t>> z(x.size());
+    int64_t i = 0;
+    for (size_t c = 0; i < static_cast<int64_t>(x.size()); c++) {
+      const int64_t n = std::min<int64_t>(chunks[c % chunks.size()], x.size() - i);
+      f.filter(x.data() + i, z.data() + i, n);
+      i += n;
+    }
+    ASSERT_EQ(close(z, expected, num_taps), true);
+  }
+}
+
+template<typename scalar_t, typename tap_t>
+void test_decimator_() {
+  const auto x = make_signal<scalar_t>(20000, 3);
+  for (int64_t factor : {1, 2, 3, 10}) {
+    const auto h = make_taps<tap_t>(8 * factor + 3, 4);
+    c10::fir_decimator<scalar_t, tap_t> d(h, factor);
+    ASSERT_EQ(d.output_size(x.size()), (static_cast<int64_t>(x.size()) + factor - 1) / factor);
+    const auto expected = reference(x, h, 1, factor, d.output_size(x.size()));
+    std::vector<c10::complex<scalar_t>> y;
+    int64_t i = 0;
+    for (size_t c = 0; i < static_cast<int64_t>(x.size()); c++) {
+      const int64_t n = std::min<int64_t>(chunks[c % chunks.size()], x.size() - i);
+      std::vector<c10::complex<scalar_t>> out(d.output_size(n));
+      ASSERT_EQ(d.filter(x.data() + i, out.data(), n), static_cast<int64_t>(out.size()));
+      y.insert(y.end(), out.begin(), out.end());
+      i += n;
+    }
+    ASSERT_EQ(close(y, expected, h.size()), true);
+  }
+}
+
+template<typename scalar_t, typename tap_t>
+void test_interpolator_() {
+  const auto x = make_signal<scalar_t>(9000, 5);
+  for (int64_t factor : {1, 2, 3, 7}) {
+    const auto h = make_taps<tap_t>(12 * factor - 1, 6);
+    c10::fir_interpolator<scalar_t, tap_t> u(h, factor);
+    const auto expected = reference(x, h, factor, 1, x.size() * factor);
+    std::vector<c10::complex<scalar_t>> y(x.size() * factor);
+    int64_t i = 0;
+    for (size_t c = 0; i < static_cast<int64_t>(x.size()); c++) {
+      const int64_t n = std::min<int64_t>(chunks[c % chunks.size()], x.size() - i);
+      u.filter(x.data() + i, y.data() + i * factor, n);
+      i += n;
+    }
+    ASSERT_EQ(close(y, expected, h.size()), true);
+  }
+}
+
+template<typename scalar_t, typename tap_t>
+void test_resampler_() {
+  const auto x = make_signal<scalar_t>(9000, 7);
+  for (auto ratio : std::vector<std::pair<int64_t, int64_t>>{{1, 1}, {3, 2}, {2, 3}, {6, 4}, {160, 147}}) {
+    const auto h = make_taps<tap_t>(10 * std::max(ratio.first, ratio.second) + 1, 8);
+    c10::rational_resampler<scalar_t, tap_t> r(ratio.first, ratio.second, h);
+    const int64_t count = r.output_size(x.size());
+    ASSERT_EQ(count, (static_cast<int64_t>(x.size()) * r.up() + r.down() - 1) / r.down());
+    const auto expected = reference(x, h, r.up(), r.down(), count);
+    std::vector<c10::complex<scalar_t>> y;
+    int64_t i = 0;
+    for (size_t c = 0; i < static_cast<int64_t>(x.size()); c++) {
+      const int64_t n = std::min<int64_t>(chunks[c % chunks.size()], x.size() - i);
+      std::vector<c10::complex<scalar_t>> out(r.output_size(n));
+      ASSERT_EQ(r.filter(x.data() + i, out.data(), n), static_cast<int64_t>(out.size()));
+      y.insert(y.end(), out.begin(), out.end());
+      i += n;
+    }
+    ASSERT_EQ(close(y, expected, h.size()), true);
+  }
+  ASSERT_EQ(c10::rational_resampler<scalar_t>(6, 4).up(), 3);
+}
+
+template<typename scalar_t>
+void test_types_() {
+  test_filter_<scalar_t, scalar_t>();
+  test_filter_<scalar_t, c10::complex<scalar_t>>();
+  test_decimator_<scalar_t, scalar_t>();
+  test_decimator_<scalar_t, c10::complex<scalar_t>>();
+  test_interpolator_<scalar_t, scalar_t>();
+  test_interpolator_<scalar_t, c10::complex<scalar_t>>();
+  test_resampler_<scalar_t, scalar_t>();
+  test_resampler_<scalar_t, c10::complex<scalar_t>>();
+}
+
+void test_lowpass() {
+  const auto h = c10::fir_lowpass<double>(63, 0.1, 2);
+  double sum = 0;
+  for (double t : h) {
+    sum += t;
+  }
+  ASSERT_EQ(std::abs(sum - 2) < 1e-12, true);
+  ASSERT_EQ(h[10], h[52]);
+  // a tone at 0.2 cycles per sample is stopped, one at 0.05 passes
+  for (double f : {0.05, 0.2}) {
+    c10::complex<double> response(0, 0);
+    for (size_t k = 0; k < h.size(); k++) {
+      const double a = -2 * 3.14159265358979323846 * f * k;
+      response += h[k] * c10::complex<double>(std::cos(a), std::sin(a));
+    }
+    ASSERT_EQ(std::abs(response) / 2 < (f < 0.1 ? 1.01 : 0.01), true);
+    ASSERT_EQ(std::abs(response) / 2 > (f < 0.1 ? 0.99 : 0.0), true);
+  }
+
+  // a resampler keeps a constant signal constant, up to the stopband of the
+  // Hamming window
+  c10::rational_resampler<float> r(5, 3);
+  std::vector<c10::complex<float>> ones(3000, c10::complex<float>(1, 0)), out(r.output_size(3000));
+  r.filter(ones.data(), out.data(), ones.size());
+  for (size_t i = 200; i < out.size(); i++) {
+    ASSERT_EQ(std::abs(out[i] - c10::complex<float>(1, 0)) < 5e-3f, true);
+  }
+}
+
+void test_errors() {
+  int thrown = 0;
+  std::vector<float> none, one = {1};
+  try {
+    c10::fir_filter<float> f(none);
+  } catch (const std::invalid_argument&) {
+    thrown++;
+  }
+  try {
+    c10::fir_decimator<float> d(one, 0);
+  } catch (const std::invalid_argument&) {
+    thrown++;
+  }
+  try {
+    c10::rational_resampler<float> r(1, -2, one);
+  } catch (const std::invalid_argument&) {
+    thrown++;
+  }
+  try {
+    c10::fir_lowpass<float>(10, 0.7);
+  } catch (const std::invalid_argument&) {
+    thrown++;
+  }
+  ASSERT_EQ(thrown, 4);
+}
+
+} // namespace fir
+
+int main() {
+  fir::test_types_<float>();
+  fir::test_types_<double>();
+  fir::test_lowpass();
+  fir::test_errors();
+}
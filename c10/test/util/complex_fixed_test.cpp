@@ -0,0 +1,145 @@
+#include <c10/test/util/complex_test_common.h>
+#include <c10/util/complex_fixed.h>
+
+#include <cmath>
+#include <cstdint>
+#include <limits>
+#include <random>
+#include <type_traits>
+#include <vector>
+
+namespace fixed {
+
+void test_scalar() {
+  static_assert(c10::q15(0.5).raw == 16384, "");
+  static_assert(c10::q15(-1.0).raw == -32768, "");
+  static_assert(c10::q15(1.0).raw == 32767, "");
+  static_assert(c10::q15(-0.2).raw == -6554, "");
+  static_assert((c10::q15(0.5) * c10::q15(-0.25)).raw == -4096, "");
+  static_assert((c10::q15(-1.0) * c10::q15(-1.0)).raw == 32767, "");
+  static_assert((c10::q15(0.75) + c10::q15(0.75)).raw == 32767, "");
+  static_assert((c10::q15(-0.75) - c10::q15(0.75)).raw == -32768, "");
+  static_assert((-c10::q15(-1.0)).raw == 32767, "");
+  static_assert((c10::q15(0.25) / c10::q15(0.5)).raw == 16384, "");
+  static_assert((c10::q31(0.5) * c10::q31(0.5)).raw == (1 << 29), "");
+  ASSERT_EQ(static_cast<float>(c10::q15(0.125)), 0.125f);
+  ASSERT_EQ(c10::q15(std::numeric_limits<double>::quiet_NaN()).raw, 0);
+  // ties round upward, like pmulhrsw
+  ASSERT_EQ((c10::q15::from_raw(1) * c10::q15(0.5)).raw, 1);
+  ASSERT_EQ((c10::q15::from_raw(-1) * c10::q15(0.5)).raw, 0);
+
+  // formats are tracked by the type
+  using q30 = c10::fixed<int32_t, 30>;
+  static_assert(std::is_same<decltype(c10::wide_mul(c10::q15(), c10::q15())), q30>::value, "");
+  static_assert(std::is_same<decltype(c10::wide_mul(c10::q31(), c10::q31())), c10::fixed<int64_t, 62>>::value, "");
+  c10::fixed<int64_t, 30> acc;
+  for (int i = 0; i < 8; i++) {
+    acc += c10::wide_mul(c10::q15(0.5), c10::q15(0.5));
+  }
+  static_assert(std::is_convertible<q30, c10::fixed<int64_t, 30>>::value, "");
+  static_assert(!std::is_convertible<c10::fixed<int64_t, 30>, q30>::value, "");
+  static_assert(!std::is_convertible<q30, c10::fixed<int64_t, 31>>::value, "");
+  ASSERT_EQ(static_cast<double>(acc), 2.0);
+  ASSERT_EQ(c10::fixed_cast<c10::q15>(acc).raw, 32767);
+  ASSERT_EQ(c10::fixed_cast<c10::q15>(q30::from_raw(3 << 14)).raw, 2);
+  ASSERT_EQ(c10::fixed_cast<c10::q31>(c10::q15(-0.5)).raw, -(1 << 30));
+  ASSERT_EQ((c10::fixed_cast<c10::fixed<int16_t, 8>>(c10::q31(0.75)).raw), 192);
+  ASSERT_EQ((c10::fixed_cast<c10::fixed<int32_t, 20>>(c10::fixed<int64_t, 10>::from_raw(int64_t(1) << 40)).raw), std::numeric_limits<int32_t>::max());
+  // 63 fraction bits, whose scale does not fit in int64_t
+  using q63 = c10::fixed<int64_t, 63>;
+  static_assert(static_cast<double>(q63(0.5)) == 0.5, "");
+  static_assert(q63(-1.0).raw == std::numeric_limits<int64_t>::min(), "");
+  static_assert(q63(1.0).raw == std::numeric_limits<int64_t>::max(), "");
+  ASSERT_EQ(c10::fixed_cast<q63>(c10::fixed<int64_t, 0>::from_raw(-1)).raw, std::numeric_limits<int64_t>::min());
+  ASSERT_EQ(c10::fixed_cast<q63>(c10::fixed<int64_t, 0>::from_raw(1)).raw, std::numeric_limits<int64_t>::max());
+  ASSERT_EQ(c10::fixed_cast<c10::q31>(q63(-0.25)).raw, -(1 << 29));
+}
+
+void test_complex() {
+  using c = c10::complex<c10::q15>;
+  static_assert(sizeof(c) == 4 && alignof(c) == 4, "");
+  static_assert(sizeof(c10::complex<c10::q31>) == 8 && alignof(c10::complex<c10::q31>) == 8, "");
+  const c z(c10::q15(0.5), c10::q15(-0.25));
+  const c w = z * z;
+  ASSERT_EQ(w, c(c10::q15(0.1875), c10::q15(-0.25)));
+  ASSERT_EQ(z + z, c(c10::q15(1.0), c10::q15(-0.5)));
+  const auto p = c10::wide_mul(z, z);
+  ASSERT_EQ(static_cast<double>(p.real()), 0.1875);
+  ASSERT_EQ(c10::fixed_cast<c10::q15>(p), w);
+  // the products widen to the accumulator
+  c10::complex<c10::fixed<int64_t, 30>> acc;
+  for (int i = 0; i < 3; i++) {
+    acc += c10::wide_mul(z, z);
+  }
+  acc -= p;
+  ASSERT_EQ(static_cast<double>(acc.real()), 2 * 0.1875);
+  ASSERT_EQ(static_cast<double>(acc.imag()), -0.5);
+}
+
+void test_bulk() {
+  // equal to operator* bit for bit, including the saturated cases, on every
+  // vector path and the tail
+  std::mt19937 gen(1);
+  std::uniform_int_distribution<int> part(-32768, 32767);
+  std::vector<c10::complex<c10::q15>> x(1003), y(1003), out(1003);
+  for (size_t i = 0; i < x.size(); i++) {
+    x[i] = c10::complex<c10::q15>(c10::q15::from_raw(part(gen)), c10::q15::from_raw(part(gen)));
+    y[i] = c10::complex<c10::q15>(c10::q15::from_raw(part(gen)), c10::q15::from_raw(part(gen)));
+  }
+  const c10::q15 lo = c10::q15::from_raw(-32768), hi = c10::q15::from_raw(32767);
+  x[0] = y[0] = c10::complex<c10::q15>(lo, lo);
+  x[1] = c10::complex<c10::q15>(lo, hi);
+  y[1] = c10::complex<c10::q15>(lo, lo);
+  x[2] = y[2] = c10::complex<c10::q15>(hi, lo);
+  c10::bulk::mul(x.data(), y.data(), out.data(), x.size());
+  for (size_t i = 0; i < x.size(); i++) {
+    ASSERT_EQ(out[i], x[i] * y[i]);
+  }
+  ASSERT_EQ(out[0], c10::complex<c10::q15>(c10::q15(), hi));
+
+  // in place
+  std::vector<c10::complex<c10::q15>> v = x;
+  c10::bulk::mul(v.data(), y.data(), v.data(), v.size());
+  for (size_t i = 0; i < v.size(); i++) {
+    ASSERT_EQ(v[i], out[i]);
+  }
+
+  // exact dot product
+  const auto d = c10::bulk::dot_wide(x.data(), y.data(), x.size());
+  int64_t re = 0, im = 0;
+  for (size_t i = 0; i < x.size(); i++) {
+    re += int64_t(x[i].real().raw) * y[i].real().raw - int64_t(x[i].imag().raw) * y[i].imag().raw;
+    im += int64_t(x[i].real().raw) * y[i].imag().raw + int64_t(x[i].imag().raw) * y[i].real().raw;
+  }
+  ASSERT_EQ(d.real().raw, re);
+  ASSERT_EQ(d.imag().raw, im);
+
+  std::vector<c10::complex<c10::q31>> x31(5), y31(5), out31(5);
+  for (int i = 0; i < 5; i++) {
+    x31[i] = c10::complex<c10::q31>(c10::q31(0.1 * i), c10::q31(-0.5));
+    y31[i] = c10::complex<c10::q31>(c10::q31(0.5), c10::q31(0.05 * i));
+  }
+  c10::bulk::mul(x31.data(), y31.data(), out31.data(), 5);
+  for (int i = 0; i < 5; i++) {
+    const auto e = x31[i] * y31[i];
+    ASSERT_LT(std::abs(out31[i].real().raw - e.real().raw), 2);
+    ASSERT_LT(std::abs(out31[i].imag().raw - e.imag().raw), 2);
+  }
+
+  std::vector<c10::complex<float>> f = {{0.5f, -0.25f}, {2.0f, -2.0f}};
+  std::vector<c10::complex<c10::q15>> q(2);
+  c10::bulk::convert_fixed(f.data(), q.data(), 2);
+  ASSERT_EQ(q[0], c10::complex<c10::q15>(c10::q15(0.5), c10::q15(-0.25)));
+  ASSERT_EQ(q[1], c10::complex<c10::q15>(hi, lo));
+  c10::bulk::convert_fixed(q.data(), f.data(), 2);
+  ASSERT_EQ(f[0], c10::complex<float>(0.5f, -0.25f));
+  ASSERT_EQ(f[1], c10::complex<float>(32767.0f / 32768, -1));
+}
+
+} // namespace fixed
+
+int main() {
+  fixed::test_scalar();
+  fixed::test_complex();
+  fixed::test_bulk();
+}
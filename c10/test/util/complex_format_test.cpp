@@ -0,0 +1,111 @@
+#include <c10/test/util/complex_test_common.h>
+#include <c10/util/complex_format.h>
+
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <iterator>
+#include <limits>
+#include <random>
+#include <string>
+#include <system_error>
+#include <vector>
+
+namespace format {
+
+void test_styles() {
+  c10::complex<double> z(1.5, -2);
+  ASSERT_EQ(c10::to_string(z), "(1.5,-2)");
+  ASSERT_EQ(c10::to_string(z, c10::complex_style::python), "1.5-2j");
+  ASSERT_EQ(c10::to_string(z, c10::complex_style::csv), "1.5,-2");
+  ASSERT_EQ(c10::to_string(c10::complex<double>(0, 0.25), c10::complex_style::python), "0+0.25j");
+  ASSERT_EQ(c10::to_string(c10::complex<double>(-0.0, -0.0), c10::complex_style::python), "-0-0j");
+  ASSERT_EQ(c10::to_string(c10::complex<float>(0.1f, 1e20f)), "(0.1,1e+20)");
+  ASSERT_EQ(c10::to_string(c10::complex<double>(0.1, 1e20)), "(0.1,1e+20)");
+  ASSERT_EQ(c10::to_string(c10::complex<double>(123456, 0.001)), "(123456,0.001)");
+  ASSERT_EQ(c10::to_string(c10::complex<double>(1e-5, 5e-324)), "(1e-05,5e-324)");
+  ASSERT_EQ(c10::to_string(c10::complex<double>(1.7976931348623157e308, -1e100)), "(1.7976931348623157e+308,-1e+100)");
+  const double inf = std::numeric_limits<double>::infinity();
+  const double nan = std::numeric_limits<double>::quiet_NaN();
+  ASSERT_EQ(c10::to_string(c10::complex<double>(inf, -inf)), "(inf,-inf)");
+  ASSERT_EQ(c10::to_string(c10::complex<double>(nan, nan), c10::complex_style::python), "nan+nanj");
+  ASSERT_EQ(c10::to_string(c10::complex<c10::Half>(3, -4), c10::complex_style::python), "3-4j");
+}
+
+template<typename scalar_t>
+void test_round_trip_() {
+  std::mt19937_64 gen(42);
+  std::uniform_int_distribution<uint64_t> bits;
+  for (int i = 0; i < 100000; i++) {
+    // random bit patterns cover all exponents
+    scalar_t values[2];
+    for (auto& v : values) {
+      do {
+        const uint64_t b = bits(gen);
+        std::memcpy(&v, &b, sizeof(v));
+      } while (!std::isfinite(v));
+    }
+    const c10::complex<scalar_t> z(values[0], values[1]);
+    char buffer[c10::complex_max_chars];
+    auto result = c10::to_chars(buffer, buffer + sizeof(buffer), z, c10::complex_style::csv);
+    ASSERT_EQ(result.ec, std::errc());
+    *result.ptr = '\0';
+    char* end;
+    const scalar_t re = static_cast<scalar_t>(std::strtod(buffer, &end));
+    ASSERT_EQ(*end, ',');
+    const scalar_t im = static_cast<scalar_t>(std::strtod(end + 1, &end));
+    ASSERT_EQ(end, result.ptr);
+    ASSERT_EQ(c10::complex<scalar_t>(re, im), z);
+  }
+}
+
+void test_round_trip() {
+  test_round_trip_<float>();
+  test_round_trip_<double>();
+}
+
+void test_buffers() {
+  c10::complex<double> z(0.1, 0.2);
+  char small[8];
+  auto result = c10::to_chars(small, small + sizeof(small), z);
+  ASSERT_EQ(result.ec, std::errc::value_too_large);
+  ASSERT_EQ(result.ptr, small + sizeof(small));
+  char exact[9];
+  result = c10::to_chars(exact, exact + sizeof(exact), z);
+  ASSERT_EQ(result.ec, std::errc());
+  ASSERT_EQ(std::string(exact, result.ptr), "(0.1,0.2)");
+
+  std::string s = "x=";
+  c10::format_to(std::back_inserter(s), z, c10::complex_style::python);
+  ASSERT_EQ(s, "x=0.1+0.2j");
+}
+
+void test_bulk() {
+  std::vector<c10::complex<float>> v(100000);
+  for (size_t i = 0; i < v.size(); i++) {
+    v[i] = c10::complex<float>(i, -0.5f * i);
+  }
+  std::string out = "re,im\n";
+  c10::bulk::format(v.data(), v.size(), out);
+  std::string expected = "re,im\n";
+  for (const auto& z : v) {
+    expected += c10::to_string(z, c10::complex_style::csv) + "\n";
+  }
+  ASSERT_EQ(out, expected);
+
+  c10::bulk::format_options options;
+  options.style = c10::complex_style::python;
+  options.separator = ' ';
+  out.clear();
+  c10::bulk::format(v.data(), 3, out, options);
+  ASSERT_EQ(out, "0-0j 1-0.5j 2-1j ");
+}
+
+} // namespace format
+
+int main() {
+  format::test_styles();
+  format::test_round_trip();
+  format::test_buffers();
+  format::test_bulk();
+}
@@ -0,0 +1,135 @@
+#include <c10/test/util/complex_test_common.h>
+#include <c10/util/complex_int.h>
+
+#include <cmath>
+#include <cstdint>
+#include <limits>
+#include <random>
+#include <vector>
+
+namespace integer {
+
+void test_types() {
+  static_assert(sizeof(c10::complex<int8_t>) == 2 && alignof(c10::complex<int8_t>) == 2, "");
+  static_assert(sizeof(c10::complex<int32_t>) == 8 && alignof(c10::complex<int32_t>) == 8, "");
+  static_assert(std::is_same<c10::complex<int16_t>, c10::complex<c10::Half>>::value, "");
+  constexpr c10::complex<int8_t> z(3, -4);
+  constexpr c10::complex<float> f = z;
+  static_assert(f.real() == 3 && f.imag() == -4, "");
+  static_assert(!std::is_convertible<c10::complex<int32_t>, c10::complex<float>>::value, "");
+  static_assert(std::is_convertible<c10::complex<int32_t>, c10::complex<double>>::value, "");
+  static_assert(!std::is_convertible<c10::complex<float>, c10::complex<int8_t>>::value, "");
+  ASSERT_EQ(c10::complex<int32_t>(c10::complex<double>(2.9, -2.9)), c10::complex<int32_t>(2, -2));
+  ASSERT_EQ(static_cast<c10::complex<float>>(c10::complex<int32_t>(5, 6)), c10::complex<float>(5, 6));
+  // scalar operators wrap like the integer types, mixed ones promote
+  ASSERT_EQ(c10::complex<int32_t>(1, 2) * c10::complex<int32_t>(3, 4), c10::complex<int32_t>(-5, 10));
+  ASSERT_EQ(z + c10::complex<float>(0.5f, 0), c10::complex<float>(3.5f, -4));
+}
+
+template<typename T>
+T reference_saturate(int64_t x) {
+  return static_cast<T>(std::min<int64_t>(std::max<int64_t>(x, std::numeric_limits<T>::min()), std::numeric_limits<T>::max()));
+}
+
+// x / 2^shift rounded half up, for the largest products of int32_t
+int64_t reference_shift(double x, int shift) {
+  return static_cast<int64_t>(std::floor(std::ldexp(x, -shift) + 0.5));
+}
+
+template<typename T>
+void test_kernels_() {
+  using c = c10::complex<T>;
+  const int64_t lo = std::numeric_limits<T>::min();
+  const int64_t hi = std::numeric_limits<T>::max();
+  std::mt19937 gen(3);
+  std::uniform_int_distribution<int64_t> part(lo, hi);
+  std::vector<c> x(1000), y(1000), out(1000);
+  for (size_t i = 0; i < x.size(); i++) {
+    x[i] = c(part(gen), part(gen));
+    y[i] = c(part(gen), part(gen));
+  }
+  // extreme values
+  x[0] = c(lo, lo);
+  y[0] = c(lo, lo);
+  x[1] = c(hi, lo);
+  y[1] = c(hi, hi);
+  c10::bulk::add_sat(x.data(), y.data(), out.data(), x.size());
+  for (size_t i = 0; i < x.size(); i++) {
+    ASSERT_EQ(out[i], c(reference_saturate<T>(int64_t(x[i].real()) + y[i].real()), reference_saturate<T>(int64_t(x[i].imag()) + y[i].imag())));
+  }
+  c10::bulk::sub_sat(x.data(), y.data(), out.data(), x.size());
+  for (size_t i = 0; i < x.size(); i++) {
+    ASSERT_EQ(out[i], c(reference_saturate<T>(int64_t(x[i].real()) - y[i].real()), reference_saturate<T>(int64_t(x[i].imag()) - y[i].imag())));
+  }
+  for (int shift : {0, 1, int(sizeof(T) * 8 - 1), int(sizeof(T) * 8)}) {
+    c10::bulk::mul_shift(x.data(), y.data(), out.data(), x.size(), shift);
+    for (size_t i = 0; i < x.size(); i++) {
+      const double a = x[i].real(), b = x[i].imag(), cr = y[i].real(), d = y[i].imag();
+      // exact in double up to 2^53, and beyond that for the shifts
+      const double re = a * cr - b * d, im = a * d + b * cr;
+      if (std::abs(re) < 9e15 && std::abs(im) < 9e15) {
+        ASSERT_EQ(out[i], c(reference_saturate<T>(reference_shift(re, shift)), reference_saturate<T>(reference_shift(im, shift))));
+      }
+    }
+  }
+  // the extreme case
+  c10::bulk::mul_shift(x.data(), y.data(), out.data(), 1, sizeof(T) * 8 - 1);
+  ASSERT_EQ(out[0], c(0, hi));
+  // in place
+  c10::bulk::add_sat(x.data(), x.data(), x.data(), 1);
+  ASSERT_EQ(x[0], c(lo, lo));
+}
+
+void test_kernels() {
+  test_kernels_<int8_t>();
+  test_kernels_<int16_t>();
+  test_kernels_<int32_t>();
+}
+
+void test_mul_wide() {
+  std::vector<c10::complex<int8_t>> x = {{-128, -128}, {127, -128}, {3, 4}};
+  std::vector<c10::complex<int8_t>> y = {{-128, -128}, {127, 127}, {5, -6}};
+  std::vector<c10::complex<int16_t>> out(3);
+  c10::bulk::mul_wide(x.data(), y.data(), out.data(), 3);
+  ASSERT_EQ(out[0], c10::complex<int16_t>(0, 32767));
+  ASSERT_EQ(out[1], c10::complex<int16_t>(127 * 127 + 128 * 127, 127 * 127 - 128 * 127));
+  ASSERT_EQ(out[2], c10::complex<int16_t>(39, 2));
+  std::vector<c10::complex<int16_t>> u = {{-32768, 32767}, {-32768, -32768}};
+  std::vector<c10::complex<int32_t>> wide(2);
+  c10::bulk::mul_wide(u.data(), u.data(), wide.data(), 2);
+  ASSERT_EQ(wide[0], c10::complex<int32_t>(32768 * 32768 - 32767 * 32767, -2 * 32768 * 32767));
+  ASSERT_EQ(wide[1], c10::complex<int32_t>(0, std::numeric_limits<int32_t>::max()));
+}
+
+void test_convert() {
+  const float nan = std::numeric_limits<float>::quiet_NaN();
+  std::vector<c10::complex<float>> f = {{1.5f, 2.5f}, {-1.5f, 1e10f}, {-1e10f, nan}, {127.4f, -128.6f}};
+  std::vector<c10::complex<int8_t>> i8(4);
+  c10::bulk::convert_int(f.data(), i8.data(), 4);
+  ASSERT_EQ(i8[0], c10::complex<int8_t>(2, 2));
+  ASSERT_EQ(i8[1], c10::complex<int8_t>(-2, 127));
+  ASSERT_EQ(i8[2], c10::complex<int8_t>(-128, 0));
+  ASSERT_EQ(i8[3], c10::complex<int8_t>(127, -128));
+  std::vector<c10::complex<int32_t>> i32(4);
+  c10::bulk::convert_int(f.data(), i32.data(), 4, 0.5f);
+  ASSERT_EQ(i32[0], c10::complex<int32_t>(3, 5));
+  ASSERT_EQ(i32[1], c10::complex<int32_t>(-3, std::numeric_limits<int32_t>::max()));
+  ASSERT_EQ(i32[2], c10::complex<int32_t>(std::numeric_limits<int32_t>::min(), 0));
+  ASSERT_EQ(i32[3], c10::complex<int32_t>(255, -257));
+  std::vector<c10::complex<float>> back(4);
+  c10::bulk::convert_int(i32.data(), back.data(), 4, 0.5f);
+  ASSERT_EQ(back[0], c10::complex<float>(1.5f, 2.5f));
+  ASSERT_EQ(back[3], c10::complex<float>(127.5f, -128.5f));
+  std::vector<c10::complex<int16_t>> i16 = {{-32768, 32767}};
+  c10::bulk::convert_int(i16.data(), back.data(), 1, 1.0f / 32768);
+  ASSERT_EQ(back[0], c10::complex<float>(-1, 32767.0f / 32768));
+}
+
+} // namespace integer
+
+int main() {
+  integer::test_types();
+  integer::test_kernels();
+  integer::test_mul_wide();
+  integer::test_convert();
+}
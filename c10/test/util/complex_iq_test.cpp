@@ -0,0 +1,175 @@
+#include <c10/test/util/complex_test_common.h>
+#include <c10/util/complex_iq.h>
+
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <limits>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+namespace iq {
+
+void test_datatypes() {
+  for (const char* name : {"cf64_le", "cf32_be", "ci32_le", "ci16_be", "ci8", "cu8"}) {
+    ASSERT_EQ(c10::to_string(c10::parse_iq_datatype(name)), std::string(name));
+  }
+  ASSERT_EQ(c10::iq_sample_size(c10::parse_iq_datatype("ci16_le")), 4);
+  bool thrown = false;
+  try {
+    c10::parse_iq_datatype("rf32_le");
+  } catch (const std::invalid_argument&) {
+    thrown = true;
+  }
+  ASSERT_EQ(thrown, true);
+}
+
+void test_convert() {
+  // integers saturate and round to nearest, cu8 is offset by 128
+  const c10::complex<float> in[] = {{1.4f, -1.6f}, {40000, -40000}, {-0.5f, 127.6f}};
+  int16_t i16[6];
+  c10::bulk::convert_iq(in, 3, c10::iq_datatype{c10::iq_format::ci16, c10::detail::host_little_endian()}, i16);
+  const int16_t expected16[] = {1, -2, 32767, -32768, 0, 128};
+  for (int i = 0; i < 6; i++) {
+    ASSERT_EQ(i16[i], expected16[i]);
+  }
+  uint8_t u8[6];
+  c10::bulk::convert_iq(in, 3, c10::iq_datatype{c10::iq_format::cu8, true}, u8);
+  const uint8_t expected8[] = {129, 126, 255, 0, 128, 255};
+  for (int i = 0; i < 6; i++) {
+    ASSERT_EQ(u8[i], expected8[i]);
+  }
+  c10::complex<float> out[3];
+  c10::bulk::convert_iq(u8, c10::iq_datatype{c10::iq_format::cu8, true}, out, 3, 0.5f);
+  ASSERT_EQ(out[0], c10::complex<float>(0.5f, -1));
+  ASSERT_EQ(out[1], c10::complex<float>(63.5f, -64));
+
+  // NaN is written as 0, the offset for cu8
+  const float nan = std::numeric_limits<float>::quiet_NaN();
+  const c10::complex<float> nans[] = {{nan, 1}, {-1, nan}};
+  int8_t i8[4];
+  c10::bulk::convert_iq(nans, 2, c10::iq_datatype{c10::iq_format::ci8, true}, i8);
+  ASSERT_EQ(i8[0], 0);
+  ASSERT_EQ(i8[3], 0);
+  c10::bulk::convert_iq(nans, 2, c10::iq_datatype{c10::iq_format::cu8, true}, u8);
+  ASSERT_EQ(u8[0], 128);
+  ASSERT_EQ(u8[1], 129);
+  ASSERT_EQ(u8[3], 128);
+
+  // byte order
+  const unsigned char be[] = {0x01, 0x02, 0xff, 0xfe};
+  c10::bulk::convert_iq(be, c10::iq_datatype{c10::iq_format::ci16, false}, out, 1);
+  ASSERT_EQ(out[0], c10::complex<float>(258, -2));
+  c10::bulk::convert_iq(be, c10::iq_datatype{c10::iq_format::ci8, false}, out, 2);
+  ASSERT_EQ(out[1], c10::complex<float>(-1, -2));
+}
+
+void test_sigmf() {
+  const std::string meta = "complex_iq_test_meta.sigmf-meta";
+  {
+    std::FILE* f = std::fopen(meta.c_str(), "wb");
+    const char* json =
+        "{\"annotations\": [{\"core:sample_start\": 0, \"core:datatype\": \"x\"}],\n"
+        " \"global\": {\"core:author\": \"a \\\"b\\\"\", \"core:sample_rate\": 2.4e6,\n"
+        "   \"core:extensions\": [], \"core:datatype\": \"ci16_be\", \"core:hw\": null,\n"
+        "   \"core:num_channels\": 2}, \"captures\": []}";
+    std::fputs(json, f);
+    std::fclose(f);
+  }
+  c10::sigmf_metadata m = c10::read_sigmf_metadata(meta);
+  ASSERT_EQ(m.datatype, c10::parse_iq_datatype("ci16_be"));
+  ASSERT_EQ(m.sample_rate, 2.4e6);
+  ASSERT_EQ(m.num_channels, 2);
+
+  m.datatype = c10::iq_datatype{c10::iq_format::cf32, true};
+  m.sample_rate = 1e6 / 3;
+  c10::write_sigmf_metadata(meta, m);
+  const c10::sigmf_metadata n = c10::read_sigmf_metadata(meta);
+  ASSERT_EQ(n.datatype, m.datatype);
+  ASSERT_EQ(n.sample_rate, m.sample_rate);
+  ASSERT_EQ(n.num_channels, 2);
+  ASSERT_EQ(n.version, "1.0.0");
+
+  {
+    std::FILE* f = std::fopen(meta.c_str(), "wb");
+    std::fputs("{\"global\": {\"core:sample_rate\": 1}}", f);
+    std::fclose(f);
+  }
+  bool thrown = false;
+  try {
+    c10::read_sigmf_metadata(meta);
+  } catch (const std::runtime_error& e) {
+    thrown = std::string(e.what()).find("core:datatype") != std::string::npos;
+  }
+  ASSERT_EQ(thrown, true);
+  std::remove(meta.c_str());
+}
+
+void test_streams() {
+  // more blocks than buffers, and a last block that is not full
+  std::vector<c10::complex<float>> v(1000);
+  for (size_t i = 0; i < v.size(); i++) {
+    v[i] = c10::complex<float>(int(i % 200) - 100, -int(i % 100));
+  }
+  c10::iq_options options;
+  options.block_samples = 64;
+  for (const char* name : {"cf64_be", "cf32_le", "ci32_be", "ci16_le", "ci8", "cu8"}) {
+    c10::sigmf_metadata m;
+    m.datatype = c10::parse_iq_datatype(name);
+    m.sample_rate = 1e6;
+    {
+      c10::iq_writer w = c10::iq_writer::create_sigmf("complex_iq_test", m, options);
+      w.write(v.data(), 300);
+      w.write(c10::span<const c10::complex<float>>(v.data() + 300, 700));
+      w.close();
+    }
+    c10::iq_reader r = c10::iq_reader::open_sigmf("complex_iq_test", options);
+    ASSERT_EQ(r.metadata().sample_rate, 1e6);
+    std::vector<c10::complex<float>> w(v.size() + 10);
+    int64_t total = 0;
+    // read sizes that do not divide the blocks
+    while (int64_t n = r.read(w.data() + total, std::min<int64_t>(37, w.size() - total))) {
+      total += n;
+    }
+    ASSERT_EQ(total, static_cast<int64_t>(v.size()));
+    ASSERT_EQ(r.read(w.data(), 10), 0);
+    for (size_t i = 0; i < v.size(); i++) {
+      ASSERT_EQ(w[i], v[i]);
+    }
+  }
+  std::remove("complex_iq_test.sigmf-meta");
+  std::remove("complex_iq_test.sigmf-data");
+
+  // the reader can be dropped before the end of the file
+  {
+    c10::iq_writer w("complex_iq_test.cf32", c10::iq_datatype(), options);
+    w.write(v.data(), v.size());
+  }
+  {
+    c10::iq_reader r("complex_iq_test.cf32", c10::iq_datatype(), options);
+    c10::complex<float> z;
+    ASSERT_EQ(r.read(&z, 1), 1);
+    ASSERT_EQ(z, v[0]);
+  }
+  // assigning over a writer closes its file first
+  {
+    c10::iq_writer w("complex_iq_test.cf32", c10::iq_datatype(), options);
+    w.write(v.data(), 10);
+    w = c10::iq_writer("complex_iq_test.2.cf32", c10::iq_datatype(), options);
+    w.write(v.data(), 20);
+  }
+  ASSERT_EQ(c10::iq_reader("complex_iq_test.cf32", c10::iq_datatype(), options).read(v.data(), v.size()), 10);
+  ASSERT_EQ(c10::iq_reader("complex_iq_test.2.cf32", c10::iq_datatype(), options).read(v.data(), v.size()), 20);
+  std::remove("complex_iq_test.2.cf32");
+  std::remove("complex_iq_test.cf32");
+}
+
+} // namespace iq
+
+int main() {
+  iq::test_datatypes();
+  iq::test_convert();
+  iq::test_sigmf();
+  iq::test_streams();
+}
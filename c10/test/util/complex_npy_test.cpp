@@ -0,0 +1,245 @@
+#include <c10/test/util/complex_test_common.h>
+#include <c10/util/complex_npy.h>
+
+#include <cstdint>
+#include <cstdio>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+namespace npy {
+
+const std::string npy_path = "complex_npy_test.npy";
+const std::string npz_path = "complex_npy_test.npz";
+
+template<typename scalar_t>
+std::vector<c10::complex<scalar_t>> make_data(int64_t n) {
+  std::vector<c10::complex<scalar_t>> v(n);
+  for (int64_t i = 0; i < n; i++) {
+    v[i] = c10::complex<scalar_t>(scalar_t(i), scalar_t(0.5) - scalar_t(i));
+  }
+  return v;
+}
+
+// Writes a .npy with the given header dictionary, padded so that the data
+// starts at data_offset, followed by data
+void write_npy(const std::string& dict, size_t data_offset, const void* data, size_t bytes) {
+  std::string header("\x93NUMPY\x01\x00", 8);
+  const size_t length = data_offset - 10;
+  header += static_cast<char>(length & 0xff);
+  header += static_cast<char>(length >> 8);
+  header += dict;
+  header.append(data_offset - header.size() - 1, ' ');
+  header += '\n';
+  std::FILE* f = std::fopen(npy_path.c_str(), "wb");
+  std::fwrite(header.data(), 1, header.size(), f);
+  std::fwrite(data, 1, bytes, f);
+  std::fclose(f);
+}
+
+template<typename scalar_t>
+void test_npy_() {
+  auto v = make_data<scalar_t>(24);
+  c10::save_npy(npy_path, v.data(), {2, 3, 4});
+  auto header = c10::read_npy_header(npy_path);
+  ASSERT_EQ(header.dtype, c10::complex_dtype_of<scalar_t>::value);
+  ASSERT_EQ(header.shape, std::vector<int64_t>({2, 3, 4}));
+  ASSERT_EQ(header.fortran_order, false);
+  ASSERT_EQ(header.data_offset % 64, 0);
+
+  auto a = c10::map_npy<scalar_t>(npy_path);
+  ASSERT_EQ(a.is_mapped(), true);
+  ASSERT_EQ(a.size(), 24);
+  for (int64_t i = 0; i < 24; i++) {
+    ASSERT_EQ(a[i], v[i]);
+  }
+  std::vector<int64_t> shape;
+  auto b = c10::load_npy<scalar_t>(npy_path, &shape);
+  ASSERT_EQ(shape, header.shape);
+  for (int64_t i = 0; i < 24; i++) {
+    ASSERT_EQ(b[i], v[i]);
+  }
+
+  // 1-d and 0-d
+  c10::save_npy(npy_path, v.data(), {5});
+  ASSERT_EQ(c10::read_npy_header(npy_path).shape, std::vector<int64_t>({5}));
+  c10::save_npy(npy_path, v.data() + 3, {});
+  auto scalar = c10::load_npy<scalar_t>(npy_path, &shape);
+  ASSERT_EQ(shape.size(), 0);
+  ASSERT_EQ(scalar.size(), 1);
+  ASSERT_EQ(scalar[0], v[3]);
+}
+
+void test_npy() {
+  test_npy_<float>();
+  test_npy_<double>();
+}
+
+void test_fortran_order() {
+  // a 2x3 matrix in Fortran order: columns are contiguous
+  auto v = make_data<double>(6);
+  c10::save_npy(npy_path, v.data(), {2, 3}, true);
+  ASSERT_EQ(c10::read_npy_header(npy_path).fortran_order, true);
+  auto a = c10::map_npy<double>(npy_path);
+  ASSERT_EQ(a.fortran_order(), true);
+  ASSERT_EQ(a[1], v[1]);
+  auto b = c10::load_npy<double>(npy_path);
+  for (int64_t i = 0; i < 2; i++) {
+    for (int64_t j = 0; j < 3; j++) {
+      ASSERT_EQ(b[i * 3 + j], v[j * 2 + i]);
+    }
+  }
+  // 3-d
+  auto w = make_data<float>(24);
+  c10::save_npy(npy_path, w.data(), {2, 3, 4}, true);
+  auto c = c10::load_npy<float>(npy_path);
+  for (int64_t i = 0; i < 2; i++) {
+    for (int64_t j = 0; j < 3; j++) {
+      for (int64_t k = 0; k < 4; k++) {
+        ASSERT_EQ(c[(i * 3 + j) * 4 + k], w[i + 2 * (j + 3 * k)]);
+      }
+    }
+  }
+}
+
+void test_fallback() {
+  auto v = make_data<double>(4);
+  // data that is not aligned to 16 bytes is copied
+  write_npy("{'descr': '<c16', 'fortran_order': False, 'shape': (4,), }", 88, v.data(), 4 * sizeof(v[0]));
+  auto a = c10::map_npy<double>(npy_path);
+  ASSERT_EQ(a.is_mapped(), false);
+  for (int64_t i = 0; i < 4; i++) {
+    ASSERT_EQ(a[i], v[i]);
+  }
+  // so is data of the other byte order
+  auto swapped = v;
+  c10::detail::swap_bytes(swapped.data(), 8, sizeof(double));
+  const char* dict = c10::detail::host_little_endian() ?
+    "{'descr': '>c16', 'fortran_order': False, 'shape': (4,), }" :
+    "{'descr': '<c16', 'fortran_order': False, 'shape': (4,), }";
+  write_npy(dict, 128, swapped.data(), 4 * sizeof(v[0]));
+  auto b = c10::map_npy<double>(npy_path);
+  ASSERT_EQ(b.is_mapped(), false);
+  auto c = c10::load_npy<double>(npy_path);
+  for (int64_t i = 0; i < 4; i++) {
+    ASSERT_EQ(b[i], v[i]);
+    ASSERT_EQ(c[i], v[i]);
+  }
+  // other dtypes are rejected
+  write_npy("{'descr': '<f8', 'fortran_order': False, 'shape': (8,), }", 128, v.data(), 4 * sizeof(v[0]));
+  bool thrown = false;
+  try {
+    c10::map_npy<double>(npy_path);
+  } catch (const std::runtime_error&) {
+    thrown = true;
+  }
+  ASSERT_EQ(thrown, true);
+  c10::save_npy(npy_path, v.data(), {4});
+  thrown = false;
+  try {
+    c10::load_npy<float>(npy_path);
+  } catch (const std::runtime_error&) {
+    thrown = true;
+  }
+  ASSERT_EQ(thrown, true);
+}
+
+void test_npz() {
+  auto v = make_data<float>(12);
+  auto w = make_data<double>(6);
+  {
+    c10::npz_writer writer(npz_path);
+    writer.add("v", v.data(), {3, 4});
+    writer.add("w", w.data(), {2, 3}, true);
+  }
+  c10::npz_file f(npz_path);
+  ASSERT_EQ(f.names(), std::vector<std::string>({"v", "w"}));
+  ASSERT_EQ(f.contains("w"), true);
+  ASSERT_EQ(f.contains("x"), false);
+  ASSERT_EQ(f.header("v").shape, std::vector<int64_t>({3, 4}));
+
+  // stored entries are aligned and mapped
+  auto a = f.map<float>("v");
+  ASSERT_EQ(a.is_mapped(), true);
+  for (int64_t i = 0; i < 12; i++) {
+    ASSERT_EQ(a[i], v[i]);
+  }
+  std::vector<int64_t> shape;
+  auto b = f.load<double>("w", &shape);
+  ASSERT_EQ(shape, std::vector<int64_t>({2, 3}));
+  for (int64_t i = 0; i < 2; i++) {
+    for (int64_t j = 0; j < 3; j++) {
+      ASSERT_EQ(b[i * 3 + j], w[j * 2 + i]);
+    }
+  }
+  bool thrown = false;
+  try {
+    f.map<double>("x");
+  } catch (const std::runtime_error&) {
+    thrown = true;
+  }
+  ASSERT_EQ(thrown, true);
+
+  // sizes past the end of the archive, and compressed entries, are
+  // rejected when it is opened
+  std::string archive;
+  {
+    std::FILE* in = std::fopen(npz_path.c_str(), "rb");
+    char buffer[4096];
+    size_t n;
+    while ((n = std::fread(buffer, 1, sizeof(buffer), in)) > 0) {
+      archive.append(buffer, n);
+    }
+    std::fclose(in);
+  }
+  const size_t central = archive.find("PK\x01\x02");
+  ASSERT_EQ(central != std::string::npos, true);
+  const std::string corrupt_path = "complex_npy_test_corrupt.npz";
+  auto opens = [&](size_t offset, const std::string& bytes) {
+    std::string corrupt = archive;
+    corrupt.replace(central + offset, bytes.size(), bytes);
+    std::FILE* out = std::fopen(corrupt_path.c_str(), "wb");
+    std::fwrite(corrupt.data(), 1, corrupt.size(), out);
+    std::fclose(out);
+    bool opened = true;
+    try {
+      c10::npz_file corrupt_file(corrupt_path);
+    } catch (const std::runtime_error&) {
+      opened = false;
+    }
+    std::remove(corrupt_path.c_str());
+    return opened;
+  };
+  ASSERT_EQ(opens(0, "PK"), true);
+  // uncompressed size, then both sizes
+  ASSERT_EQ(opens(24, std::string("\x00\x00\x00\x10", 4)), false);
+  ASSERT_EQ(opens(20, std::string("\x00\x00\x00\x10\x00\x00\x00\x10", 8)), false);
+  // deflate
+  ASSERT_EQ(opens(10, std::string("\x08\x00", 2)), false);
+
+  // assigning over a writer completes its archive first
+  const std::string other = npz_path + ".2";
+  {
+    c10::npz_writer writer(npz_path);
+    writer.add("v", v.data(), {12});
+    writer = c10::npz_writer(other);
+    writer.add("w", w.data(), {6});
+  }
+  ASSERT_EQ(c10::npz_file(npz_path).names(), std::vector<std::string>({"v"}));
+  ASSERT_EQ(c10::npz_file(other).names(), std::vector<std::string>({"w"}));
+  std::remove(other.c_str());
+
+  // CRC-32 of "123456789"
+  ASSERT_EQ(c10::detail::crc32_update(0, "123456789", 9), 0xcbf43926u);
+}
+
+} // namespace npy
+
+int main() {
+  npy::test_npy();
+  npy::test_fortran_order();
+  npy::test_fallback();
+  npy::test_npz();
+  std::remove(npy::npy_path.c_str());
+  std::remove(npy::npz_path.c_str());
+}
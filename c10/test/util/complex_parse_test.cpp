@@ -0,0 +1,200 @@
+#include <c10/test/util/complex_test_common.h>
+#include <c10/util/complex_format.h>
+#include <c10/util/complex_parse.h>
+
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <limits>
+#include <random>
+#include <stdexcept>
+#include <string>
+#include <system_error>
+#include <vector>
+
+namespace parse {
+
+template<typename scalar_t>
+c10::complex<scalar_t> parse_all(const std::string& s) {
+  c10::complex<scalar_t> z(-99, -99);
+  auto r = c10::from_chars(s.data(), s.data() + s.size(), z);
+  ASSERT_EQ(r.ec, std::errc());
+  ASSERT_EQ(r.ptr, s.data() + s.size());
+  return z;
+}
+
+void test_notations() {
+  using c = c10::complex<double>;
+  ASSERT_EQ(parse_all<double>("(1.5,-2)"), c(1.5, -2));
+  ASSERT_EQ(parse_all<double>("( 1.5 , -2 )"), c(1.5, -2));
+  ASSERT_EQ(parse_all<double>("(1.5)"), c(1.5, 0));
+  ASSERT_EQ(parse_all<double>("1.5-2j"), c(1.5, -2));
+  ASSERT_EQ(parse_all<double>("1.5+2i"), c(1.5, 2));
+  ASSERT_EQ(parse_all<double>("(1.5-2j)"), c(1.5, -2));
+  ASSERT_EQ(parse_all<double>("-2j"), c(0, -2));
+  ASSERT_EQ(parse_all<double>("2I"), c(0, 2));
+  ASSERT_EQ(parse_all<double>("1+j"), c(1, 1));
+  ASSERT_EQ(parse_all<double>("-j"), c(0, -1));
+  ASSERT_EQ(parse_all<double>("1.5"), c(1.5, 0));
+  ASSERT_EQ(parse_all<double>("1e3-.5e-1j"), c(1000, -0.05));
+  ASSERT_EQ(parse_all<double>("12345678901234567890123"), c(12345678901234567890123.0, 0));
+  ASSERT_EQ(parse_all<double>("0.000000000000000000000000001"), c(1e-27, 0));
+  ASSERT_EQ(parse_all<float>("(0.1,-3.4028235e38)"), c10::complex<float>(0.1f, -3.4028235e38f));
+  const double inf = std::numeric_limits<double>::infinity();
+  ASSERT_EQ(parse_all<double>("inf-infj"), c(inf, -inf));
+  ASSERT_EQ(parse_all<double>("(-Infinity,INF)"), c(-inf, inf));
+  auto n = parse_all<double>("nan+nanj");
+  ASSERT_EQ(std::isnan(n.real()) && std::isnan(n.imag()), true);
+
+  // parsing stops at the first character that does not belong
+  const std::string s = "1+2j, 3";
+  c10::complex<double> z;
+  auto r = c10::from_chars(s.data(), s.data() + s.size(), z);
+  ASSERT_EQ(r.ptr, s.data() + 4);
+  ASSERT_EQ(z, c(1, 2));
+  const std::string t = "1+2";
+  r = c10::from_chars(t.data(), t.data() + t.size(), z);
+  ASSERT_EQ(r.ptr, t.data() + 1);
+  ASSERT_EQ(z, c(1, 0));
+
+  // errors leave z alone
+  for (const std::string bad : {"", "x", "(1,2", "(,2)", ".", "+", "(1 2)"}) {
+    z = c(7, 7);
+    r = c10::from_chars(bad.data(), bad.data() + bad.size(), z);
+    ASSERT_EQ(r.ec, std::errc::invalid_argument);
+    ASSERT_EQ(r.ptr, bad.data());
+    ASSERT_EQ(z, c(7, 7));
+  }
+  const std::string big = "(1e400,0)";
+  r = c10::from_chars(big.data(), big.data() + big.size(), z);
+  ASSERT_EQ(r.ec, std::errc::result_out_of_range);
+  ASSERT_EQ(z, c(7, 7));
+}
+
+template<typename scalar_t>
+void test_round_trip_() {
+  // the text of c10::to_chars reads back exactly, in every style
+  std::mt19937_64 gen(7);
+  std::uniform_int_distribution<uint64_t> bits;
+  for (int i = 0; i < 50000; i++) {
+    scalar_t values[2];
+    for (auto& v : values) {
+      do {
+        const uint64_t b = bits(gen);
+        std::memcpy(&v, &b, sizeof(v));
+      } while (!std::isfinite(v));
+    }
+    const c10::complex<scalar_t> z(values[0], values[1]);
+    for (auto style : {c10::complex_style::parenthesized, c10::complex_style::python}) {
+      ASSERT_EQ(parse_all<scalar_t>(c10::to_string(z, style)), z);
+    }
+  }
+}
+
+void test_round_trip() {
+  test_round_trip_<float>();
+  test_round_trip_<double>();
+}
+
+void test_csv() {
+  const std::string text = "id,z,note\n0,1+2j,a\r\n1,\"(3,-4)\",b\n\n2, (5,6) ,c\n";
+  c10::csv_options options;
+  options.skip_rows = 1;
+  auto v = c10::parse_csv_column<double>(text.data(), text.data() + text.size(), 1, options);
+  ASSERT_EQ(v.size(), 3);
+  ASSERT_EQ(v[0], c10::complex<double>(1, 2));
+  ASSERT_EQ(v[1], c10::complex<double>(3, -4));
+  ASSERT_EQ(v[2], c10::complex<double>(5, 6));
+
+  // real and imaginary columns, without a final line break
+  const std::string columns = "re;im\n1.5;-2\n0;1e-3";
+  options.delimiter = ';';
+  options.imag_column = 1;
+  auto w = c10::parse_csv_column<float>(columns.data(), columns.data() + columns.size(), 0, options);
+  ASSERT_EQ(w.size(), 2);
+  ASSERT_EQ(w[0], c10::complex<float>(1.5f, -2));
+  ASSERT_EQ(w[1], c10::complex<float>(0, 1e-3f));
+
+  // errors name the line in the text, counting skipped and empty lines
+  const std::string bad = "z\n1+2j\n\n3+x\n";
+  bool thrown = false;
+  try {
+    c10::csv_options header;
+    header.skip_rows = 1;
+    c10::parse_csv_column<double>(bad.data(), bad.data() + bad.size(), 0, header);
+  } catch (const std::runtime_error& e) {
+    thrown = std::string(e.what()).find("line 4:") != std::string::npos;
+  }
+  ASSERT_EQ(thrown, true);
+  thrown = false;
+  try {
+    c10::parse_csv_column<double>(bad.data(), bad.data() + bad.size(), 1);
+  } catch (const std::runtime_error&) {
+    thrown = true;
+  }
+  ASSERT_EQ(thrown, true);
+}
+
+void test_csv_parallel() {
+  // large enough to be split between threads
+  std::vector<c10::complex<double>> v(200000);
+  for (size_t i = 0; i < v.size(); i++) {
+    v[i] = c10::complex<double>(i * 0.25, -double(i));
+  }
+  std::string text = "z\n";
+  c10::bulk::format_options format;
+  format.style = c10::complex_style::python;
+  c10::bulk::format(v.data(), v.size(), text, format);
+  const std::string path = "complex_parse_test.csv";
+  {
+    std::FILE* f = std::fopen(path.c_str(), "wb");
+    std::fwrite(text.data(), 1, text.size(), f);
+    std::fclose(f);
+  }
+  c10::csv_options options;
+  options.skip_rows = 1;
+  for (int threads : {1, 4}) {
+    c10::set_num_threads(threads);
+    auto w = c10::read_csv_column<double>(path, 0, options);
+    ASSERT_EQ(w.size(), static_cast<int64_t>(v.size()));
+    for (size_t i = 0; i < v.size(); i++) {
+      ASSERT_EQ(w[i], v[i]);
+    }
+  }
+  // the line of the first error, in a later part and after an empty line,
+  // whichever part fails first
+  auto line_start = [&](size_t line) {
+    size_t pos = 0;
+    for (size_t i = 1; i < line; i++) {
+      pos = text.find('\n', pos) + 1;
+    }
+    return pos;
+  };
+  const size_t line = 100000;
+  text.insert(line_start(170000), "x");
+  const size_t pos = line_start(line - 1);
+  text.insert(pos, "\n");
+  text.insert(pos + 1, "x");
+  for (int threads : {1, 4}) {
+    c10::set_num_threads(threads);
+    bool thrown = false;
+    try {
+      c10::parse_csv_column<double>(text.data(), text.data() + text.size(), 0, options);
+    } catch (const std::runtime_error& e) {
+      thrown = std::string(e.what()).find("line " + std::to_string(line) + ":") != std::string::npos;
+    }
+    ASSERT_EQ(thrown, true);
+  }
+  c10::set_num_threads(0);
+  std::remove(path.c_str());
+}
+
+} // namespace parse
+
+int main() {
+  parse::test_notations();
+  parse::test_round_trip();
+  parse::test_csv();
+  parse::test_csv_parallel();
+}
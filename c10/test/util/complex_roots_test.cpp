@@ -0,0 +1,74 @@
+#include <c10/test/util/complex_test_common.h>
+#include <c10/util/complex_roots.h>
+
+#include <cmath>
+#include <limits>
+
+namespace static_roots {
+
+using roots16 = c10::static_roots_of_unity<double, 16>;
+static_assert(roots16::view()[0] == c10::complex<double>(1, 0), "");
+static_assert(roots16::view()[4] == c10::complex<double>(0, 1), "");
+static_assert(roots16::view()[8] == c10::complex<double>(-1, 0), "");
+static_assert(roots16::view()[2].real() == roots16::view()[2].imag(), "");
+static_assert(roots16::view()[3] == c10::complex<double>(roots16::view()[1].imag(), roots16::view()[1].real()), "");
+static_assert(roots16::view().twiddle(4) == c10::complex<double>(0, -1), "");
+// a view of a divisor of the size
+static_assert(roots16::view(4)[1] == c10::complex<double>(0, 1), "");
+static_assert(roots16::view(4).size() == 4, "");
+// only the first octant is stored
+static_assert(sizeof(roots16::table) == 3 * sizeof(c10::complex<double>), "");
+static_assert(sizeof(c10::static_roots_of_unity<float, 12>::table) == 4 * sizeof(c10::complex<float>), "");
+static_assert(sizeof(c10::static_roots_of_unity<float, 6>::table) == 4 * sizeof(c10::complex<float>), "");
+static_assert(sizeof(c10::static_roots_of_unity<float, 5>::table) == 6 * sizeof(c10::complex<float>), "");
+
+} // namespace static_roots
+
+namespace roots_values {
+
+// exact up to the rounding to scalar_t, and exactly symmetric
+template<typename scalar_t>
+void check_roots(c10::roots_of_unity_view<scalar_t> view, scalar_t ulps) {
+  const int64_t n = view.size();
+  const long double pi = 3.141592653589793238462643383279502884L;
+  for (int64_t k = 0; k < n; k++) {
+    long double angle = 2 * pi * k / n;
+    c10::complex<scalar_t> w = view[k];
+    scalar_t tol = ulps * std::numeric_limits<scalar_t>::epsilon() / 2;
+    ASSERT_EQ(std::abs(w.real() - std::cos(angle)) <= tol, true);
+    ASSERT_EQ(std::abs(w.imag() - std::sin(angle)) <= tol, true);
+    ASSERT_EQ(view[(n - k) % n], std::conj(w));
+    ASSERT_EQ(view.twiddle(k), std::conj(w));
+    if (4 * k % n == 0) {
+      ASSERT_EQ(std::abs(w.real()) + std::abs(w.imag()), scalar_t(1));
+    }
+  }
+}
+
+template<typename scalar_t>
+void test_roots_() {
+  // compile-time tables are correctly rounded
+  check_roots(c10::static_roots_of_unity<scalar_t, 4096>::view(), scalar_t(1.0001));
+  check_roots(c10::static_roots_of_unity<scalar_t, 360>::view(), scalar_t(1.0001));
+  check_roots(c10::static_roots_of_unity<scalar_t, 15>::view(), scalar_t(1.0001));
+  for (int64_t n : {1, 2, 3, 4, 5, 6, 7, 8, 12, 64, 100, 768, 1000, 5120, 6000, 7919}) {
+    check_roots(c10::roots_of_unity<scalar_t>(n), scalar_t(1.01));
+  }
+  // runtime tables are built once
+  auto first = c10::roots_of_unity<scalar_t>(1000);
+  auto second = c10::roots_of_unity<scalar_t>(1000);
+  for (int64_t k = 0; k < 1000; k++) {
+    ASSERT_EQ(first[k], second[k]);
+  }
+}
+
+void test_roots() {
+  test_roots_<float>();
+  test_roots_<double>();
+}
+
+} // namespace roots_values
+
+int main() {
+  roots_values::test_roots();
+}
@@ -0,0 +1,118 @@
+#include <c10/test/util/complex_test_common.h>
+#include <c10/util/complex_span.h>
+
+#include <complex>
+#include <stdexcept>
+#include <type_traits>
+#include <vector>
+
+namespace span_basics {
+
+constexpr int values[] = {1, 2, 3};
+static_assert(c10::span<const int>(values).size() == 3, "");
+static_assert(c10::span<const int>(values)[2] == 3, "");
+static_assert(c10::span<const int>(values).subspan(1, 2)[0] == 2, "");
+
+void test_span() {
+  std::vector<c10::complex<float>> v = {{1, 2}, {3, 4}};
+  auto s = c10::make_span(v);
+  static_assert(std::is_same<decltype(s), c10::span<c10::complex<float>>>::value, "");
+  ASSERT_EQ(s.size(), 2);
+  ASSERT_EQ(s.data(), v.data());
+  s[1] = c10::complex<float>(5, 6);
+  ASSERT_EQ(v[1], c10::complex<float>(5, 6));
+  const std::vector<c10::complex<float>>& cv = v;
+  static_assert(std::is_same<decltype(c10::make_span(cv)), c10::span<const c10::complex<float>>>::value, "");
+  c10::span<const c10::complex<float>> cs = s;
+  int64_t count = 0;
+  for (const auto& z : cs) {
+    ASSERT_EQ(z, v[count++]);
+  }
+  ASSERT_EQ(count, 2);
+  ASSERT_EQ(c10::span<int>().empty(), true);
+}
+
+} // namespace span_basics
+
+namespace span_views {
+
+template<typename scalar_t>
+void test_views_() {
+  std::vector<c10::complex<scalar_t>> v = {{1, 2}, {3, 4}, {5, 6}};
+  auto s = c10::make_span(v);
+
+  // the views share the data
+  auto std_view = c10::as_std_complex(s);
+  static_assert(std::is_same<decltype(std_view), c10::span<std::complex<scalar_t>>>::value, "");
+  ASSERT_EQ(std_view.size(), 3);
+  ASSERT_EQ(std_view[1], std::complex<scalar_t>(3, 4));
+  std_view[1] *= scalar_t(2);
+  ASSERT_EQ(v[1], c10::complex<scalar_t>(6, 8));
+
+  auto interleaved = c10::as_interleaved(s);
+  ASSERT_EQ(interleaved.size(), 6);
+  ASSERT_EQ(interleaved[4], scalar_t(5));
+  ASSERT_EQ(interleaved[5], scalar_t(6));
+
+#if defined(C10_HAS_C_COMPLEX)
+  auto c_view = c10::as_c_complex(s);
+  ASSERT_EQ(__real__ c_view[2], scalar_t(5));
+  ASSERT_EQ(__imag__ c_view[2], scalar_t(6));
+  ASSERT_EQ(c10::as_c10_complex(c_view).data(), v.data());
+  static_assert(std::is_same<decltype(c10::as_c10_complex(c10::as_c_complex(c10::span<const c10::complex<scalar_t>>(s)))), c10::span<const c10::complex<scalar_t>>>::value, "");
+#endif
+
+  // and back
+  ASSERT_EQ(c10::as_c10_complex(std_view).data(), v.data());
+  ASSERT_EQ(c10::as_c10_complex(interleaved).data(), v.data());
+  ASSERT_EQ(c10::as_c10_complex(interleaved).size(), 3);
+
+  // const is kept
+  c10::span<const c10::complex<scalar_t>> cs = s;
+  static_assert(std::is_same<decltype(c10::as_std_complex(cs)), c10::span<const std::complex<scalar_t>>>::value, "");
+  static_assert(std::is_same<decltype(c10::as_interleaved(cs)), c10::span<const scalar_t>>::value, "");
+  static_assert(std::is_same<decltype(c10::as_c10_complex(c10::as_interleaved(cs))), c10::span<const c10::complex<scalar_t>>>::value, "");
+
+  // misaligned data and odd sizes are rejected
+  bool thrown = false;
+  try {
+    c10::as_c10_complex(interleaved.subspan(1, 4));
+  } catch (const std::invalid_argument&) {
+    thrown = true;
+  }
+  ASSERT_EQ(thrown, true);
+  thrown = false;
+  try {
+    c10::as_c10_complex(interleaved.subspan(0, 5));
+  } catch (const std::invalid_argument&) {
+    thrown = true;
+  }
+  ASSERT_EQ(thrown, true);
+  std::vector<std::complex<scalar_t>> std_data(3);
+  if (reinterpret_cast<uintptr_t>(std_data.data() + 1) % alignof(c10::complex<scalar_t>) != 0) {
+    thrown = false;
+    try {
+      c10::as_c10_complex(c10::make_span(std_data).subspan(1, 2));
+    } catch (const std::invalid_argument&) {
+      thrown = true;
+    }
+    ASSERT_EQ(thrown, true);
+  }
+}
+
+void test_views() {
+  test_views_<float>();
+  test_views_<double>();
+  // interleaved c10::Half
+  std::vector<c10::Half> halves = {1, 2, 3, 4};
+  auto h = c10::as_c10_complex(c10::make_span(halves));
+  ASSERT_EQ(h.size(), 2);
+  ASSERT_EQ(h[1], c10::complex<c10::Half>(3, 4));
+}
+
+} // namespace span_views
+
+int main() {
+  span_basics::test_span();
+  span_views::test_views();
+}
@@ -0,0 +1,194 @@
+#include <c10/test/util/complex_test_common.h>
+#include <c10/util/complex_stft.h>
+
+#include <cmath>
+#include <cstdint>
+#include <limits>
+#include <stdexcept>
+#include <vector>
+
+namespace stft {
+
+using test_data::make_signal;
+
+// The DFT of size N of x[start + j] window[j], padded with zeros
+template<typename scalar_t>
+std::vector<c10::complex<double>> frame_dft(const std::vector<c10::complex<scalar_t>>& x, int64_t start, const std::vector<scalar_t>& window, int64_t N) {
+  const double pi = 3.14159265358979323846;
+  std::vector<c10::complex<double>> y(N);
+  for (int64_t k = 0; k < N; k++) {
+    c10::complex<double> sum(0, 0);
+    for (int64_t j = 0; j < static_cast<int64_t>(window.size()); j++) {
+      const double a = -2 * pi * static_cast<double>((j * k) % N) / N;
+      const c10::complex<double> v(x[start + j].real(), x[start + j].imag());
+      sum += v * c10::complex<double>(window[j] * std::cos(a), window[j] * std::sin(a));
+    }
+    y[k] = sum;
+  }
+  return y;
+}
+
+// Chunk sizes that cross frames and the internal chunks
+const std::vector<int64_t> chunks = {1, 7, 100, 70000, 3, 4096, 333};
+
+template<typename scalar_t>
+void test_frames_() {
+  const double eps = std::is_same<scalar_t, float>::value ? 1e-6 : 1e-15;
+  const auto x = make_signal<scalar_t>(150000, 1);
+  struct config { int64_t window, hop, fft; };
+  for (config c : {config{64, 16, 0}, config{100, 100, 128}, config{60, 25, 75}, config{32, 50, 32}, config{1024, 256, 0}}) {
+    const auto window = c10::fft_window<scalar_t>(c10::window_kind::hann, c.window);
+    c10::stft<scalar_t> s(window, c.hop, c.fft);
+    const int64_t N = s.fft_size();
+    ASSERT_EQ(N, c.fft == 0 ? c.window : c.fft);
+    const int64_t expected_frames = (static_cast<int64_t>(x.size()) - c.window) / c.hop + 1;
+    ASSERT_EQ(s.output_frames(x.size()), expected_frames);
+    for (int pass = 0; pass < 2; pass++) {
+      // all at once, then in chunks
+      s.reset();
+      std::vector<c10::complex<scalar_t>> y;
+      std::vector<scalar_t> magnitude, db;
+      int64_t i = 0;
+      for (size_t k = 0; i < static_cast<int64_t>(x.size()); k++) {
+        const int64_t n = pass == 0 ? x.size() : std::min<int64_t>(chunks[k % chunks.size()], x.size() - i);
+        const int64_t frames = s.output_frames(n);
+        std::vector<c10::complex<scalar_t>> out(frames * N);
+        ASSERT_EQ(s.transform(x.data() + i, n, out.data()), frames);
+        y.insert(y.end(), out.begin(), out.end());
+        i += n;
+      }
+      ASSERT_EQ(static_cast<int64_t>(y.size()), expected_frames * N);
+      for (int64_t f : {int64_t(0), int64_t(1), expected_frames / 2, expected_frames - 1}) {
+        const auto expected = frame_dft(x, f * c.hop, window, N);
+        for (int64_t k = 0; k < N; k++) {
+          const c10::complex<double> d(y[f * N + k].real() - expected[k].real(), y[f * N + k].imag() - expected[k].imag());
+          ASSERT_EQ(std::abs(d) < 50 * eps * std::sqrt(static_cast<double>(c.window)) * std::log2(2.0 * N), true);
+        }
+      }
+      // the scaled outputs of the same frames
+      s.reset();
+      magnitude.resize(expected_frames * N);
+      db.resize(expected_frames * N);
+      ASSERT_EQ(s.transform(x.data(), x.size(), magnitude.data(), c10::spectrogram_scale::magnitude), expected_frames);
+      s.reset();
+      ASSERT_EQ(s.transform(x.data(), x.size(), db.data(), c10::spectrogram_scale::power_db), expected_frames);
+      for (size_t k = 0; k < y.size(); k += 7) {
+        const double m = std::abs(c10::complex<double>(y[k].real(), y[k].imag()));
+        ASSERT_EQ(std::abs(magnitude[k] - m) <= 4 * eps * m, true);
+        ASSERT_EQ(std::abs(db[k] - 20 * std::log10(m)) < 1e4 * eps, true);
+      }
+    }
+  }
+}
+
+template<typename scalar_t>
+void test_tone_() {
+  // a tone in bin 5 of 64 with a Hann window: bins 4, 5, 6 only
+  const int64_t N = 64;
+  const double pi = 3.14159265358979323846;
+  std::vector<c10::complex<scalar_t>> x(4 * N);
+  for (size_t j = 0; j < x.size(); j++) {
+    const double a = 2 * pi * 5 * static_cast<double>(j) / N;
+    x[j] = c10::complex<scalar_t>(std::cos(a), std::sin(a));
+  }
+  c10::stft<scalar_t> s(c10::window_kind::hann, N, N / 2);
+  std::vector<scalar_t> db(s.output_frames(x.size()) * N);
+  ASSERT_EQ(s.transform(x.data(), x.size(), db.data(), c10::spectrogram_scale::power_db), 7);
+  for (int64_t f = 0; f < 7; f++) {
+    ASSERT_EQ(std::abs(db[f * N + 5] - 20 * std::log10(N / 2.0)) < 1e-3, true);
+    ASSERT_EQ(std::abs(db[f * N + 4] - 20 * std::log10(N / 4.0)) < 1e-3, true);
+    ASSERT_EQ(db[f * N + 20] < -80, true);
+  }
+}
+
+void test_scale() {
+  using limits = std::numeric_limits<float>;
+  const std::vector<c10::complex<float>> x = {
+    {3, 4}, {0, 0}, {limits::max(), limits::max()}, {limits::infinity(), 1}, {1e-30f, 1e-30f},
+    {limits::quiet_NaN(), -limits::infinity()}, {1, limits::quiet_NaN()}, {0, limits::denorm_min()}};
+  std::vector<float> magnitude(x.size()), db(x.size());
+  c10::detail::spectrogram_scale_bins(x.data(), magnitude.data(), x.size(), c10::spectrogram_scale::magnitude);
+  c10::detail::spectrogram_scale_bins(x.data(), db.data(), x.size(), c10::spectrogram_scale::power_db);
+  ASSERT_EQ(std::abs(magnitude[0] - 5) < 1e-6f, true);
+  ASSERT_EQ(magnitude[1], 0.0f);
+  ASSERT_EQ(magnitude[2], limits::infinity());
+  ASSERT_EQ(magnitude[3], limits::infinity());
+  ASSERT_EQ(std::abs(magnitude[4] / 1.41421356e-30f - 1) < 1e-6f, true);
+  ASSERT_EQ(std::abs(db[0] - 20 * std::log10(5.0f)) < 1e-5f, true);
+  ASSERT_EQ(std::abs(db[1] - 20 * std::log10(limits::min())) < 1e-3f, true);
+  ASSERT_EQ(db[3], limits::infinity());
+  ASSERT_EQ(std::abs(db[4] - 20 * std::log10(1.41421356e-30f)) < 1e-4f, true);
+  // no overflow in the squares
+  ASSERT_EQ(std::abs(db[2] - (20 * std::log10(limits::max()) + 10 * std::log10(2.0f))) < 1e-3f, true);
+  ASSERT_EQ(magnitude[5], limits::infinity());
+  ASSERT_EQ(std::isnan(magnitude[6]), true);
+  ASSERT_EQ(std::isnan(db[6]), true);
+  ASSERT_EQ(magnitude[7], limits::denorm_min());
+  ASSERT_EQ(std::abs(db[7] - 20 * std::log10(static_cast<double>(limits::denorm_min()))) < 1e-3f, true);
+}
+
+void test_windows() {
+  for (auto kind : {c10::window_kind::rectangular, c10::window_kind::hann, c10::window_kind::hamming, c10::window_kind::blackman}) {
+    const auto w = c10::fft_window<double>(kind, 16);
+    // periodic: symmetric about 8
+    for (int k = 1; k < 8; k++) {
+      ASSERT_EQ(std::abs(w[k] - w[16 - k]) < 1e-15, true);
+    }
+    ASSERT_EQ(std::abs(w[8] - 1) < 1e-15, true);
+  }
+  ASSERT_EQ(c10::fft_window<float>(c10::window_kind::hann, 16)[0], 0.0f);
+}
+
+void test_parallel() {
+  c10::set_num_threads(4);
+  const auto x = make_signal<float>(200000, 3);
+  c10::stft<float> s(c10::window_kind::blackman, 512, 128);
+  std::vector<c10::complex<float>> parallel(s.output_frames(x.size()) * 512);
+  s.transform(x.data(), x.size(), parallel.data());
+  c10::set_num_threads(1);
+  s.reset();
+  std::vector<c10::complex<float>> serial(parallel.size());
+  s.transform(x.data(), x.size(), serial.data());
+  for (size_t k = 0; k < serial.size(); k++) {
+    ASSERT_EQ(parallel[k], serial[k]);
+  }
+}
+
+void test_errors() {
+  int thrown = 0;
+  std::vector<float> none, window(64, 1.0f);
+  try {
+    c10::stft<float> s(none, 1);
+  } catch (const std::invalid_argument&) {
+    thrown++;
+  }
+  try {
+    c10::stft<float> s(window, 0);
+  } catch (const std::invalid_argument&) {
+    thrown++;
+  }
+  try {
+    c10::stft<float> s(window, 16, 32);
+  } catch (const std::invalid_argument&) {
+    thrown++;
+  }
+  try {
+    c10::fft_window<float>(c10::window_kind::hann, 0);
+  } catch (const std::invalid_argument&) {
+    thrown++;
+  }
+  ASSERT_EQ(thrown, 4);
+}
+
+} // namespace stft
+
+int main() {
+  stft::test_frames_<float>();
+  stft::test_frames_<double>();
+  stft::test_tone_<float>();
+  stft::test_tone_<double>();
+  stft::test_scale();
+  stft::test_windows();
+  stft::test_parallel();
+  stft::test_errors();
+}
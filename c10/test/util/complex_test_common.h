@@ -1,7 +1,11 @@
 #include <c10/util/complex.h>
+#include <c10/util/complex_constexpr.h>
+#include <cstdint>
+#include <random>
 #include <type_traits>
 #include <tuple>
 #include <sstream>
+#include <vector>
 
 #if (defined(__CUDACC__) || defined(__HIPCC__)) && !defined(C10_HOST_DEVICE)
 #define MAYBE_GLOBAL __global__
@@ -9,7 +13,7 @@
 #define MAYBE_GLOBAL
 #endif
 
-const double PI = 3.141592653589793238463;
+constexpr double PI = 3.141592653589793238463;
 
 // gtest mock
 #include <iostream>
@@ -18,6 +22,56 @@ const double PI = 3.141592653589793238463;
 #define ASSERT_LT(a, b) assert((a) < (b))
 #define TEST(a, b) void a##_##b()
 
+// Random inputs of the filter and transform tests
+namespace test_data {
+
+// n numbers with parts uniform in [-1, 1)
+template<typename scalar_t>
+std::vector<c10::complex<scalar_t>> make_signal(int64_t n, unsigned seed) {
+  std::mt19937 gen(seed);
+  std::uniform_real_distribution<scalar_t> u(-1, 1);
+  std::vector<c10::complex<scalar_t>> x(n);
+  for (auto& z : x) {
+    z = c10::complex<scalar_t>(u(gen), u(gen));
+  }
+  return x;
+}
+
+template<typename scalar_t>
+void random_tap(scalar_t& t, std::mt19937& gen) {
+  t = std::uniform_real_distribution<scalar_t>(-1, 1)(gen);
+}
+template<typename scalar_t>
+void random_tap(c10::complex<scalar_t>& t, std::mt19937& gen) {
+  std::uniform_real_distribution<scalar_t> u(-1, 1);
+  t = c10::complex<scalar_t>(u(gen), u(gen));
+}
+
+// n real or complex taps with parts uniform in [-1, 1)
+template<typename tap_t>
+std::vector<tap_t> make_taps(int64_t n, unsigned seed) {
+  std::mt19937 gen(seed);
+  std::vector<tap_t> h(n);
+  for (auto& t : h) {
+    random_tap(t, gen);
+  }
+  return h;
+}
+
+// Outputs as c10::complex<double>, to compare with references
+inline c10::complex<double> widen(float x) {
+  return c10::complex<double>(x, 0);
+}
+inline c10::complex<double> widen(double x) {
+  return c10::complex<double>(x, 0);
+}
+template<typename scalar_t>
+c10::complex<double> widen(c10::complex<scalar_t> x) {
+  return c10::complex<double>(x.real(), x.imag());
+}
+
+} // namespace test_data
+
 namespace memory {
 
 MAYBE_GLOBAL void test_size() {
@@ -417,10 +471,47 @@ C10_HOST_DEVICE void test_arithmetic_() {
   static_assert(scalar_t(25) / c10::complex<scalar_t>(3, 4)  == c10::complex<scalar_t>(3, -4), "");
 }
 
+// mixed types promote to the wider scalar type, integers do not promote
+static_assert(std::is_same<decltype(c10::complex<float>() * c10::complex<double>()), c10::complex<double>>::value, "");
+static_assert(std::is_same<decltype(c10::complex<c10::Half>() + c10::complex<float>()), c10::complex<float>>::value, "");
+static_assert(std::is_same<decltype(c10::complex<float>() * 2.0), c10::complex<double>>::value, "");
+static_assert(std::is_same<decltype(2.0f / c10::complex<double>()), c10::complex<double>>::value, "");
+static_assert(std::is_same<decltype(c10::complex<float>() - 2), c10::complex<float>>::value, "");
+static_assert(std::is_same<decltype(int64_t(2) * c10::complex<c10::Half>()), c10::complex<c10::Half>>::value, "");
+static_assert(std::is_same<decltype(c10::complex<double>() + 2u), c10::complex<double>>::value, "");
+
+template<typename scalar_t, typename other_t>
+C10_HOST_DEVICE void test_arithmetic_mixed_() {
+  static_assert(c10::complex<scalar_t>(1, 2) + c10::complex<other_t>(3, 4) == c10::complex<double>(4, 6), "");
+  static_assert(c10::complex<other_t>(1, 2) - c10::complex<scalar_t>(3, 4) == c10::complex<double>(-2, -2), "");
+  static_assert(c10::complex<scalar_t>(1, 2) * c10::complex<other_t>(3, 4) == c10::complex<double>(-5, 10), "");
+  static_assert(c10::complex<other_t>(-5, 10) / c10::complex<scalar_t>(3, 4) == c10::complex<double>(1, 2), "");
+
+  static_assert(c10::complex<scalar_t>(1, 2) + other_t(3) == c10::complex<double>(4, 2), "");
+  static_assert(other_t(3) - c10::complex<scalar_t>(1, 2) == c10::complex<double>(2, -2), "");
+  static_assert(c10::complex<scalar_t>(1, 2) * other_t(3) == c10::complex<double>(3, 6), "");
+  static_assert(other_t(25) / c10::complex<scalar_t>(3, 4) == c10::complex<double>(3, -4), "");
+
+  static_assert(c10::complex<scalar_t>(1, 2) + 3 == c10::complex<scalar_t>(4, 2), "");
+  static_assert(3l - c10::complex<scalar_t>(1, 2) == c10::complex<scalar_t>(2, -2), "");
+  static_assert(c10::complex<scalar_t>(1, 2) * 3u == c10::complex<scalar_t>(3, 6), "");
+  static_assert(25 / c10::complex<scalar_t>(3, 4) == c10::complex<scalar_t>(3, -4), "");
+}
+
 MAYBE_GLOBAL void test_arithmetic() {
   test_arithmetic_<c10::Half>();
   test_arithmetic_<float>();
   test_arithmetic_<double>();
+  test_arithmetic_mixed_<c10::Half, double>();
+  test_arithmetic_mixed_<float, double>();
+}
+
+void test_arithmetic_precision() {
+  // the float operand is promoted instead of rounding the double one
+  const double third = 1.0 / 3;
+  ASSERT_EQ((c10::complex<float>(1, 0) * third).real(), third);
+  ASSERT_EQ((third + c10::complex<float>(0, 1)).real(), third);
+  ASSERT_EQ((c10::complex<double>(third, 0) - c10::complex<float>(0, 0)).real(), third);
 }
 
 } // namespace arithmetic
@@ -500,9 +591,184 @@ void test_values() {
 
 } // namespace test_std
 
+namespace test_math {
+
+template<typename scalar_t>
+void test_exp_log_pow_() {
+  ASSERT_LT(std::abs(std::exp(c10::complex<scalar_t>(0, PI)) - c10::complex<scalar_t>(-1, 0)), 1e-6);
+  ASSERT_LT(std::abs(std::exp(c10::complex<scalar_t>(1, 0)) - c10::complex<scalar_t>(std::exp(scalar_t(1)), 0)), 1e-6);
+  ASSERT_LT(std::abs(std::log(c10::complex<scalar_t>(-1, 0)) - c10::complex<scalar_t>(0, PI)), 1e-6);
+  ASSERT_LT(std::abs(std::log10(c10::complex<scalar_t>(100, 0)) - c10::complex<scalar_t>(2, 0)), 1e-6);
+  ASSERT_LT(std::abs(std::pow(c10::complex<scalar_t>(0, 1), c10::complex<scalar_t>(2, 0)) - c10::complex<scalar_t>(-1, 0)), 1e-6);
+  ASSERT_LT(std::abs(std::pow(c10::complex<scalar_t>(1, 1), scalar_t(2)) - c10::complex<scalar_t>(0, 2)), 1e-6);
+  ASSERT_LT(std::abs(std::pow(scalar_t(2), c10::complex<scalar_t>(0, PI / std::log(2))) - c10::complex<scalar_t>(-1, 0)), 1e-6);
+  ASSERT_LT(std::abs(std::sqrt(c10::complex<scalar_t>(-4, 0)) - c10::complex<scalar_t>(0, 2)), 1e-6);
+  ASSERT_LT(std::abs(std::sqrt(c10::complex<scalar_t>(0, 2)) - c10::complex<scalar_t>(1, 1)), 1e-6);
+}
+
+void test_exp_log_pow() {
+  test_exp_log_pow_<float>();
+  test_exp_log_pow_<double>();
+}
+
+template<typename scalar_t>
+void test_trig_hyperbolic_() {
+  c10::complex<scalar_t> x(scalar_t(0.5), scalar_t(-1.5));
+  std::complex<scalar_t> y(scalar_t(0.5), scalar_t(-1.5));
+  ASSERT_LT(std::abs(std::sin(x) - c10::complex<scalar_t>(std::sin(y))), 1e-6);
+  ASSERT_LT(std::abs(std::cos(x) - c10::complex<scalar_t>(std::cos(y))), 1e-6);
+  ASSERT_LT(std::abs(std::tan(x) - c10::complex<scalar_t>(std::tan(y))), 1e-6);
+  ASSERT_LT(std::abs(std::sinh(x) - c10::complex<scalar_t>(std::sinh(y))), 1e-6);
+  ASSERT_LT(std::abs(std::cosh(x) - c10::complex<scalar_t>(std::cosh(y))), 1e-6);
+  ASSERT_LT(std::abs(std::tanh(x) - c10::complex<scalar_t>(std::tanh(y))), 1e-6);
+  // sin(z) = -i sinh(iz)
+  ASSERT_LT(std::abs(std::sin(x) - c10::complex<scalar_t>(0, -1) * std::sinh(c10::complex<scalar_t>(0, 1) * x)), 1e-6);
+}
+
+void test_trig_hyperbolic() {
+  test_trig_hyperbolic_<float>();
+  test_trig_hyperbolic_<double>();
+}
+
+template<typename scalar_t>
+void test_inverse_() {
+  for (auto v : {std::complex<scalar_t>(scalar_t(0.5), scalar_t(-1.5)), std::complex<scalar_t>(scalar_t(-3), scalar_t(1e-3)), std::complex<scalar_t>(scalar_t(1e10), scalar_t(-1e10))}) {
+    c10::complex<scalar_t> x(v);
+    scalar_t scale = std::abs(v) > 1 ? std::log(std::abs(v)) : scalar_t(1);
+    ASSERT_LT(std::abs(std::asin(x) - c10::complex<scalar_t>(std::asin(v))), 1e-5 * scale);
+    ASSERT_LT(std::abs(std::acos(x) - c10::complex<scalar_t>(std::acos(v))), 1e-5 * scale);
+    ASSERT_LT(std::abs(std::atan(x) - c10::complex<scalar_t>(std::atan(v))), 1e-5 * scale);
+    ASSERT_LT(std::abs(std::asinh(x) - c10::complex<scalar_t>(std::asinh(v))), 1e-5 * scale);
+    ASSERT_LT(std::abs(std::acosh(x) - c10::complex<scalar_t>(std::acosh(v))), 1e-5 * scale);
+    ASSERT_LT(std::abs(std::atanh(x) - c10::complex<scalar_t>(std::atanh(v))), 1e-5 * scale);
+  }
+  // inverse of the forward function near the origin
+  c10::complex<scalar_t> z(scalar_t(0.25), scalar_t(0.5));
+  ASSERT_LT(std::abs(std::sin(std::asin(z)) - z), 1e-6);
+  ASSERT_LT(std::abs(std::tanh(std::atanh(z)) - z), 1e-6);
+  // branch cuts follow the sign of zero
+  ASSERT_EQ(std::signbit(std::asin(c10::complex<scalar_t>(2, -0.0)).imag()), true);
+  ASSERT_EQ(std::signbit(std::asin(c10::complex<scalar_t>(2, 0.0)).imag()), false);
+}
+
+void test_inverse() {
+  test_inverse_<float>();
+  test_inverse_<double>();
+}
+
+template<typename scalar_t>
+void test_fma_() {
+  c10::complex<scalar_t> a(scalar_t(1.5), scalar_t(-2)), b(scalar_t(0.25), scalar_t(3)), c(scalar_t(-1), scalar_t(0.5));
+  ASSERT_LT(std::abs(c10::fma(a, b, c) - (a * b + c)), 1e-6);
+  ASSERT_LT(std::abs(c10::fma_conj(a, b, c) - (a * std::conj(b) + c)), 1e-6);
+  // (1 + e) * (1 - e) - 1 = -e^2 is lost when the product is rounded first
+  const scalar_t e = std::ldexp(scalar_t(1), -(std::numeric_limits<scalar_t>::digits / 2 + 1));
+  c10::complex<scalar_t> p(1 + e, 0), q(1 - e, 0), m(-1, -1);
+  ASSERT_EQ(c10::fma(p, q, m), c10::complex<scalar_t>(-e * e, -1));
+  ASSERT_EQ(c10::fma(c10::complex<scalar_t>(0, 1 + e), c10::complex<scalar_t>(0, 1 - e), c10::complex<scalar_t>(1, 0)), c10::complex<scalar_t>(e * e, 0));
+  ASSERT_EQ(c10::fma_conj(c10::complex<scalar_t>(0, 1 + e), c10::complex<scalar_t>(0, 1 - e), m), c10::complex<scalar_t>(-e * e, -1));
+  // accumulating
+  c10::complex<scalar_t> acc(0, 0);
+  for (int i = 0; i < 4; i++) {
+    acc = c10::fma(c10::complex<scalar_t>(0, 1), c10::complex<scalar_t>(0, 1), acc);
+  }
+  ASSERT_EQ(acc, c10::complex<scalar_t>(-4, 0));
+}
+
+void test_fma() {
+  test_fma_<float>();
+  test_fma_<double>();
+}
+
+} // namespace test_math
+
+namespace test_constexpr_math {
+
+static_assert(c10::constexpr_math::exp(0.0) == 1.0, "");
+static_assert(c10::constexpr_math::exp(1.0) == 2.718281828459045, "");
+static_assert(c10::constexpr_math::exp(1.0f) == 2.71828183f, "");
+static_assert(c10::constexpr_math::cos(0.0f) == 1.0f, "");
+static_assert(c10::constexpr_math::sin(-0.0) == 0.0 && c10::constexpr_math::sin(0.5) > 0.479 && c10::constexpr_math::sin(0.5) < 0.4795, "");
+static_assert(c10::constexpr_math::polar(2.0, 0.0) == c10::complex<double>(2, 0), "");
+// cos(pi / 2) is the rounding error of pi / 2, correctly rounded
+static_assert(c10::constexpr_math::cos(PI / 2) == 6.123233995736766e-17, "");
+static_assert(c10::constexpr_math::exp(c10::complex<double>(0, PI)).real() == -1.0, "");
+
+constexpr int num_values = 41;
+
+// a table computed at compile time
+template<typename scalar_t>
+struct values {
+  scalar_t exp[num_values], sin[num_values], cos[num_values];
+  c10::complex<scalar_t> cexp[num_values], csin[num_values], ccos[num_values], polar[num_values];
+};
+
+template<typename scalar_t>
+constexpr scalar_t value(int i) {
+  return scalar_t(-10) + scalar_t(i) * scalar_t(0.5) + scalar_t(0.0625);
+}
+
+template<typename scalar_t>
+constexpr values<scalar_t> make_values() {
+  values<scalar_t> v{};
+  for (int i = 0; i < num_values; i++) {
+    scalar_t x = value<scalar_t>(i);
+    c10::complex<scalar_t> z(x / 4, value<scalar_t>(num_values - 1 - i) / 2);
+    v.exp[i] = c10::constexpr_math::exp(x);
+    v.sin[i] = c10::constexpr_math::sin(x);
+    v.cos[i] = c10::constexpr_math::cos(x);
+    v.cexp[i] = c10::constexpr_math::exp(z);
+    v.csin[i] = c10::constexpr_math::sin(z);
+    v.ccos[i] = c10::constexpr_math::cos(z);
+    v.polar[i] = c10::constexpr_math::polar(scalar_t(3), x);
+  }
+  return v;
+}
+
+// std is not always correctly rounded either
+template<typename scalar_t>
+void assert_ulp(scalar_t actual, scalar_t expected) {
+  scalar_t ulp = std::nextafter(std::abs(expected), std::numeric_limits<scalar_t>::infinity()) - std::abs(expected);
+  ASSERT_EQ(std::abs(actual - expected) <= ulp, true);
+}
+
+template<typename scalar_t>
+void assert_close(c10::complex<scalar_t> actual, c10::complex<scalar_t> expected) {
+  ASSERT_EQ(std::abs(actual - expected) <= 4 * std::numeric_limits<scalar_t>::epsilon() * std::abs(expected), true);
+}
+
+template<typename scalar_t>
+void test_values_() {
+  constexpr values<scalar_t> v = make_values<scalar_t>();
+  for (int i = 0; i < num_values; i++) {
+    scalar_t x = value<scalar_t>(i);
+    c10::complex<scalar_t> z(x / 4, value<scalar_t>(num_values - 1 - i) / 2);
+    assert_ulp(v.exp[i], std::exp(x));
+    assert_ulp(v.sin[i], std::sin(x));
+    assert_ulp(v.cos[i], std::cos(x));
+    assert_close(v.cexp[i], std::exp(z));
+    assert_close(v.csin[i], std::sin(z));
+    assert_close(v.ccos[i], std::cos(z));
+    assert_close(v.polar[i], c10::polar(scalar_t(3), x));
+  }
+}
+
+void test_values() {
+  test_values_<float>();
+  test_values_<double>();
+}
+
+} // namespace test_constexpr_math
+
 void run_all_host_tests() {
   constructors::test_thrust_conversion();
   assignment::test_assign_thrust();
   io::test_io();
   test_std::test_values();
+  test_math::test_exp_log_pow();
+  test_math::test_trig_hyperbolic();
+  test_math::test_inverse();
+  test_math::test_fma();
+  arithmetic::test_arithmetic_precision();
+  test_constexpr_math::test_values();
 }
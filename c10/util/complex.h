@@ -1,7 +1,9 @@
 #pragma once
 
 #include <complex>
+#include <cstdint>
 #include <iostream>
+#include <type_traits>
 
 #if defined(__CUDACC__) || defined(__HIPCC__)
 #include <thrust/complex.h>
@@ -38,6 +40,8 @@ using Half = short;  // Just for the convenience of prototyping
 // Converting constructors: 
 // - std::complex defines converting constructor between float/double/long double,
 //   while we define converting constructor between c10::Half/float/double.
+//   float and double also convert from complex<int8_t> and complex<int32_t>,
+//   whose constructors are defined in c10/util/complex_int.h.
 // - For these converting constructors, upcasting is implicit, downcasting is
 //   explicit.
 // - We also define explicit casting from std::complex/thrust::complex
@@ -103,6 +107,14 @@ using Half = short;  // Just for the convenience of prototyping
 // - complex + real
 // - real + complex
 //
+// Unlike std::complex, the operands may also have different scalar types:
+// - complex<T> + complex<U> is a complex of the wider of T and U, in the
+//   order c10::Half < float < double
+// - complex<T> + c10::Half/float/double is also a complex of the wider type
+// - complex<T> + an integer is a complex<T>, the integer is converted to T
+// The operands are converted first and the result is computed by the version
+// for matching types, so a real operand is never turned into a complex one.
+//
 // [Operator ==, !=]
 // 
 // Each operator has three versions (taking == as example):
@@ -119,6 +131,12 @@ using Half = short;  // Just for the convenience of prototyping
 template<typename T>
 struct complex;
 
+// Defined in c10/util/complex_int.h
+template<>
+struct complex<int8_t>;
+template<>
+struct complex<int32_t>;
+
 template<typename T>
 struct alignas(sizeof(T) * 2) complex_common {
   T storage[2];
@@ -261,6 +279,8 @@ struct alignas(8) complex<float>: public complex_common<float> {
   constexpr complex(): complex_common() {}; // needed by CUDA 9.x
   constexpr complex(const complex<c10::Half> &other);
   explicit constexpr complex(const complex<double> &other);
+  constexpr complex(const complex<int8_t> &other);
+  explicit constexpr complex(const complex<int32_t> &other);
 };
 
 template<>
@@ -269,6 +289,8 @@ struct alignas(16) complex<double>: public complex_common<double> {
   constexpr complex(): complex_common() {}; // needed by CUDA 9.x
   constexpr complex(const complex<c10::Half> &other);
   constexpr complex(const complex<float> &other);
+  constexpr complex(const complex<int8_t> &other);
+  constexpr complex(const complex<int32_t> &other);
 };
 
 constexpr complex<c10::Half>::complex(const complex<float> &other): complex_common(other.real(), other.imag()) {}
@@ -294,6 +316,40 @@ constexpr complex<double> operator"" _id(long double imag) {
 
 } // namespace complex_literals
 
+namespace detail {
+
+// Order of the scalar types of c10::complex for promotion, -1 for other types
+template<typename T>
+struct scalar_rank: std::integral_constant<int, -1> {};
+template<>
+struct scalar_rank<c10::Half>: std::integral_constant<int, 0> {};
+template<>
+struct scalar_rank<float>: std::integral_constant<int, 1> {};
+template<>
+struct scalar_rank<double>: std::integral_constant<int, 2> {};
+
+// Scalar type of complex<T> op complex<U>, only defined if T and U differ
+template<typename T, typename U, typename = void>
+struct promote_complex {};
+template<typename T, typename U>
+struct promote_complex<T, U, typename std::enable_if<!std::is_same<T, U>::value>::type> {
+  using type = typename std::conditional<(scalar_rank<T>::value > scalar_rank<U>::value), T, U>::type;
+};
+
+// Scalar type of complex<T> op S for a real S other than T, see [Binary operators +-*/]
+template<typename T, typename S, typename = void>
+struct promote_real {};
+template<typename T, typename S>
+struct promote_real<T, S, typename std::enable_if<!std::is_same<T, S>::value && (scalar_rank<S>::value >= 0)>::type> {
+  using type = typename promote_complex<T, S>::type;
+};
+template<typename T, typename S>
+struct promote_real<T, S, typename std::enable_if<(scalar_rank<S>::value < 0) && std::is_integral<S>::value && !std::is_same<S, bool>::value>::type> {
+  using type = T;
+};
+
+} // namespace detail
+
 } // namespace c10
 
 template<typename T>
@@ -378,6 +434,80 @@ constexpr c10::complex<T> operator/(const T& lhs, const c10::complex<T>& rhs) {
   return result /= rhs;
 }
 
+// Mixed type versions, see [Binary operators +-*/]
+
+template<typename T, typename U>
+constexpr c10::complex<typename c10::detail::promote_complex<T, U>::type> operator+(const c10::complex<T>& lhs, const c10::complex<U>& rhs) {
+  using R = typename c10::detail::promote_complex<T, U>::type;
+  return c10::complex<R>(lhs) + c10::complex<R>(rhs);
+}
+
+template<typename T, typename S>
+constexpr c10::complex<typename c10::detail::promote_real<T, S>::type> operator+(const c10::complex<T>& lhs, const S& rhs) {
+  using R = typename c10::detail::promote_real<T, S>::type;
+  return c10::complex<R>(lhs) + static_cast<R>(rhs);
+}
+
+template<typename S, typename T>
+constexpr c10::complex<typename c10::detail::promote_real<T, S>::type> operator+(const S& lhs, const c10::complex<T>& rhs) {
+  using R = typename c10::detail::promote_real<T, S>::type;
+  return static_cast<R>(lhs) + c10::complex<R>(rhs);
+}
+
+template<typename T, typename U>
+constexpr c10::complex<typename c10::detail::promote_complex<T, U>::type> operator-(const c10::complex<T>& lhs, const c10::complex<U>& rhs) {
+  using R = typename c10::detail::promote_complex<T, U>::type;
+  return c10::complex<R>(lhs) - c10::complex<R>(rhs);
+}
+
+template<typename T, typename S>
+constexpr c10::complex<typename c10::detail::promote_real<T, S>::type> operator-(const c10::complex<T>& lhs, const S& rhs) {
+  using R = typename c10::detail::promote_real<T, S>::type;
+  return c10::complex<R>(lhs) - static_cast<R>(rhs);
+}
+
+template<typename S, typename T>
+constexpr c10::complex<typename c10::detail::promote_real<T, S>::type> operator-(const S& lhs, const c10::complex<T>& rhs) {
+  using R = typename c10::detail::promote_real<T, S>::type;
+  return static_cast<R>(lhs) - c10::complex<R>(rhs);
+}
+
+template<typename T, typename U>
+constexpr c10::complex<typename c10::detail::promote_complex<T, U>::type> operator*(const c10::complex<T>& lhs, const c10::complex<U>& rhs) {
+  using R = typename c10::detail::promote_complex<T, U>::type;
+  return c10::complex<R>(lhs) * c10::complex<R>(rhs);
+}
+
+template<typename T, typename S>
+constexpr c10::complex<typename c10::detail::promote_real<T, S>::type> operator*(const c10::complex<T>& lhs, const S& rhs) {
+  using R = typename c10::detail::promote_real<T, S>::type;
+  return c10::complex<R>(lhs) * static_cast<R>(rhs);
+}
+
+template<typename S, typename T>
+constexpr c10::complex<typename c10::detail::promote_real<T, S>::type> operator*(const S& lhs, const c10::complex<T>& rhs) {
+  using R = typename c10::detail::promote_real<T, S>::type;
+  return static_cast<R>(lhs) * c10::complex<R>(rhs);
+}
+
+template<typename T, typename U>
+constexpr c10::complex<typename c10::detail::promote_complex<T, U>::type> operator/(const c10::complex<T>& lhs, const c10::complex<U>& rhs) {
+  using R = typename c10::detail::promote_complex<T, U>::type;
+  return c10::complex<R>(lhs) / c10::complex<R>(rhs);
+}
+
+template<typename T, typename S>
+constexpr c10::complex<typename c10::detail::promote_real<T, S>::type> operator/(const c10::complex<T>& lhs, const S& rhs) {
+  using R = typename c10::detail::promote_real<T, S>::type;
+  return c10::complex<R>(lhs) / static_cast<R>(rhs);
+}
+
+template<typename S, typename T>
+constexpr c10::complex<typename c10::detail::promote_real<T, S>::type> operator/(const S& lhs, const c10::complex<T>& rhs) {
+  using R = typename c10::detail::promote_real<T, S>::type;
+  return static_cast<R>(lhs) / c10::complex<R>(rhs);
+}
+
 template<typename T>
 constexpr bool operator==(const c10::complex<T>& lhs, const c10::complex<T>& rhs) {
   return (lhs.real() == rhs.real()) && (lhs.imag() == rhs.imag());
@@ -0,0 +1,439 @@
+#pragma once
+
+#include <c10/util/complex.h>
+#include <c10/util/complex_buffer.h>
+#include <c10/util/complex_parallel.h>
+#include <c10/util/complex_span.h>
+#include <c10/util/complex_vec_math.h>
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <limits>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+// Block floating point storage of c10::complex<float>
+//
+// [Block floating point]
+//
+// c10::complex_bfp stores n complex numbers in blocks of block_size
+// numbers that share one exponent, with integer mantissas of 8, 12 or 16
+// bits for each real and imaginary part, i.e. 2, 3 or 4 bytes per number
+// instead of 8:
+//
+//   c10::complex_bfp b(x, n, 12);      // encode with 12 bit mantissas
+//   b.decode(out);                      // out[i] is x[i] up to rounding
+//   c10::complex<float> z = b[i];
+//
+// A block with exponent E holds the parts as q * 2^(E - (bits - 1)), where
+// E is the exponent of the part of largest magnitude (frexp) and |q| is at
+// most 2^(bits - 1) - 1, so each part is within half a step, 2^(E - bits),
+// of the original; a largest part that rounds up to 2^(bits - 1) is clamped
+// and within a step. Small parts of a block with a large one lose their
+// precision, which suits data with a limited dynamic range per block, like
+// the bins of a spectrum. The mantissa range is symmetric, so negation is
+// exact. 12 bit mantissas are packed, the real and imaginary part of a
+// number in 3 bytes. Infinite and NaN parts cannot be encoded and throw
+// std::invalid_argument.
+//
+// Some operations work on the compressed form, block by block, without
+// decoding to float:
+//
+//   b.ldexp(k);                         // times 2^k, only changes exponents
+//   c10::bulk::conj(b, out);            // negates imaginary mantissas
+//   c10::bulk::mul(x, y, out);          // mantissa products renormalized
+//   c10::bulk::add(x, y, out);          // mantissas aligned to the larger exponent
+//
+// mul and add need x and y to have the same size, mantissa bits and block
+// size, and give out the same format. The products and sums of mantissas
+// are exact in 32 bit integers; the result is rounded once more to the
+// mantissa bits, so its error is about that of encoding the exact result.
+//
+// Encoding, decoding and the kernels run in loops over the parts of a block
+// that the compiler vectorizes, and split arrays of more than
+// bfp_grain_size numbers between threads with c10::parallel_for.
+
+namespace c10 {
+
+constexpr int64_t bfp_default_block_size = 64;
+
+// Number of complex numbers processed by each thread at least
+constexpr int64_t bfp_grain_size = int64_t(1) << 16;
+
+// Options of complex_buffer<float> that place it like complex_bfp splits
+// the arrays it encodes and decodes, see [NUMA placement]
+inline numa_options bfp_numa_options(int64_t block_size = bfp_default_block_size, numa_placement placement = numa_placement::interleave) {
+  numa_options options;
+  options.placement = placement;
+  options.grain_size = std::max<int64_t>(1, bfp_grain_size / block_size);
+  options.unit_bytes = block_size * sizeof(complex<float>);
+  return options;
+}
+
+namespace detail {
+
+// Largest mantissa magnitude
+inline int32_t bfp_max_mantissa(int bits) {
+  return (int32_t(1) << (bits - 1)) - 1;
+}
+
+// 2^k. Block scales are applied as two such factors, 2^(k / 2) and
+// 2^(k - k / 2), so that neither leaves the range of float.
+inline float bfp_scale_factor(int k) {
+  return std::ldexp(1.0f, k);
+}
+
+// Packs 2 count mantissas q into bytes of the given width
+inline void bfp_pack(const int32_t* q, int64_t count, int bits, unsigned char* out) {
+  if (bits == 8) {
+    int8_t* o = reinterpret_cast<int8_t*>(out);
+    C10_VEC_LOOP
+    for (int64_t j = 0; j < 2 * count; j++) {
+      o[j] = static_cast<int8_t>(q[j]);
+    }
+  } else if (bits == 16) {
+    C10_VEC_LOOP
+    for (int64_t j = 0; j < 2 * count; j++) {
+      const int16_t v = static_cast<int16_t>(q[j]);
+      std::memcpy(out + 2 * j, &v, 2);
+    }
+  } else {
+    C10_VEC_LOOP
+    for (int64_t j = 0; j < count; j++) {
+      const uint32_t re = static_cast<uint32_t>(q[2 * j]) & 0xfff;
+      const uint32_t im = static_cast<uint32_t>(q[2 * j + 1]) & 0xfff;
+      out[3 * j] = static_cast<unsigned char>(re);
+      out[3 * j + 1] = static_cast<unsigned char>((re >> 8) | (im << 4));
+      out[3 * j + 2] = static_cast<unsigned char>(im >> 4);
+    }
+  }
+}
+
+inline void bfp_unpack(const unsigned char* in, int64_t count, int bits, int32_t* q) {
+  if (bits == 8) {
+    const int8_t* p = reinterpret_cast<const int8_t*>(in);
+    C10_VEC_LOOP
+    for (int64_t j = 0; j < 2 * count; j++) {
+      q[j] = p[j];
+    }
+  } else if (bits == 16) {
+    C10_VEC_LOOP
+    for (int64_t j = 0; j < 2 * count; j++) {
+      int16_t v;
+      std::memcpy(&v, in + 2 * j, 2);
+      q[j] = v;
+    }
+  } else {
+    C10_VEC_LOOP
+    for (int64_t j = 0; j < count; j++) {
+      const uint32_t b0 = in[3 * j], b1 = in[3 * j + 1], b2 = in[3 * j + 2];
+      // sign extend from 12 bits
+      q[2 * j] = static_cast<int32_t>((b0 | (b1 << 8)) << 20) >> 20;
+      q[2 * j + 1] = static_cast<int32_t>(((b1 >> 4) | (b2 << 4)) << 20) >> 20;
+    }
+  }
+}
+
+// Smallest shift s such that the largest magnitude m, shifted right by s
+// with rounding, fits in the mantissas
+inline int bfp_normalize_shift(int64_t m, int bits) {
+  const int64_t limit = bfp_max_mantissa(bits);
+  int s = 0;
+  while (s < 62 && (s == 0 ? m : (m >> s) + ((m >> (s - 1)) & 1)) > limit) {
+    s++;
+  }
+  return s;
+}
+
+// v / 2^s rounded to nearest, ties upward, and clamped to the mantissas
+C10_VEC_INLINE int32_t bfp_round_shift(int64_t v, int s, int32_t limit) {
+  const int64_t r = s == 0 ? v : (v >> s) + ((v >> (s - 1)) & 1);
+  return static_cast<int32_t>(r > limit ? limit : (r < -limit ? -limit : r));
+}
+
+} // namespace detail
+
+class complex_bfp {
+ public:
+  complex_bfp() = default;
+
+  // n zeros
+  explicit complex_bfp(int64_t n, int mantissa_bits = 16, int64_t block_size = bfp_default_block_size)
+    : size_(n), bits_(mantissa_bits), block_size_(block_size) {
+    if (mantissa_bits != 8 && mantissa_bits != 12 && mantissa_bits != 16) {
+      throw std::invalid_argument("c10::complex_bfp: mantissa_bits must be 8, 12 or 16, not " + std::to_string(mantissa_bits));
+    }
+    if (block_size <= 0 || n < 0) {
+      throw std::invalid_argument("c10::complex_bfp: block_size must be positive and n not negative");
+    }
+    exponents_.assign((n + block_size - 1) / block_size, 0);
+    mantissas_.assign(n * bytes_per_number(), 0);
+  }
+
+  // x[0, n) encoded, see [Block floating point]
+  complex_bfp(const complex<float>* x, int64_t n, int mantissa_bits = 16, int64_t block_size = bfp_default_block_size)
+    : complex_bfp(n, mantissa_bits, block_size) {
+    c10::parallel_for(0, num_blocks(), block_grain(), [&](int64_t begin, int64_t end) {
+      std::vector<int32_t> q(2 * block_size_);
+      for (int64_t b = begin; b < end; b++) {
+        encode_block(x, b, q.data());
+      }
+    });
+  }
+
+  complex_bfp(span<const complex<float>> x, int mantissa_bits = 16, int64_t block_size = bfp_default_block_size)
+    : complex_bfp(x.data(), x.size(), mantissa_bits, block_size) {}
+
+  // out[0, size()) decoded
+  void decode(complex<float>* out) const {
+    c10::parallel_for(0, num_blocks(), block_grain(), [&](int64_t begin, int64_t end) {
+      std::vector<int32_t> q(2 * block_size_);
+      for (int64_t b = begin; b < end; b++) {
+        decode_block(b, q.data(), out + b * block_size_);
+      }
+    });
+  }
+
+  complex_buffer<float> decode() const {
+    complex_buffer<float> out(size_);
+    decode(out.data());
+    return out;
+  }
+
+  complex<float> operator[](int64_t i) const {
+    int32_t q[2];
+    detail::bfp_unpack(mantissas_.data() + i * bytes_per_number(), 1, bits_, q);
+    const int k = exponents_[i / block_size_] - (bits_ - 1);
+    const float s1 = detail::bfp_scale_factor(k / 2);
+    const float s2 = detail::bfp_scale_factor(k - k / 2);
+    return complex<float>(static_cast<float>(q[0]) * s1 * s2, static_cast<float>(q[1]) * s1 * s2);
+  }
+
+  // Multiplies every number by 2^k, see [Block floating point]
+  void ldexp(int k) {
+    for (int16_t& e : exponents_) {
+      e = static_cast<int16_t>(std::max(-32768, std::min(32767, e + k)));
+    }
+  }
+
+  int64_t size() const {
+    return size_;
+  }
+  int mantissa_bits() const {
+    return bits_;
+  }
+  int64_t block_size() const {
+    return block_size_;
+  }
+  int64_t num_blocks() const {
+    return static_cast<int64_t>(exponents_.size());
+  }
+  int64_t bytes_per_number() const {
+    return bits_ / 4;
+  }
+  // Bytes of the compressed data, mantissas and exponents
+  int64_t bytes() const {
+    return static_cast<int64_t>(mantissas_.size() + exponents_.size() * sizeof(int16_t));
+  }
+
+  // The exponent of each block and the packed mantissas of the numbers
+  int16_t* exponents() {
+    return exponents_.data();
+  }
+  const int16_t* exponents() const {
+    return exponents_.data();
+  }
+  unsigned char* mantissas() {
+    return mantissas_.data();
+  }
+  const unsigned char* mantissas() const {
+    return mantissas_.data();
+  }
+
+  // Numbers in block b
+  int64_t block_count(int64_t b) const {
+    return std::min(block_size_, size_ - b * block_size_);
+  }
+
+  // Mantissas of block b as 32 bit integers, 2 per number
+  void unpack_block(int64_t b, int32_t* q) const {
+    detail::bfp_unpack(mantissas_.data() + b * block_size_ * bytes_per_number(), block_count(b), bits_, q);
+  }
+
+  void pack_block(int64_t b, const int32_t* q) {
+    detail::bfp_pack(q, block_count(b), bits_, mantissas_.data() + b * block_size_ * bytes_per_number());
+  }
+
+  // Blocks processed by each thread at least
+  int64_t block_grain() const {
+    return std::max<int64_t>(1, bfp_grain_size / block_size_);
+  }
+
+ private:
+  void encode_block(const complex<float>* x, int64_t b, int32_t* q) {
+    using namespace vec_math;
+    const int64_t count = block_count(b);
+    const float* v = reinterpret_cast<const float*>(x + b * block_size_);
+    // max() drops NaNs, so finiteness is tracked on its own
+    float m = 0;
+    int finite = 1;
+    C10_VEC_LOOP
+    for (int64_t j = 0; j < 2 * count; j++) {
+      m = max(m, abs(v[j]));
+      finite &= is_finite(v[j]);
+    }
+    if (!finite) {
+      throw std::invalid_argument("c10::complex_bfp: cannot encode infinite or NaN values");
+    }
+    int e = 0;
+    if (m > 0) {
+      std::frexp(m, &e);
+    }
+    exponents_[b] = static_cast<int16_t>(e);
+    const int k = (bits_ - 1) - e;
+    const float s1 = detail::bfp_scale_factor(k / 2);
+    const float s2 = detail::bfp_scale_factor(k - k / 2);
+    const float limit = static_cast<float>(detail::bfp_max_mantissa(bits_));
+    C10_VEC_LOOP
+    for (int64_t j = 0; j < 2 * count; j++) {
+      const float r = round_int(v[j] * s1 * s2);
+      q[j] = static_cast<int32_t>(max(-limit, min(limit, r)));
+    }
+    pack_block(b, q);
+  }
+
+  void decode_block(int64_t b, int32_t* q, complex<float>* out) const {
+    const int64_t count = block_count(b);
+    unpack_block(b, q);
+    const int k = exponents_[b] - (bits_ - 1);
+    const float s1 = detail::bfp_scale_factor(k / 2);
+    const float s2 = detail::bfp_scale_factor(k - k / 2);
+    float* o = reinterpret_cast<float*>(out);
+    C10_VEC_LOOP
+    for (int64_t j = 0; j < 2 * count; j++) {
+      o[j] = static_cast<float>(q[j]) * s1 * s2;
+    }
+  }
+
+  int64_t size_ = 0;
+  int bits_ = 16;
+  int64_t block_size_ = bfp_default_block_size;
+  std::vector<int16_t> exponents_;
+  std::vector<unsigned char> mantissas_;
+};
+
+namespace bulk {
+namespace detail {
+
+inline void check_bfp_formats(const complex_bfp& x, const complex_bfp& y, const char* function) {
+  if (x.size() != y.size() || x.mantissa_bits() != y.mantissa_bits() || x.block_size() != y.block_size()) {
+    throw std::invalid_argument(std::string(function) + ": operands must have the same size, mantissa bits and block size");
+  }
+}
+
+// Rounds the results r of block b, which stand for r 2^(exponent - (bits - 1)),
+// to the mantissas of out
+inline void bfp_store_block(complex_bfp& out, int64_t b, const int64_t* r, int exponent, int32_t* q) {
+  const int64_t count = out.block_count(b);
+  const int bits = out.mantissa_bits();
+  int64_t m = 0;
+  C10_VEC_LOOP
+  for (int64_t j = 0; j < 2 * count; j++) {
+    m = std::max(m, r[j] < 0 ? -r[j] : r[j]);
+  }
+  const int s = c10::detail::bfp_normalize_shift(m, bits);
+  const int32_t limit = c10::detail::bfp_max_mantissa(bits);
+  C10_VEC_LOOP
+  for (int64_t j = 0; j < 2 * count; j++) {
+    q[j] = c10::detail::bfp_round_shift(r[j], s, limit);
+  }
+  out.exponents()[b] = static_cast<int16_t>(std::max(-32768, std::min(32767, m == 0 ? 0 : exponent + s)));
+  out.pack_block(b, q);
+}
+
+} // namespace detail
+
+// out[i] = conj(x[i]), see [Block floating point]
+inline void conj(const complex_bfp& x, complex_bfp& out) {
+  if (&out != &x) {
+    out = x;
+  }
+  c10::parallel_for(0, out.num_blocks(), out.block_grain(), [&](int64_t begin, int64_t end) {
+    std::vector<int32_t> q(2 * out.block_size());
+    for (int64_t b = begin; b < end; b++) {
+      out.unpack_block(b, q.data());
+      const int64_t count = out.block_count(b);
+      C10_VEC_LOOP
+      for (int64_t j = 0; j < count; j++) {
+        q[2 * j + 1] = -q[2 * j + 1];
+      }
+      out.pack_block(b, q.data());
+    }
+  });
+}
+
+// out[i] = x[i] * y[i], see [Block floating point]
+inline void mul(const complex_bfp& x, const complex_bfp& y, complex_bfp& out) {
+  detail::check_bfp_formats(x, y, "c10::bulk::mul");
+  if (&out != &x && &out != &y) {
+    out = complex_bfp(x.size(), x.mantissa_bits(), x.block_size());
+  }
+  const int bits = x.mantissa_bits();
+  c10::parallel_for(0, x.num_blocks(), x.block_grain(), [&](int64_t begin, int64_t end) {
+    const int64_t n = 2 * x.block_size();
+    std::vector<int32_t> a(n), c(n), q(n);
+    std::vector<int64_t> r(n);
+    for (int64_t b = begin; b < end; b++) {
+      const int64_t count = x.block_count(b);
+      x.unpack_block(b, a.data());
+      y.unpack_block(b, c.data());
+      C10_VEC_LOOP
+      for (int64_t j = 0; j < count; j++) {
+        const int32_t ar = a[2 * j], ai = a[2 * j + 1];
+        const int32_t cr = c[2 * j], ci = c[2 * j + 1];
+        // at most 2 (2^15 - 1)^2, which fits in 32 bits
+        r[2 * j] = ar * cr - ai * ci;
+        r[2 * j + 1] = ar * ci + ai * cr;
+      }
+      // (qa 2^(Ea - bits + 1)) (qb 2^(Eb - bits + 1)) = r 2^(Ea + Eb - 2 (bits - 1))
+      const int exponent = x.exponents()[b] + y.exponents()[b] - (bits - 1);
+      detail::bfp_store_block(out, b, r.data(), exponent, q.data());
+    }
+  });
+}
+
+// out[i] = x[i] + y[i], see [Block floating point]
+inline void add(const complex_bfp& x, const complex_bfp& y, complex_bfp& out) {
+  detail::check_bfp_formats(x, y, "c10::bulk::add");
+  if (&out != &x && &out != &y) {
+    out = complex_bfp(x.size(), x.mantissa_bits(), x.block_size());
+  }
+  c10::parallel_for(0, x.num_blocks(), x.block_grain(), [&](int64_t begin, int64_t end) {
+    const int64_t n = 2 * x.block_size();
+    std::vector<int32_t> a(n), c(n), q(n);
+    std::vector<int64_t> r(n);
+    for (int64_t b = begin; b < end; b++) {
+      const int64_t count = x.block_count(b);
+      x.unpack_block(b, a.data());
+      y.unpack_block(b, c.data());
+      const int ex = x.exponents()[b], ey = y.exponents()[b];
+      const int e = std::max(ex, ey);
+      // the mantissas of the smaller exponent lose their low bits; 16 guard
+      // bits keep the sum exact unless the exponents differ by more
+      constexpr int guard = 16;
+      const int sx = std::min(e - ex, 62), sy = std::min(e - ey, 62);
+      const int64_t one = int64_t(1) << guard;
+      C10_VEC_LOOP
+      for (int64_t j = 0; j < 2 * count; j++) {
+        r[j] = ((a[j] * one) >> sx) + ((c[j] * one) >> sy);
+      }
+      detail::bfp_store_block(out, b, r.data(), e - guard, q.data());
+    }
+  });
+}
+
+} // namespace bulk
+} // namespace c10
@@ -0,0 +1,599 @@
+#pragma once
+
+#include <c10/util/complex.h>
+#include <c10/util/complex_parallel.h>
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <new>
+#include <utility>
+#include <vector>
+
+#if defined(_WIN32)
+#include <malloc.h>
+#endif
+#if defined(__linux__)
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+// Owning, aligned and pooled arrays of c10::complex for kernel temporaries
+//
+// [Complex buffers]
+//
+// c10::complex_buffer<T> owns an array of n c10::complex<T>, like
+// std::unique_ptr<c10::complex<T>[]>, but:
+// - the data is aligned to 64 bytes (a cache line and an AVX-512 register)
+// - the elements are not initialized, like at::empty, since scratch
+//   buffers are written before they are read
+// - the memory comes from a per-thread pool and goes back to it when the
+//   buffer is destroyed, so code that needs the same scratch buffers on
+//   every call (FFT, convolution, ...) only allocates on the first call
+// - blocks of at least buffer_huge_page_size are aligned to it and on Linux
+//   marked for transparent huge pages, which saves TLB misses on large
+//   arrays
+//
+// The pool rounds sizes up to a power of two (at least 64 bytes), and keeps
+// freed blocks in one list per size in the thread that frees them, up to
+// buffer_max_cached_bytes per thread; blocks beyond that go back to the
+// system. Blocks larger than buffer_max_pooled_bytes are never pooled, so
+// they are only rounded up to their alignment. A buffer may be
+// destroyed on another thread than the one that created it.
+// c10::release_cached_buffers() frees the blocks cached by the calling
+// thread.
+//
+// c10::get_buffer_stats() counts, over all threads, the requests, how many
+// of them were served from the pool, i.e. allocations avoided, and the
+// blocks allocated with huge pages.
+//
+// [NUMA placement]
+//
+// On machines with several NUMA nodes (sockets), a page is by default placed
+// on the node of the thread that first writes to it, so an array that is
+// initialized by one thread ends up on one node, and parallel kernels on it
+// are limited by the bandwidth of that node. A buffer constructed with
+// numa_options instead gets fresh pages from the kernel, with one of these
+// placements:
+// - numa_placement::interleave: the pages are spread round-robin over all
+//   nodes, which balances the bandwidth without any assumption on which
+//   thread reads what
+// - numa_placement::partition: the chunks of the loop described by the
+//   options are placed on the nodes in order, the first chunks on the first
+//   node. Accesses are local when threads are pinned to the nodes in the
+//   same order (e.g. with numactl or taskset), and balanced otherwise.
+// - numa_placement::none: the default policy, so pages go to the node of the
+//   thread that first touches them
+// With options.first_touch (the default) the buffer is zeroed by that loop,
+// so that each page is first touched by the thread that will process it.
+//
+// The loop is c10::parallel_for(0, units, options.grain_size, ...) over the
+// buffer cut into units of options.unit_bytes bytes, the iterations of the
+// loop. The defaults, units of one element and a grain of 2^17 of them,
+// describe an elementwise loop of the caller. The parallel kernels split
+// their arrays differently, and give the options that match them:
+// - bulk::convert_numa_options<T>() for the arrays of bulk::convert, split
+//   into real numbers
+// - bfp_numa_options(block_size) for the complex<float> arrays that
+//   complex_bfp encodes and decodes, split into blocks
+// The STFT splits each piece of its stream on its own, so no partition
+// matches its outputs, which are best interleaved. The number of threads
+// must not change between allocation and use.
+//
+// The placement uses the mbind system call of Linux directly, without
+// libnuma. On other systems, or if the kernel refuses (e.g. in containers
+// without NUMA support), the buffer is allocated normally and the placement
+// is ignored; get_buffer_stats().numa_placed counts the buffers that were
+// placed. NUMA buffers are not pooled: their pages go back to the kernel
+// when the buffer is destroyed.
+
+namespace c10 {
+
+constexpr size_t buffer_alignment = 64;
+constexpr size_t buffer_huge_page_size = size_t(1) << 21;  // 2 MiB
+constexpr size_t buffer_max_pooled_bytes = size_t(1) << 28;  // 256 MiB
+constexpr size_t buffer_max_cached_bytes = size_t(1) << 30;  // 1 GiB
+
+struct buffer_stats {
+  uint64_t requests;           // blocks requested
+  uint64_t reused;             // requests served from the pool
+  uint64_t system_allocations; // requests that allocated from the system
+  uint64_t huge_pages;         // system allocations marked for huge pages
+  uint64_t cached_bytes;       // bytes currently cached by all threads
+  uint64_t numa_placed;        // buffers placed on NUMA nodes
+};
+
+// See [NUMA placement]
+enum class numa_placement {
+  none,
+  interleave,
+  partition,
+};
+
+struct numa_options {
+  numa_placement placement = numa_placement::interleave;
+  // grain size, in units, of the parallel_for loops that use the buffer
+  int64_t grain_size = int64_t(1) << 17;
+  // bytes per iteration of those loops, 0 for one element
+  size_t unit_bytes = 0;
+  // zero the buffer in parallel with the same chunks as those loops
+  bool first_touch = true;
+};
+
+namespace detail {
+
+struct buffer_counters {
+  std::atomic<uint64_t> requests{0};
+  std::atomic<uint64_t> reused{0};
+  std::atomic<uint64_t> system_allocations{0};
+  std::atomic<uint64_t> huge_pages{0};
+  std::atomic<uint64_t> cached_bytes{0};
+  std::atomic<uint64_t> numa_placed{0};
+};
+
+inline buffer_counters& global_buffer_counters() {
+  static buffer_counters c;
+  return c;
+}
+
+// Alignment of a block of bytes from the system
+inline size_t system_alignment(size_t bytes) {
+  return bytes >= buffer_huge_page_size ? buffer_huge_page_size : buffer_alignment;
+}
+
+// bytes rounded up to a multiple of its alignment, at least one
+inline size_t system_block_size(size_t bytes) {
+  const size_t alignment = system_alignment(bytes);
+  return std::max(alignment, (bytes + alignment - 1) / alignment * alignment);
+}
+
+// Size of the block for a request of bytes: a power of two if the pool can
+// keep it
+inline size_t buffer_block_size(size_t bytes) {
+  if (bytes > buffer_max_pooled_bytes) {
+    return system_block_size(bytes);
+  }
+  size_t size = buffer_alignment;
+  while (size < bytes) {
+    size *= 2;
+  }
+  return size;
+}
+
+inline int buffer_size_class(size_t block_size) {
+  int c = 0;
+  for (size_t size = buffer_alignment; size < block_size; size *= 2) {
+    c++;
+  }
+  return c;
+}
+
+constexpr int buffer_num_size_classes = 23;  // 2^6 ... 2^28 bytes
+
+inline void* system_allocate(size_t bytes) {
+  const bool huge = bytes >= buffer_huge_page_size;
+  const size_t alignment = system_alignment(bytes);
+  void* p = nullptr;
+#if defined(_WIN32)
+  p = _aligned_malloc(bytes, alignment);
+#else
+  if (posix_memalign(&p, alignment, bytes) != 0) {
+    p = nullptr;
+  }
+#endif
+  if (p == nullptr) {
+    throw std::bad_alloc();
+  }
+  global_buffer_counters().system_allocations.fetch_add(1, std::memory_order_relaxed);
+#if defined(__linux__) && defined(MADV_HUGEPAGE)
+  if (huge && madvise(p, bytes, MADV_HUGEPAGE) == 0) {
+    global_buffer_counters().huge_pages.fetch_add(1, std::memory_order_relaxed);
+  }
+#endif
+  return p;
+}
+
+inline void system_free(void* p) {
+#if defined(_WIN32)
+  _aligned_free(p);
+#else
+  std::free(p);
+#endif
+}
+
+// Set when the cache of the thread is destroyed at thread exit, so that
+// buffers destroyed later (e.g. in other thread_local objects) are freed
+// directly. A trivially destructible thread_local stays usable until the
+// thread ends.
+inline bool& buffer_cache_destroyed() {
+  thread_local bool destroyed = false;
+  return destroyed;
+}
+
+struct buffer_cache {
+  std::vector<void*> free_blocks[buffer_num_size_classes];
+  size_t cached_bytes = 0;
+
+  void release() {
+    for (int c = 0; c < buffer_num_size_classes; c++) {
+      for (void* p : free_blocks[c]) {
+        system_free(p);
+      }
+      free_blocks[c].clear();
+    }
+    global_buffer_counters().cached_bytes.fetch_sub(cached_bytes, std::memory_order_relaxed);
+    cached_bytes = 0;
+  }
+
+  ~buffer_cache() {
+    release();
+    buffer_cache_destroyed() = true;
+  }
+};
+
+inline buffer_cache& local_buffer_cache() {
+  thread_local buffer_cache cache;
+  return cache;
+}
+
+// A block of at least bytes, aligned to buffer_alignment. block_size is set
+// to the size that has to be passed to buffer_free.
+inline void* buffer_allocate(size_t bytes, size_t& block_size) {
+  block_size = buffer_block_size(bytes);
+  global_buffer_counters().requests.fetch_add(1, std::memory_order_relaxed);
+  if (block_size <= buffer_max_pooled_bytes && !buffer_cache_destroyed()) {
+    buffer_cache& cache = local_buffer_cache();
+    auto& list = cache.free_blocks[buffer_size_class(block_size)];
+    if (!list.empty()) {
+      void* p = list.back();
+      list.pop_back();
+      cache.cached_bytes -= block_size;
+      global_buffer_counters().cached_bytes.fetch_sub(block_size, std::memory_order_relaxed);
+      global_buffer_counters().reused.fetch_add(1, std::memory_order_relaxed);
+      return p;
+    }
+  }
+  return system_allocate(block_size);
+}
+
+inline void buffer_free(void* p, size_t block_size) {
+  if (p == nullptr) {
+    return;
+  }
+  if (block_size <= buffer_max_pooled_bytes && !buffer_cache_destroyed()) {
+    buffer_cache& cache = local_buffer_cache();
+    if (cache.cached_bytes + block_size <= buffer_max_cached_bytes) {
+      try {
+        cache.free_blocks[buffer_size_class(block_size)].push_back(p);
+      } catch (const std::bad_alloc&) {
+        system_free(p);
+        return;
+      }
+      cache.cached_bytes += block_size;
+      global_buffer_counters().cached_bytes.fetch_add(block_size, std::memory_order_relaxed);
+      return;
+    }
+  }
+  system_free(p);
+}
+
+// NUMA buffers, see [NUMA placement]
+
+inline size_t numa_unit_bytes(size_t element_size, const numa_options& options) {
+  return options.unit_bytes > 0 ? options.unit_bytes : element_size;
+}
+
+// The byte offsets of the chunks that the loop of options splits bytes
+// into, chunk k being [offsets[k], offsets[k + 1])
+inline std::vector<size_t> numa_chunk_offsets(size_t bytes, size_t element_size, const numa_options& options) {
+  const size_t unit = numa_unit_bytes(element_size, options);
+  const int64_t units = (bytes + unit - 1) / unit;
+  std::vector<size_t> offsets = {0};
+  if (units > 0) {
+    const int64_t num_chunks = parallel_num_chunks(units, options.grain_size);
+    const int64_t chunk_size = (units + num_chunks - 1) / num_chunks;
+    for (int64_t begin = chunk_size; begin < units; begin += chunk_size) {
+      offsets.push_back(begin * unit);
+    }
+  }
+  offsets.push_back(bytes);
+  return offsets;
+}
+
+#if defined(__linux__) && defined(SYS_mbind) && defined(SYS_get_mempolicy)
+
+// From <linux/mempolicy.h>
+constexpr int mpol_preferred = 1;
+constexpr int mpol_interleave = 3;
+constexpr unsigned long mpol_f_mems_allowed = 1 << 2;
+
+constexpr int numa_max_nodes = 1024;
+constexpr int numa_mask_word_bits = 8 * sizeof(unsigned long);
+
+struct numa_node_mask {
+  unsigned long words[numa_max_nodes / numa_mask_word_bits] = {};
+
+  void set(int node) {
+    words[node / numa_mask_word_bits] |= 1ul << (node % numa_mask_word_bits);
+  }
+  bool test(int node) const {
+    return (words[node / numa_mask_word_bits] >> (node % numa_mask_word_bits)) & 1;
+  }
+};
+
+// The kernel reads one bit less than maxnode
+constexpr unsigned long numa_maxnode = numa_max_nodes + 1;
+
+// The nodes the process may allocate memory on, empty if unknown
+inline const std::vector<int>& numa_nodes() {
+  static const std::vector<int> nodes = [] {
+    std::vector<int> result;
+    numa_node_mask allowed;
+    if (syscall(SYS_get_mempolicy, nullptr, allowed.words, numa_maxnode, nullptr, mpol_f_mems_allowed) == 0) {
+      for (int node = 0; node < numa_max_nodes; node++) {
+        if (allowed.test(node)) {
+          result.push_back(node);
+        }
+      }
+    }
+    return result;
+  }();
+  return nodes;
+}
+
+inline bool numa_bind(void* p, size_t bytes, int mode, const numa_node_mask& mask) {
+  return bytes == 0 || syscall(SYS_mbind, p, bytes, mode, mask.words, numa_maxnode, 0) == 0;
+}
+
+inline size_t page_size() {
+  static const size_t size = static_cast<size_t>(sysconf(_SC_PAGESIZE));
+  return size;
+}
+
+// Pages that nobody has touched yet, so that the NUMA policy applies to all
+// of them. bytes is a multiple of alignment, which is a multiple of the page
+// size.
+inline void* numa_map(size_t bytes, size_t alignment) {
+  const size_t mapped = bytes + alignment - page_size();
+  void* p = mmap(nullptr, mapped, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+  if (p == MAP_FAILED) {
+    throw std::bad_alloc();
+  }
+  char* start = static_cast<char*>(p);
+  char* aligned = start + (alignment - reinterpret_cast<uintptr_t>(start) % alignment) % alignment;
+  if (aligned != start) {
+    munmap(start, aligned - start);
+  }
+  if (aligned + bytes != start + mapped) {
+    munmap(aligned + bytes, start + mapped - (aligned + bytes));
+  }
+  return aligned;
+}
+
+// Applies the placement to n elements of element_size bytes at p, in a
+// mapping of bytes
+inline bool numa_place(char* p, size_t bytes, int64_t n, size_t element_size, const numa_options& options) {
+  const std::vector<int>& nodes = numa_nodes();
+  if (nodes.empty()) {
+    return false;
+  }
+  if (options.placement == numa_placement::interleave) {
+    numa_node_mask mask;
+    for (int node : nodes) {
+      mask.set(node);
+    }
+    return numa_bind(p, bytes, mpol_interleave, mask);
+  }
+  // partition: chunk k goes to node k * nodes / chunks, cut at the page
+  // that contains its first byte
+  const std::vector<size_t> offsets = numa_chunk_offsets(n * element_size, element_size, options);
+  const int64_t num_chunks = offsets.size() - 1;
+  const int64_t num_nodes = nodes.size();
+  auto page_begin = [&](size_t byte) {
+    return byte / page_size() * page_size();
+  };
+  bool placed = true;
+  for (int64_t k = 0; k < num_chunks; k++) {
+    numa_node_mask mask;
+    mask.set(nodes[k * num_nodes / num_chunks]);
+    const size_t begin = page_begin(offsets[k]);
+    const size_t end = k + 1 == num_chunks ? bytes : page_begin(offsets[k + 1]);
+    if (end > begin) {
+      placed = numa_bind(p + begin, end - begin, mpol_preferred, mask) && placed;
+    }
+  }
+  return placed;
+}
+
+// A block of at least n * element_size bytes placed as given by options.
+// block_size is set to the size that has to be passed to numa_free.
+inline void* numa_allocate(int64_t n, size_t element_size, const numa_options& options, size_t& block_size) {
+  const size_t bytes = n * element_size;
+  const bool huge = bytes >= buffer_huge_page_size;
+  const size_t alignment = huge ? buffer_huge_page_size : std::max(page_size(), buffer_alignment);
+  block_size = (bytes + alignment - 1) / alignment * alignment;
+  buffer_counters& c = global_buffer_counters();
+  c.requests.fetch_add(1, std::memory_order_relaxed);
+  char* p = static_cast<char*>(numa_map(block_size, alignment));
+  c.system_allocations.fetch_add(1, std::memory_order_relaxed);
+#if defined(MADV_HUGEPAGE)
+  if (huge && madvise(p, block_size, MADV_HUGEPAGE) == 0) {
+    c.huge_pages.fetch_add(1, std::memory_order_relaxed);
+  }
+#endif
+  if (options.placement != numa_placement::none && numa_place(p, block_size, n, element_size, options)) {
+    c.numa_placed.fetch_add(1, std::memory_order_relaxed);
+  }
+  return p;
+}
+
+inline void numa_free(void* p, size_t block_size) {
+  if (p != nullptr) {
+    munmap(p, block_size);
+  }
+}
+
+#else
+
+inline const std::vector<int>& numa_nodes() {
+  static const std::vector<int> nodes;
+  return nodes;
+}
+
+inline void* numa_allocate(int64_t n, size_t element_size, const numa_options& /*options*/, size_t& block_size) {
+  block_size = system_block_size(n * element_size);
+  global_buffer_counters().requests.fetch_add(1, std::memory_order_relaxed);
+  return system_allocate(block_size);
+}
+
+inline void numa_free(void* p, size_t /*block_size*/) {
+  system_free(p);
+}
+
+#endif
+
+} // namespace detail
+
+inline buffer_stats get_buffer_stats() {
+  const detail::buffer_counters& c = detail::global_buffer_counters();
+  return buffer_stats{
+    c.requests.load(std::memory_order_relaxed),
+    c.reused.load(std::memory_order_relaxed),
+    c.system_allocations.load(std::memory_order_relaxed),
+    c.huge_pages.load(std::memory_order_relaxed),
+    c.cached_bytes.load(std::memory_order_relaxed),
+    c.numa_placed.load(std::memory_order_relaxed)};
+}
+
+// Frees the blocks cached by the calling thread
+inline void release_cached_buffers() {
+  if (!detail::buffer_cache_destroyed()) {
+    detail::local_buffer_cache().release();
+  }
+}
+
+// Number of NUMA nodes the process may allocate memory on, 1 if unknown
+inline int get_numa_num_nodes() {
+  return std::max<int>(1, detail::numa_nodes().size());
+}
+
+// See [Complex buffers]
+template<typename T>
+class complex_buffer {
+ public:
+  using value_type = c10::complex<T>;
+
+  complex_buffer() = default;
+
+  // n uninitialized elements
+  explicit complex_buffer(int64_t n): size_(n) {
+    if (n > 0) {
+      data_ = static_cast<value_type*>(detail::buffer_allocate(n * sizeof(value_type), block_size_));
+    }
+  }
+
+  complex_buffer(int64_t n, const value_type& value): complex_buffer(n) {
+    for (int64_t i = 0; i < n; i++) {
+      data_[i] = value;
+    }
+  }
+
+  // n elements placed on the NUMA nodes as given by options, see
+  // [NUMA placement]
+  complex_buffer(int64_t n, const numa_options& options): size_(n), numa_(true) {
+    if (n > 0) {
+      data_ = static_cast<value_type*>(detail::numa_allocate(n, sizeof(value_type), options, block_size_));
+      if (options.first_touch) {
+        char* data = reinterpret_cast<char*>(data_);
+        const size_t bytes = n * sizeof(value_type);
+        const size_t unit = detail::numa_unit_bytes(sizeof(value_type), options);
+        c10::parallel_for(0, (bytes + unit - 1) / unit, options.grain_size, [&](int64_t begin, int64_t end) {
+          const size_t first = begin * unit;
+          std::memset(data + first, 0, std::min(bytes, end * unit) - first);
+        });
+      }
+    }
+  }
+
+  complex_buffer(complex_buffer&& other) noexcept
+    : data_(other.data_), size_(other.size_), block_size_(other.block_size_), numa_(other.numa_) {
+    other.data_ = nullptr;
+    other.size_ = 0;
+    other.block_size_ = 0;
+    other.numa_ = false;
+  }
+
+  complex_buffer& operator=(complex_buffer&& other) noexcept {
+    if (this != &other) {
+      reset();
+      std::swap(data_, other.data_);
+      std::swap(size_, other.size_);
+      std::swap(block_size_, other.block_size_);
+      std::swap(numa_, other.numa_);
+    }
+    return *this;
+  }
+
+  complex_buffer(const complex_buffer&) = delete;
+  complex_buffer& operator=(const complex_buffer&) = delete;
+
+  ~complex_buffer() {
+    reset();
+  }
+
+  // frees the data, or returns it to the pool
+  void reset() {
+    if (numa_) {
+      detail::numa_free(data_, block_size_);
+    } else {
+      detail::buffer_free(data_, block_size_);
+    }
+    data_ = nullptr;
+    size_ = 0;
+    block_size_ = 0;
+    numa_ = false;
+  }
+
+  value_type* data() {
+    return data_;
+  }
+  const value_type* data() const {
+    return data_;
+  }
+  int64_t size() const {
+    return size_;
+  }
+  bool empty() const {
+    return size_ == 0;
+  }
+  value_type& operator[](int64_t i) {
+    return data_[i];
+  }
+  const value_type& operator[](int64_t i) const {
+    return data_[i];
+  }
+  value_type* begin() {
+    return data_;
+  }
+  value_type* end() {
+    return data_ + size_;
+  }
+  const value_type* begin() const {
+    return data_;
+  }
+  const value_type* end() const {
+    return data_ + size_;
+  }
+
+ private:
+  value_type* data_ = nullptr;
+  int64_t size_ = 0;
+  size_t block_size_ = 0;
+  bool numa_ = false;
+};
+
+} // namespace c10
@@ -0,0 +1,849 @@
+#pragma once
+
+#include <c10/util/complex.h>
+#include <c10/util/complex_nontemporal.h>
+#include <c10/util/complex_vec_math.h>
+
+#include <algorithm>
+#include <cstdint>
+#include <limits>
+#include <type_traits>
+
+// Bulk math functions for contiguous arrays of c10::complex
+//
+// [Bulk kernels]
+//
+// Each function in namespace c10::bulk computes the corresponding function in
+// c10/util/complex_math.h elementwise on arrays, e.g.
+//
+//   c10::bulk::exp(x, out, n);  // out[i] = std::exp(x[i]) for i in [0, n)
+//
+// Only c10::complex<float> and c10::complex<double> are supported. Input and
+// output may alias exactly (in-place), but must not partially overlap.
+//
+// Elements are processed in blocks of vec_math::lanes<T>::value. A block is
+// split into separate arrays of real and imaginary parts, every lane is
+// computed by the branch-free functions in c10/util/complex_vec_math.h, and
+// the results are interleaved again. Each lane also reports whether its
+// input is in the region handled by the fast path; lanes that are not (zero,
+// infinite or NaN inputs, huge arguments of sin/cos, ...) are recomputed
+// with the scalar function, so the results follow the same special value
+// behavior as std::complex.
+//
+// Outputs of at least get_streaming_threshold() bytes that are not computed
+// in place are written with non-temporal stores, see [Non-temporal stores]
+// in c10/util/complex_nontemporal.h.
+//
+// The multiply-accumulate kernels axpy, dot and vdot are described in
+// [Bulk multiply-add] below.
+
+namespace c10 {
+namespace bulk {
+namespace detail {
+
+template<typename T>
+struct check_bulk_type {
+  static_assert(std::is_same<T, float>::value || std::is_same<T, double>::value,
+    "bulk kernels only support c10::complex<float> and c10::complex<double>");
+};
+
+// Runs map<false> on the elements before the first 64-byte boundary of out,
+// and map<true>, which writes full blocks with non-temporal stores, on the
+// others if the output is large enough, see [Non-temporal stores]
+template<typename T, typename Map>
+void stream_map(complex<T>* out, int64_t n, bool in_place, const Map& map) {
+  if (!use_stream_stores(n * sizeof(complex<T>), in_place)) {
+    map(std::integral_constant<bool, false>(), 0, n);
+    return;
+  }
+  const int64_t head = std::min(n, stream_head(out));
+  map(std::integral_constant<bool, false>(), 0, head);
+  map(std::integral_constant<bool, true>(), head, n);
+  stream_fence();
+}
+
+// out[i] = k(x[i]) for i in [begin, end). With Stream, full blocks of out
+// are written with non-temporal stores and out + begin must be aligned to 64
+// bytes.
+template<bool Stream, typename T, typename Kernel>
+void unary_map_range(const complex<T>* x, complex<T>* out, int64_t begin, int64_t end, const Kernel& k) {
+  constexpr int W = vec_math::lanes<T>::value;
+  for (int64_t i = begin; i < end; i += W) {
+    const int count = end - i < W ? static_cast<int>(end - i) : W;
+    T re[W], im[W], ore[W], oim[W];
+    // same width as T, so that the lane loop does not mix vector sizes
+    typename vec_math::float_traits<T>::uint_t ok[W];
+    if (count == W) {
+      C10_VEC_LOOP
+      for (int l = 0; l < W; l++) {
+        re[l] = x[i + l].real();
+        im[l] = x[i + l].imag();
+      }
+    } else {
+      // pad the tail with a value that is on the fast path of every kernel
+      for (int l = 0; l < W; l++) {
+        re[l] = l < count ? x[i + l].real() : T(1);
+        im[l] = l < count ? x[i + l].imag() : T(0);
+      }
+    }
+    C10_VEC_LOOP
+    for (int l = 0; l < W; l++) {
+      ok[l] = k(re[l], im[l], ore[l], oim[l]);
+    }
+    bool all_ok = true;
+    for (int l = 0; l < count; l++) {
+      all_ok = all_ok && ok[l];
+    }
+    alignas(stream_line) complex<T> block[W];
+    complex<T>* dst = Stream && count == W ? block : out + i;
+    for (int l = 0; l < count; l++) {
+      dst[l] = complex<T>(ore[l], oim[l]);
+    }
+    if (!all_ok) {
+      for (int l = 0; l < count; l++) {
+        if (!ok[l]) {
+          dst[l] = k.scalar(complex<T>(re[l], im[l]));
+        }
+      }
+    }
+    if (Stream && count == W) {
+      stream_lines(out + i, block, sizeof(block));
+    }
+  }
+}
+
+// out[i] = k(x[i]), where k(re, im, out_re, out_im) computes one lane and
+// returns false if the lane has to be recomputed by k.scalar(x[i])
+template<typename T, typename Kernel>
+void unary_map(const complex<T>* x, complex<T>* out, int64_t n, const Kernel& k) {
+  check_bulk_type<T>();
+  stream_map(out, n, x == out, [&](auto stream, int64_t begin, int64_t end) {
+    unary_map_range<decltype(stream)::value>(x, out, begin, end, k);
+  });
+}
+
+// out[i] = k(x[i], y[i]) for i in [begin, end), see unary_map_range
+template<bool Stream, typename T, typename Kernel>
+void binary_map_range(const complex<T>* x, const complex<T>* y, complex<T>* out, int64_t begin, int64_t end, const Kernel& k) {
+  constexpr int W = vec_math::lanes<T>::value;
+  for (int64_t i = begin; i < end; i += W) {
+    const int count = end - i < W ? static_cast<int>(end - i) : W;
+    T xr[W], xi[W], yr[W], yi[W], ore[W], oim[W];
+    typename vec_math::float_traits<T>::uint_t ok[W];
+    if (count == W) {
+      C10_VEC_LOOP
+      for (int l = 0; l < W; l++) {
+        xr[l] = x[i + l].real();
+        xi[l] = x[i + l].imag();
+        yr[l] = y[i + l].real();
+        yi[l] = y[i + l].imag();
+      }
+    } else {
+      for (int l = 0; l < W; l++) {
+        xr[l] = l < count ? x[i + l].real() : T(1);
+        xi[l] = l < count ? x[i + l].imag() : T(0);
+        yr[l] = l < count ? y[i + l].real() : T(1);
+        yi[l] = l < count ? y[i + l].imag() : T(0);
+      }
+    }
+    C10_VEC_LOOP
+    for (int l = 0; l < W; l++) {
+      ok[l] = k(xr[l], xi[l], yr[l], yi[l], ore[l], oim[l]);
+    }
+    bool all_ok = true;
+    for (int l = 0; l < count; l++) {
+      all_ok = all_ok && ok[l];
+    }
+    alignas(stream_line) complex<T> block[W];
+    complex<T>* dst = Stream && count == W ? block : out + i;
+    for (int l = 0; l < count; l++) {
+      dst[l] = complex<T>(ore[l], oim[l]);
+    }
+    if (!all_ok) {
+      for (int l = 0; l < count; l++) {
+        if (!ok[l]) {
+          dst[l] = k.scalar(complex<T>(xr[l], xi[l]), complex<T>(yr[l], yi[l]));
+        }
+      }
+    }
+    if (Stream && count == W) {
+      stream_lines(out + i, block, sizeof(block));
+    }
+  }
+}
+
+// out[i] = k(x[i], y[i]), see unary_map
+template<typename T, typename Kernel>
+void binary_map(const complex<T>* x, const complex<T>* y, complex<T>* out, int64_t n, const Kernel& k) {
+  check_bulk_type<T>();
+  stream_map(out, n, x == out || y == out, [&](auto stream, int64_t begin, int64_t end) {
+    binary_map_range<decltype(stream)::value>(x, y, out, begin, end, k);
+  });
+}
+
+// exp(re + im i) = e^re * (cos(im) + sin(im) i)
+//
+// e^re is kept as mantissa * 2^n (see vec_math::exp_mantissa), and only the
+// products with cos and sin are scaled, so the result does not overflow when
+// e^re does but e^re * cos(im) does not.
+template<typename T>
+C10_VEC_INLINE bool exp_lane(T re, T im, T& out_re, T& out_im) {
+  T n;
+  T p = vec_math::exp_mantissa(re, n);
+  T s, c;
+  vec_math::sincos(im, s, c);
+  out_re = vec_math::ldexp(p * c, n);
+  out_im = vec_math::ldexp(p * s, n);
+  return vec_math::exp_fast_ok(re) & vec_math::sincos_fast_ok(im);
+}
+
+// log(re + im i) = log|z| + arg(z) i
+//
+// Both parts are computed from hi = max(|re|, |im|) and ratio = min / hi:
+//   log|z| = log(hi) + log1p(ratio^2) / 2
+//   arg(z) = atan(ratio), reflected into the right octant
+// which avoids the overflow and underflow of re^2 + im^2. Close to |z| = 1
+// the two terms cancel, so there log|z| = log1p(hi^2 + lo^2 - 1) / 2 with
+// the squares computed exactly.
+template<typename T>
+C10_VEC_INLINE bool log_lane(T re, T im, T& out_re, T& out_im) {
+  T are = vec_math::abs(re);
+  T aim = vec_math::abs(im);
+  bool im_larger = aim > are;
+  T hi = vec_math::max(are, aim);
+  T lo = vec_math::min(are, aim);
+  bool ok = vec_math::is_finite(re) & vec_math::is_finite(im) & (hi > T(0));
+  hi = vec_math::select(ok, hi, T(1));
+  T ratio = lo / hi;
+  T hh_lo, ll_lo;
+  T hh = vec_math::two_product(hi, hi, hh_lo);
+  T ll = vec_math::two_product(lo, lo, ll_lo);
+  T near_one = T(0.5) * vec_math::log1p(((hh - T(1)) + ll) + (hh_lo + ll_lo));
+  T general = vec_math::log(hi) + T(0.5) * vec_math::log1p(ratio * ratio);
+  // hh - 1 is exact for hh in [1/2, 2]
+  out_re = vec_math::select((hi > T(0.70710678118654752440)) & (hi < T(1.41421356237309504880)), near_one, general);
+  out_im = vec_math::atan2_from_ratio(im, re, ratio, im_larger);
+  return ok;
+}
+
+// x^y = exp(y * log(x)), without leaving registers in between
+template<typename T>
+C10_VEC_INLINE bool pow_lane(T xr, T xi, T yr, T yi, T& out_re, T& out_im) {
+  T lr, li;
+  bool ok = log_lane(xr, xi, lr, li);
+  T ar = yr * lr - yi * li;
+  T ai = yr * li + yi * lr;
+  ok = exp_lane(ar, ai, out_re, out_im) & ok;
+  return ok & vec_math::is_finite(yr) & vec_math::is_finite(yi);
+}
+
+// The real products needed by sin, cos, sinh and cosh of x + y i:
+//   ch_c = cosh(x) cos(y), sh_s = sinh(x) sin(y)
+//   sh_c = sinh(x) cos(y), ch_s = cosh(x) sin(y)
+// with one exponential and one sincos per lane. Like exp_lane, e^|x| is
+// kept as mantissa * 2^n so that the products do not overflow early.
+template<typename T>
+C10_VEC_INLINE bool sinhcosh_lane(T x, T y, T& ch_c, T& sh_s, T& sh_c, T& ch_s) {
+  T ax = vec_math::abs(x);
+  T n;
+  T p = vec_math::exp_mantissa(ax, n);
+  T s, c;
+  vec_math::sincos(y, s, c);
+  // e^|x| / 2 and e^-|x| / 2 multiplied by c and s
+  T big_c = vec_math::ldexp(p * c, n - T(1));
+  T small_c = vec_math::ldexp(c / p, -n - T(1));
+  T big_s = vec_math::ldexp(p * s, n - T(1));
+  T small_s = vec_math::ldexp(s / p, -n - T(1));
+  bool tiny = ax < T(1);
+  T sh = vec_math::sinh_poly(ax);
+  T sinh_c = vec_math::select(tiny, sh * c, big_c - small_c);
+  T sinh_s = vec_math::select(tiny, sh * s, big_s - small_s);
+  bool negative = vec_math::signbit(x);
+  ch_c = big_c + small_c;
+  ch_s = big_s + small_s;
+  sh_c = vec_math::select(negative, -sinh_c, sinh_c);
+  sh_s = vec_math::select(negative, -sinh_s, sinh_s);
+  return vec_math::exp_fast_ok(x) & vec_math::sincos_fast_ok(y);
+}
+
+// tanh(x + y i) = (sinh(x) cosh(x) + sin(y) cos(y) i) / (sinh(x)^2 + cos(y)^2)
+//
+// For large |x|, tanh(x + y i) = sign(x) + 4 sin(y) cos(y) e^(-2|x|) i
+template<typename T>
+C10_VEC_INLINE bool tanh_lane(T x, T y, T& out_re, T& out_im) {
+  T ax = vec_math::abs(x);
+  T s, c;
+  vec_math::sincos(y, s, c);
+  bool large = ax > vec_math::tanh_limit<T>::value;
+  T e = vec_math::exp(vec_math::min(ax, vec_math::tanh_limit<T>::value));
+  T sh = vec_math::select(ax < T(1), vec_math::sinh_poly(ax), T(0.5) * (e - T(1) / e));
+  T ch = T(0.5) * (e + T(1) / e);
+  T den = sh * sh + c * c;
+  T re = vec_math::select(large, T(1), sh * ch / den);
+  T im = vec_math::select(large, T(4) * s * c * vec_math::exp(T(-2) * ax), s * c / den);
+  out_re = vec_math::copysign(re, x);
+  out_im = im;
+  return vec_math::is_finite(x) & vec_math::sincos_fast_ok(y);
+}
+
+// sqrt(x + y i) = t + y / (2t) i          if x >= 0
+//              = |y| / (2t) + sign(y) t i  if x < 0
+// with t = sqrt((|x| + |z|) / 2), so that no branch subtracts nearly equal
+// values; the two cases are blended. |z| is computed after scaling x and y
+// by 2^-2k, an even power of two that brings max(|x|, |y|) into [1, 4),
+// hence t = 2^k * t_scaled and |z| = 2^2k * r_scaled never overflow or
+// underflow. Lanes with subnormal, infinite or NaN parts are not ok; zero
+// lanes are ok and have t_scaled = 0.
+template<typename T>
+C10_VEC_INLINE bool sqrt_lane(T re, T im, T& t_scaled, T& y_scaled, T& r_scaled, T& pow2_k, T& pow2_minus_k) {
+  using traits = vec_math::float_traits<T>;
+  using uint_t = typename traits::uint_t;
+  constexpr uint_t bias = traits::exponent_bias;
+  T x = vec_math::abs(re);
+  T y = vec_math::abs(im);
+  bool zero = (x == T(0)) & (y == T(0));
+  bool ok = vec_math::is_finite(re) & vec_math::is_finite(im) & (vec_math::max(x, y) >= std::numeric_limits<T>::min());
+  x = vec_math::select(ok, x, T(1));
+  y = vec_math::select(ok, y, T(0));
+  uint_t half_exp;
+  vec_math::split_even_exponent(vec_math::max(x, y), half_exp);
+  pow2_k = vec_math::pow2_half_exp<T>(half_exp);
+  pow2_minus_k = vec_math::from_bits<T>((bias + (bias + 1) / 2 - half_exp) << traits::mantissa_bits);
+  T scale = vec_math::from_bits<T>((2 * bias + 1 - 2 * half_exp) << traits::mantissa_bits);  // 2^-2k
+  T x_scaled = x * scale;
+  y_scaled = y * scale;
+  r_scaled = vec_math::hypot_unsafe(x_scaled, y_scaled);
+  t_scaled = vec_math::select(zero, T(0), vec_math::sqrt(T(0.5) * (x_scaled + r_scaled)));
+  return ok | zero;
+}
+
+// Bounds of the main regions of std::asin / std::acos (Hull et al.) and
+// std::atanh in c10/util/complex_math.h, in which |re| and |im| can be
+// squared without overflow or underflow. These are the fast paths of the
+// bulk inverse functions; other lanes take the scalar exception handling.
+template<typename T>
+struct inverse_region;
+template<>
+struct inverse_region<float> {
+  static constexpr float asin_min = 4.336808689942018e-19f;  // 2^-61
+  static constexpr float asin_max = 1.152921504606847e+18f;  // 2^60
+  static constexpr float atanh_min = 2.168404344971009e-19f;  // 2^-62
+  static constexpr float atanh_max = 4.611686018427388e+18f;  // 2^62
+};
+template<>
+struct inverse_region<double> {
+  static constexpr double asin_min = 5.966672584960166e-154;  // 2^-509
+  static constexpr double asin_max = 8.379879956214123e+152;  // 2^508
+  static constexpr double atanh_min = 2.983336292480083e-154;  // 2^-510
+  static constexpr double atanh_max = 3.3519519824856493e+153;  // 2^510
+};
+
+// The main region of Hull et al. for x = |re| and y = |im|, both branches of
+// every crossover are computed and the right one is blended in. Returns the
+// real parts of asin and acos (which only differ by the order of the atan2
+// arguments) and the magnitude of the shared imaginary part.
+template<typename T>
+C10_VEC_INLINE bool asin_acos_lane(T x, T y, T& asin_re, T& acos_re, T& im) {
+  using region = inverse_region<T>;
+  bool ok = (x > region::asin_min) & (x < region::asin_max) & (y > region::asin_min) & (y < region::asin_max);
+  x = vec_math::select(ok, x, T(0.5));
+  y = vec_math::select(ok, y, T(0.5));
+  T xp1 = T(1) + x;
+  T xm1 = x - T(1);
+  T yy = y * y;
+  T r = vec_math::hypot_unsafe(xp1, y);
+  T s = vec_math::hypot_unsafe(xm1, y);
+  T a = T(0.5) * (r + s);
+  T b = x / a;
+  T apx = a + x;
+  bool x_le_1 = x <= T(1);
+  // real part: asin(b) = atan2(b, sqrt(1 - b^2)) if b <= 0.6417,
+  // otherwise atan2(x, d) with d computed without cancellation
+  bool small_b = b <= T(0.6417);
+  T sqrt_1mb2 = vec_math::sqrt((T(1) - b) * (T(1) + b));
+  T d_le = vec_math::sqrt(T(0.5) * apx * (yy / (r + xp1) + (s - xm1)));
+  T d_gt = y * vec_math::sqrt(T(0.5) * (apx / (r + xp1) + apx / (s + xm1)));
+  T d = vec_math::select(x_le_1, d_le, d_gt);
+  T num = vec_math::select(small_b, b, x);
+  T den = vec_math::select(small_b, sqrt_1mb2, d);
+  asin_re = vec_math::atan2(num, den);
+  acos_re = vec_math::atan2(den, num);
+  // imaginary part: log(a + sqrt(a^2 - 1)), via log1p(a - 1 + ...) if a <= 1.5
+  T am1 = T(0.5) * (yy / (r + xp1) + vec_math::select(x < T(1), yy / (s - xm1), s + xm1));
+  T im_small = vec_math::log1p(am1 + vec_math::sqrt(am1 * (a + T(1))));
+  T im_large = vec_math::log(a + vec_math::sqrt(a * a - T(1)));
+  im = vec_math::select(a <= T(1.5), im_small, im_large);
+  return ok;
+}
+
+// atanh(x + y i) = log1p(4x / ((1 - x)^2 + y^2)) / 4 + atan2(2y, (1 - x)(1 + x) - y^2) / 2 i
+template<typename T>
+C10_VEC_INLINE bool atanh_lane(T re, T im, T& out_re, T& out_im) {
+  using region = inverse_region<T>;
+  T x = vec_math::abs(re);
+  T y = vec_math::abs(im);
+  bool ok = (x > region::atanh_min) & (x < region::atanh_max) & (y > region::atanh_min) & (y < region::atanh_max);
+  x = vec_math::select(ok, x, T(0.5));
+  y = vec_math::select(ok, y, T(0.5));
+  T yy = y * y;
+  T mxm1 = T(1) - x;
+  T real = T(0.25) * vec_math::log1p(T(4) * x / (mxm1 * mxm1 + yy));
+  T imag = T(0.5) * vec_math::atan2(T(2) * y, mxm1 * (T(1) + x) - yy);
+  out_re = vec_math::copysign(real, re);
+  out_im = vec_math::copysign(imag, im);
+  return ok;
+}
+
+template<typename T>
+struct exp_kernel {
+  C10_VEC_INLINE bool operator()(T re, T im, T& out_re, T& out_im) const {
+    return exp_lane(re, im, out_re, out_im);
+  }
+  complex<T> scalar(const complex<T>& x) const {
+    return std::exp(x);
+  }
+};
+
+template<typename T>
+struct log_kernel {
+  C10_VEC_INLINE bool operator()(T re, T im, T& out_re, T& out_im) const {
+    return log_lane(re, im, out_re, out_im);
+  }
+  complex<T> scalar(const complex<T>& x) const {
+    return std::log(x);
+  }
+};
+
+template<typename T>
+struct pow_kernel {
+  C10_VEC_INLINE bool operator()(T xr, T xi, T yr, T yi, T& out_re, T& out_im) const {
+    return pow_lane(xr, xi, yr, yi, out_re, out_im);
+  }
+  complex<T> scalar(const complex<T>& x, const complex<T>& y) const {
+    return std::pow(x, y);
+  }
+};
+
+template<typename T>
+struct pow_scalar_kernel {
+  complex<T> y;
+  C10_VEC_INLINE bool operator()(T re, T im, T& out_re, T& out_im) const {
+    return pow_lane(re, im, y.real(), y.imag(), out_re, out_im);
+  }
+  complex<T> scalar(const complex<T>& x) const {
+    return std::pow(x, y);
+  }
+};
+
+template<typename T>
+struct pow_real_kernel {
+  T y;
+  C10_VEC_INLINE bool operator()(T re, T im, T& out_re, T& out_im) const {
+    return pow_lane(re, im, y, T(0), out_re, out_im);
+  }
+  complex<T> scalar(const complex<T>& x) const {
+    return std::pow(x, y);
+  }
+};
+
+
+// sin(z) = -i sinh(i z), computed as the hyperbolic products of (im, re)
+template<typename T>
+struct sin_kernel {
+  C10_VEC_INLINE bool operator()(T re, T im, T& out_re, T& out_im) const {
+    T ch_c, sh_s, sh_c, ch_s;
+    bool ok = sinhcosh_lane(im, re, ch_c, sh_s, sh_c, ch_s);
+    out_re = ch_s;
+    out_im = sh_c;
+    return ok;
+  }
+  complex<T> scalar(const complex<T>& x) const {
+    return std::sin(x);
+  }
+};
+
+// cos(z) = cosh(i z)
+template<typename T>
+struct cos_kernel {
+  C10_VEC_INLINE bool operator()(T re, T im, T& out_re, T& out_im) const {
+    T ch_c, sh_s, sh_c, ch_s;
+    bool ok = sinhcosh_lane(im, re, ch_c, sh_s, sh_c, ch_s);
+    out_re = ch_c;
+    out_im = -sh_s;
+    return ok;
+  }
+  complex<T> scalar(const complex<T>& x) const {
+    return std::cos(x);
+  }
+};
+
+// tan(z) = -i tanh(i z)
+template<typename T>
+struct tan_kernel {
+  C10_VEC_INLINE bool operator()(T re, T im, T& out_re, T& out_im) const {
+    T tr, ti;
+    bool ok = tanh_lane(-im, re, tr, ti);
+    out_re = ti;
+    out_im = -tr;
+    return ok;
+  }
+  complex<T> scalar(const complex<T>& x) const {
+    return std::tan(x);
+  }
+};
+
+template<typename T>
+struct sinh_kernel {
+  C10_VEC_INLINE bool operator()(T re, T im, T& out_re, T& out_im) const {
+    T ch_c, sh_s, sh_c, ch_s;
+    bool ok = sinhcosh_lane(re, im, ch_c, sh_s, sh_c, ch_s);
+    out_re = sh_c;
+    out_im = ch_s;
+    return ok;
+  }
+  complex<T> scalar(const complex<T>& x) const {
+    return std::sinh(x);
+  }
+};
+
+template<typename T>
+struct cosh_kernel {
+  C10_VEC_INLINE bool operator()(T re, T im, T& out_re, T& out_im) const {
+    T ch_c, sh_s, sh_c, ch_s;
+    bool ok = sinhcosh_lane(re, im, ch_c, sh_s, sh_c, ch_s);
+    out_re = ch_c;
+    out_im = sh_s;
+    return ok;
+  }
+  complex<T> scalar(const complex<T>& x) const {
+    return std::cosh(x);
+  }
+};
+
+template<typename T>
+struct tanh_kernel {
+  C10_VEC_INLINE bool operator()(T re, T im, T& out_re, T& out_im) const {
+    return tanh_lane(re, im, out_re, out_im);
+  }
+  complex<T> scalar(const complex<T>& x) const {
+    return std::tanh(x);
+  }
+};
+
+// The small part y / (2t) is divided by the unscaled t, so that it is not
+// lost to underflow in the scaled domain when k is large
+template<typename T>
+struct sqrt_kernel {
+  C10_VEC_INLINE bool operator()(T re, T im, T& out_re, T& out_im) const {
+    T t_scaled, y_scaled, r_scaled, pow2_k, pow2_minus_k;
+    bool ok = sqrt_lane(re, im, t_scaled, y_scaled, r_scaled, pow2_k, pow2_minus_k);
+    T t = t_scaled * pow2_k;
+    T other = vec_math::select(t == T(0), T(0), vec_math::abs(im) / (T(2) * t));
+    bool negative = vec_math::signbit(re);
+    out_re = vec_math::select(negative, other, t);
+    out_im = vec_math::copysign(vec_math::select(negative, t, other), im);
+    return ok;
+  }
+  complex<T> scalar(const complex<T>& x) const {
+    return std::sqrt(x);
+  }
+};
+
+// 1 / sqrt(z) = conj(sqrt(z)) / |z|, which in the scaled domain of
+// sqrt_lane is 2^-k * conj(sqrt(z_scaled)) / r_scaled. Zero lanes go to
+// the scalar path to get the special values of complex division.
+template<typename T>
+struct rsqrt_kernel {
+  C10_VEC_INLINE bool operator()(T re, T im, T& out_re, T& out_im) const {
+    T t_scaled, y_scaled, r_scaled, pow2_k, pow2_minus_k;
+    bool ok = sqrt_lane(re, im, t_scaled, y_scaled, r_scaled, pow2_k, pow2_minus_k) & (t_scaled > T(0));
+    t_scaled = vec_math::select(ok, t_scaled, T(1));
+    T other = y_scaled / (T(2) * t_scaled);
+    T scale = pow2_minus_k / r_scaled;
+    bool negative = vec_math::signbit(re);
+    out_re = vec_math::select(negative, other, t_scaled) * scale;
+    out_im = -vec_math::copysign(vec_math::select(negative, t_scaled, other) * scale, im);
+    return ok;
+  }
+  complex<T> scalar(const complex<T>& x) const {
+    // division of std::complex follows the special values of C99 Annex G
+    return static_cast<complex<T>>(T(1) / static_cast<std::complex<T>>(std::sqrt(x)));
+  }
+};
+
+template<typename T>
+struct asin_kernel {
+  C10_VEC_INLINE bool operator()(T re, T im, T& out_re, T& out_im) const {
+    T asin_re, acos_re, imag;
+    bool ok = asin_acos_lane(vec_math::abs(re), vec_math::abs(im), asin_re, acos_re, imag);
+    out_re = vec_math::copysign(asin_re, re);
+    out_im = vec_math::copysign(imag, im);
+    return ok;
+  }
+  complex<T> scalar(const complex<T>& x) const {
+    return std::asin(x);
+  }
+};
+
+template<typename T>
+struct acos_kernel {
+  C10_VEC_INLINE bool operator()(T re, T im, T& out_re, T& out_im) const {
+    T asin_re, acos_re, imag;
+    bool ok = asin_acos_lane(vec_math::abs(re), vec_math::abs(im), asin_re, acos_re, imag);
+    out_re = vec_math::select(vec_math::signbit(re), T(3.14159265358979323846) - acos_re, acos_re);
+    out_im = vec_math::select(vec_math::signbit(im), imag, -imag);
+    return ok;
+  }
+  complex<T> scalar(const complex<T>& x) const {
+    return std::acos(x);
+  }
+};
+
+template<typename T>
+struct atan_kernel {
+  C10_VEC_INLINE bool operator()(T re, T im, T& out_re, T& out_im) const {
+    // atan(z) = -i atanh(i z)
+    T tr, ti;
+    bool ok = atanh_lane(-im, re, tr, ti);
+    out_re = ti;
+    out_im = -tr;
+    return ok;
+  }
+  complex<T> scalar(const complex<T>& x) const {
+    return std::atan(x);
+  }
+};
+
+template<typename T>
+struct asinh_kernel {
+  C10_VEC_INLINE bool operator()(T re, T im, T& out_re, T& out_im) const {
+    // asinh(z) = -i asin(i z), and i z = -im + re i
+    T asin_re, acos_re, imag;
+    bool ok = asin_acos_lane(vec_math::abs(im), vec_math::abs(re), asin_re, acos_re, imag);
+    out_re = vec_math::copysign(imag, re);
+    out_im = vec_math::copysign(asin_re, im);
+    return ok;
+  }
+  complex<T> scalar(const complex<T>& x) const {
+    return std::asinh(x);
+  }
+};
+
+template<typename T>
+struct acosh_kernel {
+  C10_VEC_INLINE bool operator()(T re, T im, T& out_re, T& out_im) const {
+    // acosh(z) = |imag(acos(z))| + real(acos(z)) i, with the sign of im
+    T asin_re, acos_re, imag;
+    bool ok = asin_acos_lane(vec_math::abs(re), vec_math::abs(im), asin_re, acos_re, imag);
+    out_re = imag;
+    out_im = vec_math::copysign(vec_math::select(vec_math::signbit(re), T(3.14159265358979323846) - acos_re, acos_re), im);
+    return ok;
+  }
+  complex<T> scalar(const complex<T>& x) const {
+    return std::acosh(x);
+  }
+};
+
+template<typename T>
+struct atanh_kernel {
+  C10_VEC_INLINE bool operator()(T re, T im, T& out_re, T& out_im) const {
+    return atanh_lane(re, im, out_re, out_im);
+  }
+  complex<T> scalar(const complex<T>& x) const {
+    return std::atanh(x);
+  }
+};
+
+// sum(x[i] * y[i]) if Conj is false, sum(conj(x[i]) * y[i]) if it is true.
+// The arrays are read as arrays of real numbers p, q of length 2n, and
+//
+//   straight[j] = sum(p[j] * q[j]),  swapped[j] = sum(p[j] * q[j ^ 1])
+//
+// are accumulated for j in [0, 2W), so the loop needs no shuffles other than
+// swapping neighbors. The even and odd entries give the products of the real
+// and imaginary parts.
+template<bool Conj, typename T>
+complex<T> dot(const complex<T>* x, const complex<T>* y, int64_t n) {
+  check_bulk_type<T>();
+  constexpr int W = vec_math::lanes<T>::value;
+  const T* p = reinterpret_cast<const T*>(x);
+  const T* q = reinterpret_cast<const T*>(y);
+  T straight[2 * W] = {}, swapped[2 * W] = {};
+  for (int64_t i = 0; i < n; i += W) {
+    const int count = n - i < W ? static_cast<int>(n - i) : W;
+    if (count == W) {
+      C10_VEC_LOOP
+      for (int j = 0; j < 2 * W; j++) {
+        straight[j] = vec_math::fma(p[2 * i + j], q[2 * i + j], straight[j]);
+        swapped[j] = vec_math::fma(p[2 * i + j], q[2 * i + (j ^ 1)], swapped[j]);
+      }
+    } else {
+      for (int j = 0; j < 2 * count; j++) {
+        straight[j] = vec_math::fma(p[2 * i + j], q[2 * i + j], straight[j]);
+        swapped[j] = vec_math::fma(p[2 * i + j], q[2 * i + (j ^ 1)], swapped[j]);
+      }
+    }
+  }
+  // straight: re(x) re(y), im(x) im(y); swapped: re(x) im(y), im(x) re(y)
+  T rr = 0, ii = 0, ri = 0, ir = 0;
+  for (int l = 0; l < W; l++) {
+    rr += straight[2 * l];
+    ii += straight[2 * l + 1];
+    ri += swapped[2 * l];
+    ir += swapped[2 * l + 1];
+  }
+  return Conj ? complex<T>(rr + ii, ri - ir) : complex<T>(rr - ii, ri + ir);
+}
+
+} // namespace detail
+
+// [Bulk multiply-add]
+//
+// Multiply-accumulate kernels round like c10::fma when the target has FMA
+// instructions, and like a * b + c otherwise, see vec_math::fma. Reductions
+// (dot, vdot) accumulate each of the four real products in
+// vec_math::lanes<T>::value independent partial sums, so the order of the
+// additions differs from a sequential loop.
+
+// y[i] = alpha * x[i] + y[i]
+template<typename T>
+void axpy(const complex<T>& alpha, const complex<T>* x, complex<T>* y, int64_t n) {
+  detail::check_bulk_type<T>();
+  const T ar = alpha.real(), ai = alpha.imag();
+  C10_VEC_LOOP
+  for (int64_t i = 0; i < n; i++) {
+    const T xr = x[i].real(), xi = x[i].imag();
+    y[i] = complex<T>(
+      vec_math::fma(ar, xr, vec_math::fma(-ai, xi, y[i].real())),
+      vec_math::fma(ar, xi, vec_math::fma(ai, xr, y[i].imag())));
+  }
+}
+
+// sum(x[i] * y[i]) for i in [0, n)
+template<typename T>
+complex<T> dot(const complex<T>* x, const complex<T>* y, int64_t n) {
+  return detail::dot<false>(x, y, n);
+}
+
+// sum(conj(x[i]) * y[i]) for i in [0, n)
+template<typename T>
+complex<T> vdot(const complex<T>* x, const complex<T>* y, int64_t n) {
+  return detail::dot<true>(x, y, n);
+}
+
+// out[i] = std::exp(x[i])
+template<typename T>
+void exp(const complex<T>* x, complex<T>* out, int64_t n) {
+  detail::unary_map(x, out, n, detail::exp_kernel<T>());
+}
+
+// out[i] = std::log(x[i])
+template<typename T>
+void log(const complex<T>* x, complex<T>* out, int64_t n) {
+  detail::unary_map(x, out, n, detail::log_kernel<T>());
+}
+
+// out[i] = std::pow(x[i], y[i])
+template<typename T>
+void pow(const complex<T>* x, const complex<T>* y, complex<T>* out, int64_t n) {
+  detail::binary_map(x, y, out, n, detail::pow_kernel<T>());
+}
+
+// out[i] = std::pow(x[i], y)
+template<typename T>
+void pow(const complex<T>* x, const complex<T>& y, complex<T>* out, int64_t n) {
+  detail::unary_map(x, out, n, detail::pow_scalar_kernel<T>{y});
+}
+
+// out[i] = std::pow(x[i], y)
+template<typename T>
+void pow(const complex<T>* x, const T& y, complex<T>* out, int64_t n) {
+  detail::unary_map(x, out, n, detail::pow_real_kernel<T>{y});
+}
+
+// out[i] = std::sqrt(x[i])
+template<typename T>
+void sqrt(const complex<T>* x, complex<T>* out, int64_t n) {
+  detail::unary_map(x, out, n, detail::sqrt_kernel<T>());
+}
+
+// out[i] = 1 / std::sqrt(x[i])
+template<typename T>
+void rsqrt(const complex<T>* x, complex<T>* out, int64_t n) {
+  detail::unary_map(x, out, n, detail::rsqrt_kernel<T>());
+}
+
+// out[i] = std::sin(x[i])
+template<typename T>
+void sin(const complex<T>* x, complex<T>* out, int64_t n) {
+  detail::unary_map(x, out, n, detail::sin_kernel<T>());
+}
+
+// out[i] = std::cos(x[i])
+template<typename T>
+void cos(const complex<T>* x, complex<T>* out, int64_t n) {
+  detail::unary_map(x, out, n, detail::cos_kernel<T>());
+}
+
+// out[i] = std::tan(x[i])
+template<typename T>
+void tan(const complex<T>* x, complex<T>* out, int64_t n) {
+  detail::unary_map(x, out, n, detail::tan_kernel<T>());
+}
+
+// out[i] = std::sinh(x[i])
+template<typename T>
+void sinh(const complex<T>* x, complex<T>* out, int64_t n) {
+  detail::unary_map(x, out, n, detail::sinh_kernel<T>());
+}
+
+// out[i] = std::cosh(x[i])
+template<typename T>
+void cosh(const complex<T>* x, complex<T>* out, int64_t n) {
+  detail::unary_map(x, out, n, detail::cosh_kernel<T>());
+}
+
+// out[i] = std::tanh(x[i])
+template<typename T>
+void tanh(const complex<T>* x, complex<T>* out, int64_t n) {
+  detail::unary_map(x, out, n, detail::tanh_kernel<T>());
+}
+
+// out[i] = std::asin(x[i])
+template<typename T>
+void asin(const complex<T>* x, complex<T>* out, int64_t n) {
+  detail::unary_map(x, out, n, detail::asin_kernel<T>());
+}
+
+// out[i] = std::acos(x[i])
+template<typename T>
+void acos(const complex<T>* x, complex<T>* out, int64_t n) {
+  detail::unary_map(x, out, n, detail::acos_kernel<T>());
+}
+
+// out[i] = std::atan(x[i])
+template<typename T>
+void atan(const complex<T>* x, complex<T>* out, int64_t n) {
+  detail::unary_map(x, out, n, detail::atan_kernel<T>());
+}
+
+// out[i] = std::asinh(x[i])
+template<typename T>
+void asinh(const complex<T>* x, complex<T>* out, int64_t n) {
+  detail::unary_map(x, out, n, detail::asinh_kernel<T>());
+}
+
+// out[i] = std::acosh(x[i])
+template<typename T>
+void acosh(const complex<T>* x, complex<T>* out, int64_t n) {
+  detail::unary_map(x, out, n, detail::acosh_kernel<T>());
+}
+
+// out[i] = std::atanh(x[i])
+template<typename T>
+void atanh(const complex<T>* x, complex<T>* out, int64_t n) {
+  detail::unary_map(x, out, n, detail::atanh_kernel<T>());
+}
+
+} // namespace bulk
+} // namespace c10
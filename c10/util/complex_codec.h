@@ -0,0 +1,925 @@
+#pragma once
+
+#include <c10/util/complex.h>
+#include <c10/util/complex_file.h>
+#include <c10/util/complex_parallel.h>
+#include <c10/util/complex_span.h>
+#include <c10/util/complex_vec_math.h>
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <stdexcept>
+#include <string>
+#include <utility>
+#include <vector>
+
+// Lossless compression of arrays of c10::complex
+//
+// [Compressed complex files]
+//
+// Time series of complex numbers compress badly with general purpose
+// codecs, which see bytes where the data has floating point numbers whose
+// sign, exponent and leading mantissa bits change slowly. The codec below
+// compresses the bits of the numbers exactly, NaN payloads included, in
+// blocks of block_size numbers:
+//
+// - the real and imaginary parts of a block are compressed separately
+// - each part is predicted from the previous one, by XOR of the bits like
+//   Gorilla, by the zigzag encoded difference of the bits, or not at all,
+//   whichever leaves the fewest nonzero bytes in the first numbers of the
+//   block
+// - the residuals are split into byte planes, the most significant bytes
+//   of all numbers, the next ones, ..., which are mostly zero for slowly
+//   changing data
+// - each plane is stored as one repeated byte, raw, or entropy coded by an
+//   order 0 rANS coder with two interleaved states
+//
+// Blocks are independent, so complex_codec_writer compresses and
+// complex_codec_reader decompresses a batch of blocks on all threads with
+// c10::parallel_for:
+//
+//   c10::complex_codec_writer<T> w(path, row_shape);  w.append(data, n);
+//   c10::complex_codec_reader<T> r(path);             r.read(out, n);
+//   c10::load_compressed_complex_file<T>(path, &shape);
+//   c10::compress_complex_file(src, dst);              // complex file -> compressed
+//   c10::decompress_complex_file(src, dst);            // compressed -> complex file
+//
+// The file follows the complex file format of c10/util/complex_file.h, with
+// a different magic, "\x93C10CZIP", and the block size in the reserved
+// field; all of its integers are little endian:
+//
+//   offset  size
+//   0       8       magic "\x93C10CZIP"
+//   8       1       version, 1
+//   9       1       dtype, see complex_dtype
+//   10      1       '<'
+//   11      1       ndim, the number of dimensions
+//   12      4       block_size, uint32
+//   16      8*ndim  shape, int64, the first dimension is the slowest
+//
+// followed by the blocks, each with a header of two uint32, its number of
+// elements (at most block_size) and the bytes of the compressed data that
+// follows it. Every block but the last of a flush() has block_size
+// elements. The data of a block is, for the real and then the imaginary
+// parts, one byte for the predictor (0 none, 1 XOR, 2 difference) and the
+// byte planes, from the least significant one, each a byte for its mode:
+//
+//   0  repeated byte     the byte
+//   1  raw               count bytes
+//   2  rANS              a bitmap of the 256 bytes that occur, their
+//                        frequencies as uint16 adding up to 2^12 in the
+//                        order of the bytes, and a uint32 count of the
+//                        coded bytes that follow
+//
+// The writer updates the first dimension of the shape on flush() and
+// close() like complex_file_writer. Values are compressed as integers, so
+// files are portable between byte orders. Malformed files and I/O errors
+// throw std::runtime_error.
+
+namespace c10 {
+
+constexpr int64_t codec_default_block_size = int64_t(1) << 16;
+constexpr int64_t codec_max_block_size = int64_t(1) << 24;
+
+namespace detail {
+
+constexpr char codec_file_magic[8] = {'\x93', 'C', '1', '0', 'C', 'Z', 'I', 'P'};
+constexpr uint8_t codec_file_version = 1;
+constexpr size_t codec_block_header_size = 8;
+
+// Unsigned integers with the bits of a part
+template<size_t Size>
+struct codec_uint;
+template<>
+struct codec_uint<2> {
+  using type = uint16_t;
+};
+template<>
+struct codec_uint<4> {
+  using type = uint32_t;
+};
+template<>
+struct codec_uint<8> {
+  using type = uint64_t;
+};
+
+inline void store_le(unsigned char* p, uint64_t v, int bytes) {
+  for (int i = 0; i < bytes; i++) {
+    p[i] = static_cast<unsigned char>(v >> (8 * i));
+  }
+}
+
+inline uint64_t load_le(const unsigned char* p, int bytes) {
+  uint64_t v = 0;
+  for (int i = 0; i < bytes; i++) {
+    v |= uint64_t(p[i]) << (8 * i);
+  }
+  return v;
+}
+
+inline void append_le(std::vector<unsigned char>& out, uint64_t v, int bytes) {
+  const size_t size = out.size();
+  out.resize(size + bytes);
+  store_le(&out[size], v, bytes);
+}
+
+[[noreturn]] inline void codec_corrupt() {
+  throw std::runtime_error("corrupt compressed block");
+}
+
+// Reads the data of a block, throwing at its end
+struct codec_cursor {
+  const unsigned char* p;
+  const unsigned char* end;
+
+  const unsigned char* take(size_t bytes) {
+    if (static_cast<size_t>(end - p) < bytes) {
+      codec_corrupt();
+    }
+    const unsigned char* result = p;
+    p += bytes;
+    return result;
+  }
+  uint64_t take_le(int bytes) {
+    return load_le(take(bytes), bytes);
+  }
+};
+
+// rANS with probabilities of 12 bits and byte-wise renormalization, after
+// rans_byte.h by Fabian Giesen. The encoder divides by multiplying with a
+// reciprocal.
+constexpr int rans_scale_bits = 12;
+constexpr uint32_t rans_scale = uint32_t(1) << rans_scale_bits;
+constexpr uint32_t rans_lower_bound = uint32_t(1) << 23;
+
+struct rans_encoder_symbol {
+  uint32_t x_max;
+  uint32_t rcp_freq;
+  uint32_t bias;
+  uint32_t cmpl_freq;
+  uint32_t rcp_shift;
+};
+
+inline rans_encoder_symbol make_rans_encoder_symbol(uint32_t start, uint32_t freq) {
+  rans_encoder_symbol s;
+  s.x_max = ((rans_lower_bound >> rans_scale_bits) << 8) * freq;
+  s.cmpl_freq = rans_scale - freq;
+  if (freq < 2) {
+    // x / 1 = x: a reciprocal of 2^32 - 1 and a bias that makes up for it
+    s.rcp_freq = ~uint32_t(0);
+    s.rcp_shift = 0;
+    s.bias = start + rans_scale - 1;
+  } else {
+    uint32_t shift = 0;
+    while (freq > (uint32_t(1) << shift)) {
+      shift++;
+    }
+    s.rcp_freq = static_cast<uint32_t>(((uint64_t(1) << (shift + 31)) + freq - 1) / freq);
+    s.rcp_shift = shift - 1;
+    s.bias = start;
+  }
+  s.rcp_shift += 32;
+  return s;
+}
+
+// Writes the bytes that renormalize x backwards from p
+inline void rans_put(uint32_t& x, unsigned char*& p, const rans_encoder_symbol& s) {
+  while (x >= s.x_max) {
+    *--p = static_cast<unsigned char>(x);
+    x >>= 8;
+  }
+  const uint32_t q = static_cast<uint32_t>((uint64_t(x) * s.rcp_freq) >> s.rcp_shift);
+  x += s.bias + q * s.cmpl_freq;
+}
+
+// Frequencies that add up to rans_scale, at least 1 for every byte that
+// occurs
+inline void rans_normalize(const uint32_t* counts, int64_t total, uint32_t* freq) {
+  uint32_t sum = 0;
+  int largest = 0;
+  for (int s = 0; s < 256; s++) {
+    freq[s] = counts[s] == 0 ? 0 : std::max<uint32_t>(1, static_cast<uint32_t>(uint64_t(counts[s]) * rans_scale / total));
+    sum += freq[s];
+    if (freq[s] > freq[largest]) {
+      largest = s;
+    }
+  }
+  if (sum <= rans_scale) {
+    freq[largest] += rans_scale - sum;
+    return;
+  }
+  // rare bytes rounded up to 1 took too much; take it from the largest,
+  // which have more than 2^12 / 256 each
+  while (sum > rans_scale) {
+    largest = static_cast<int>(std::max_element(freq, freq + 256) - freq);
+    const uint32_t d = std::min(sum - rans_scale, freq[largest] / 2);
+    freq[largest] -= d;
+    sum -= d;
+  }
+}
+
+template<typename U>
+struct codec_scratch {
+  std::vector<U> values;     // the parts of a block, interleaved
+  std::vector<U> residuals;  // of one part
+  std::vector<unsigned char> planes;
+  std::vector<unsigned char> coded;
+};
+
+// Appends the plane p of n bytes, see [Compressed complex files]
+inline void encode_plane(const unsigned char* p, int64_t n, std::vector<unsigned char>& coded, std::vector<unsigned char>& out) {
+  // in four tables, so that runs of one byte do not wait for each other
+  uint32_t partial[4][256] = {};
+  int64_t i = 0;
+  for (; i + 4 <= n; i += 4) {
+    partial[0][p[i]]++;
+    partial[1][p[i + 1]]++;
+    partial[2][p[i + 2]]++;
+    partial[3][p[i + 3]]++;
+  }
+  for (; i < n; i++) {
+    partial[0][p[i]]++;
+  }
+  uint32_t counts[256];
+  for (int s = 0; s < 256; s++) {
+    counts[s] = partial[0][s] + partial[1][s] + partial[2][s] + partial[3][s];
+  }
+  int used = 0;
+  double bits = 0;
+  for (int s = 0; s < 256; s++) {
+    if (counts[s] != 0) {
+      used++;
+      bits += counts[s] * std::log2(static_cast<double>(n) / counts[s]);
+    }
+  }
+  if (used == 1) {
+    out.push_back(0);
+    out.push_back(p[0]);
+    return;
+  }
+  // a rANS plane is about the entropy plus its table; the coder is not worth
+  // it for planes of nearly random bytes, like the low bytes of noise
+  const double estimate = bits / 8 + 32 + 2 * used + 12;
+  if (estimate < 0.95 * n) {
+    uint32_t freq[256];
+    rans_normalize(counts, n, freq);
+    rans_encoder_symbol symbols[256];
+    uint32_t start = 0;
+    for (int s = 0; s < 256; s++) {
+      if (freq[s] != 0) {
+        symbols[s] = make_rans_encoder_symbol(start, freq[s]);
+      }
+      start += freq[s];
+    }
+    // a byte takes at most rans_scale_bits bits, plus the final states
+    coded.resize(2 * n + 8);
+    unsigned char* const end = coded.data() + coded.size();
+    unsigned char* q = end;
+    uint32_t x0 = rans_lower_bound, x1 = rans_lower_bound;
+    // backwards, so that the decoder reads forwards; even bytes use x0
+    i = n;
+    if (i % 2 == 1) {
+      rans_put(x0, q, symbols[p[--i]]);
+    }
+    while (i > 0) {
+      rans_put(x1, q, symbols[p[i - 1]]);
+      rans_put(x0, q, symbols[p[i - 2]]);
+      i -= 2;
+    }
+    q -= 4;
+    store_le(q, x1, 4);
+    q -= 4;
+    store_le(q, x0, 4);
+    const int64_t size = end - q;
+    if (size + 32 + 2 * used + 4 < n) {
+      out.push_back(2);
+      unsigned char bitmap[32] = {};
+      for (int s = 0; s < 256; s++) {
+        if (freq[s] != 0) {
+          bitmap[s / 8] |= static_cast<unsigned char>(1 << (s % 8));
+        }
+      }
+      out.insert(out.end(), bitmap, bitmap + 32);
+      for (int s = 0; s < 256; s++) {
+        if (freq[s] != 0) {
+          append_le(out, freq[s], 2);
+        }
+      }
+      append_le(out, size, 4);
+      out.insert(out.end(), q, end);
+      return;
+    }
+  }
+  out.push_back(1);
+  out.insert(out.end(), p, p + n);
+}
+
+inline void decode_plane(codec_cursor& in, int64_t n, unsigned char* p) {
+  const unsigned char mode = *in.take(1);
+  if (mode == 0) {
+    std::memset(p, *in.take(1), n);
+    return;
+  }
+  if (mode == 1) {
+    std::memcpy(p, in.take(n), n);
+    return;
+  }
+  if (mode != 2) {
+    codec_corrupt();
+  }
+  const unsigned char* bitmap = in.take(32);
+  uint32_t freq[256], start[256];
+  uint32_t sum = 0;
+  unsigned char symbol_of[rans_scale];
+  for (int s = 0; s < 256; s++) {
+    freq[s] = (bitmap[s / 8] >> (s % 8)) & 1 ? static_cast<uint32_t>(in.take_le(2)) : 0;
+    start[s] = sum;
+    if (sum + freq[s] > rans_scale) {
+      codec_corrupt();
+    }
+    std::memset(symbol_of + sum, s, freq[s]);
+    sum += freq[s];
+  }
+  if (sum != rans_scale) {
+    codec_corrupt();
+  }
+  const uint64_t size = in.take_le(4);
+  if (size < 8) {
+    codec_corrupt();
+  }
+  const unsigned char* coded = in.take(size);
+  codec_cursor data{coded, coded + size};
+  uint32_t x0 = static_cast<uint32_t>(data.take_le(4));
+  uint32_t x1 = static_cast<uint32_t>(data.take_le(4));
+  const uint32_t mask = rans_scale - 1;
+  auto get = [&](uint32_t& x) {
+    const unsigned char s = symbol_of[x & mask];
+    x = freq[s] * (x >> rans_scale_bits) + (x & mask) - start[s];
+    while (x < rans_lower_bound) {
+      if (data.p == data.end) {
+        codec_corrupt();
+      }
+      x = (x << 8) | *data.p++;
+    }
+    return s;
+  };
+  int64_t i = 0;
+  for (; i + 1 < n; i += 2) {
+    p[i] = get(x0);
+    p[i + 1] = get(x1);
+  }
+  if (i < n) {
+    p[i] = get(x0);
+  }
+}
+
+// Number of nonzero bytes of the residuals of v[0, n) for each predictor,
+// with v[-1] = 0
+template<typename U>
+C10_VEC_INLINE uint32_t codec_nonzero_bytes(U r) {
+  uint32_t count = 0;
+  for (size_t j = 0; j < sizeof(U); j++) {
+    count += static_cast<uint32_t>(((r >> (8 * j)) & 0xff) != 0);
+  }
+  return count;
+}
+
+template<typename U>
+void codec_predictor_costs(const U* v, int64_t n, int64_t* costs) {
+  using S = typename std::make_signed<U>::type;
+  constexpr int width = 8 * sizeof(U);
+  const U z = static_cast<U>((v[0] << 1) ^ static_cast<U>(static_cast<S>(v[0]) >> (width - 1)));
+  uint32_t c0 = codec_nonzero_bytes(v[0]), c1 = c0, c2 = codec_nonzero_bytes(z);
+  C10_VEC_LOOP
+  for (int64_t i = 1; i < n; i++) {
+    const U d = static_cast<U>(v[2 * i] - v[2 * i - 2]);
+    c0 += codec_nonzero_bytes(v[2 * i]);
+    c1 += codec_nonzero_bytes(static_cast<U>(v[2 * i] ^ v[2 * i - 2]));
+    c2 += codec_nonzero_bytes(static_cast<U>((d << 1) ^ static_cast<U>(static_cast<S>(d) >> (width - 1))));
+  }
+  costs[0] = c0;
+  costs[1] = c1;
+  costs[2] = c2;
+}
+
+// Numbers whose residuals choose the predictor of a part
+constexpr int64_t codec_predictor_sample = 512;
+
+// Appends the header and data of the block x[0, n)
+template<typename T>
+void encode_codec_block(const complex<T>* x, int64_t n, codec_scratch<typename codec_uint<sizeof(T)>::type>& scratch, std::vector<unsigned char>& out) {
+  using U = typename codec_uint<sizeof(T)>::type;
+  using S = typename std::make_signed<U>::type;
+  constexpr int width = 8 * sizeof(U);
+  scratch.values.resize(2 * n);
+  scratch.residuals.resize(n);
+  scratch.planes.resize(sizeof(U) * n);
+  std::memcpy(scratch.values.data(), x, n * sizeof(complex<T>));
+  out.resize(codec_block_header_size);
+  store_le(out.data(), n, 4);
+  for (int part = 0; part < 2; part++) {
+    const U* v = scratch.values.data() + part;
+    U* r = scratch.residuals.data();
+    int64_t costs[3];
+    codec_predictor_costs(v, std::min(n, codec_predictor_sample), costs);
+    const int predictor = static_cast<int>(std::min_element(costs, costs + 3) - costs);
+    out.push_back(static_cast<unsigned char>(predictor));
+    r[0] = v[0];
+    if (predictor == 0) {
+      C10_VEC_LOOP
+      for (int64_t i = 1; i < n; i++) {
+        r[i] = v[2 * i];
+      }
+    } else if (predictor == 1) {
+      C10_VEC_LOOP
+      for (int64_t i = 1; i < n; i++) {
+        r[i] = v[2 * i] ^ v[2 * i - 2];
+      }
+    } else {
+      r[0] = static_cast<U>((v[0] << 1) ^ static_cast<U>(static_cast<S>(v[0]) >> (width - 1)));
+      C10_VEC_LOOP
+      for (int64_t i = 1; i < n; i++) {
+        const U d = static_cast<U>(v[2 * i] - v[2 * i - 2]);
+        r[i] = static_cast<U>((d << 1) ^ static_cast<U>(static_cast<S>(d) >> (width - 1)));
+      }
+    }
+    unsigned char* planes = scratch.planes.data();
+    C10_VEC_LOOP
+    for (int64_t i = 0; i < n; i++) {
+      for (size_t j = 0; j < sizeof(U); j++) {
+        planes[j * n + i] = static_cast<unsigned char>(r[i] >> (8 * j));
+      }
+    }
+    for (size_t j = 0; j < sizeof(U); j++) {
+      encode_plane(planes + j * n, n, scratch.coded, out);
+    }
+  }
+  store_le(out.data() + 4, out.size() - codec_block_header_size, 4);
+}
+
+// Decodes the data of a block of n numbers, without its header, to out
+template<typename T>
+void decode_codec_block(const unsigned char* data, size_t bytes, int64_t n, complex<T>* out, codec_scratch<typename codec_uint<sizeof(T)>::type>& scratch) {
+  using U = typename codec_uint<sizeof(T)>::type;
+  scratch.values.resize(2 * n);
+  scratch.residuals.resize(n);
+  scratch.planes.resize(sizeof(U) * n);
+  codec_cursor in{data, data + bytes};
+  for (int part = 0; part < 2; part++) {
+    U* v = scratch.values.data() + part;
+    U* r = scratch.residuals.data();
+    const unsigned char predictor = *in.take(1);
+    if (predictor > 2) {
+      codec_corrupt();
+    }
+    for (size_t j = 0; j < sizeof(U); j++) {
+      decode_plane(in, n, scratch.planes.data() + j * n);
+    }
+    const unsigned char* planes = scratch.planes.data();
+    C10_VEC_LOOP
+    for (int64_t i = 0; i < n; i++) {
+      U x = 0;
+      for (size_t j = 0; j < sizeof(U); j++) {
+        x |= static_cast<U>(U(planes[j * n + i]) << (8 * j));
+      }
+      r[i] = x;
+    }
+    if (predictor == 0) {
+      for (int64_t i = 0; i < n; i++) {
+        v[2 * i] = r[i];
+      }
+    } else if (predictor == 1) {
+      U prev = 0;
+      for (int64_t i = 0; i < n; i++) {
+        prev ^= r[i];
+        v[2 * i] = prev;
+      }
+    } else {
+      U prev = 0;
+      for (int64_t i = 0; i < n; i++) {
+        prev = static_cast<U>(prev + static_cast<U>((r[i] >> 1) ^ static_cast<U>(U(0) - (r[i] & 1))));
+        v[2 * i] = prev;
+      }
+    }
+  }
+  if (in.p != in.end) {
+    codec_corrupt();
+  }
+  std::memcpy(static_cast<void*>(out), scratch.values.data(), n * sizeof(complex<T>));
+}
+
+// Largest data of a block of n numbers of size bytes each
+inline uint64_t codec_max_block_bytes(int64_t n, size_t size) {
+  return 2 * (1 + size * (2 + 32 + 512 + 4 + uint64_t(n)));
+}
+
+// Blocks compressed or decompressed at once by a writer or reader
+inline int64_t codec_batch_blocks() {
+  return 2 * int64_t(get_num_threads());
+}
+
+inline std::string encode_codec_file_header(complex_dtype dtype, const std::vector<int64_t>& shape, int64_t block_size) {
+  std::string header(complex_file_fixed_header_size + 8 * shape.size(), '\0');
+  unsigned char* p = reinterpret_cast<unsigned char*>(&header[0]);
+  std::memcpy(p, codec_file_magic, sizeof(codec_file_magic));
+  p[8] = codec_file_version;
+  p[9] = static_cast<unsigned char>(dtype);
+  p[10] = '<';
+  p[11] = static_cast<unsigned char>(shape.size());
+  store_le(p + 12, block_size, 4);
+  for (size_t i = 0; i < shape.size(); i++) {
+    store_le(p + complex_file_fixed_header_size + 8 * i, shape[i], 8);
+  }
+  return header;
+}
+
+// Reads and checks the header of an open file, which is left at the first
+// block, and its block size
+inline complex_file_header read_codec_file_header(std::FILE* f, int64_t& block_size, const char* function, const std::string& path) {
+  unsigned char fixed[complex_file_fixed_header_size];
+  if (std::fread(fixed, 1, sizeof(fixed), f) != sizeof(fixed) ||
+      std::memcmp(fixed, codec_file_magic, sizeof(codec_file_magic)) != 0) {
+    complex_file_error(function, path, "not a compressed complex file");
+  }
+  if (fixed[8] != codec_file_version) {
+    complex_file_error(function, path, "unsupported version " + std::to_string(fixed[8]));
+  }
+  complex_file_header header;
+  header.dtype = static_cast<complex_dtype>(fixed[9]);
+  if (complex_dtype_size(header.dtype) == 0) {
+    complex_file_error(function, path, "unknown dtype " + std::to_string(fixed[9]));
+  }
+  if (fixed[10] != '<') {
+    complex_file_error(function, path, "invalid byte order");
+  }
+  header.little_endian = true;
+  block_size = static_cast<int64_t>(load_le(fixed + 12, 4));
+  if (block_size <= 0 || block_size > codec_max_block_size) {
+    complex_file_error(function, path, "invalid block size");
+  }
+  std::vector<unsigned char> shape(8 * fixed[11]);
+  if (!shape.empty() && std::fread(shape.data(), 1, shape.size(), f) != shape.size()) {
+    complex_file_error(function, path, "truncated header");
+  }
+  for (size_t i = 0; i < fixed[11]; i++) {
+    header.shape.push_back(static_cast<int64_t>(load_le(&shape[8 * i], 8)));
+  }
+  check_complex_file_shape(header.shape, header.dtype, function, path);
+  header.data_offset = complex_file_fixed_header_size + shape.size();
+  return header;
+}
+
+} // namespace detail
+
+// Writes a compressed complex file row by row, see
+// [Compressed complex files]
+template<typename T>
+class complex_codec_writer {
+ public:
+  using value_type = c10::complex<T>;
+
+  // A file of shape {0, row_shape...}, replacing the file at path
+  explicit complex_codec_writer(const std::string& path, std::vector<int64_t> row_shape = {}, int64_t block_size = codec_default_block_size)
+    : path_(path), file_(detail::open_file(path, "wb", "c10::complex_codec_writer")), block_size_(block_size) {
+    if (block_size <= 0 || block_size > codec_max_block_size) {
+      throw std::invalid_argument("c10::complex_codec_writer: block_size must be in [1, 2^24]");
+    }
+    if (row_shape.size() >= static_cast<size_t>(detail::complex_file_max_ndim)) {
+      throw std::invalid_argument("c10::complex_codec_writer: too many dimensions");
+    }
+    row_size_ = 1;
+    for (int64_t d : row_shape) {
+      if (d <= 0) {
+        throw std::invalid_argument("c10::complex_codec_writer: the dimensions of a row must be positive");
+      }
+      row_size_ *= d;
+    }
+    shape_.push_back(0);
+    shape_.insert(shape_.end(), row_shape.begin(), row_shape.end());
+    std::setvbuf(file_.get(), nullptr, _IOFBF, size_t(1) << 20);
+    const std::string header = detail::encode_codec_file_header(complex_dtype_of<T>::value, shape_, block_size_);
+    write(header.data(), header.size());
+  }
+
+  complex_codec_writer(complex_codec_writer&&) = default;
+  // Closes the file of *this first, which compresses its pending elements
+  complex_codec_writer& operator=(complex_codec_writer&& other) {
+    if (this != &other) {
+      close();
+      path_ = std::move(other.path_);
+      file_ = std::move(other.file_);
+      shape_ = std::move(other.shape_);
+      row_size_ = other.row_size_;
+      block_size_ = other.block_size_;
+      pending_ = std::move(other.pending_);
+      blocks_ = std::move(other.blocks_);
+    }
+    return *this;
+  }
+
+  ~complex_codec_writer() {
+    try {
+      close();
+    } catch (const std::exception&) {
+      // errors can only be reported by calling close
+    }
+  }
+
+  // Appends n elements, a whole number of rows. Whole batches of blocks are
+  // compressed right away, the rest when more data comes or on flush().
+  void append(const value_type* data, int64_t n) {
+    if (n % row_size_ != 0) {
+      throw std::invalid_argument("c10::complex_codec_writer: can only append whole rows");
+    }
+    check_open();
+    const int64_t batch = detail::codec_batch_blocks() * block_size_;
+    int64_t i = 0;
+    if (!pending_.empty()) {
+      const int64_t count = std::min(n, batch - static_cast<int64_t>(pending_.size()));
+      pending_.insert(pending_.end(), data, data + count);
+      i = count;
+      if (static_cast<int64_t>(pending_.size()) == batch) {
+        write_blocks(pending_.data(), batch);
+        pending_.clear();
+      }
+    }
+    // straight from data, without a copy
+    for (; n - i >= batch; i += batch) {
+      write_blocks(data + i, batch);
+    }
+    pending_.insert(pending_.end(), data + i, data + n);
+    shape_[0] += n / row_size_;
+  }
+
+  void append(span<const value_type> s) {
+    append(s.data(), s.size());
+  }
+
+  // Compresses the pending elements, and writes the current shape to the
+  // header and the buffered data to the file
+  void flush() {
+    check_open();
+    write_blocks(pending_.data(), pending_.size());
+    pending_.clear();
+    std::FILE* f = file_.get();
+    if (std::fflush(f) != 0 || std::fseek(f, detail::complex_file_fixed_header_size, SEEK_SET) != 0) {
+      detail::complex_file_errno("c10::complex_codec_writer", path_);
+    }
+    unsigned char rows[8];
+    detail::store_le(rows, shape_[0], 8);
+    write(rows, sizeof(rows));
+    if (std::fflush(f) != 0 || std::fseek(f, 0, SEEK_END) != 0) {
+      detail::complex_file_errno("c10::complex_codec_writer", path_);
+    }
+  }
+
+  void close() {
+    if (file_ != nullptr) {
+      flush();
+      if (std::fclose(file_.release()) != 0) {
+        detail::complex_file_errno("c10::complex_codec_writer", path_);
+      }
+    }
+  }
+
+  // Elements appended so far
+  int64_t size() const {
+    return shape_[0] * row_size_;
+  }
+  const std::vector<int64_t>& shape() const {
+    return shape_;
+  }
+  int64_t block_size() const {
+    return block_size_;
+  }
+
+ private:
+  void check_open() const {
+    if (file_ == nullptr) {
+      throw std::logic_error("c10::complex_codec_writer: the file is closed");
+    }
+  }
+
+  void write(const void* data, size_t bytes) {
+    if (bytes > 0 && std::fwrite(data, 1, bytes, file_.get()) != bytes) {
+      detail::complex_file_errno("c10::complex_codec_writer", path_);
+    }
+  }
+
+  // Compresses data[0, n) in blocks on all threads
+  void write_blocks(const value_type* data, int64_t n) {
+    const int64_t num_blocks = (n + block_size_ - 1) / block_size_;
+    blocks_.resize(std::max<size_t>(blocks_.size(), num_blocks));
+    c10::parallel_for(0, num_blocks, 1, [&](int64_t begin, int64_t end) {
+      detail::codec_scratch<typename detail::codec_uint<sizeof(T)>::type> scratch;
+      for (int64_t b = begin; b < end; b++) {
+        const int64_t offset = b * block_size_;
+        detail::encode_codec_block(data + offset, std::min(block_size_, n - offset), scratch, blocks_[b]);
+      }
+    });
+    for (int64_t b = 0; b < num_blocks; b++) {
+      write(blocks_[b].data(), blocks_[b].size());
+    }
+  }
+
+  std::string path_;
+  detail::file_ptr file_;
+  std::vector<int64_t> shape_;
+  int64_t row_size_;
+  int64_t block_size_;
+  std::vector<value_type> pending_;
+  std::vector<std::vector<unsigned char>> blocks_;
+};
+
+// Reads a compressed complex file in chunks, see [Compressed complex files]
+template<typename T>
+class complex_codec_reader {
+ public:
+  using value_type = c10::complex<T>;
+
+  explicit complex_codec_reader(const std::string& path)
+    : path_(path), file_(detail::open_file(path, "rb", "c10::complex_codec_reader")) {
+    header_ = detail::read_codec_file_header(file_.get(), block_size_, "c10::complex_codec_reader", path);
+    if (header_.dtype != complex_dtype_of<T>::value) {
+      detail::complex_file_error("c10::complex_codec_reader", path, "dtype does not match");
+    }
+    remaining_ = header_.numel();
+    undecoded_ = remaining_;
+  }
+
+  // Reads the next min(n, remaining()) elements into out and returns their
+  // number
+  int64_t read(value_type* out, int64_t n) {
+    n = std::min(n, remaining_);
+    if (n <= 0) {
+      return 0;
+    }
+    for (int64_t i = 0; i < n;) {
+      if (next_ == static_cast<int64_t>(decoded_.size())) {
+        decode_batch();
+      }
+      const int64_t count = std::min(n - i, static_cast<int64_t>(decoded_.size()) - next_);
+      std::copy(decoded_.begin() + next_, decoded_.begin() + next_ + count, out + i);
+      next_ += count;
+      i += count;
+    }
+    remaining_ -= n;
+    return n;
+  }
+
+  int64_t read(span<value_type> s) {
+    return read(s.data(), s.size());
+  }
+
+  int64_t remaining() const {
+    return remaining_;
+  }
+  const complex_file_header& header() const {
+    return header_;
+  }
+  int64_t block_size() const {
+    return block_size_;
+  }
+
+ private:
+  // Reads the next batch of blocks and decompresses them on all threads
+  void decode_batch() {
+    const char* function = "c10::complex_codec_reader";
+    const int64_t max_blocks = detail::codec_batch_blocks();
+    std::vector<int64_t> offsets(1, 0);
+    blocks_.resize(std::max<size_t>(blocks_.size(), max_blocks));
+    int64_t num_blocks = 0;
+    while (num_blocks < max_blocks && undecoded_ > 0) {
+      unsigned char header[detail::codec_block_header_size];
+      if (std::fread(header, 1, sizeof(header), file_.get()) != sizeof(header)) {
+        detail::complex_file_error(function, path_, "truncated data");
+      }
+      const int64_t count = static_cast<int64_t>(detail::load_le(header, 4));
+      const uint64_t bytes = detail::load_le(header + 4, 4);
+      if (count <= 0 || count > block_size_ || count > undecoded_ || bytes > detail::codec_max_block_bytes(count, sizeof(T))) {
+        detail::complex_file_error(function, path_, "corrupt block header");
+      }
+      std::vector<unsigned char>& block = blocks_[num_blocks];
+      block.resize(bytes);
+      if (bytes > 0 && std::fread(block.data(), 1, bytes, file_.get()) != bytes) {
+        detail::complex_file_error(function, path_, "truncated data");
+      }
+      undecoded_ -= count;
+      offsets.push_back(offsets.back() + count);
+      num_blocks++;
+    }
+    decoded_.resize(offsets.back());
+    try {
+      c10::parallel_for(0, num_blocks, 1, [&](int64_t begin, int64_t end) {
+        detail::codec_scratch<typename detail::codec_uint<sizeof(T)>::type> scratch;
+        for (int64_t b = begin; b < end; b++) {
+          detail::decode_codec_block(blocks_[b].data(), blocks_[b].size(), offsets[b + 1] - offsets[b], decoded_.data() + offsets[b], scratch);
+        }
+      });
+    } catch (const std::runtime_error& e) {
+      detail::complex_file_error(function, path_, e.what());
+    }
+    next_ = 0;
+  }
+
+  std::string path_;
+  detail::file_ptr file_;
+  complex_file_header header_;
+  int64_t block_size_;
+  int64_t remaining_;
+  int64_t undecoded_;   // elements in blocks not read from the file yet
+  std::vector<value_type> decoded_;
+  int64_t next_ = 0;    // in decoded_
+  std::vector<std::vector<unsigned char>> blocks_;
+};
+
+// Reads a whole compressed complex file, and its shape if shape is not null
+template<typename T>
+complex_buffer<T> load_compressed_complex_file(const std::string& path, std::vector<int64_t>* shape = nullptr) {
+  complex_codec_reader<T> r(path);
+  complex_buffer<T> result(r.remaining());
+  r.read(result.data(), result.size());
+  if (shape != nullptr) {
+    *shape = r.header().shape;
+  }
+  return result;
+}
+
+namespace detail {
+
+// Elements copied at once by compress_complex_file and
+// decompress_complex_file, rounded up to whole rows
+constexpr int64_t codec_copy_chunk = int64_t(1) << 22;
+
+inline std::vector<int64_t> codec_row_shape(const std::vector<int64_t>& shape) {
+  return shape.empty() ? std::vector<int64_t>() : std::vector<int64_t>(shape.begin() + 1, shape.end());
+}
+
+template<typename T, typename Reader, typename Writer>
+void codec_copy(Reader& r, Writer& w) {
+  int64_t row_size = 1;
+  for (int64_t d : codec_row_shape(r.header().shape)) {
+    row_size *= d;
+  }
+  row_size = std::max<int64_t>(row_size, 1);
+  std::vector<complex<T>> chunk((codec_copy_chunk + row_size - 1) / row_size * row_size);
+  while (r.remaining() > 0) {
+    const int64_t n = r.read(chunk.data(), chunk.size());
+    w.append(chunk.data(), n);
+  }
+  w.close();
+}
+
+template<typename T>
+void compress_complex_file(const std::string& src, const std::string& dst, int64_t block_size) {
+  complex_file_reader<T> r(src);
+  complex_codec_writer<T> w(dst, codec_row_shape(r.header().shape), block_size);
+  codec_copy<T>(r, w);
+}
+
+template<typename T>
+void decompress_complex_file(const std::string& src, const std::string& dst) {
+  complex_codec_reader<T> r(src);
+  complex_file_writer<T> w(dst, codec_row_shape(r.header().shape));
+  codec_copy<T>(r, w);
+}
+
+} // namespace detail
+
+// Compresses the complex file src to the compressed complex file dst,
+// streaming, see [Compressed complex files]. A shape with no dimensions is
+// stored as {1}.
+inline void compress_complex_file(const std::string& src, const std::string& dst, int64_t block_size = codec_default_block_size) {
+  switch (read_complex_file_header(src).dtype) {
+    case complex_dtype::complex_half:
+      return detail::compress_complex_file<c10::Half>(src, dst, block_size);
+    case complex_dtype::complex_float:
+      return detail::compress_complex_file<float>(src, dst, block_size);
+    case complex_dtype::complex_double:
+      return detail::compress_complex_file<double>(src, dst, block_size);
+  }
+}
+
+// Decompresses the compressed complex file src to the complex file dst,
+// streaming
+inline void decompress_complex_file(const std::string& src, const std::string& dst) {
+  int64_t block_size;
+  complex_dtype dtype;
+  {
+    detail::file_ptr f = detail::open_file(src, "rb", "c10::decompress_complex_file");
+    dtype = detail::read_codec_file_header(f.get(), block_size, "c10::decompress_complex_file", src).dtype;
+  }
+  switch (dtype) {
+    case complex_dtype::complex_half:
+      return detail::decompress_complex_file<c10::Half>(src, dst);
+    case complex_dtype::complex_float:
+      return detail::decompress_complex_file<float>(src, dst);
+    case complex_dtype::complex_double:
+      return detail::decompress_complex_file<double>(src, dst);
+  }
+}
+
+} // namespace c10
@@ -0,0 +1,430 @@
+#pragma once
+
+#include <c10/util/complex.h>
+
+#include <cstdint>
+#include <type_traits>
+
+// constexpr elementary functions for c10::complex
+//
+// [Compile-time math]
+//
+// The functions in c10/util/complex_math.h call std and thrust, so they are
+// not constexpr, and tables computed from them (twiddle factors, window
+// coefficients, constellation maps, ...) have to be built at run time. The
+// functions in namespace c10::constexpr_math can be evaluated at compile
+// time instead, so such tables end up in read-only data:
+//
+//   constexpr auto w = c10::constexpr_math::polar(1.0, -2 * pi / 1024);
+//
+// Available are exp, sin and cos of real and complex numbers, polar, and
+// root_of_unity for exactly symmetric tables of exp(2 pi i k / n).
+// Only float and double are supported.
+//
+// Internally everything is computed in double-double arithmetic (an
+// unevaluated sum of two doubles, about 106 significant bits) and rounded to
+// T once at the end, so the real functions and each part of the complex
+// results are correctly rounded. Subnormal results are the exception: they
+// are rounded twice.
+//
+// Arguments must be finite. sin and cos reduce their argument with pi / 2
+// split into four doubles, which is accurate for |x| < 2^20.
+//
+// These functions are meant for constant evaluation. At run time they are
+// much slower than std::exp etc., and the error-free transformations they
+// are built on are only exact if the compiler does not contract a * b + c
+// into fused multiply-adds (which GCC does by default when FMA instructions
+// are available).
+
+namespace c10 {
+namespace constexpr_math {
+namespace detail {
+
+// hi + lo, with |lo| <= ulp(hi) / 2
+struct dd {
+  double hi;
+  double lo;
+};
+
+constexpr dd make_dd(double x) {
+  return dd{x, 0.0};
+}
+
+// s + e = a + b exactly (Knuth)
+constexpr dd two_sum(double a, double b) {
+  double s = a + b;
+  double bb = s - a;
+  return dd{s, (a - (s - bb)) + (b - bb)};
+}
+
+// s + e = a + b exactly, for |a| >= |b|
+constexpr dd fast_two_sum(double a, double b) {
+  double s = a + b;
+  return dd{s, b - (s - a)};
+}
+
+// p + e = a * b exactly (Dekker), for |a|, |b| < 2^996
+constexpr dd two_prod(double a, double b) {
+  constexpr double split = 134217729.0;  // 2^27 + 1
+  double ca = split * a;
+  double a_hi = ca - (ca - a);
+  double a_lo = a - a_hi;
+  double cb = split * b;
+  double b_hi = cb - (cb - b);
+  double b_lo = b - b_hi;
+  double p = a * b;
+  return dd{p, ((a_hi * b_hi - p) + a_hi * b_lo + a_lo * b_hi) + a_lo * b_lo};
+}
+
+// 0 - x instead of -x, so that zeros stay positive
+constexpr dd neg(dd a) {
+  return dd{0.0 - a.hi, 0.0 - a.lo};
+}
+
+template<typename U>
+constexpr U neg(U x) {
+  return U(0) - x;
+}
+
+constexpr dd add(dd a, dd b) {
+  dd s = two_sum(a.hi, b.hi);
+  dd t = two_sum(a.lo, b.lo);
+  s = fast_two_sum(s.hi, s.lo + t.hi);
+  return fast_two_sum(s.hi, s.lo + t.lo);
+}
+
+constexpr dd sub(dd a, dd b) {
+  return add(a, neg(b));
+}
+
+constexpr dd mul(dd a, dd b) {
+  dd p = two_prod(a.hi, b.hi);
+  return fast_two_sum(p.hi, p.lo + (a.hi * b.lo + a.lo * b.hi));
+}
+
+constexpr dd div(dd a, dd b) {
+  double q1 = a.hi / b.hi;
+  dd r = sub(a, mul(b, make_dd(q1)));
+  double q2 = r.hi / b.hi;
+  r = sub(r, mul(b, make_dd(q2)));
+  double q3 = r.hi / b.hi;
+  return add(fast_two_sum(q1, q2), make_dd(q3));
+}
+
+// multiplication by a power of two p is exact
+constexpr dd scale(dd a, double p) {
+  return dd{a.hi * p, a.lo * p};
+}
+
+constexpr double abs(double x) {
+  return x < 0 ? -x : x;
+}
+
+// x rounded to the nearest integer, for |x| < 2^62
+constexpr int64_t nearest_int(double x) {
+  return static_cast<int64_t>(x < 0 ? x - 0.5 : x + 0.5);
+}
+
+// 2^k, exact unless it overflows or underflows
+constexpr double pow2(int64_t k) {
+  double result = 1.0;
+  double factor = k < 0 ? 0.5 : 2.0;
+  for (int64_t n = k < 0 ? -k : k; n != 0; n >>= 1) {
+    if (n & 1) {
+      result *= factor;
+    }
+    factor *= factor;
+  }
+  return result;
+}
+
+// x * 2^k, in two steps so that the scale factors stay representable
+constexpr double ldexp(double x, int64_t k) {
+  return x * pow2(k / 2) * pow2(k - k / 2);
+}
+
+// Rounds a double-double to T. A normalized double-double is already rounded
+// to double in its hi part. For float, rounding hi again is wrong only if hi
+// is exactly halfway between two floats, where lo decides.
+template<typename T>
+struct rounding;
+
+template<>
+struct rounding<double> {
+  static constexpr double round(dd x) {
+    return x.hi;
+  }
+};
+
+template<>
+struct rounding<float> {
+  static constexpr float round(dd x) {
+    float f = static_cast<float>(x.hi);
+    double d = x.hi - static_cast<double>(f);
+    // if hi is halfway, the other neighbor of hi is f + 2d, and it is a float
+    double other = static_cast<double>(f) + 2 * d;
+    if (d != 0 && static_cast<double>(static_cast<float>(other)) == other && x.lo * d > 0) {
+      return static_cast<float>(other);
+    }
+    return f;
+  }
+};
+
+// x * 2^k rounded to T. The mantissa is rounded first, so the final scaling
+// is exact unless the result is subnormal.
+template<typename T>
+constexpr T round_scaled(dd x, int64_t k) {
+  return static_cast<T>(ldexp(static_cast<double>(rounding<T>::round(x)), k));
+}
+
+// Splits of constants into four doubles each
+constexpr double ln2_parts[4] = {0.6931471805599453, 2.3190468138462996e-17, 5.707708438416212e-34, -3.5824322106018114e-50};
+constexpr double pio2_parts[4] = {1.5707963267948966, 6.123233995736766e-17, -1.4973849048591698e-33, 5.562271104316826e-50};
+constexpr double inv_ln2 = 1.4426950408889634;
+constexpr double two_over_pi = 0.6366197723675814;
+
+// x - k * (parts[0] + parts[1] + parts[2] + parts[3])
+constexpr dd reduce(double x, int64_t k, const double* parts) {
+  dd r = make_dd(x);
+  for (int i = 0; i < 4; i++) {
+    r = sub(r, two_prod(static_cast<double>(k), parts[i]));
+  }
+  return r;
+}
+
+// 1 / k! for k in [0, 32)
+struct inverse_factorials {
+  dd values[32];
+};
+
+constexpr inverse_factorials make_inverse_factorials() {
+  inverse_factorials f{};
+  f.values[0] = make_dd(1.0);
+  for (int k = 1; k < 32; k++) {
+    f.values[k] = div(f.values[k - 1], make_dd(k));
+  }
+  return f;
+}
+
+constexpr inverse_factorials inverse_factorial = make_inverse_factorials();
+
+// m * 2^k
+struct scaled {
+  dd m;
+  int64_t k;
+};
+
+// e^x = e^r * 2^k with r = x - k ln2 and |r| <= ln2 / 2. e^r is the Taylor
+// series of e^(r / 256), squared 8 times.
+constexpr scaled exp_scaled(double x) {
+  // beyond these bounds the result overflows or underflows anyway
+  x = x < -1500.0 ? -1500.0 : (x > 1500.0 ? 1500.0 : x);
+  int64_t k = nearest_int(x * inv_ln2);
+  dd r = scale(reduce(x, k, ln2_parts), 1.0 / 256);
+  // |r| < 2^-9, so the terms up to r^12 / 12! are enough
+  dd sum = inverse_factorial.values[12];
+  for (int k = 11; k >= 0; k--) {
+    sum = add(inverse_factorial.values[k], mul(sum, r));
+  }
+  for (int i = 0; i < 8; i++) {
+    sum = mul(sum, sum);
+  }
+  return scaled{sum, k};
+}
+
+struct sin_cos {
+  dd sin;
+  dd cos;
+};
+
+// Taylor series of sin and cos for |r| <= pi / 4, where the terms up to
+// r^29 / 29! are enough for double-double precision
+constexpr sin_cos sincos_reduced(dd r) {
+  dd r2 = mul(r, r);
+  dd s = inverse_factorial.values[29];
+  dd c = inverse_factorial.values[30];
+  for (int k = 27; k >= 1; k -= 2) {
+    s = sub(inverse_factorial.values[k], mul(s, r2));
+    c = sub(inverse_factorial.values[k + 1], mul(c, r2));
+  }
+  c = sub(make_dd(1.0), mul(c, r2));
+  return sin_cos{mul(s, r), c};
+}
+
+// sin and cos of x rotated by k quarter turns
+template<typename U>
+constexpr void rotate_quadrant(U& s, U& c, int64_t k) {
+  U s0 = s;
+  U c0 = c;
+  switch (k & 3) {
+    case 0: s = s0; c = c0; break;
+    case 1: s = c0; c = neg(s0); break;
+    case 2: s = neg(s0); c = neg(c0); break;
+    default: s = neg(c0); c = s0; break;
+  }
+}
+
+// sin and cos of x = r + k pi / 2, with |r| <= pi / 4
+constexpr sin_cos sincos(double x) {
+  int64_t k = nearest_int(x * two_over_pi);
+  sin_cos t = sincos_reduced(reduce(x, k, pio2_parts));
+  rotate_quadrant(t.sin, t.cos, k);
+  return t;
+}
+
+// The angle 2 pi k / n written as quadrant * pi / 2 + phi or
+// quadrant * pi / 2 + (pi / 2 - phi), where phi = (pi / 4) * (r / n) is in
+// the first octant. In the second case sin and cos of phi are swapped.
+// Reducing k / n exactly in integers makes the roots of unity exactly
+// symmetric, e.g. the root for k = n / 4 is exactly i.
+struct octant {
+  int64_t r;
+  bool swap;
+  int64_t quadrant;
+};
+
+// for n < 2^59
+constexpr octant reduce_octant(int64_t k, int64_t n) {
+  k %= n;
+  k = k < 0 ? k + n : k;
+  int64_t a = 8 * k;
+  int64_t o = a / n;
+  return (o & 1) ? octant{(o + 1) * n - a, true, o / 2} : octant{a - o * n, false, o / 2};
+}
+
+// sin and cos of (pi / 4) * (r / n), for r in [0, n]
+constexpr sin_cos sincos_octant(int64_t r, int64_t n) {
+  dd pi_4 = scale(dd{pio2_parts[0], pio2_parts[1]}, 0.5);
+  return sincos_reduced(mul(pi_4, div(make_dd(static_cast<double>(r)), make_dd(static_cast<double>(n)))));
+}
+
+struct sinh_cosh {
+  scaled sinh;
+  scaled cosh;
+};
+
+// sinh(y) and cosh(y) from e^|y| and e^-|y|, except that the Taylor series
+// is used for sinh of |y| < 1, where the difference would cancel
+constexpr sinh_cosh sinhcosh(double y) {
+  double ay = abs(y);
+  scaled e = exp_scaled(ay);
+  double sign = y < 0 ? -1.0 : 1.0;
+  if (e.k > 60) {
+    // e^-|y| is less than 2^-120 of e^|y|
+    return sinh_cosh{scaled{scale(e.m, sign), e.k - 1}, scaled{e.m, e.k - 1}};
+  }
+  dd big = scale(e.m, pow2(e.k));
+  dd small = div(make_dd(1.0), big);
+  dd cosh = scale(add(big, small), 0.5);
+  dd sinh = scale(sub(big, small), 0.5);
+  if (ay < 1) {
+    dd y_dd = make_dd(ay);
+    dd y2 = mul(y_dd, y_dd);
+    dd term = y_dd;
+    sinh = y_dd;
+    for (int n = 2; n < 40 && term.hi > 1e-40; n += 2) {
+      term = div(mul(term, y2), make_dd(static_cast<double>(n) * (n + 1)));
+      sinh = add(sinh, term);
+    }
+  }
+  return sinh_cosh{scaled{scale(sinh, sign), 0}, scaled{cosh, 0}};
+}
+
+template<typename T>
+struct check_constexpr_type {
+  static_assert(std::is_same<T, float>::value || std::is_same<T, double>::value,
+    "constexpr math functions only support float and double");
+  using type = T;
+};
+
+} // namespace detail
+
+template<typename T>
+constexpr T exp(T x) {
+  using U = typename detail::check_constexpr_type<T>::type;
+  detail::scaled e = detail::exp_scaled(static_cast<double>(x));
+  return detail::round_scaled<U>(e.m, e.k);
+}
+
+template<typename T>
+constexpr T sin(T x) {
+  using U = typename detail::check_constexpr_type<T>::type;
+  return x == T(0) ? x : detail::rounding<U>::round(detail::sincos(static_cast<double>(x)).sin);
+}
+
+template<typename T>
+constexpr T cos(T x) {
+  using U = typename detail::check_constexpr_type<T>::type;
+  return detail::rounding<U>::round(detail::sincos(static_cast<double>(x)).cos);
+}
+
+// r * (cos(theta) + sin(theta) i)
+template<typename T>
+constexpr c10::complex<T> polar(const T& r, const T& theta = T()) {
+  using U = typename detail::check_constexpr_type<T>::type;
+  detail::sin_cos t = detail::sincos(static_cast<double>(theta));
+  detail::dd r_dd = detail::make_dd(static_cast<double>(r));
+  return c10::complex<T>(
+    detail::rounding<U>::round(detail::mul(r_dd, t.cos)),
+    theta == T(0) ? r * theta : detail::rounding<U>::round(detail::mul(r_dd, t.sin)));
+}
+
+// exp(2 pi i k / n), for n in [1, 2^59). The angle is reduced to the first
+// octant exactly (see detail::reduce_octant), so the roots are exactly
+// symmetric: e.g. root_of_unity(n / 4, n) is 0 + 1 i and the roots for k
+// and n - k are conjugates.
+template<typename T>
+constexpr c10::complex<T> root_of_unity(int64_t k, int64_t n) {
+  using U = typename detail::check_constexpr_type<T>::type;
+  detail::octant o = detail::reduce_octant(k, n);
+  detail::sin_cos t = detail::sincos_octant(o.r, n);
+  U c = detail::rounding<U>::round(o.swap ? t.sin : t.cos);
+  U s = detail::rounding<U>::round(o.swap ? t.cos : t.sin);
+  detail::rotate_quadrant(s, c, o.quadrant);
+  return c10::complex<T>(c, s);
+}
+
+// e^re * (cos(im) + sin(im) i)
+template<typename T>
+constexpr c10::complex<T> exp(const c10::complex<T>& z) {
+  using U = typename detail::check_constexpr_type<T>::type;
+  if (z.imag() == T(0)) {
+    return c10::complex<T>(exp(z.real()), z.imag());
+  }
+  detail::scaled e = detail::exp_scaled(static_cast<double>(z.real()));
+  detail::sin_cos t = detail::sincos(static_cast<double>(z.imag()));
+  return c10::complex<T>(
+    detail::round_scaled<U>(detail::mul(e.m, t.cos), e.k),
+    detail::round_scaled<U>(detail::mul(e.m, t.sin), e.k));
+}
+
+// sin(x + y i) = sin(x) cosh(y) + cos(x) sinh(y) i
+template<typename T>
+constexpr c10::complex<T> sin(const c10::complex<T>& z) {
+  using U = typename detail::check_constexpr_type<T>::type;
+  if (z.imag() == T(0)) {
+    return c10::complex<T>(sin(z.real()), cos(z.real()) * z.imag());
+  }
+  detail::sin_cos t = detail::sincos(static_cast<double>(z.real()));
+  detail::sinh_cosh h = detail::sinhcosh(static_cast<double>(z.imag()));
+  return c10::complex<T>(
+    detail::round_scaled<U>(detail::mul(t.sin, h.cosh.m), h.cosh.k),
+    detail::round_scaled<U>(detail::mul(t.cos, h.sinh.m), h.sinh.k));
+}
+
+// cos(x + y i) = cos(x) cosh(y) - sin(x) sinh(y) i
+template<typename T>
+constexpr c10::complex<T> cos(const c10::complex<T>& z) {
+  using U = typename detail::check_constexpr_type<T>::type;
+  if (z.imag() == T(0)) {
+    return c10::complex<T>(cos(z.real()), -(sin(z.real()) * z.imag()));
+  }
+  detail::sin_cos t = detail::sincos(static_cast<double>(z.real()));
+  detail::sinh_cosh h = detail::sinhcosh(static_cast<double>(z.imag()));
+  return c10::complex<T>(
+    detail::round_scaled<U>(detail::mul(t.cos, h.cosh.m), h.cosh.k),
+    detail::round_scaled<U>(detail::scale(detail::mul(t.sin, h.sinh.m), -1.0), h.sinh.k));
+}
+
+} // namespace constexpr_math
+} // namespace c10
@@ -0,0 +1,227 @@
+#pragma once
+
+#include <c10/util/complex.h>
+#include <c10/util/complex_buffer.h>
+#include <c10/util/complex_nontemporal.h>
+#include <c10/util/complex_parallel.h>
+#include <c10/util/complex_vec_math.h>
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <limits>
+#include <type_traits>
+
+// Bulk conversion between arrays of c10::complex<c10::Half>, c10::complex<float>
+// and c10::complex<double>
+//
+// [Bulk conversion]
+//
+//   c10::bulk::convert(x, out, n);           // out[i] = complex<To>(x[i])
+//   c10::bulk::convert(x, out, n, options);
+//
+// By default the result is the same as the converting constructors of
+// c10::complex applied elementwise, but the arrays are converted as arrays of
+// real numbers by a loop that the compiler vectorizes. x and out must not
+// overlap, unless From and To are the same type and x == out.
+//
+// Conversions that lose precision (double to float, and float or double to
+// c10::Half, which is an integer type in this prototype) can be changed with
+// convert_options:
+// - saturate: values beyond the range of To become the largest finite value
+//   of the same sign instead of infinity. For c10::Half, values are clamped
+//   to its range and NaN becomes 0, where the plain conversion is undefined.
+// - stochastic_rounding: round up or down at random, with the probability of
+//   rounding up equal to the distance from the value below divided by the
+//   spacing, so the expected result is the exact value (the plain conversion
+//   rounds to nearest, or truncates for c10::Half). Results in the subnormal
+//   range of float are rounded to nearest. The random numbers come from a hash of
+//   seed and the position of each real number, so the result only depends on
+//   seed and not on how the work is split between threads.
+// - nontemporal: write out with non-temporal (streaming) stores, which
+//   bypass the caches. This helps when out is much larger than the last
+//   level cache and is not read again soon, see [Non-temporal stores]. It
+//   falls back to normal stores on targets without SSE2. Outputs of at
+//   least get_streaming_threshold() bytes use non-temporal stores even
+//   without this option, like the elementwise bulk kernels.
+//
+// Exact conversions (widening, or between the same types) ignore these options.
+// With options, conversions from double need 64 bit lane masks, so on x86
+// they are only vectorized from SSE4.1 on, like the double bulk kernels.
+// Arrays of more than convert_grain_size real numbers are split between
+// threads with c10::parallel_for.
+
+namespace c10 {
+namespace bulk {
+
+struct convert_options {
+  bool saturate = false;
+  bool stochastic_rounding = false;
+  uint64_t seed = 0;
+  bool nontemporal = false;
+};
+
+// Number of real numbers converted by each thread at least
+constexpr int64_t convert_grain_size = int64_t(1) << 18;
+
+namespace detail {
+
+template<typename T>
+struct check_convert_type {
+  static_assert(std::is_same<T, c10::Half>::value || std::is_same<T, float>::value || std::is_same<T, double>::value,
+    "bulk conversion only supports c10::complex<c10::Half>, c10::complex<float> and c10::complex<double>");
+};
+
+// 32 bit integer hash by Chris Wellons ("lowbias32"), which only needs
+// operations that are vectorized on 32 bit lanes
+C10_VEC_INLINE uint32_t hash32(uint32_t x) {
+  x ^= x >> 16;
+  x *= 0x7feb352du;
+  x ^= x >> 15;
+  x *= 0x846ca68bu;
+  x ^= x >> 16;
+  return x;
+}
+
+// Key of the random numbers for the real numbers [2^32 k, 2^32 (k + 1))
+inline uint32_t random_key(uint64_t seed, uint64_t k) {
+  return hash32(static_cast<uint32_t>(seed) ^ hash32(static_cast<uint32_t>(seed >> 32) + hash32(static_cast<uint32_t>(k))));
+}
+
+// Converts one real number, given 32 random bits for stochastic rounding.
+// The primary template is for exact conversions.
+template<typename From, typename To, bool Stochastic, bool Saturate, typename = void>
+struct convert_lane {
+  static constexpr bool exact = true;
+  C10_VEC_INLINE To operator()(From x, uint32_t /*random*/) const {
+    return static_cast<To>(x);
+  }
+};
+
+template<bool Stochastic, bool Saturate>
+struct convert_lane<double, float, Stochastic, Saturate> {
+  static constexpr bool exact = false;
+  C10_VEC_INLINE float operator()(double x, uint32_t random) const {
+    using namespace vec_math;
+    if (Stochastic) {
+      // float keeps 29 fewer mantissa bits than double. Adding random bits
+      // below them to the magnitude and truncating rounds up with the right
+      // probability; a carry into the exponent is still the next value up.
+      constexpr uint64_t low = (uint64_t(1) << 29) - 1;
+      double truncated = from_bits<double>((to_bits(x) + (random >> 3)) & ~low);
+      x = select(is_finite(x), truncated, x);
+    }
+    if (Saturate) {
+      // clamp before converting, so that the lanes stay double until the end
+      constexpr double limit = std::numeric_limits<float>::max();
+      x = select(is_finite(x), max(-limit, min(limit, x)), x);
+    }
+    return static_cast<float>(x);
+  }
+};
+
+template<typename From, bool Stochastic, bool Saturate>
+struct convert_lane<From, c10::Half, Stochastic, Saturate, typename std::enable_if<!std::is_same<From, c10::Half>::value>::type> {
+  static constexpr bool exact = false;
+  C10_VEC_INLINE c10::Half operator()(From x, uint32_t random) const {
+    using namespace vec_math;
+    using int_limits = std::numeric_limits<c10::Half>;
+    if (Stochastic) {
+      // floor(x + u) with u uniform in [0, 1)
+      x = x + From(static_cast<int32_t>(random >> 8)) * From(1.0 / (1 << 24));
+    }
+    if (Saturate) {
+      x = select(x == x, x, From(0));
+      x = max(From(int_limits::min()), min(From(int_limits::max()), x));
+    }
+    // truncate in 32 bits, which every SIMD instruction set can do
+    int32_t i = static_cast<int32_t>(x);
+    if (Stochastic) {
+      i -= static_cast<int32_t>(static_cast<From>(i) > x);
+    }
+    return static_cast<c10::Half>(i);
+  }
+};
+
+// Converts the real numbers [begin, end). Blocks start at multiples of
+// block_size, so a block never crosses a multiple of 2^32 where the random
+// key changes.
+template<typename From, typename To, typename Lane>
+void convert_range(const From* x, To* out, int64_t begin, int64_t end, uint64_t seed, bool nontemporal, const Lane& lane) {
+  constexpr int64_t block_size = 1024;
+  To buffer[block_size];
+  for (int64_t b = begin; b < end;) {
+    const int64_t block_end = std::min(end, (b / block_size + 1) * block_size);
+    const int count = static_cast<int>(block_end - b);
+    const uint32_t key = random_key(seed, static_cast<uint64_t>(b) >> 32);
+    const uint32_t first = static_cast<uint32_t>(b);
+    const From* src = x + b;
+    To* dst = nontemporal ? buffer : out + b;
+    C10_VEC_LOOP
+    for (int j = 0; j < count; j++) {
+      dst[j] = lane(src[j], hash32(key ^ (first + static_cast<uint32_t>(j))));
+    }
+    if (nontemporal) {
+      stream_copy(out + b, buffer, count * sizeof(To));
+    }
+    b = block_end;
+  }
+  if (nontemporal) {
+    stream_fence();
+  }
+}
+
+template<typename From, typename To, bool Stochastic, bool Saturate>
+void convert_real(const From* x, To* out, int64_t n, const convert_options& options) {
+  const convert_lane<From, To, Stochastic, Saturate> lane;
+  c10::parallel_for(0, n, convert_grain_size, [&](int64_t begin, int64_t end) {
+    convert_range(x, out, begin, end, options.seed, options.nontemporal, lane);
+  });
+}
+
+} // namespace detail
+
+// Options of complex_buffer<T> that place it like bulk::convert splits it,
+// see [NUMA placement]
+template<typename T>
+numa_options convert_numa_options(numa_placement placement = numa_placement::interleave) {
+  numa_options options;
+  options.placement = placement;
+  options.grain_size = convert_grain_size;
+  options.unit_bytes = sizeof(T);
+  return options;
+}
+
+// out[i] = complex<To>(x[i]) for i in [0, n), see [Bulk conversion]
+template<typename From, typename To>
+void convert(const complex<From>* x, complex<To>* out, int64_t n, const convert_options& options = convert_options()) {
+  detail::check_convert_type<From>();
+  detail::check_convert_type<To>();
+  if (n <= 0) {
+    // x and out may be null, which memcpy does not allow
+    return;
+  }
+  const From* xr = reinterpret_cast<const From*>(x);
+  To* outr = reinterpret_cast<To*>(out);
+  const bool in_place = static_cast<const void*>(x) == static_cast<const void*>(out);
+  convert_options resolved = options;
+  resolved.nontemporal = options.nontemporal || detail::use_stream_stores(n * sizeof(complex<To>), in_place);
+  if (std::is_same<From, To>::value && !resolved.nontemporal) {
+    if (!in_place) {
+      std::memcpy(static_cast<void*>(out), static_cast<const void*>(x), n * sizeof(complex<To>));
+    }
+  } else if (detail::convert_lane<From, To, false, false>::exact) {
+    detail::convert_real<From, To, false, false>(xr, outr, 2 * n, resolved);
+  } else if (options.stochastic_rounding && options.saturate) {
+    detail::convert_real<From, To, true, true>(xr, outr, 2 * n, resolved);
+  } else if (options.stochastic_rounding) {
+    detail::convert_real<From, To, true, false>(xr, outr, 2 * n, resolved);
+  } else if (options.saturate) {
+    detail::convert_real<From, To, false, true>(xr, outr, 2 * n, resolved);
+  } else {
+    detail::convert_real<From, To, false, false>(xr, outr, 2 * n, resolved);
+  }
+}
+
+} // namespace bulk
+} // namespace c10
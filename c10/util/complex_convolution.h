@@ -0,0 +1,372 @@
+#pragma once
+
+#include <c10/util/complex.h>
+#include <c10/util/complex_fft.h>
+#include <c10/util/complex_fir.h>
+#include <c10/util/complex_span.h>
+#include <c10/util/complex_vec_math.h>
+
+#include <algorithm>
+#include <cstdint>
+#include <stdexcept>
+#include <string>
+#include <type_traits>
+#include <vector>
+
+// Fast convolution and correlation of c10::complex streams with FFTs
+//
+// [Fast convolution]
+//
+// c10::fft_convolver<T, Tap> filters a stream of c10::complex<T>, T float
+// or double, with taps of type T or c10::complex<T>, like c10::fir_filter,
+// but computes the outputs with FFTs of size N, so each output costs
+// O(log N) instead of O(number of taps):
+//
+//   c10::fft_convolver<float> f(taps);                     // y[i] = sum_k h[k] x[i - k]
+//   c10::fft_convolver<float> g(taps, c10::convolution_kind::correlation);
+//                                                          // y[i] = sum_k conj(h[k]) x[i - (K - 1) + k]
+//   f.filter(x, out, n);
+//
+// with K the number of taps. The correlation is the matched filter of h: a
+// copy of h that starts at input s gives a peak at output s + K - 1. The
+// streams behave like fir_filter: n inputs give n outputs, chunks of any
+// size give the same outputs, the inputs before the first are zero.
+//
+// The spectrum H of the taps, padded to N and scaled by 1 / N, is computed
+// once. Each block of L = N - K + 1 inputs is transformed, multiplied by H,
+// or by conj(H) for correlations, in one pass, and transformed back:
+// - overlap_method::overlap_save transforms the block with the K - 1 inputs
+//   before it; the circular convolution is then exact at the last L
+//   entries, the circular correlation at the first L.
+// - overlap_method::overlap_add transforms the block padded with zeros and
+//   adds the last K - 1 entries of the result to the first outputs of the
+//   next block.
+// Both give the same outputs up to rounding. A chunk that ends inside a
+// block computes the outputs it can with the inputs it has, which are
+// exact since the filter is causal, and the block is transformed again
+// when it is complete, so chunks of at least block_size() inputs are the
+// cheapest.
+//
+// N is a power of two of at least 2K. By default it minimizes the
+// operations per output, (2 N log2 N + N) / L, among the sizes whose plan,
+// spectrum and block fit in fft_convolution_cache_bytes, so the passes of
+// the FFTs stay in the L2 cache.
+//
+// c10::convolve and c10::correlate compute the nx + K - 1 outputs of whole
+// arrays, with c10::fir_filter or with an fft_convolver, whichever
+// c10::fft_convolution_preferred expects to be faster.
+
+namespace c10 {
+
+enum class convolution_kind { convolution, correlation };
+
+enum class overlap_method { overlap_save, overlap_add };
+
+enum class convolution_method { automatic, direct, fft };
+
+// Bytes of the plan, spectrum and block of an FFT convolution, see [Fast
+// convolution]
+constexpr int64_t fft_convolution_cache_bytes = 256 * 1024;
+
+namespace detail {
+
+template<typename T, typename Tap>
+struct check_convolution_types {
+  static_assert(std::is_same<T, float>::value || std::is_same<T, double>::value,
+    "convolutions only support c10::complex<float> and c10::complex<double> data");
+  static_assert(std::is_same<Tap, T>::value || std::is_same<Tap, complex<T>>::value,
+    "convolutions only support taps of type T or c10::complex<T>");
+};
+
+inline int fft_log2(int64_t n) {
+  int bits = 0;
+  while ((int64_t(1) << bits) < n) {
+    bits++;
+  }
+  return bits;
+}
+
+// Operations per output of an FFT convolution of size n with k taps
+inline double fft_convolution_cost(int64_t n, int64_t k) {
+  return (2.0 * n * fft_log2(n) + n) / static_cast<double>(n - k + 1);
+}
+
+// The FFT size for k taps: a power of two of at least 2 k, at most enough
+// for num_outputs if it is positive, see [Fast convolution]
+template<typename T>
+int64_t fft_convolution_size(int64_t k, int64_t num_outputs) {
+  const int64_t smallest = fft_next_power_of_two(2 * k);
+  int64_t largest = fft_convolution_cache_bytes / (3 * static_cast<int64_t>(sizeof(complex<T>)));
+  if (num_outputs > 0) {
+    largest = std::min(largest, fft_next_power_of_two(num_outputs + k - 1));
+  }
+  int64_t best = smallest;
+  for (int64_t n = 2 * smallest; n <= largest; n *= 2) {
+    if (fft_convolution_cost(n, k) < fft_convolution_cost(best, k)) {
+      best = n;
+    }
+  }
+  return best;
+}
+
+// out[i] = x[i] * h[i], or x[i] * conj(h[i]) if Conj is true; out may be x
+template<bool Conj, typename T>
+void spectrum_multiply(const complex<T>* x, const complex<T>* h, complex<T>* out, int64_t n) {
+  C10_VEC_LOOP
+  for (int64_t i = 0; i < n; i++) {
+    const T xr = x[i].real(), xi = x[i].imag();
+    const T hr = h[i].real(), hi = Conj ? -h[i].imag() : h[i].imag();
+    out[i] = complex<T>(
+      vec_math::fma(xr, hr, -(xi * hi)),
+      vec_math::fma(xr, hi, xi * hr));
+  }
+}
+
+inline complex<float> conj_tap(const complex<float>& h) {
+  return complex<float>(h.real(), -h.imag());
+}
+
+inline complex<double> conj_tap(const complex<double>& h) {
+  return complex<double>(h.real(), -h.imag());
+}
+
+template<typename T>
+T conj_tap(const T& h) {
+  return h;
+}
+
+} // namespace detail
+
+// Whether an FFT convolution is expected to be faster than a direct one for
+// num_taps taps and num_outputs outputs, or a long stream if num_outputs is
+// 0.
+template<typename T, typename Tap = T>
+bool fft_convolution_preferred(int64_t num_taps, int64_t num_outputs = 0) {
+  detail::check_convolution_types<T, Tap>();
+  const int64_t n = detail::fft_convolution_size<T>(num_taps, num_outputs);
+  const int64_t blocks = num_outputs > 0 ? (num_outputs + n - num_taps) / (n - num_taps + 1) : 0;
+  // the time per output of fir_filter in units of the cost model, measured
+  // with AVX2: about 0.13 to 0.16 per real tap and 0.26 to 0.35 per complex
+  // tap, so the FFT wins from about 200 real or 80 complex taps
+  const double direct = (std::is_same<Tap, T>::value ? 0.14 : 0.3) * num_taps;
+  double fft = detail::fft_convolution_cost(n, num_taps);
+  if (num_outputs > 0) {
+    // the spectrum of the taps
+    fft = (fft * blocks * (n - num_taps + 1) + n * detail::fft_log2(n)) / num_outputs;
+  }
+  return fft < direct;
+}
+
+// A stream filtered with FFTs, see [Fast convolution]
+template<typename T, typename Tap = T>
+class fft_convolver {
+ public:
+  using value_type = complex<T>;
+  using tap_type = Tap;
+
+  fft_convolver() = default;
+
+  // fft_size is a power of two of at least twice the number of taps, or 0
+  // to choose one
+  explicit fft_convolver(
+      span<const Tap> taps,
+      convolution_kind kind = convolution_kind::convolution,
+      overlap_method method = overlap_method::overlap_save,
+      int64_t fft_size = 0)
+    : kind_(kind), method_(method) {
+    detail::check_convolution_types<T, Tap>();
+    detail::check_fir_taps(taps, "c10::fft_convolver");
+    const int64_t k = taps.size();
+    if (fft_size == 0) {
+      fft_size = detail::fft_convolution_size<T>(k, 0);
+    }
+    if (!detail::fft_is_power_of_two(fft_size) || fft_size < 2 * k) {
+      throw std::invalid_argument(
+        "c10::fft_convolver: the FFT size must be a power of two of at least twice the number of taps");
+    }
+    num_taps_ = k;
+    plan_ = fft_plan<T>(fft_size);
+    spectrum_.assign(fft_size, value_type(0, 0));
+    const T scale = T(1) / static_cast<T>(fft_size);
+    for (int64_t i = 0; i < k; i++) {
+      spectrum_[i] = value_type(taps[i]) * scale;
+    }
+    plan_.forward(spectrum_.data(), spectrum_.data());
+    work_.resize(fft_size);
+    // overlap-save keeps the inputs of the previous block, overlap-add the
+    // outputs it added into this one
+    input_.resize(method_ == overlap_method::overlap_save ? fft_size : block_size());
+    tail_.resize(method_ == overlap_method::overlap_add ? k - 1 : 0);
+    reset();
+  }
+
+  // Filters the next n inputs into out[0, n). out may be x.
+  void filter(const value_type* x, value_type* out, int64_t n) {
+    const int64_t history = method_ == overlap_method::overlap_save ? num_taps_ - 1 : 0;
+    const int64_t L = block_size();
+    int64_t i = 0;
+    while (i < n) {
+      const int64_t count = std::min(L - pending_, n - i);
+      std::copy(x + i, x + i + count, input_.begin() + history + pending_);
+      pending_ += count;
+      i += count;
+      if (pending_ == L) {
+        transform(history + L);
+        out = emit(out, L);
+        if (method_ == overlap_method::overlap_save) {
+          std::copy(input_.begin() + L, input_.begin() + L + history, input_.begin());
+        } else {
+          for (int64_t j = 0; j < num_taps_ - 1; j++) {
+            tail_[j] = result(L + j);
+          }
+        }
+        pending_ = 0;
+        emitted_ = 0;
+      }
+    }
+    if (pending_ > emitted_) {
+      transform(history + pending_);
+      emit(out, pending_);
+    }
+  }
+
+  void filter(span<const value_type> x, span<value_type> out) {
+    filter(x.data(), out.data(), std::min(x.size(), out.size()));
+  }
+
+  void reset() {
+    std::fill(input_.begin(), input_.end(), value_type(0, 0));
+    std::fill(tail_.begin(), tail_.end(), value_type(0, 0));
+    pending_ = 0;
+    emitted_ = 0;
+  }
+
+  int64_t num_taps() const {
+    return num_taps_;
+  }
+
+  int64_t fft_size() const {
+    return plan_.size();
+  }
+
+  // Inputs per block: chunks of a multiple of it transform each block once
+  int64_t block_size() const {
+    return plan_.size() - num_taps_ + 1;
+  }
+
+ private:
+  // The circular convolution or correlation of input_[0, count), padded
+  // with zeros, and the taps, in work_
+  void transform(int64_t count) {
+    std::copy(input_.begin(), input_.begin() + count, work_.begin());
+    std::fill(work_.begin() + count, work_.end(), value_type(0, 0));
+    plan_.forward(work_.data(), work_.data());
+    if (kind_ == convolution_kind::convolution) {
+      detail::spectrum_multiply<false>(work_.data(), spectrum_.data(), work_.data(), work_.size());
+    } else {
+      detail::spectrum_multiply<true>(work_.data(), spectrum_.data(), work_.data(), work_.size());
+    }
+    plan_.inverse(work_.data(), work_.data());
+  }
+
+  // Entry i of the linear convolution of the transformed inputs: the
+  // circular correlation starts K - 1 entries later, wrapped
+  value_type result(int64_t i) const {
+    const int64_t n = plan_.size();
+    const int64_t shift = kind_ == convolution_kind::convolution ? 0 : n - (num_taps_ - 1);
+    return work_[(i + shift) & (n - 1)];
+  }
+
+  // Writes the outputs of the inputs [emitted_, end) of the block to out
+  // and returns the end of them
+  value_type* emit(value_type* out, int64_t end) {
+    const int64_t offset = method_ == overlap_method::overlap_save ? num_taps_ - 1 : 0;
+    const int64_t tail = tail_.size();
+    for (int64_t j = emitted_; j < end; j++) {
+      value_type y = result(offset + j);
+      if (j < tail) {
+        y += tail_[j];
+      }
+      *out++ = y;
+    }
+    emitted_ = end;
+    return out;
+  }
+
+  convolution_kind kind_ = convolution_kind::convolution;
+  overlap_method method_ = overlap_method::overlap_save;
+  int64_t num_taps_ = 0;
+  fft_plan<T> plan_;
+  std::vector<value_type> spectrum_;  // of the taps, scaled by 1 / N
+  std::vector<value_type> work_;
+  std::vector<value_type> input_;     // [K - 1 previous inputs,] block
+  std::vector<value_type> tail_;      // overlap-add: added to the next outputs
+  int64_t pending_ = 0;               // inputs of the block
+  int64_t emitted_ = 0;               // outputs of the block already written
+};
+
+namespace detail {
+
+// Streams x and K - 1 zeros through filter, in two chunks that split x at a
+// multiple of block, so that only the last block is incomplete
+template<typename Filter, typename T>
+void filter_full(Filter& filter, const complex<T>* x, int64_t nx, complex<T>* out, int64_t k, int64_t block) {
+  const int64_t head = nx - nx % block;
+  filter.filter(x, out, head);
+  std::vector<complex<T>> rest(nx - head + k - 1, complex<T>(0, 0));
+  std::copy(x + head, x + nx, rest.begin());
+  filter.filter(rest.data(), out + head, rest.size());
+}
+
+template<typename T, typename Tap>
+void convolve_full(
+    const complex<T>* x, int64_t nx, const Tap* h, int64_t nh, complex<T>* out,
+    convolution_kind kind, convolution_method method, const char* function) {
+  check_convolution_types<T, Tap>();
+  if (nh <= 0 || nx < 0) {
+    throw std::invalid_argument(std::string(function) + ": no taps");
+  }
+  if (method == convolution_method::automatic) {
+    method = fft_convolution_preferred<T, Tap>(nh, nx + nh - 1)
+      ? convolution_method::fft : convolution_method::direct;
+  }
+  if (method == convolution_method::fft) {
+    fft_convolver<T, Tap> f(
+      span<const Tap>(h, nh), kind, overlap_method::overlap_save,
+      fft_convolution_size<T>(nh, nx + nh - 1));
+    filter_full(f, x, nx, out, nh, f.block_size());
+  } else if (kind == convolution_kind::convolution) {
+    fir_filter<T, Tap> f(span<const Tap>(h, nh));
+    filter_full(f, x, nx, out, nh, fir_chunk);
+  } else {
+    // the correlation is the convolution with conj(h) reversed
+    std::vector<Tap> g(nh);
+    for (int64_t i = 0; i < nh; i++) {
+      g[i] = conj_tap(h[nh - 1 - i]);
+    }
+    fir_filter<T, Tap> f{span<const Tap>(g)};
+    filter_full(f, x, nx, out, nh, fir_chunk);
+  }
+}
+
+} // namespace detail
+
+// out[i] = sum_k h[k] x[i - k] for i in [0, nx + nh - 1), see [Fast
+// convolution]
+template<typename T, typename Tap>
+void convolve(
+    const complex<T>* x, int64_t nx, const Tap* h, int64_t nh, complex<T>* out,
+    convolution_method method = convolution_method::automatic) {
+  detail::convolve_full(x, nx, h, nh, out, convolution_kind::convolution, method, "c10::convolve");
+}
+
+// out[i] = sum_k conj(h[k]) x[i - (nh - 1) + k] for i in [0, nx + nh - 1),
+// the correlation at lag i - (nh - 1), see [Fast convolution]
+template<typename T, typename Tap>
+void correlate(
+    const complex<T>* x, int64_t nx, const Tap* h, int64_t nh, complex<T>* out,
+    convolution_method method = convolution_method::automatic) {
+  detail::convolve_full(x, nx, h, nh, out, convolution_kind::correlation, method, "c10::correlate");
+}
+
+} // namespace c10
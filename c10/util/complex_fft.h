@@ -0,0 +1,301 @@
+#pragma once
+
+#include <c10/util/complex.h>
+#include <c10/util/complex_roots.h>
+#include <c10/util/complex_vec_math.h>
+
+#include <algorithm>
+#include <cstdint>
+#include <memory>
+#include <stdexcept>
+#include <type_traits>
+#include <vector>
+
+// Fast Fourier transforms of arrays of c10::complex
+//
+// [FFT plans]
+//
+// c10::fft_plan<T>(n) precomputes what the transforms of size n need, and
+// is then immutable, so one plan can be used by several threads at once:
+//
+//   c10::fft_plan<float> plan(n);
+//   plan.forward(x, out);   // out[k] = sum_j x[j] exp(-2 pi i j k / n)
+//   plan.inverse(x, out);   // out[j] = sum_k x[k] exp(2 pi i j k / n)
+//
+// The inverse is not scaled by 1 / n. out may be x.
+// plan.forward_windowed(x, window, count, out) transforms x[j] window[j] for
+// j in [0, count), padded with zeros to n, and applies the window while it
+// reads the input, without a separate pass.
+//
+// Sizes that are powers of two are transformed by iterative radix-2
+// decimation in time: the input is permuted into bit-reversed order and
+// log2(n) passes of butterflies combine transforms of size m into
+// transforms of size 2m. The twiddle factors of a pass, exp(-2 pi i k / 2m)
+// for k in [0, m), are stored contiguously as real and imaginary parts,
+// taken from c10::roots_of_unity, so the butterflies of a pass are lane
+// loops over k. The first two passes, whose twiddles are 1 and -i, are
+// fused into one radix-4 pass without multiplications.
+//
+// Other sizes use Bluestein's algorithm, which writes the transform as a
+// convolution with the chirp exp(-pi i k^2 / n) and computes it with
+// transforms of the next power of two of at least 2n - 1, so every size
+// takes O(n log n) time, with a larger constant.
+
+namespace c10 {
+namespace detail {
+
+inline bool fft_is_power_of_two(int64_t n) {
+  return n > 0 && (n & (n - 1)) == 0;
+}
+
+inline int64_t fft_next_power_of_two(int64_t n) {
+  int64_t p = 1;
+  while (p < n) {
+    p *= 2;
+  }
+  return p;
+}
+
+} // namespace detail
+
+template<typename T>
+class fft_plan {
+ public:
+  using value_type = complex<T>;
+
+  fft_plan() = default;
+
+  explicit fft_plan(int64_t n): n_(n) {
+    static_assert(std::is_same<T, float>::value || std::is_same<T, double>::value,
+      "FFTs only support c10::complex<float> and c10::complex<double>");
+    if (n <= 0 || n > (int64_t(1) << 30)) {
+      throw std::invalid_argument("c10::fft_plan: the size must be in [1, 2^30]");
+    }
+    if (detail::fft_is_power_of_two(n)) {
+      init_power_of_two();
+    } else {
+      init_bluestein();
+    }
+  }
+
+  int64_t size() const {
+    return n_;
+  }
+
+  // out[k] = sum_j x[j] exp(-2 pi i j k / n)
+  void forward(const value_type* x, value_type* out) const {
+    transform<false>(x, nullptr, n_, out);
+  }
+
+  // out[j] = sum_k x[k] exp(2 pi i j k / n), not scaled
+  void inverse(const value_type* x, value_type* out) const {
+    transform<true>(x, nullptr, n_, out);
+  }
+
+  // forward() of x[j] window[j] for j in [0, count) and zeros after, with
+  // count <= n. The window is applied while the input is permuted, so it
+  // costs no extra pass. out may not overlap x.
+  void forward_windowed(const value_type* x, const T* window, int64_t count, value_type* out) const {
+    transform<false>(x, window, std::min(count, n_), out);
+  }
+
+ private:
+  void init_power_of_two() {
+    int bits = 0;
+    while ((int64_t(1) << bits) < n_) {
+      bits++;
+    }
+    reversed_.resize(n_);
+    for (int64_t i = 0; i < n_; i++) {
+      uint32_t r = 0;
+      for (int b = 0; b < bits; b++) {
+        r |= static_cast<uint32_t>((i >> b) & 1) << (bits - 1 - b);
+      }
+      reversed_[i] = r;
+    }
+    // the twiddles exp(-2 pi i k / 2m) of the pass of size m at [m, 2m)
+    twiddles_re_.resize(std::max<int64_t>(n_, 2));
+    twiddles_im_.resize(std::max<int64_t>(n_, 2));
+    const roots_of_unity_view<T> roots = roots_of_unity<T>(n_);
+    for (int64_t m = 1; m < n_; m *= 2) {
+      for (int64_t k = 0; k < m; k++) {
+        const value_type w = roots.twiddle(k * (n_ / (2 * m)));
+        twiddles_re_[m + k] = w.real();
+        twiddles_im_[m + k] = w.imag();
+      }
+    }
+  }
+
+  void init_bluestein() {
+    const int64_t m = detail::fft_next_power_of_two(2 * n_ - 1);
+    inner_ = std::make_shared<const fft_plan<T>>(m);
+    // chirp_[k] = exp(-pi i k^2 / n), with k^2 reduced modulo 2n so that
+    // the roots of unity of size 2n give it exactly
+    const roots_of_unity_view<T> roots = roots_of_unity<T>(2 * n_);
+    chirp_.resize(n_);
+    for (int64_t k = 0; k < n_; k++) {
+      chirp_[k] = roots.twiddle(static_cast<int64_t>((static_cast<uint64_t>(k) * k) % (2 * n_)));
+    }
+    // the spectrum of conj(chirp) at indices -(n - 1) ... n - 1, wrapped,
+    // scaled by 1 / m for the inverse transform
+    std::vector<value_type> b(m, value_type(0, 0));
+    const T scale = T(1) / static_cast<T>(m);
+    for (int64_t k = 0; k < n_; k++) {
+      const value_type c(chirp_[k].real() * scale, -chirp_[k].imag() * scale);
+      b[k] = c;
+      if (k > 0) {
+        b[m - k] = c;
+      }
+    }
+    chirp_spectrum_.resize(m);
+    inner_->forward(b.data(), chirp_spectrum_.data());
+  }
+
+  // The transform of x[j] window[j] for j in [0, count) and zeros after;
+  // no window if it is null
+  template<bool Inverse>
+  void transform(const value_type* x, const T* window, int64_t count, value_type* out) const {
+    if (n_ == 0) {
+      return;
+    }
+    if (inner_ == nullptr) {
+      permute(x, window, count, out);
+      butterflies<Inverse>(out);
+    } else {
+      bluestein<Inverse>(x, window, count, out);
+    }
+  }
+
+  // out[reversed_[i]] = x[i] window[i]
+  void permute(const value_type* x, const T* window, int64_t count, value_type* out) const {
+    if (count < n_) {
+      std::fill(out, out + n_, value_type(0, 0));
+    }
+    if (window != nullptr) {
+      for (int64_t i = 0; i < count; i++) {
+        out[reversed_[i]] = x[i] * window[i];
+      }
+    } else if (x == out) {
+      for (int64_t i = 0; i < n_; i++) {
+        const int64_t r = reversed_[i];
+        if (i < r) {
+          std::swap(out[i], out[r]);
+        }
+      }
+    } else {
+      for (int64_t i = 0; i < count; i++) {
+        out[reversed_[i]] = x[i];
+      }
+    }
+  }
+
+  template<bool Inverse>
+  void butterflies(value_type* data) const {
+    T* p = reinterpret_cast<T*>(data);
+    const T s = Inverse ? T(-1) : T(1);
+    int64_t m = 1;
+    if (n_ >= 4) {
+      // the passes of m = 1 and m = 2 as one radix-4 pass; multiplying by
+      // -i (i for the inverse) swaps the parts
+      C10_VEC_LOOP
+      for (int64_t j = 0; j < 2 * n_; j += 8) {
+        const T ar = p[j] + p[j + 2], ai = p[j + 1] + p[j + 3];
+        const T br = p[j] - p[j + 2], bi = p[j + 1] - p[j + 3];
+        const T cr = p[j + 4] + p[j + 6], ci = p[j + 5] + p[j + 7];
+        const T dr = p[j + 4] - p[j + 6], di = p[j + 5] - p[j + 7];
+        // d times -i is (di, -dr)
+        p[j] = ar + cr;
+        p[j + 1] = ai + ci;
+        p[j + 4] = ar - cr;
+        p[j + 5] = ai - ci;
+        p[j + 2] = br + s * di;
+        p[j + 3] = bi - s * dr;
+        p[j + 6] = br - s * di;
+        p[j + 7] = bi + s * dr;
+      }
+      m = 4;
+    }
+    // The other passes run W butterflies at a time: the products with the
+    // twiddles go to arrays of real and imaginary parts first, so that the
+    // lane loops see no aliasing. 32 bytes of parts per array measured
+    // faster than vec_math::lanes, with and without AVX.
+    constexpr int64_t W = 32 / sizeof(T);
+    for (; m < n_; m *= 2) {
+      const T* wr = twiddles_re_.data() + m;
+      const T* wi = twiddles_im_.data() + m;
+      for (int64_t j = 0; j < n_; j += 2 * m) {
+        T* a = p + 2 * j;
+        T* b = a + 2 * m;
+        const int64_t width = std::min(W, m);
+        for (int64_t i = 0; i < m; i += width) {
+          T tr[W], ti[W];
+          if (width == W) {
+            C10_VEC_LOOP
+            for (int64_t k = 0; k < W; k++) {
+              twiddle(b + 2 * (i + k), wr[i + k], s * wi[i + k], tr[k], ti[k]);
+            }
+            C10_VEC_LOOP
+            for (int64_t k = 0; k < W; k++) {
+              butterfly(a + 2 * (i + k), b + 2 * (i + k), tr[k], ti[k]);
+            }
+          } else {
+            for (int64_t k = 0; k < width; k++) {
+              twiddle(b + 2 * (i + k), wr[i + k], s * wi[i + k], tr[k], ti[k]);
+            }
+            for (int64_t k = 0; k < width; k++) {
+              butterfly(a + 2 * (i + k), b + 2 * (i + k), tr[k], ti[k]);
+            }
+          }
+        }
+      }
+    }
+  }
+
+  // (tr, ti) = b (wr, wi)
+  static C10_VEC_INLINE void twiddle(const T* b, T wr, T wi, T& tr, T& ti) {
+    tr = vec_math::fma(b[0], wr, -(b[1] * wi));
+    ti = vec_math::fma(b[0], wi, b[1] * wr);
+  }
+
+  // (a, b) = (a + t, a - t)
+  static C10_VEC_INLINE void butterfly(T* a, T* b, T tr, T ti) {
+    const T ar = a[0], ai = a[1];
+    a[0] = ar + tr;
+    a[1] = ai + ti;
+    b[0] = ar - tr;
+    b[1] = ai - ti;
+  }
+
+  // X[k] = c[k] sum_j (x[j] c[j]) conj(c[k - j]), with c the chirp; the
+  // inverse is conj(forward(conj(x)))
+  template<bool Inverse>
+  void bluestein(const value_type* x, const T* window, int64_t count, value_type* out) const {
+    const int64_t m = inner_->size();
+    std::vector<value_type> a(m, value_type(0, 0));
+    for (int64_t k = 0; k < count; k++) {
+      const value_type v = Inverse ? value_type(x[k].real(), -x[k].imag()) : x[k];
+      a[k] = v * (window != nullptr ? chirp_[k] * window[k] : chirp_[k]);
+    }
+    inner_->forward(a.data(), a.data());
+    for (int64_t k = 0; k < m; k++) {
+      a[k] *= chirp_spectrum_[k];
+    }
+    inner_->inverse(a.data(), a.data());
+    for (int64_t k = 0; k < n_; k++) {
+      const value_type v = a[k] * chirp_[k];
+      out[k] = Inverse ? value_type(v.real(), -v.imag()) : v;
+    }
+  }
+
+  int64_t n_ = 0;
+  // powers of two
+  std::vector<uint32_t> reversed_;
+  std::vector<T> twiddles_re_;
+  std::vector<T> twiddles_im_;
+  // other sizes
+  std::shared_ptr<const fft_plan<T>> inner_;
+  std::vector<value_type> chirp_;
+  std::vector<value_type> chirp_spectrum_;
+};
+
+} // namespace c10
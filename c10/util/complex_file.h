@@ -0,0 +1,600 @@
+#pragma once
+
+#include <c10/util/complex.h>
+#include <c10/util/complex_buffer.h>
+#include <c10/util/complex_span.h>
+
+#include <algorithm>
+#include <cerrno>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <limits>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#if defined(__unix__) || defined(__APPLE__)
+#define C10_HAS_MMAP 1
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+// Binary files of arrays of c10::complex
+//
+// [Complex files]
+//
+// operator<< and operator>> format complex numbers as text through
+// std::complex, which is far too slow for large arrays. The functions below
+// store arrays in a binary format instead: a small header followed by the
+// raw interleaved data, which can be memory-mapped.
+//
+//   c10::save_complex_file(path, data, shape);
+//   c10::complex_file_writer<T> w(path, row_shape);  w.append(data, n);
+//   c10::mapped_complex_file<T> f(path);             // zero-copy, read-only
+//   c10::complex_file_reader<T> r(path);             r.read(out, n);
+//   c10::load_complex_file<T>(path, &shape);         // into a complex_buffer
+//
+// The header is, with all integers in the byte order of the data:
+//
+//   offset  size
+//   0       8       magic "\x93C10CPLX"
+//   8       1       version, 1
+//   9       1       dtype, see complex_dtype
+//   10      1       byte order of the data, '<' little or '>' big endian
+//   11      1       ndim, the number of dimensions
+//   12      4       reserved, 0
+//   16      8*ndim  shape, int64, the first dimension is the slowest
+//
+// followed by zeros up to the data, which starts at the next multiple of
+// complex_file_alignment bytes, so that mapped data is aligned for every
+// c10::complex type (and a cache line). The data is numel() elements in
+// row-major order, each the real part followed by the imaginary part.
+//
+// complex_file_writer appends rows to a file: its shape is
+// {rows, row_shape...}, and every append has to be a whole number of rows.
+// The header is written when the file is created, with 0 rows, and updated
+// by flush() and close() (also called by the destructor), so a file that is
+// still being written can be read up to the last flush. Writes are buffered
+// by stdio; appends larger than the buffer go straight to the file.
+//
+// The writer always writes the byte order of the host. mapped_complex_file
+// only maps files whose dtype is T and whose byte order is the one of the
+// host, and throws std::runtime_error otherwise; complex_file_reader and
+// load_complex_file also swap bytes. Malformed files and I/O errors throw
+// std::runtime_error too. On systems without mmap, mapped_complex_file
+// reads the whole file into memory instead.
+
+namespace c10 {
+
+enum class complex_dtype : uint8_t {
+  complex_half = 1,    // c10::complex<c10::Half>
+  complex_float = 2,   // c10::complex<float>
+  complex_double = 3,  // c10::complex<double>
+};
+
+template<typename T>
+struct complex_dtype_of;
+template<>
+struct complex_dtype_of<c10::Half> {
+  static constexpr complex_dtype value = complex_dtype::complex_half;
+};
+template<>
+struct complex_dtype_of<float> {
+  static constexpr complex_dtype value = complex_dtype::complex_float;
+};
+template<>
+struct complex_dtype_of<double> {
+  static constexpr complex_dtype value = complex_dtype::complex_double;
+};
+
+// Size in bytes of one element
+inline size_t complex_dtype_size(complex_dtype dtype) {
+  switch (dtype) {
+    case complex_dtype::complex_half:
+      return sizeof(c10::complex<c10::Half>);
+    case complex_dtype::complex_float:
+      return sizeof(c10::complex<float>);
+    case complex_dtype::complex_double:
+      return sizeof(c10::complex<double>);
+  }
+  return 0;
+}
+
+constexpr int64_t complex_file_alignment = 64;
+
+struct complex_file_header {
+  complex_dtype dtype;
+  bool little_endian;
+  std::vector<int64_t> shape;
+  int64_t data_offset;  // in bytes from the start of the file
+
+  int64_t numel() const {
+    int64_t n = 1;
+    for (int64_t d : shape) {
+      n *= d;
+    }
+    return n;
+  }
+};
+
+namespace detail {
+
+constexpr char complex_file_magic[8] = {'\x93', 'C', '1', '0', 'C', 'P', 'L', 'X'};
+constexpr uint8_t complex_file_version = 1;
+constexpr size_t complex_file_fixed_header_size = 16;
+constexpr int complex_file_max_ndim = 255;
+
+inline bool host_little_endian() {
+#if defined(__BYTE_ORDER__) && defined(__ORDER_LITTLE_ENDIAN__)
+  return __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__;
+#else
+  const uint16_t one = 1;
+  unsigned char first;
+  std::memcpy(&first, &one, 1);
+  return first == 1;
+#endif
+}
+
+// Reverses the bytes of each of count values of width bytes
+inline void swap_bytes(void* data, int64_t count, size_t width) {
+  unsigned char* p = static_cast<unsigned char*>(data);
+  for (int64_t i = 0; i < count; i++, p += width) {
+    for (size_t j = 0; j < width / 2; j++) {
+      std::swap(p[j], p[width - 1 - j]);
+    }
+  }
+}
+
+inline int64_t complex_file_data_offset(size_t ndim) {
+  const int64_t end = complex_file_fixed_header_size + 8 * ndim;
+  return (end + complex_file_alignment - 1) / complex_file_alignment * complex_file_alignment;
+}
+
+[[noreturn]] inline void complex_file_error(const char* function, const std::string& path, const std::string& what) {
+  throw std::runtime_error(std::string(function) + ": " + path + ": " + what);
+}
+
+[[noreturn]] inline void complex_file_errno(const char* function, const std::string& path) {
+  complex_file_error(function, path, std::strerror(errno));
+}
+
+// The header of a file with the byte order of the host, up to the data
+inline std::string encode_complex_file_header(complex_dtype dtype, const std::vector<int64_t>& shape) {
+  std::string header(complex_file_data_offset(shape.size()), '\0');
+  std::memcpy(&header[0], complex_file_magic, sizeof(complex_file_magic));
+  header[8] = static_cast<char>(complex_file_version);
+  header[9] = static_cast<char>(dtype);
+  header[10] = host_little_endian() ? '<' : '>';
+  header[11] = static_cast<char>(shape.size());
+  if (!shape.empty()) {
+    std::memcpy(&header[complex_file_fixed_header_size], shape.data(), 8 * shape.size());
+  }
+  return header;
+}
+
+// Throws for negative dimensions and for sizes that do not fit in int64_t
+inline void check_complex_file_shape(const std::vector<int64_t>& shape, complex_dtype dtype, const char* function, const std::string& path) {
+  const int64_t max_bytes = std::numeric_limits<int64_t>::max() / 2;
+  int64_t bytes = complex_dtype_size(dtype);
+  for (int64_t d : shape) {
+    if (d < 0 || (d > 0 && bytes > max_bytes / d)) {
+      complex_file_error(function, path, "invalid shape");
+    }
+    bytes *= d;
+  }
+}
+
+// Reads and checks the header of an open file, which is left at the start
+// of the data
+inline complex_file_header read_complex_file_header(std::FILE* f, const char* function, const std::string& path) {
+  unsigned char fixed[complex_file_fixed_header_size];
+  if (std::fread(fixed, 1, sizeof(fixed), f) != sizeof(fixed) ||
+      std::memcmp(fixed, complex_file_magic, sizeof(complex_file_magic)) != 0) {
+    complex_file_error(function, path, "not a complex file");
+  }
+  if (fixed[8] != complex_file_version) {
+    complex_file_error(function, path, "unsupported version " + std::to_string(fixed[8]));
+  }
+  complex_file_header header;
+  header.dtype = static_cast<complex_dtype>(fixed[9]);
+  if (complex_dtype_size(header.dtype) == 0) {
+    complex_file_error(function, path, "unknown dtype " + std::to_string(fixed[9]));
+  }
+  if (fixed[10] != '<' && fixed[10] != '>') {
+    complex_file_error(function, path, "invalid byte order");
+  }
+  header.little_endian = fixed[10] == '<';
+  header.shape.resize(fixed[11]);
+  if (!header.shape.empty() && std::fread(header.shape.data(), 8, header.shape.size(), f) != header.shape.size()) {
+    complex_file_error(function, path, "truncated header");
+  }
+  if (header.little_endian != host_little_endian()) {
+    swap_bytes(header.shape.data(), header.shape.size(), 8);
+  }
+  check_complex_file_shape(header.shape, header.dtype, function, path);
+  header.data_offset = complex_file_data_offset(header.shape.size());
+  if (std::fseek(f, header.data_offset, SEEK_SET) != 0) {
+    complex_file_error(function, path, "truncated header");
+  }
+  return header;
+}
+
+struct file_closer {
+  void operator()(std::FILE* f) const {
+    if (f != nullptr) {
+      std::fclose(f);
+    }
+  }
+};
+
+using file_ptr = std::unique_ptr<std::FILE, file_closer>;
+
+inline file_ptr open_file(const std::string& path, const char* mode, const char* function) {
+  file_ptr f(std::fopen(path.c_str(), mode));
+  if (f == nullptr) {
+    complex_file_errno(function, path);
+  }
+  return f;
+}
+
+// A whole file mapped read-only, or read into memory without mmap
+class mapped_file {
+ public:
+  mapped_file() = default;
+
+  mapped_file(const std::string& path, const char* function) {
+#if defined(C10_HAS_MMAP)
+    const int fd = ::open(path.c_str(), O_RDONLY);
+    if (fd < 0) {
+      complex_file_errno(function, path);
+    }
+    struct stat st;
+    if (::fstat(fd, &st) != 0) {
+      const int error = errno;
+      ::close(fd);
+      errno = error;
+      complex_file_errno(function, path);
+    }
+    size_ = st.st_size;
+    if (size_ > 0) {
+      void* p = ::mmap(nullptr, size_, PROT_READ, MAP_SHARED, fd, 0);
+      if (p == MAP_FAILED) {
+        const int error = errno;
+        ::close(fd);
+        errno = error;
+        complex_file_errno(function, path);
+      }
+      data_ = static_cast<const char*>(p);
+    }
+    ::close(fd);
+#else
+    file_ptr f = open_file(path, "rb", function);
+    char chunk[1 << 16];
+    size_t count;
+    while ((count = std::fread(chunk, 1, sizeof(chunk), f.get())) > 0) {
+      contents_.insert(contents_.end(), chunk, chunk + count);
+    }
+    if (std::ferror(f.get())) {
+      complex_file_errno(function, path);
+    }
+    data_ = contents_.data();
+    size_ = contents_.size();
+#endif
+  }
+
+  mapped_file(mapped_file&& other) noexcept {
+    *this = std::move(other);
+  }
+
+  mapped_file& operator=(mapped_file&& other) noexcept {
+    if (this != &other) {
+      reset();
+      std::swap(data_, other.data_);
+      std::swap(size_, other.size_);
+#if !defined(C10_HAS_MMAP)
+      std::swap(contents_, other.contents_);
+#endif
+    }
+    return *this;
+  }
+
+  mapped_file(const mapped_file&) = delete;
+  mapped_file& operator=(const mapped_file&) = delete;
+
+  ~mapped_file() {
+    reset();
+  }
+
+  void reset() {
+#if defined(C10_HAS_MMAP)
+    if (data_ != nullptr) {
+      ::munmap(const_cast<char*>(data_), size_);
+    }
+#else
+    contents_.clear();
+#endif
+    data_ = nullptr;
+    size_ = 0;
+  }
+
+  const char* data() const {
+    return data_;
+  }
+  size_t size() const {
+    return size_;
+  }
+
+ private:
+  const char* data_ = nullptr;
+  size_t size_ = 0;
+#if !defined(C10_HAS_MMAP)
+  std::vector<char> contents_;
+#endif
+};
+
+} // namespace detail
+
+// Reads the header of the complex file at path
+inline complex_file_header read_complex_file_header(const std::string& path) {
+  const char* function = "c10::read_complex_file_header";
+  detail::file_ptr f = detail::open_file(path, "rb", function);
+  return detail::read_complex_file_header(f.get(), function, path);
+}
+
+// Writes a complex file row by row, see [Complex files]
+template<typename T>
+class complex_file_writer {
+ public:
+  using value_type = c10::complex<T>;
+
+  // A file of shape {0, row_shape...}, replacing the file at path
+  explicit complex_file_writer(const std::string& path, std::vector<int64_t> row_shape = {})
+    : path_(path), file_(detail::open_file(path, "wb", "c10::complex_file_writer")) {
+    if (row_shape.size() >= static_cast<size_t>(detail::complex_file_max_ndim)) {
+      throw std::invalid_argument("c10::complex_file_writer: too many dimensions");
+    }
+    row_size_ = 1;
+    for (int64_t d : row_shape) {
+      if (d <= 0) {
+        throw std::invalid_argument("c10::complex_file_writer: the dimensions of a row must be positive");
+      }
+      row_size_ *= d;
+    }
+    shape_.push_back(0);
+    shape_.insert(shape_.end(), row_shape.begin(), row_shape.end());
+    std::setvbuf(file_.get(), nullptr, _IOFBF, size_t(1) << 20);
+    const std::string header = detail::encode_complex_file_header(complex_dtype_of<T>::value, shape_);
+    write(header.data(), header.size());
+  }
+
+  complex_file_writer(complex_file_writer&&) = default;
+  // Closes the file of *this first, so that its header is complete
+  complex_file_writer& operator=(complex_file_writer&& other) {
+    if (this != &other) {
+      close();
+      path_ = std::move(other.path_);
+      file_ = std::move(other.file_);
+      shape_ = std::move(other.shape_);
+      row_size_ = other.row_size_;
+    }
+    return *this;
+  }
+
+  ~complex_file_writer() {
+    try {
+      close();
+    } catch (const std::exception&) {
+      // errors can only be reported by calling close
+    }
+  }
+
+  // Appends n elements, a whole number of rows
+  void append(const value_type* data, int64_t n) {
+    if (n % row_size_ != 0) {
+      throw std::invalid_argument("c10::complex_file_writer: can only append whole rows");
+    }
+    check_open();
+    write(data, n * sizeof(value_type));
+    shape_[0] += n / row_size_;
+  }
+
+  void append(span<const value_type> s) {
+    append(s.data(), s.size());
+  }
+
+  // Writes the current shape to the header and the buffered data to the
+  // file
+  void flush() {
+    check_open();
+    std::FILE* f = file_.get();
+    if (std::fflush(f) != 0 || std::fseek(f, detail::complex_file_fixed_header_size, SEEK_SET) != 0) {
+      detail::complex_file_errno("c10::complex_file_writer", path_);
+    }
+    write(&shape_[0], sizeof(int64_t));
+    if (std::fflush(f) != 0 || std::fseek(f, 0, SEEK_END) != 0) {
+      detail::complex_file_errno("c10::complex_file_writer", path_);
+    }
+  }
+
+  void close() {
+    if (file_ != nullptr) {
+      flush();
+      if (std::fclose(file_.release()) != 0) {
+        detail::complex_file_errno("c10::complex_file_writer", path_);
+      }
+    }
+  }
+
+  // Elements written so far
+  int64_t size() const {
+    return shape_[0] * row_size_;
+  }
+  const std::vector<int64_t>& shape() const {
+    return shape_;
+  }
+
+ private:
+  void check_open() const {
+    if (file_ == nullptr) {
+      throw std::logic_error("c10::complex_file_writer: the file is closed");
+    }
+  }
+
+  void write(const void* data, size_t bytes) {
+    if (bytes > 0 && std::fwrite(data, 1, bytes, file_.get()) != bytes) {
+      detail::complex_file_errno("c10::complex_file_writer", path_);
+    }
+  }
+
+  std::string path_;
+  detail::file_ptr file_;
+  std::vector<int64_t> shape_;
+  int64_t row_size_;
+};
+
+// Writes prod(shape) elements to a new file at path. A shape with no
+// dimensions is stored as {1}.
+template<typename T>
+void save_complex_file(const std::string& path, const c10::complex<T>* data, const std::vector<int64_t>& shape) {
+  int64_t rows = 1;
+  std::vector<int64_t> row_shape;
+  if (!shape.empty()) {
+    rows = shape[0];
+    row_shape.assign(shape.begin() + 1, shape.end());
+  }
+  if (rows < 0) {
+    throw std::invalid_argument("c10::save_complex_file: negative dimension");
+  }
+  complex_file_writer<T> w(path, row_shape);
+  int64_t row_size = 1;
+  for (int64_t d : row_shape) {
+    row_size *= d;
+  }
+  w.append(data, rows * row_size);
+  w.close();
+}
+
+// A complex file mapped read-only, see [Complex files]
+template<typename T>
+class mapped_complex_file {
+ public:
+  using value_type = c10::complex<T>;
+
+  explicit mapped_complex_file(const std::string& path) {
+    const char* function = "c10::mapped_complex_file";
+    header_ = read_complex_file_header(path);
+    if (header_.dtype != complex_dtype_of<T>::value) {
+      detail::complex_file_error(function, path, "dtype does not match");
+    }
+    if (header_.little_endian != detail::host_little_endian()) {
+      detail::complex_file_error(function, path, "byte order does not match the host, use c10::load_complex_file");
+    }
+    file_ = detail::mapped_file(path, function);
+    const int64_t bytes = header_.numel() * sizeof(value_type);
+    if (static_cast<int64_t>(file_.size()) < header_.data_offset + bytes) {
+      detail::complex_file_error(function, path, "truncated data");
+    }
+    if (bytes > 0) {
+      data_ = reinterpret_cast<const value_type*>(file_.data() + header_.data_offset);
+    }
+  }
+
+  const value_type* data() const {
+    return data_;
+  }
+  int64_t size() const {
+    return data_ == nullptr ? 0 : header_.numel();
+  }
+  const std::vector<int64_t>& shape() const {
+    return header_.shape;
+  }
+  const complex_file_header& header() const {
+    return header_;
+  }
+  const value_type* begin() const {
+    return data();
+  }
+  const value_type* end() const {
+    return data() + size();
+  }
+  const value_type& operator[](int64_t i) const {
+    return data_[i];
+  }
+
+ private:
+  detail::mapped_file file_;
+  complex_file_header header_;
+  const value_type* data_ = nullptr;
+};
+
+// Reads a complex file in chunks, swapping bytes if needed, see
+// [Complex files]
+template<typename T>
+class complex_file_reader {
+ public:
+  using value_type = c10::complex<T>;
+
+  explicit complex_file_reader(const std::string& path)
+    : path_(path), file_(detail::open_file(path, "rb", "c10::complex_file_reader")) {
+    header_ = detail::read_complex_file_header(file_.get(), "c10::complex_file_reader", path);
+    if (header_.dtype != complex_dtype_of<T>::value) {
+      detail::complex_file_error("c10::complex_file_reader", path, "dtype does not match");
+    }
+    remaining_ = header_.numel();
+  }
+
+  // Reads the next min(n, remaining()) elements into out and returns their
+  // number
+  int64_t read(value_type* out, int64_t n) {
+    n = std::min(n, remaining_);
+    if (n <= 0) {
+      return 0;
+    }
+    if (std::fread(out, sizeof(value_type), n, file_.get()) != static_cast<size_t>(n)) {
+      detail::complex_file_error("c10::complex_file_reader", path_, "truncated data");
+    }
+    if (header_.little_endian != detail::host_little_endian()) {
+      detail::swap_bytes(out, 2 * n, sizeof(T));
+    }
+    remaining_ -= n;
+    return n;
+  }
+
+  int64_t read(span<value_type> s) {
+    return read(s.data(), s.size());
+  }
+
+  int64_t remaining() const {
+    return remaining_;
+  }
+  const complex_file_header& header() const {
+    return header_;
+  }
+
+ private:
+  std::string path_;
+  detail::file_ptr file_;
+  complex_file_header header_;
+  int64_t remaining_;
+};
+
+// Reads a whole complex file, and its shape if shape is not null
+template<typename T>
+complex_buffer<T> load_complex_file(const std::string& path, std::vector<int64_t>* shape = nullptr) {
+  complex_file_reader<T> r(path);
+  complex_buffer<T> result(r.remaining());
+  r.read(result.data(), result.size());
+  if (shape != nullptr) {
+    *shape = r.header().shape;
+  }
+  return result;
+}
+
+} // namespace c10
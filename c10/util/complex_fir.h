@@ -0,0 +1,525 @@
+#pragma once
+
+#include <c10/util/complex.h>
+#include <c10/util/complex_bulk.h>
+#include <c10/util/complex_span.h>
+#include <c10/util/complex_vec_math.h>
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <stdexcept>
+#include <type_traits>
+#include <vector>
+
+// FIR filters, decimators, interpolators and resamplers for streams of
+// c10::complex
+//
+// [FIR filters]
+//
+// The classes below filter c10::complex<T> streams, T float or double, with
+// taps of type Tap, either T or c10::complex<T>:
+//
+//   c10::fir_filter<T, Tap> f(taps);                  // y[i] = sum_k h[k] x[i - k]
+//   c10::fir_decimator<T, Tap> d(taps, M);            // y[j] = (h * x)[j M]
+//   c10::fir_interpolator<T, Tap> u(taps, L);         // y = h * (x upsampled by L)
+//   c10::rational_resampler<T, Tap> r(L, M, taps);    // y[j] = (h * (x upsampled by L))[j M]
+//
+// Each is a stream: filter() takes the next chunk of input and carries the
+// inputs the next outputs still need, so filtering a signal in chunks of
+// any size gives the same outputs as filtering it at once. The inputs
+// before the first are zero; reset() starts again. The number of outputs of
+// a chunk of n inputs is n for fir_filter, n L for fir_interpolator and
+// output_size(n) for the others, which only compute the outputs that are
+// kept. Upsampling inserts zeros, so interpolators and resamplers have the
+// gain of the taps at DC divided by L; c10::fir_lowpass designs taps with a
+// given gain.
+//
+// Interpolators and resamplers are polyphase: the taps are split into L
+// phases h[p], h[p + L], h[p + 2 L], ..., and an output of phase p only
+// multiplies the inputs by the taps of its phase.
+//
+// The taps are stored reversed, so each output is an inner product of the
+// taps with contiguous inputs. Runs of outputs at consecutive inputs, in
+// fir_filter and in each phase of fir_interpolator, are computed a few
+// vector registers at a time: each tap is broadcast and multiplied with the
+// parts of all of them, so the accumulators stay in registers and need no
+// shuffles. The other outputs are inner products with
+// vec_math::lanes<T>::value partial sums like c10::bulk::dot. Products are
+// fused like in c10::bulk::dot, see [Bulk multiply-add] in
+// c10/util/complex_bulk.h.
+
+namespace c10 {
+namespace detail {
+
+template<typename T, typename Tap>
+struct check_fir_types {
+  static_assert(std::is_same<T, float>::value || std::is_same<T, double>::value,
+    "FIR filters only support c10::complex<float> and c10::complex<double> data");
+  static_assert(std::is_same<Tap, T>::value || std::is_same<Tap, complex<T>>::value,
+    "FIR filters only support taps of type T or c10::complex<T>");
+};
+
+// Inputs copied into the history of a filter at once
+constexpr int64_t fir_chunk = 4096;
+
+// Bytes of the vector registers of the target
+#if defined(__AVX512F__)
+constexpr int fir_vector_bytes = 64;
+#elif defined(__AVX__)
+constexpr int fir_vector_bytes = 32;
+#else
+constexpr int fir_vector_bytes = 16;
+#endif
+
+// The taps of a filter, reversed, in the layout of the kernels: real taps
+// twice each, so that they line up with the parts of the inputs
+template<typename T, typename Tap>
+struct fir_taps;
+
+template<typename T>
+struct fir_taps<T, T> {
+  std::vector<T> h;  // h[2 k] = h[2 k + 1] = taps[n - 1 - k]
+  int64_t n = 0;
+
+  fir_taps() = default;
+  fir_taps(const T* taps, int64_t count): h(2 * count), n(count) {
+    for (int64_t k = 0; k < n; k++) {
+      h[2 * k] = h[2 * k + 1] = taps[n - 1 - k];
+    }
+  }
+
+  // sum_k taps[n - 1 - k] x[k]
+  complex<T> dot(const complex<T>* x) const {
+    constexpr int W = vec_math::lanes<T>::value;
+    const T* p = reinterpret_cast<const T*>(x);
+    const T* q = h.data();
+    T sum[W] = {};
+    int64_t j = 0;
+    for (; j + W <= 2 * n; j += W) {
+      C10_VEC_LOOP
+      for (int l = 0; l < W; l++) {
+        sum[l] = vec_math::fma(q[j + l], p[j + l], sum[l]);
+      }
+    }
+    for (int l = 0; j + l < 2 * n; l++) {
+      sum[l] = vec_math::fma(q[j + l], p[j + l], sum[l]);
+    }
+    T re = 0, im = 0;
+    for (int l = 0; l < W; l += 2) {
+      re += sum[l];
+      im += sum[l + 1];
+    }
+    return complex<T>(re, im);
+  }
+
+  // out[i out_stride] = dot(x + i) for i in [0, count)
+  void block(const complex<T>* x, int64_t count, complex<T>* out, int64_t out_stride) const {
+    // 4 vectors of parts of outputs computed at once, one tap at a time
+    constexpr int V = fir_vector_bytes / sizeof(T);
+    constexpr int B = 2 * V;
+    int64_t i = 0;
+    for (; i + B <= count; i += B) {
+      const T* p = reinterpret_cast<const T*>(x + i);
+      T acc0[V] = {}, acc1[V] = {}, acc2[V] = {}, acc3[V] = {};
+      for (int64_t k = 0; k < n; k++) {
+        const T hk = h[2 * k];
+        const T* pk = p + 2 * k;
+        C10_VEC_LOOP
+        for (int l = 0; l < V; l++) {
+          acc0[l] = vec_math::fma(hk, pk[l], acc0[l]);
+        }
+        C10_VEC_LOOP
+        for (int l = 0; l < V; l++) {
+          acc1[l] = vec_math::fma(hk, pk[V + l], acc1[l]);
+        }
+        C10_VEC_LOOP
+        for (int l = 0; l < V; l++) {
+          acc2[l] = vec_math::fma(hk, pk[2 * V + l], acc2[l]);
+        }
+        C10_VEC_LOOP
+        for (int l = 0; l < V; l++) {
+          acc3[l] = vec_math::fma(hk, pk[3 * V + l], acc3[l]);
+        }
+      }
+      const T* acc[4] = {acc0, acc1, acc2, acc3};
+      for (int b = 0; b < B; b++) {
+        const T* a = acc[2 * b / V] + 2 * b % V;
+        out[(i + b) * out_stride] = complex<T>(a[0], a[1]);
+      }
+    }
+    for (; i < count; i++) {
+      out[i * out_stride] = dot(x + i);
+    }
+  }
+};
+
+template<typename T>
+struct fir_taps<T, complex<T>> {
+  std::vector<complex<T>> h;  // h[k] = taps[n - 1 - k]
+  int64_t n = 0;
+
+  fir_taps() = default;
+  fir_taps(const complex<T>* taps, int64_t count): h(taps, taps + count), n(count) {
+    std::reverse(h.begin(), h.end());
+  }
+
+  complex<T> dot(const complex<T>* x) const {
+    return c10::bulk::detail::dot<false>(h.data(), x, n);
+  }
+
+  void block(const complex<T>* x, int64_t count, complex<T>* out, int64_t out_stride) const {
+    // 2 vectors of parts of outputs computed at once, one tap at a time,
+    // each multiplied by the real and by the imaginary part of the tap
+    constexpr int V = fir_vector_bytes / sizeof(T);
+    constexpr int B = V;
+    int64_t i = 0;
+    for (; i + B <= count; i += B) {
+      const T* p = reinterpret_cast<const T*>(x + i);
+      T re0[V] = {}, im0[V] = {}, re1[V] = {}, im1[V] = {};
+      for (int64_t k = 0; k < n; k++) {
+        const T hr = h[k].real(), hi = h[k].imag();
+        const T* pk = p + 2 * k;
+        C10_VEC_LOOP
+        for (int l = 0; l < V; l++) {
+          re0[l] = vec_math::fma(hr, pk[l], re0[l]);
+          im0[l] = vec_math::fma(hi, pk[l], im0[l]);
+        }
+        C10_VEC_LOOP
+        for (int l = 0; l < V; l++) {
+          re1[l] = vec_math::fma(hr, pk[V + l], re1[l]);
+          im1[l] = vec_math::fma(hi, pk[V + l], im1[l]);
+        }
+      }
+      // re: re(h) re(x), re(h) im(x); im: im(h) re(x), im(h) im(x)
+      for (int b = 0; b < B; b++) {
+        const T* r = (2 * b < V ? re0 : re1) + 2 * b % V;
+        const T* m = (2 * b < V ? im0 : im1) + 2 * b % V;
+        out[(i + b) * out_stride] = complex<T>(r[0] - m[1], r[1] + m[0]);
+      }
+    }
+    for (; i < count; i++) {
+      out[i * out_stride] = dot(x + i);
+    }
+  }
+};
+
+// The last inputs of a stream, followed by the chunk being filtered
+template<typename T>
+class fir_history {
+ public:
+  fir_history() = default;
+  explicit fir_history(int64_t length): length_(length), buffer_(length + fir_chunk) {}
+
+  // Appends x[0, n), n <= fir_chunk, after the history
+  const complex<T>* push(const complex<T>* x, int64_t n) {
+    std::copy(x, x + n, buffer_.begin() + length_);
+    return buffer_.data();
+  }
+
+  // Keeps the last length inputs, after a chunk of n
+  void pop(int64_t n) {
+    std::copy(buffer_.begin() + n, buffer_.begin() + n + length_, buffer_.begin());
+  }
+
+  void reset() {
+    std::fill(buffer_.begin(), buffer_.begin() + length_, complex<T>(0, 0));
+  }
+
+ private:
+  int64_t length_ = 0;
+  std::vector<complex<T>> buffer_;
+};
+
+inline void check_fir_factor(int64_t factor, const char* function) {
+  if (factor <= 0) {
+    throw std::invalid_argument(std::string(function) + ": the factor must be positive");
+  }
+}
+
+template<typename Tap>
+void check_fir_taps(span<const Tap> taps, const char* function) {
+  if (taps.size() == 0) {
+    throw std::invalid_argument(std::string(function) + ": no taps");
+  }
+}
+
+// The taps of the L phases of a polyphase filter, each padded to the same
+// length with zeros
+template<typename T, typename Tap>
+std::vector<fir_taps<T, Tap>> fir_phases(span<const Tap> taps, int64_t L) {
+  const int64_t length = (taps.size() + L - 1) / L;
+  std::vector<fir_taps<T, Tap>> phases;
+  std::vector<Tap> phase(length);
+  for (int64_t p = 0; p < L; p++) {
+    for (int64_t q = 0; q < length; q++) {
+      phase[q] = p + q * L < taps.size() ? taps[p + q * L] : Tap(0);
+    }
+    phases.emplace_back(phase.data(), length);
+  }
+  return phases;
+}
+
+} // namespace detail
+
+// Taps of a lowpass filter with the given cutoff, in cycles per sample, at
+// most 0.5, and gain at DC: a sinc windowed by a Hamming window
+template<typename T>
+std::vector<T> fir_lowpass(int64_t num_taps, double cutoff, double gain = 1) {
+  if (num_taps <= 0 || !(cutoff > 0 && cutoff <= 0.5)) {
+    throw std::invalid_argument("c10::fir_lowpass: num_taps must be positive and cutoff in (0, 0.5]");
+  }
+  const double pi = 3.14159265358979323846;
+  std::vector<double> h(num_taps);
+  double sum = 0;
+  for (int64_t k = 0; k < num_taps; k++) {
+    const double t = k - (num_taps - 1) / 2.0;
+    const double sinc = t == 0 ? 2 * cutoff : std::sin(2 * pi * cutoff * t) / (pi * t);
+    const double window = num_taps == 1 ? 1 : 0.54 - 0.46 * std::cos(2 * pi * k / (num_taps - 1));
+    h[k] = sinc * window;
+    sum += h[k];
+  }
+  std::vector<T> taps(num_taps);
+  for (int64_t k = 0; k < num_taps; k++) {
+    taps[k] = static_cast<T>(h[k] * gain / sum);
+  }
+  return taps;
+}
+
+// y[i] = sum_k taps[k] x[i - k], see [FIR filters]
+template<typename T, typename Tap = T>
+class fir_filter {
+ public:
+  using value_type = complex<T>;
+  using tap_type = Tap;
+
+  fir_filter() = default;
+  explicit fir_filter(span<const Tap> taps) {
+    detail::check_fir_types<T, Tap>();
+    detail::check_fir_taps(taps, "c10::fir_filter");
+    taps_ = detail::fir_taps<T, Tap>(taps.data(), taps.size());
+    history_ = detail::fir_history<T>(taps.size() - 1);
+  }
+
+  // Filters the next n inputs into out[0, n). out may be x.
+  void filter(const value_type* x, value_type* out, int64_t n) {
+    for (int64_t i = 0; i < n; i += detail::fir_chunk) {
+      const int64_t count = std::min(detail::fir_chunk, n - i);
+      taps_.block(history_.push(x + i, count), count, out + i, 1);
+      history_.pop(count);
+    }
+  }
+
+  void filter(span<const value_type> x, span<value_type> out) {
+    filter(x.data(), out.data(), std::min(x.size(), out.size()));
+  }
+
+  void reset() {
+    history_.reset();
+  }
+
+  int64_t num_taps() const {
+    return taps_.n;
+  }
+
+ private:
+  detail::fir_taps<T, Tap> taps_;
+  detail::fir_history<T> history_;
+};
+
+// y[j] = sum_k taps[k] x[j factor - k], see [FIR filters]
+template<typename T, typename Tap = T>
+class fir_decimator {
+ public:
+  using value_type = complex<T>;
+  using tap_type = Tap;
+
+  fir_decimator() = default;
+  fir_decimator(span<const Tap> taps, int64_t factor): factor_(factor) {
+    detail::check_fir_types<T, Tap>();
+    detail::check_fir_taps(taps, "c10::fir_decimator");
+    detail::check_fir_factor(factor, "c10::fir_decimator");
+    taps_ = detail::fir_taps<T, Tap>(taps.data(), taps.size());
+    history_ = detail::fir_history<T>(taps.size() - 1);
+  }
+
+  // Number of outputs of the next n inputs
+  int64_t output_size(int64_t n) const {
+    return n > next_ ? (n - next_ + factor_ - 1) / factor_ : 0;
+  }
+
+  // Filters the next n inputs into out[0, output_size(n)) and returns the
+  // number of outputs
+  int64_t filter(const value_type* x, value_type* out, int64_t n) {
+    int64_t count = 0;
+    for (int64_t i = 0; i < n; i += detail::fir_chunk) {
+      const int64_t size = std::min(detail::fir_chunk, n - i);
+      const value_type* chunk = history_.push(x + i, size);
+      for (; next_ < size; next_ += factor_) {
+        out[count++] = taps_.dot(chunk + next_);
+      }
+      next_ -= size;
+      history_.pop(size);
+    }
+    return count;
+  }
+
+  void reset() {
+    history_.reset();
+    next_ = 0;
+  }
+
+  int64_t num_taps() const {
+    return taps_.n;
+  }
+  int64_t factor() const {
+    return factor_;
+  }
+
+ private:
+  detail::fir_taps<T, Tap> taps_;
+  detail::fir_history<T> history_;
+  int64_t factor_ = 1;
+  int64_t next_ = 0;  // input of the next output, from the next chunk
+};
+
+// y = taps * (x upsampled by factor), see [FIR filters]
+template<typename T, typename Tap = T>
+class fir_interpolator {
+ public:
+  using value_type = complex<T>;
+  using tap_type = Tap;
+
+  fir_interpolator() = default;
+  fir_interpolator(span<const Tap> taps, int64_t factor)
+    : factor_(factor), num_taps_(taps.size()) {
+    detail::check_fir_types<T, Tap>();
+    detail::check_fir_taps(taps, "c10::fir_interpolator");
+    detail::check_fir_factor(factor, "c10::fir_interpolator");
+    phases_ = detail::fir_phases<T, Tap>(taps, factor);
+    history_ = detail::fir_history<T>(phases_[0].n - 1);
+  }
+
+  // Filters the next n inputs into out[0, n factor)
+  void filter(const value_type* x, value_type* out, int64_t n) {
+    for (int64_t i = 0; i < n; i += detail::fir_chunk) {
+      const int64_t count = std::min(detail::fir_chunk, n - i);
+      const value_type* chunk = history_.push(x + i, count);
+      for (int64_t p = 0; p < factor_; p++) {
+        phases_[p].block(chunk, count, out + i * factor_ + p, factor_);
+      }
+      history_.pop(count);
+    }
+  }
+
+  void reset() {
+    history_.reset();
+  }
+
+  int64_t num_taps() const {
+    return num_taps_;
+  }
+  int64_t factor() const {
+    return factor_;
+  }
+
+ private:
+  std::vector<detail::fir_taps<T, Tap>> phases_;
+  detail::fir_history<T> history_;
+  int64_t factor_ = 1;
+  int64_t num_taps_ = 0;
+};
+
+// Resampling by up / down: y[j] = (taps * (x upsampled by up))[j down], see
+// [FIR filters]. up and down are divided by their greatest common divisor.
+template<typename T, typename Tap = T>
+class rational_resampler {
+ public:
+  using value_type = complex<T>;
+  using tap_type = Tap;
+
+  rational_resampler() = default;
+  rational_resampler(int64_t up, int64_t down, span<const Tap> taps) {
+    detail::check_fir_taps(taps, "c10::rational_resampler");
+    init(up, down, taps);
+  }
+
+  // With taps from fir_lowpass: 20 per phase, a cutoff at the lower of the
+  // two Nyquist frequencies and a gain of up
+  rational_resampler(int64_t up, int64_t down) {
+    detail::check_fir_factor(up, "c10::rational_resampler");
+    detail::check_fir_factor(down, "c10::rational_resampler");
+    const int64_t g = gcd(up, down);
+    const int64_t m = std::max(up, down) / g;
+    const std::vector<T> h = fir_lowpass<T>(20 * m + 1, 0.5 / m, static_cast<double>(up / g));
+    std::vector<Tap> taps(h.begin(), h.end());
+    init(up, down, taps);
+  }
+
+  // Number of outputs of the next n inputs
+  int64_t output_size(int64_t n) const {
+    return n * up_ > next_ ? (n * up_ - next_ + down_ - 1) / down_ : 0;
+  }
+
+  // Resamples the next n inputs into out[0, output_size(n)) and returns the
+  // number of outputs
+  int64_t filter(const value_type* x, value_type* out, int64_t n) {
+    int64_t count = 0;
+    for (int64_t i = 0; i < n; i += detail::fir_chunk) {
+      const int64_t size = std::min(detail::fir_chunk, n - i);
+      const value_type* chunk = history_.push(x + i, size);
+      for (; next_ < size * up_; next_ += down_) {
+        out[count++] = phases_[next_ % up_].dot(chunk + next_ / up_);
+      }
+      next_ -= size * up_;
+      history_.pop(size);
+    }
+    return count;
+  }
+
+  void reset() {
+    history_.reset();
+    next_ = 0;
+  }
+
+  int64_t up() const {
+    return up_;
+  }
+  int64_t down() const {
+    return down_;
+  }
+  int64_t num_taps() const {
+    return num_taps_;
+  }
+
+ private:
+  static int64_t gcd(int64_t a, int64_t b) {
+    while (b != 0) {
+      const int64_t r = a % b;
+      a = b;
+      b = r;
+    }
+    return a;
+  }
+
+  void init(int64_t up, int64_t down, span<const Tap> taps) {
+    detail::check_fir_types<T, Tap>();
+    detail::check_fir_factor(up, "c10::rational_resampler");
+    detail::check_fir_factor(down, "c10::rational_resampler");
+    const int64_t g = gcd(up, down);
+    up_ = up / g;
+    down_ = down / g;
+    num_taps_ = taps.size();
+    phases_ = detail::fir_phases<T, Tap>(taps, up_);
+    history_ = detail::fir_history<T>(phases_[0].n - 1);
+  }
+
+  std::vector<detail::fir_taps<T, Tap>> phases_;
+  detail::fir_history<T> history_;
+  int64_t up_ = 1;
+  int64_t down_ = 1;
+  int64_t num_taps_ = 0;
+  int64_t next_ = 0;  // upsampled input of the next output, from the next chunk
+};
+
+} // namespace c10
@@ -0,0 +1,430 @@
+#pragma once
+
+#include <c10/util/complex.h>
+#include <c10/util/complex_int.h>
+#include <c10/util/complex_vec_math.h>
+
+#include <cmath>
+#include <cstdint>
+#include <limits>
+#include <type_traits>
+
+#if defined(__SSSE3__)
+#include <tmmintrin.h>
+#elif defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+#if defined(__AVX2__)
+#include <immintrin.h>
+#endif
+
+// Fixed point real numbers in Q format, and complex numbers of them
+//
+// [Fixed point]
+//
+// c10::fixed<Raw, F> is the real number raw / 2^F for a signed integer raw
+// of type Raw, i.e. the Q format with F fraction bits. c10::q15 and c10::q31
+// are the usual formats of DSP front ends, with values in [-1, 1):
+//
+//   c10::q15 a(0.5), b(-0.25);        // from float or double, rounded and saturated
+//   c10::q15 c = a * b;               // rounded and saturated, -0.125
+//   float f = static_cast<float>(c);
+//   c10::complex<c10::q15> z(a, b);   // a complex_common like the others
+//
+// Arithmetic between numbers of the same format saturates: + and - to the
+// range of Raw, * rounds the product to F fraction bits (ties upward) before
+// saturating, and / rounds toward zero. Only the product -1 * -1 of q15 and
+// q31 saturates, to the largest value below 1. The operators of
+// complex<fixed<Raw, F>> are those of complex_common built from these, so
+// each product of a complex multiplication is rounded before the sum.
+//
+// Formats are tracked by the type: operands of different formats do not
+// mix, except that a format converts implicitly, and exactly, to the
+// formats with the same F and a wider Raw. wide_mul returns the exact
+// product in the format of the product, fixed<wider Raw, F1 + F2> (q15 *
+// q15 is fixed<int32_t, 30>, q31 * q31 is fixed<int64_t, 62>). For complex
+// numbers the sums of the products are in that format too, so only the
+// imaginary part of (-1 - i)^2 saturates. Products are summed in a wide
+// accumulator like the 40 bit accumulators of DSPs, which they widen to,
+// and fixed_cast converts the result back, rounding when it drops fraction
+// bits and saturating:
+//
+//   c10::fixed<int64_t, 30> acc;
+//   for (...) acc += c10::wide_mul(x[i], h[i]);   // exact, complex too
+//   c10::q15 y = c10::fixed_cast<c10::q15>(acc);
+//
+// The bulk kernels work on arrays of complex<q15> and complex<q31>:
+//
+//   c10::bulk::mul(x, y, out, n);       // out[i] = x[i] * y[i], like operator*
+//   c10::bulk::dot_wide(x, y, n);       // sum of x[i] * y[i], exact
+//   c10::bulk::convert_fixed(x, out, n);  // complex<float> <-> fixed point
+//
+// For q15, mul runs on 16 bit lanes with pmulhrsw (SSSE3, or AVX2 for 8
+// complex numbers per instruction), twice the lanes of complex<float>. Its
+// results equal operator* of complex<q15> bit for bit: pmulhrsw rounds like
+// operator* of q15, and its one overflow, -1 * -1, is saturated. With only
+// SSE2, pmulhrsw is emulated with pmulhw and pmullw, and other targets run
+// a scalar loop that computes the same. For q31, mul is mul_shift of
+// c10/util/complex_int.h with a shift of 31, which rounds once after the
+// sum and so can differ from operator* in the last bit. dot_wide, for q15,
+// sums the exact products in 64 bit lanes and returns them as
+// fixed<int64_t, 30>, which cannot overflow for fewer than 2^32 terms.
+
+namespace c10 {
+
+namespace detail {
+
+template<typename Raw>
+struct fixed_wide {
+  using type = void;
+};
+template<>
+struct fixed_wide<int8_t> {
+  using type = int16_t;
+};
+template<>
+struct fixed_wide<int16_t> {
+  using type = int32_t;
+};
+template<>
+struct fixed_wide<int32_t> {
+  using type = int64_t;
+};
+
+template<typename Raw, typename W>
+constexpr Raw fixed_saturate(W x) {
+  return x < W(std::numeric_limits<Raw>::min()) ? std::numeric_limits<Raw>::min()
+    : (x > W(std::numeric_limits<Raw>::max()) ? std::numeric_limits<Raw>::max() : static_cast<Raw>(x));
+}
+
+template<typename Raw>
+constexpr Raw fixed_add(Raw a, Raw b) {
+  using U = typename std::make_unsigned<Raw>::type;
+  // wraps in unsigned arithmetic, then saturates if the sign is wrong
+  return ((a ^ static_cast<Raw>(static_cast<U>(a) + static_cast<U>(b))) & (b ^ static_cast<Raw>(static_cast<U>(a) + static_cast<U>(b)))) < 0
+    ? (a < 0 ? std::numeric_limits<Raw>::min() : std::numeric_limits<Raw>::max())
+    : static_cast<Raw>(static_cast<U>(a) + static_cast<U>(b));
+}
+
+template<typename Raw>
+constexpr Raw fixed_sub(Raw a, Raw b) {
+  using U = typename std::make_unsigned<Raw>::type;
+  return ((a ^ b) & (a ^ static_cast<Raw>(static_cast<U>(a) - static_cast<U>(b)))) < 0
+    ? (a < 0 ? std::numeric_limits<Raw>::min() : std::numeric_limits<Raw>::max())
+    : static_cast<Raw>(static_cast<U>(a) - static_cast<U>(b));
+}
+
+// x / 2^shift rounded to nearest, ties upward, for shift >= 0
+template<typename W>
+constexpr W fixed_round_shift(W x, int shift) {
+  return shift == 0 ? x : static_cast<W>((x >> shift) + ((x >> (shift - 1)) & 1));
+}
+
+// 2^F, shifted unsigned since 2^63 does not fit in int64_t
+template<int F>
+constexpr double fixed_scale() {
+  return static_cast<double>(uint64_t(1) << F);
+}
+
+// raw value of x * 2^F rounded to nearest and saturated, 0 for NaN
+template<typename Raw, int F>
+constexpr Raw fixed_from_double(double x) {
+  const double v = x * fixed_scale<F>() + 0.5;
+  if (!(v == v)) {
+    return 0;
+  }
+  if (v >= -static_cast<double>(std::numeric_limits<Raw>::min())) {
+    return std::numeric_limits<Raw>::max();
+  }
+  if (v <= static_cast<double>(std::numeric_limits<Raw>::min())) {
+    return std::numeric_limits<Raw>::min();
+  }
+  // floor, converting truncates toward zero
+  const int64_t t = static_cast<int64_t>(v);
+  return static_cast<Raw>(t - (static_cast<double>(t) > v));
+}
+
+} // namespace detail
+
+template<typename Raw, int F>
+struct fixed {
+  static_assert(std::is_integral<Raw>::value && std::is_signed<Raw>::value, "c10::fixed needs a signed integer type");
+  static_assert(F >= 0 && F < static_cast<int>(sizeof(Raw) * 8), "c10::fixed needs 0 <= F < bits of Raw");
+  using raw_type = Raw;
+  static constexpr int fraction_bits = F;
+
+  Raw raw;
+
+  constexpr fixed(): raw(0) {}
+  explicit constexpr fixed(double x): raw(detail::fixed_from_double<Raw, F>(x)) {}
+  explicit constexpr fixed(float x): fixed(static_cast<double>(x)) {}
+  explicit constexpr fixed(int x): fixed(static_cast<double>(x)) {}
+  // from a narrower Raw with the same fraction bits, exactly
+  template<typename Narrow, typename = typename std::enable_if<(sizeof(Narrow) < sizeof(Raw))>::type>
+  constexpr fixed(fixed<Narrow, F> x): raw(x.raw) {}
+
+  static constexpr fixed from_raw(Raw r) {
+    fixed result;
+    result.raw = r;
+    return result;
+  }
+
+  explicit constexpr operator double() const {
+    return static_cast<double>(raw) / detail::fixed_scale<F>();
+  }
+  explicit constexpr operator float() const {
+    return static_cast<float>(static_cast<double>(*this));
+  }
+
+  constexpr fixed& operator+=(fixed other) {
+    raw = detail::fixed_add(raw, other.raw);
+    return *this;
+  }
+  constexpr fixed& operator-=(fixed other) {
+    raw = detail::fixed_sub(raw, other.raw);
+    return *this;
+  }
+  constexpr fixed& operator*=(fixed other) {
+    using W = typename detail::fixed_wide<Raw>::type;
+    static_assert(!std::is_void<W>::value, "c10::fixed multiplication needs a wider integer type, use wide_mul");
+    raw = detail::fixed_saturate<Raw>(detail::fixed_round_shift(static_cast<W>(static_cast<W>(raw) * other.raw), F));
+    return *this;
+  }
+  constexpr fixed& operator/=(fixed other) {
+    using W = typename detail::fixed_wide<Raw>::type;
+    static_assert(!std::is_void<W>::value, "c10::fixed division needs a wider integer type");
+    raw = other.raw == 0 ? (raw < 0 ? std::numeric_limits<Raw>::min() : std::numeric_limits<Raw>::max())
+      : detail::fixed_saturate<Raw>(static_cast<W>(static_cast<W>(raw) * (W(1) << F)) / other.raw);
+    return *this;
+  }
+};
+
+using q15 = fixed<int16_t, 15>;
+using q31 = fixed<int32_t, 31>;
+
+template<typename Raw, int F>
+constexpr fixed<Raw, F> operator+(fixed<Raw, F> a, fixed<Raw, F> b) {
+  return a += b;
+}
+template<typename Raw, int F>
+constexpr fixed<Raw, F> operator-(fixed<Raw, F> a, fixed<Raw, F> b) {
+  return a -= b;
+}
+template<typename Raw, int F>
+constexpr fixed<Raw, F> operator-(fixed<Raw, F> a) {
+  return fixed<Raw, F>() - a;
+}
+template<typename Raw, int F>
+constexpr fixed<Raw, F> operator*(fixed<Raw, F> a, fixed<Raw, F> b) {
+  return a *= b;
+}
+template<typename Raw, int F>
+constexpr fixed<Raw, F> operator/(fixed<Raw, F> a, fixed<Raw, F> b) {
+  return a /= b;
+}
+template<typename Raw, int F>
+constexpr bool operator==(fixed<Raw, F> a, fixed<Raw, F> b) {
+  return a.raw == b.raw;
+}
+template<typename Raw, int F>
+constexpr bool operator!=(fixed<Raw, F> a, fixed<Raw, F> b) {
+  return a.raw != b.raw;
+}
+template<typename Raw, int F>
+constexpr bool operator<(fixed<Raw, F> a, fixed<Raw, F> b) {
+  return a.raw < b.raw;
+}
+
+template<typename Raw, int F>
+struct alignas(sizeof(Raw) * 2) complex<fixed<Raw, F>>: public complex_common<fixed<Raw, F>> {
+  using complex_common<fixed<Raw, F>>::complex_common;
+  constexpr complex(): complex_common<fixed<Raw, F>>() {};
+};
+
+// Exact product in the format of the product, see [Fixed point]
+template<typename Raw, int F, typename RawB, int G>
+constexpr fixed<typename detail::fixed_wide<typename std::conditional<(sizeof(Raw) > sizeof(RawB)), Raw, RawB>::type>::type, F + G>
+wide_mul(fixed<Raw, F> a, fixed<RawB, G> b) {
+  using W = typename detail::fixed_wide<typename std::conditional<(sizeof(Raw) > sizeof(RawB)), Raw, RawB>::type>::type;
+  return fixed<W, F + G>::from_raw(static_cast<W>(static_cast<W>(a.raw) * b.raw));
+}
+
+template<typename Raw, int F, typename RawB, int G>
+constexpr auto wide_mul(const complex<fixed<Raw, F>>& a, const complex<fixed<RawB, G>>& b) -> complex<decltype(wide_mul(a.real(), b.real()))> {
+  return complex<decltype(wide_mul(a.real(), b.real()))>(
+    wide_mul(a.real(), b.real()) - wide_mul(a.imag(), b.imag()),
+    wide_mul(a.real(), b.imag()) + wide_mul(a.imag(), b.real()));
+}
+
+// x in the format To, rounded to nearest (ties upward) when it drops
+// fraction bits and saturated, see [Fixed point]
+template<typename To, typename Raw, int F>
+constexpr To fixed_cast(fixed<Raw, F> x) {
+  using R = typename To::raw_type;
+  using W = typename std::conditional<(sizeof(R) > sizeof(Raw)), R, Raw>::type;
+  // shifting left by To::fraction_bits - F saturates like a multiplication
+  return To::from_raw(To::fraction_bits <= F
+    ? detail::fixed_saturate<R>(detail::fixed_round_shift(static_cast<W>(x.raw), F - To::fraction_bits))
+    : (static_cast<W>(x.raw) > (std::numeric_limits<W>::max() >> (To::fraction_bits - F)) ? std::numeric_limits<R>::max()
+      : (static_cast<W>(x.raw) < (std::numeric_limits<W>::min() >> (To::fraction_bits - F)) ? std::numeric_limits<R>::min()
+      : detail::fixed_saturate<R>(static_cast<W>(static_cast<typename std::make_unsigned<W>::type>(x.raw) << (To::fraction_bits - F))))));
+}
+
+template<typename To, typename Raw, int F>
+constexpr complex<To> fixed_cast(const complex<fixed<Raw, F>>& x) {
+  return complex<To>(fixed_cast<To>(x.real()), fixed_cast<To>(x.imag()));
+}
+
+namespace bulk {
+namespace detail {
+
+template<typename T>
+struct check_fixed_type {
+  static_assert(std::is_same<T, q15>::value || std::is_same<T, q31>::value,
+    "fixed point kernels only support c10::complex<c10::q15> and c10::complex<c10::q31>");
+};
+
+// pmulhrsw of one lane, saturated: round(a * b / 2^15)
+C10_VEC_INLINE int16_t mulhrs(int16_t a, int16_t b) {
+  const int32_t p = (int32_t(a) * b + (1 << 14)) >> 15;
+  return static_cast<int16_t>(p > 32767 ? 32767 : p);
+}
+
+C10_VEC_INLINE int16_t adds(int32_t a, int32_t b) {
+  return saturate<int16_t>(a + b);
+}
+
+inline void mul_q15_parts(const int16_t* x, const int16_t* y, int16_t* out, int64_t n) {
+  C10_VEC_LOOP
+  for (int64_t i = 0; i < n; i++) {
+    const int16_t a = x[2 * i], b = x[2 * i + 1];
+    const int16_t c = y[2 * i], d = y[2 * i + 1];
+    out[2 * i] = adds(mulhrs(a, c), -mulhrs(b, d));
+    out[2 * i + 1] = adds(mulhrs(a, d), mulhrs(b, c));
+  }
+}
+
+#if defined(__SSE2__)
+// pmulhrsw, from the high and low halves of the products without SSSE3:
+// (hi * 2^16 + lo + 2^14) >> 15 = 2 hi + (lo >> 15) + ((lo & 0x7fff) + 2^14) >> 15
+inline __m128i mulhrs_epi16(__m128i x, __m128i y) {
+#if defined(__SSSE3__)
+  return _mm_mulhrs_epi16(x, y);
+#else
+  const __m128i hi = _mm_mulhi_epi16(x, y);
+  const __m128i lo = _mm_mullo_epi16(x, y);
+  const __m128i low_bits = _mm_add_epi16(_mm_and_si128(lo, _mm_set1_epi16(0x7fff)), _mm_set1_epi16(0x4000));
+  const __m128i carry = _mm_add_epi16(_mm_srli_epi16(lo, 15), _mm_srli_epi16(low_bits, 15));
+  return _mm_add_epi16(_mm_add_epi16(hi, hi), carry);
+#endif
+}
+
+// swaps the 16 bit halves of each 32 bit lane
+inline __m128i swap_pairs_epi16(__m128i x) {
+#if defined(__SSSE3__)
+  return _mm_shuffle_epi8(x, _mm_setr_epi8(2, 3, 0, 1, 6, 7, 4, 5, 10, 11, 8, 9, 14, 15, 12, 13));
+#else
+  return _mm_shufflehi_epi16(_mm_shufflelo_epi16(x, 0xb1), 0xb1);
+#endif
+}
+
+// 4 products of interleaved complex<q15>, see mul_q15_parts
+inline __m128i mul_q15_sse(__m128i x, __m128i y) {
+  const __m128i overflow = _mm_set1_epi16(std::numeric_limits<int16_t>::min());
+  // the real part in the low half of each 32 bit pair
+  const __m128i real_lanes = _mm_set1_epi32(0xffff);
+  const __m128i swapped = swap_pairs_epi16(y);
+  __m128i p = mulhrs_epi16(x, y);        // ac, bd
+  __m128i q = mulhrs_epi16(x, swapped);  // ad, bc
+  // -32768 only comes from -1 * -1, which should be the largest value
+  p = _mm_xor_si128(p, _mm_cmpeq_epi16(p, overflow));
+  q = _mm_xor_si128(q, _mm_cmpeq_epi16(q, overflow));
+  const __m128i re = _mm_subs_epi16(p, swap_pairs_epi16(p));
+  const __m128i im = _mm_adds_epi16(q, swap_pairs_epi16(q));
+  return _mm_or_si128(_mm_and_si128(real_lanes, re), _mm_andnot_si128(real_lanes, im));
+}
+#endif
+
+#if defined(__AVX2__)
+inline __m256i swap_pairs_epi16(__m256i x) {
+  return _mm256_shuffle_epi8(x, _mm256_setr_epi8(2, 3, 0, 1, 6, 7, 4, 5, 10, 11, 8, 9, 14, 15, 12, 13, 2, 3, 0, 1, 6, 7, 4, 5, 10, 11, 8, 9, 14, 15, 12, 13));
+}
+
+// 8 products, see mul_q15_sse
+inline __m256i mul_q15_avx2(__m256i x, __m256i y) {
+  const __m256i overflow = _mm256_set1_epi16(std::numeric_limits<int16_t>::min());
+  const __m256i real_lanes = _mm256_set1_epi32(0xffff);
+  const __m256i swapped = swap_pairs_epi16(y);
+  __m256i p = _mm256_mulhrs_epi16(x, y);
+  __m256i q = _mm256_mulhrs_epi16(x, swapped);
+  p = _mm256_xor_si256(p, _mm256_cmpeq_epi16(p, overflow));
+  q = _mm256_xor_si256(q, _mm256_cmpeq_epi16(q, overflow));
+  const __m256i re = _mm256_subs_epi16(p, swap_pairs_epi16(p));
+  const __m256i im = _mm256_adds_epi16(q, swap_pairs_epi16(q));
+  return _mm256_or_si256(_mm256_and_si256(real_lanes, re), _mm256_andnot_si256(real_lanes, im));
+}
+#endif
+
+} // namespace detail
+
+// out[i] = x[i] * y[i], see [Fixed point]
+inline void mul(const complex<q15>* x, const complex<q15>* y, complex<q15>* out, int64_t n) {
+  const int16_t* a = reinterpret_cast<const int16_t*>(x);
+  const int16_t* b = reinterpret_cast<const int16_t*>(y);
+  int16_t* r = reinterpret_cast<int16_t*>(out);
+  int64_t i = 0;
+#if defined(__AVX2__)
+  for (; i + 8 <= n; i += 8) {
+    const __m256i u = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(a + 2 * i));
+    const __m256i v = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(b + 2 * i));
+    _mm256_storeu_si256(reinterpret_cast<__m256i*>(r + 2 * i), detail::mul_q15_avx2(u, v));
+  }
+#endif
+#if defined(__SSE2__)
+  for (; i + 4 <= n; i += 4) {
+    const __m128i u = _mm_loadu_si128(reinterpret_cast<const __m128i*>(a + 2 * i));
+    const __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(b + 2 * i));
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(r + 2 * i), detail::mul_q15_sse(u, v));
+  }
+#endif
+  detail::mul_q15_parts(a + 2 * i, b + 2 * i, r + 2 * i, n - i);
+}
+
+inline void mul(const complex<q31>* x, const complex<q31>* y, complex<q31>* out, int64_t n) {
+  mul_shift(reinterpret_cast<const complex<int32_t>*>(x), reinterpret_cast<const complex<int32_t>*>(y), reinterpret_cast<complex<int32_t>*>(out), n, 31);
+}
+
+// Sum of x[i] * y[i] computed exactly, see [Fixed point]
+inline complex<fixed<int64_t, 30>> dot_wide(const complex<q15>* x, const complex<q15>* y, int64_t n) {
+  const int16_t* a = reinterpret_cast<const int16_t*>(x);
+  const int16_t* b = reinterpret_cast<const int16_t*>(y);
+  int64_t re = 0, im = 0;
+  C10_VEC_LOOP
+  for (int64_t i = 0; i < n; i++) {
+    const int32_t ar = a[2 * i], ai = a[2 * i + 1];
+    const int32_t br = b[2 * i], bi = b[2 * i + 1];
+    re += int64_t(ar * br) - int64_t(ai * bi);
+    im += int64_t(ar * bi) + int64_t(ai * br);
+  }
+  using acc = fixed<int64_t, 30>;
+  return complex<acc>(acc::from_raw(re), acc::from_raw(im));
+}
+
+// out[i] = x[i] as complex<float>, see [Fixed point]
+template<typename T>
+void convert_fixed(const complex<T>* x, complex<float>* out, int64_t n) {
+  detail::check_fixed_type<T>();
+  using R = typename T::raw_type;
+  convert_int(reinterpret_cast<const complex<R>*>(x), out, n, std::ldexp(1.0f, -T::fraction_bits));
+}
+
+// out[i] = x[i] rounded and saturated to T, see [Fixed point]
+template<typename T>
+void convert_fixed(const complex<float>* x, complex<T>* out, int64_t n) {
+  detail::check_fixed_type<T>();
+  using R = typename T::raw_type;
+  convert_int(x, reinterpret_cast<complex<R>*>(out), n, std::ldexp(1.0f, -T::fraction_bits));
+}
+
+} // namespace bulk
+} // namespace c10
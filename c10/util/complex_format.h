@@ -0,0 +1,456 @@
+#pragma once
+
+#include <c10/util/complex.h>
+#include <c10/util/complex_parallel.h>
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <limits>
+#include <string>
+#include <system_error>
+#include <type_traits>
+#include <vector>
+
+// Fast text formatting of c10::complex
+//
+// [Complex formatting]
+//
+// operator<< formats through std::complex and the locale of the stream,
+// with 6 significant digits by default, which is slow and loses precision.
+// The functions below write the shortest text that reads back to the same
+// value instead, without locale:
+//
+//   c10::to_chars(first, last, z, style)     into [first, last), not 0-terminated
+//   c10::format_to(out, z, style)            to an output iterator, like fmt::format_to
+//   c10::to_string(z, style)
+//   c10::bulk::format(x, n, out, options)    appends n numbers to a std::string
+//
+// with the styles:
+//
+//   complex_style::parenthesized   (1.5,-2)    like operator<<
+//   complex_style::python          1.5-2j      like Python and NumPy
+//   complex_style::csv             1.5,-2      two CSV columns
+//
+// Real and imaginary parts are written like %g: in fixed notation when the
+// decimal exponent is in [-4, digits10], and as 1.5e+20 otherwise. Integers
+// have no decimal point, and infinities and NaNs are written inf, -inf and
+// nan. The digits come from the Grisu2 algorithm (Loitsch, "Printing
+// Floating-Point Numbers Quickly and Accurately with Integers", PLDI 2010),
+// which always reads back to the same float or double with strtod, and is
+// the shortest such text for all but a tiny fraction of values, where it
+// has one more digit. c10::Half, an integer type in this prototype, is
+// written as an integer.
+//
+// to_chars returns {last, std::errc::value_too_large} when the text does
+// not fit; complex_max_chars is always enough. bulk::format splits arrays
+// of more than format_grain_size numbers between threads with
+// c10::parallel_for.
+
+namespace c10 {
+
+enum class complex_style {
+  parenthesized,
+  python,
+  csv,
+};
+
+// Characters needed for any complex number in any style
+constexpr int complex_max_chars = 64;
+
+struct to_chars_result {
+  char* ptr;
+  std::errc ec;
+};
+
+namespace detail {
+
+// Grisu2, following the reference implementation of Florian Loitsch (MIT
+// license) as adapted in nlohmann/json
+
+// f * 2^e
+struct diyfp {
+  uint64_t f;
+  int e;
+
+  static diyfp sub(diyfp x, diyfp y) {
+    return {x.f - y.f, x.e};
+  }
+
+  // The upper 64 bits of x.f * y.f, rounded
+  static diyfp mul(diyfp x, diyfp y) {
+    const uint64_t u_lo = x.f & 0xffffffffu;
+    const uint64_t u_hi = x.f >> 32;
+    const uint64_t v_lo = y.f & 0xffffffffu;
+    const uint64_t v_hi = y.f >> 32;
+    const uint64_t p0 = u_lo * v_lo;
+    const uint64_t p1 = u_lo * v_hi;
+    const uint64_t p2 = u_hi * v_lo;
+    const uint64_t p3 = u_hi * v_hi;
+    uint64_t q = (p0 >> 32) + (p1 & 0xffffffffu) + (p2 & 0xffffffffu);
+    q += uint64_t(1) << 31;
+    return {p3 + (p2 >> 32) + (p1 >> 32) + (q >> 32), x.e + y.e + 64};
+  }
+
+  static diyfp normalize(diyfp x) {
+#if defined(__GNUC__) || defined(__clang__)
+    const int shift = __builtin_clzll(x.f);
+    return {x.f << shift, x.e - shift};
+#else
+    while ((x.f >> 63) == 0) {
+      x.f <<= 1;
+      x.e--;
+    }
+    return x;
+#endif
+  }
+
+  static diyfp normalize_to(diyfp x, int e) {
+    return {x.f << (x.e - e), e};
+  }
+};
+
+// value and the boundaries of the values that round to it, normalized.
+// value is finite and positive.
+template<typename T>
+void grisu2_boundaries(T value, diyfp& w, diyfp& minus, diyfp& plus) {
+  static_assert(std::numeric_limits<T>::is_iec559, "Grisu2 needs IEEE-754 floating point numbers");
+  constexpr int precision = std::numeric_limits<T>::digits;
+  constexpr int bias = std::numeric_limits<T>::max_exponent - 1 + (precision - 1);
+  constexpr uint64_t hidden_bit = uint64_t(1) << (precision - 1);
+  using bits_t = typename std::conditional<precision == 24, uint32_t, uint64_t>::type;
+  bits_t raw;
+  std::memcpy(&raw, &value, sizeof(raw));
+  const uint64_t bits = raw;
+  const uint64_t exponent = bits >> (precision - 1);
+  const uint64_t fraction = bits & (hidden_bit - 1);
+  const diyfp v = exponent == 0 ? diyfp{fraction, 1 - bias} : diyfp{fraction + hidden_bit, static_cast<int>(exponent) - bias};
+  // the lower boundary is closer at powers of two
+  const bool lower_closer = fraction == 0 && exponent > 1;
+  plus = diyfp::normalize({2 * v.f + 1, v.e - 1});
+  minus = diyfp::normalize_to(lower_closer ? diyfp{4 * v.f - 1, v.e - 2} : diyfp{2 * v.f - 1, v.e - 1}, plus.e);
+  w = diyfp::normalize(v);
+}
+
+constexpr int grisu2_alpha = -60;
+
+// A normalized c = f * 2^e ~= 10^k such that the exponent of w * c is in
+// [-60, -32] for a normalized w of exponent e
+inline diyfp grisu2_cached_power(int e, int& k) {
+  // 10^-300, 10^-292, ..., 10^324
+  static const uint64_t f[] = {
+    0xab70fe17c79ac6ca, 0xff77b1fcbebcdc4f, 0xbe5691ef416bd60c, 0x8dd01fad907ffc3c, 0xd3515c2831559a83,
+    0x9d71ac8fada6c9b5, 0xea9c227723ee8bcb, 0xaecc49914078536d, 0x823c12795db6ce57, 0xc21094364dfb5637,
+    0x9096ea6f3848984f, 0xd77485cb25823ac7, 0xa086cfcd97bf97f4, 0xef340a98172aace5, 0xb23867fb2a35b28e,
+    0x84c8d4dfd2c63f3b, 0xc5dd44271ad3cdba, 0x936b9fcebb25c996, 0xdbac6c247d62a584, 0xa3ab66580d5fdaf6,
+    0xf3e2f893dec3f126, 0xb5b5ada8aaff80b8, 0x87625f056c7c4a8b, 0xc9bcff6034c13053, 0x964e858c91ba2655,
+    0xdff9772470297ebd, 0xa6dfbd9fb8e5b88f, 0xf8a95fcf88747d94, 0xb94470938fa89bcf, 0x8a08f0f8bf0f156b,
+    0xcdb02555653131b6, 0x993fe2c6d07b7fac, 0xe45c10c42a2b3b06, 0xaa242499697392d3, 0xfd87b5f28300ca0e,
+    0xbce5086492111aeb, 0x8cbccc096f5088cc, 0xd1b71758e219652c, 0x9c40000000000000, 0xe8d4a51000000000,
+    0xad78ebc5ac620000, 0x813f3978f8940984, 0xc097ce7bc90715b3, 0x8f7e32ce7bea5c70, 0xd5d238a4abe98068,
+    0x9f4f2726179a2245, 0xed63a231d4c4fb27, 0xb0de65388cc8ada8, 0x83c7088e1aab65db, 0xc45d1df942711d9a,
+    0x924d692ca61be758, 0xda01ee641a708dea, 0xa26da3999aef774a, 0xf209787bb47d6b85, 0xb454e4a179dd1877,
+    0x865b86925b9bc5c2, 0xc83553c5c8965d3d, 0x952ab45cfa97a0b3, 0xde469fbd99a05fe3, 0xa59bc234db398c25,
+    0xf6c69a72a3989f5c, 0xb7dcbf5354e9bece, 0x88fcf317f22241e2, 0xcc20ce9bd35c78a5, 0x98165af37b2153df,
+    0xe2a0b5dc971f303a, 0xa8d9d1535ce3b396, 0xfb9b7cd9a4a7443c, 0xbb764c4ca7a44410, 0x8bab8eefb6409c1a,
+    0xd01fef10a657842c, 0x9b10a4e5e9913129, 0xe7109bfba19c0c9d, 0xac2820d9623bf429, 0x80444b5e7aa7cf85,
+    0xbf21e44003acdd2d, 0x8e679c2f5e44ff8f, 0xd433179d9c8cb841, 0x9e19db92b4e31ba9,
+  };
+  constexpr int min_k = -300;
+  constexpr int step = 8;
+  const int g = grisu2_alpha - e - 1;
+  // ceil(g * log10(2))
+  const int k_min = (g * 78913) / (1 << 18) + (g > 0);
+  const int index = (-min_k + k_min + step - 1) / step;
+  k = min_k + index * step;
+  // the binary exponent of 10^k is floor(k * log2(10)) - 63
+  const int exponent = (k >= 0 ? (k * 1741647) >> 19 : -((-k * 1741647 + (1 << 19) - 1) >> 19)) - 63;
+  return {f[index], exponent};
+}
+
+// Largest power of ten <= n, and its number of digits
+inline int largest_pow10(uint32_t n, uint32_t& pow10) {
+  static const uint32_t powers[] = {1, 10, 100, 1000, 10000, 100000, 1000000, 10000000, 100000000, 1000000000};
+  int digits = 1;
+  while (digits < 10 && n >= powers[digits]) {
+    digits++;
+  }
+  pow10 = powers[digits - 1];
+  return digits;
+}
+
+inline void grisu2_round(char* buffer, int length, uint64_t dist, uint64_t delta, uint64_t rest, uint64_t ten_k) {
+  while (rest < dist && delta - rest >= ten_k && (rest + ten_k < dist || dist - rest > rest + ten_k - dist)) {
+    buffer[length - 1]--;
+    rest += ten_k;
+  }
+}
+
+// Writes the digits of the value w in [minus, plus], and its decimal
+// exponent: value = digits * 10^exponent
+inline void grisu2_digits(char* buffer, int& length, int& exponent, diyfp minus, diyfp w, diyfp plus) {
+  uint64_t delta = diyfp::sub(plus, minus).f;
+  uint64_t dist = diyfp::sub(plus, w).f;
+  const int shift = -plus.e;
+  const uint64_t one = uint64_t(1) << shift;
+  uint32_t p1 = static_cast<uint32_t>(plus.f >> shift);
+  uint64_t p2 = plus.f & (one - 1);
+
+  // integral part, whose digits are split off with divisions by the
+  // constant 10, which are multiplications
+  uint32_t pow10;
+  int n = largest_pow10(p1, pow10);
+  char digits[10];
+  uint32_t x = p1;
+  for (int i = n - 1; i >= 0; i--, x /= 10) {
+    digits[i] = static_cast<char>(x % 10);
+  }
+  for (int i = 0; n > 0; i++) {
+    buffer[length++] = static_cast<char>('0' + digits[i]);
+    p1 -= digits[i] * pow10;
+    n--;
+    const uint64_t rest = (uint64_t(p1) << shift) + p2;
+    if (rest <= delta) {
+      exponent += n;
+      grisu2_round(buffer, length, dist, delta, rest, uint64_t(pow10) << shift);
+      return;
+    }
+    pow10 /= 10;
+  }
+  // fractional part
+  int m = 0;
+  while (true) {
+    p2 *= 10;
+    buffer[length++] = static_cast<char>('0' + (p2 >> shift));
+    p2 &= one - 1;
+    m++;
+    delta *= 10;
+    dist *= 10;
+    if (p2 <= delta) {
+      break;
+    }
+  }
+  exponent -= m;
+  grisu2_round(buffer, length, dist, delta, p2, one);
+}
+
+template<typename T>
+void grisu2(char* buffer, int& length, int& exponent, T value) {
+  diyfp w, minus, plus;
+  grisu2_boundaries(value, w, minus, plus);
+  int k;
+  const diyfp c = grisu2_cached_power(plus.e, k);
+  const diyfp w_c = diyfp::mul(w, c);
+  const diyfp minus_c = diyfp::mul(minus, c);
+  const diyfp plus_c = diyfp::mul(plus, c);
+  length = 0;
+  exponent = -k;
+  grisu2_digits(buffer, length, exponent, {minus_c.f + 1, minus_c.e}, w_c, {plus_c.f - 1, plus_c.e});
+}
+
+inline char* write_exponent(char* p, int e) {
+  *p++ = e < 0 ? '-' : '+';
+  uint32_t k = e < 0 ? -e : e;
+  if (k >= 100) {
+    *p++ = static_cast<char>('0' + k / 100);
+    k %= 100;
+  }
+  *p++ = static_cast<char>('0' + k / 10);
+  *p++ = static_cast<char>('0' + k % 10);
+  return p;
+}
+
+// Writes digits * 10^exponent like %g, see [Complex formatting]. buffer
+// starts with the digits and has room for 32 characters.
+inline char* format_digits(char* buffer, int length, int exponent, int max_exponent) {
+  const int n = length + exponent;  // position of the decimal point
+  if (length <= n && n <= max_exponent) {
+    // 1200
+    std::memset(buffer + length, '0', n - length);
+    return buffer + n;
+  }
+  if (0 < n && n <= max_exponent) {
+    // 12.34
+    std::memmove(buffer + n + 1, buffer + n, length - n);
+    buffer[n] = '.';
+    return buffer + length + 1;
+  }
+  if (-4 < n && n <= 0) {
+    // 0.001234
+    std::memmove(buffer + 2 - n, buffer, length);
+    buffer[0] = '0';
+    buffer[1] = '.';
+    std::memset(buffer + 2, '0', -n);
+    return buffer + 2 - n + length;
+  }
+  // 1.234e+56
+  if (length > 1) {
+    std::memmove(buffer + 2, buffer + 1, length - 1);
+    buffer[1] = '.';
+  }
+  buffer += length > 1 ? length + 1 : 1;
+  *buffer++ = 'e';
+  return write_exponent(buffer, n - 1);
+}
+
+// Writes value to p, which has room for 32 characters, and returns the end
+template<typename T, typename std::enable_if<std::is_floating_point<T>::value, int>::type = 0>
+char* format_real(char* p, T value) {
+  if (std::isnan(value)) {
+    std::memcpy(p, "nan", 3);
+    return p + 3;
+  }
+  if (std::signbit(value)) {
+    *p++ = '-';
+    value = -value;
+  }
+  if (std::isinf(value)) {
+    std::memcpy(p, "inf", 3);
+    return p + 3;
+  }
+  if (value == 0) {
+    *p = '0';
+    return p + 1;
+  }
+  int length;
+  int exponent;
+  grisu2(p, length, exponent, value);
+  return format_digits(p, length, exponent, std::numeric_limits<T>::digits10);
+}
+
+template<typename T, typename std::enable_if<std::is_integral<T>::value, int>::type = 0>
+char* format_real(char* p, T value) {
+  uint64_t u = value < 0 ? uint64_t(0) - static_cast<uint64_t>(value) : static_cast<uint64_t>(value);
+  if (value < 0) {
+    *p++ = '-';
+  }
+  char digits[20];
+  int n = 0;
+  do {
+    digits[n++] = static_cast<char>('0' + u % 10);
+    u /= 10;
+  } while (u != 0);
+  while (n > 0) {
+    *p++ = digits[--n];
+  }
+  return p;
+}
+
+// Writes z to p, which has room for complex_max_chars characters
+template<typename T>
+char* format_complex(char* p, const c10::complex<T>& z, complex_style style) {
+  switch (style) {
+    case complex_style::parenthesized:
+      *p++ = '(';
+      p = format_real(p, z.real());
+      *p++ = ',';
+      p = format_real(p, z.imag());
+      *p++ = ')';
+      return p;
+    case complex_style::python: {
+      p = format_real(p, z.real());
+      char* imag = p;
+      p = format_real(p + 1, z.imag());
+      // the sign of the imaginary part is the operator
+      if (imag[1] == '-') {
+        imag[0] = '-';
+        std::memmove(imag + 1, imag + 2, p - imag - 2);
+        p--;
+      } else {
+        imag[0] = '+';
+      }
+      *p++ = 'j';
+      return p;
+    }
+    case complex_style::csv:
+      p = format_real(p, z.real());
+      *p++ = ',';
+      return format_real(p, z.imag());
+  }
+  return p;
+}
+
+} // namespace detail
+
+// Writes z to [first, last), see [Complex formatting]
+template<typename T>
+to_chars_result to_chars(char* first, char* last, const c10::complex<T>& z, complex_style style = complex_style::parenthesized) {
+  if (last - first >= complex_max_chars) {
+    return {detail::format_complex(first, z, style), std::errc()};
+  }
+  char buffer[complex_max_chars];
+  char* end = detail::format_complex(buffer, z, style);
+  if (end - buffer > last - first) {
+    return {last, std::errc::value_too_large};
+  }
+  std::memcpy(first, buffer, end - buffer);
+  return {first + (end - buffer), std::errc()};
+}
+
+template<typename OutputIt, typename T>
+OutputIt format_to(OutputIt out, const c10::complex<T>& z, complex_style style = complex_style::parenthesized) {
+  char buffer[complex_max_chars];
+  char* end = detail::format_complex(buffer, z, style);
+  for (const char* p = buffer; p != end; ++p) {
+    *out++ = *p;
+  }
+  return out;
+}
+
+template<typename T>
+std::string to_string(const c10::complex<T>& z, complex_style style = complex_style::parenthesized) {
+  char buffer[complex_max_chars];
+  char* end = detail::format_complex(buffer, z, style);
+  return std::string(buffer, end);
+}
+
+namespace bulk {
+
+// Number of complex numbers formatted by each thread at least
+constexpr int64_t format_grain_size = int64_t(1) << 15;
+
+struct format_options {
+  complex_style style = complex_style::csv;
+  char separator = '\n';  // written after each number
+};
+
+// Appends x[0], ..., x[n - 1] to out, each followed by options.separator
+template<typename T>
+void format(const c10::complex<T>* x, int64_t n, std::string& out, const format_options& options = format_options()) {
+  auto format_range = [&](int64_t begin, int64_t end, std::string& s) {
+    const size_t start = s.size();
+    s.resize(start + (end - begin) * (complex_max_chars + 1));
+    char* p = &s[start];
+    for (int64_t i = begin; i < end; i++) {
+      p = detail::format_complex(p, x[i], options.style);
+      *p++ = options.separator;
+    }
+    s.resize(p - s.data());
+  };
+  if (n <= format_grain_size) {
+    format_range(0, n, out);
+    return;
+  }
+  // format blocks in parallel, then concatenate them in order
+  const int64_t num_blocks = (n + format_grain_size - 1) / format_grain_size;
+  std::vector<std::string> blocks(num_blocks);
+  c10::parallel_for(0, num_blocks, 1, [&](int64_t begin, int64_t end) {
+    for (int64_t b = begin; b < end; b++) {
+      format_range(b * format_grain_size, std::min(n, (b + 1) * format_grain_size), blocks[b]);
+    }
+  });
+  size_t size = out.size();
+  for (const std::string& block : blocks) {
+    size += block.size();
+  }
+  out.reserve(size);
+  for (const std::string& block : blocks) {
+    out += block;
+  }
+}
+
+} // namespace bulk
+
+} // namespace c10
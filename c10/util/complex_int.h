@@ -0,0 +1,244 @@
+#pragma once
+
+#include <c10/util/complex.h>
+#include <c10/util/complex_vec_math.h>
+
+#include <cmath>
+#include <cstdint>
+#include <limits>
+#include <type_traits>
+
+// Complex numbers with integer parts, and saturating bulk kernels for them
+//
+// [Integer complex]
+//
+// ADCs deliver samples as pairs of 8 or 16 bit integers. c10::complex<int8_t>
+// and c10::complex<int32_t> follow the conventions of the floating point
+// specializations: they are aligned to their size, are built from
+// complex_common, and complex<float> and complex<double> convert from them
+// implicitly where that is exact (int8_t to both, int32_t to double) and
+// explicitly otherwise. Conversions from floating point are explicit and
+// truncate, like static_cast of the parts. c10::Half is an alias of short in
+// this prototype, so c10::complex<int16_t> is c10::complex<c10::Half>, which
+// already converts implicitly to complex<float> and complex<double>.
+//
+// The scalar operators of complex_common wrap around on overflow like the
+// integer types do. The kernels in c10::bulk saturate instead, and work on
+// all three types:
+//
+//   c10::bulk::add_sat(x, y, out, n);         // out[i] = sat(x[i] + y[i])
+//   c10::bulk::sub_sat(x, y, out, n);         // out[i] = sat(x[i] - y[i])
+//   c10::bulk::mul_shift(x, y, out, n, 15);   // out[i] = sat(round(x[i] * y[i] / 2^15))
+//   c10::bulk::mul_wide(x, y, out, n);        // out[i] = x[i] * y[i] in twice the bits
+//   c10::bulk::convert_int(x, out, n, s);     // complex<float> <-> integer complex
+//
+// mul_shift computes the products and their sums exactly in twice the bits
+// of T, rounds the result shifted right by shift bits to nearest (ties
+// upward, like the rounding shifts of ARM and pmulhrsw of x86) and
+// saturates it to T. mul_wide, for int8_t and int16_t, writes the exact
+// products to complex<int16_t> and complex<int32_t>; the only product that
+// does not fit, (min + min i)^2 imaginary part, saturates to the maximum.
+//
+// convert_int to complex<float> computes x * scale per part. From
+// complex<float>, it rounds value / scale to the nearest integer (ties to
+// even) and saturates it, with NaN becoming 0, like bulk::convert with
+// saturate.
+//
+// Each kernel is a loop over lanes of integers at most twice as wide as T
+// that the compiler vectorizes; the saturation is a clamp, and the products
+// of 16 bit parts run in 32 bit lanes like pmaddwd.
+// Arrays may be in-place (out == x or out == y) but must not partially
+// overlap.
+
+namespace c10 {
+
+template<>
+struct alignas(2) complex<int8_t>: public complex_common<int8_t> {
+  using complex_common<int8_t>::complex_common;
+  constexpr complex(): complex_common() {};
+  explicit constexpr complex(const complex<float> &other): complex_common(static_cast<int8_t>(other.real()), static_cast<int8_t>(other.imag())) {}
+  explicit constexpr complex(const complex<double> &other): complex_common(static_cast<int8_t>(other.real()), static_cast<int8_t>(other.imag())) {}
+};
+
+template<>
+struct alignas(8) complex<int32_t>: public complex_common<int32_t> {
+  using complex_common<int32_t>::complex_common;
+  constexpr complex(): complex_common() {};
+  explicit constexpr complex(const complex<float> &other): complex_common(static_cast<int32_t>(other.real()), static_cast<int32_t>(other.imag())) {}
+  explicit constexpr complex(const complex<double> &other): complex_common(static_cast<int32_t>(other.real()), static_cast<int32_t>(other.imag())) {}
+};
+
+// Declared in c10/util/complex.h
+constexpr complex<float>::complex(const complex<int8_t> &other): complex_common(other.real(), other.imag()) {}
+constexpr complex<float>::complex(const complex<int32_t> &other): complex_common(static_cast<float>(other.real()), static_cast<float>(other.imag())) {}
+constexpr complex<double>::complex(const complex<int8_t> &other): complex_common(other.real(), other.imag()) {}
+constexpr complex<double>::complex(const complex<int32_t> &other): complex_common(other.real(), other.imag()) {}
+
+namespace bulk {
+namespace detail {
+
+template<typename T>
+struct int_traits;
+
+// Holds the products of two parts, and their sums except for one extreme
+// case, see add_wide_sat
+template<>
+struct int_traits<int8_t> {
+  using wide = int16_t;
+};
+
+template<>
+struct int_traits<int16_t> {
+  using wide = int32_t;
+};
+
+template<>
+struct int_traits<int32_t> {
+  using wide = int64_t;
+};
+
+template<typename T>
+struct check_int_type {
+  static_assert(std::is_same<T, int8_t>::value || std::is_same<T, int16_t>::value || std::is_same<T, int32_t>::value,
+    "integer kernels only support c10::complex<int8_t>, c10::complex<int16_t> and c10::complex<int32_t>");
+};
+
+template<typename T, typename W>
+C10_VEC_INLINE T saturate(W x) {
+  const W lo = std::numeric_limits<T>::min();
+  const W hi = std::numeric_limits<T>::max();
+  return static_cast<T>(x < lo ? lo : (x > hi ? hi : x));
+}
+
+// p + q, saturated to W. Only the sum of two extreme products overflows.
+template<typename W>
+C10_VEC_INLINE W add_wide_sat(W p, W q) {
+  using U = typename std::make_unsigned<W>::type;
+  const W s = static_cast<W>(static_cast<U>(p) + static_cast<U>(q));
+  const bool overflow = ((p ^ s) & (q ^ s)) < 0;
+  const W limit = p < 0 ? std::numeric_limits<W>::min() : std::numeric_limits<W>::max();
+  return overflow ? limit : s;
+}
+
+// x / 2^shift rounded to nearest, ties upward, without overflow. Round is
+// shift > 0, a template parameter so that the lane loop has no branch.
+template<bool Round, typename W>
+C10_VEC_INLINE W round_shift(W x, int shift) {
+  return Round ? static_cast<W>((x >> shift) + ((x >> (shift - 1)) & 1)) : x;
+}
+
+template<bool Round, typename T>
+void mul_shift_parts(const T* x, const T* y, T* out, int64_t n, int shift) {
+  using W = typename int_traits<T>::wide;
+  C10_VEC_LOOP
+  for (int64_t i = 0; i < n; i++) {
+    const W a = x[2 * i], b = x[2 * i + 1];
+    const W c = y[2 * i], d = y[2 * i + 1];
+    const W re = add_wide_sat<W>(a * c, -(b * d));
+    const W im = add_wide_sat<W>(a * d, b * c);
+    out[2 * i] = saturate<T>(round_shift<Round>(re, shift));
+    out[2 * i + 1] = saturate<T>(round_shift<Round>(im, shift));
+  }
+}
+
+} // namespace detail
+
+// out[i] = x[i] + y[i], saturated, see [Integer complex]
+template<typename T>
+void add_sat(const complex<T>* x, const complex<T>* y, complex<T>* out, int64_t n) {
+  detail::check_int_type<T>();
+  const T* a = reinterpret_cast<const T*>(x);
+  const T* b = reinterpret_cast<const T*>(y);
+  T* r = reinterpret_cast<T*>(out);
+  using W = typename detail::int_traits<T>::wide;
+  C10_VEC_LOOP
+  for (int64_t i = 0; i < 2 * n; i++) {
+    r[i] = detail::saturate<T>(static_cast<W>(a[i]) + static_cast<W>(b[i]));
+  }
+}
+
+// out[i] = x[i] - y[i], saturated, see [Integer complex]
+template<typename T>
+void sub_sat(const complex<T>* x, const complex<T>* y, complex<T>* out, int64_t n) {
+  detail::check_int_type<T>();
+  const T* a = reinterpret_cast<const T*>(x);
+  const T* b = reinterpret_cast<const T*>(y);
+  T* r = reinterpret_cast<T*>(out);
+  using W = typename detail::int_traits<T>::wide;
+  C10_VEC_LOOP
+  for (int64_t i = 0; i < 2 * n; i++) {
+    r[i] = detail::saturate<T>(static_cast<W>(a[i]) - static_cast<W>(b[i]));
+  }
+}
+
+// out[i] = x[i] * y[i] / 2^shift, rounded and saturated, see [Integer complex]
+template<typename T>
+void mul_shift(const complex<T>* x, const complex<T>* y, complex<T>* out, int64_t n, int shift) {
+  detail::check_int_type<T>();
+  const T* a = reinterpret_cast<const T*>(x);
+  const T* b = reinterpret_cast<const T*>(y);
+  T* r = reinterpret_cast<T*>(out);
+  if (shift == 0) {
+    detail::mul_shift_parts<false>(a, b, r, n, 0);
+  } else {
+    detail::mul_shift_parts<true>(a, b, r, n, shift);
+  }
+}
+
+// out[i] = x[i] * y[i] in twice the bits of T, see [Integer complex]
+template<typename T, typename W>
+void mul_wide(const complex<T>* x, const complex<T>* y, complex<W>* out, int64_t n) {
+  static_assert((std::is_same<T, int8_t>::value && std::is_same<W, int16_t>::value) || (std::is_same<T, int16_t>::value && std::is_same<W, int32_t>::value),
+    "mul_wide computes c10::complex<int8_t> products as c10::complex<int16_t> and c10::complex<int16_t> products as c10::complex<int32_t>");
+  const T* a = reinterpret_cast<const T*>(x);
+  const T* b = reinterpret_cast<const T*>(y);
+  W* r = reinterpret_cast<W*>(out);
+  C10_VEC_LOOP
+  for (int64_t i = 0; i < n; i++) {
+    const W ar = a[2 * i], ai = a[2 * i + 1];
+    const W br = b[2 * i], bi = b[2 * i + 1];
+    r[2 * i] = static_cast<W>(ar * br - ai * bi);
+    r[2 * i + 1] = detail::add_wide_sat<W>(ar * bi, ai * br);
+  }
+}
+
+// out[i] = x[i] * scale, see [Integer complex]
+template<typename T>
+void convert_int(const complex<T>* x, complex<float>* out, int64_t n, float scale = 1) {
+  detail::check_int_type<T>();
+  const T* a = reinterpret_cast<const T*>(x);
+  float* r = reinterpret_cast<float*>(out);
+  C10_VEC_LOOP
+  for (int64_t i = 0; i < 2 * n; i++) {
+    r[i] = static_cast<float>(a[i]) * scale;
+  }
+}
+
+// out[i] = x[i] / scale, rounded and saturated, see [Integer complex]
+template<typename T>
+void convert_int(const complex<float>* x, complex<T>* out, int64_t n, float scale = 1) {
+  detail::check_int_type<T>();
+  using namespace vec_math;
+  const float* a = reinterpret_cast<const float*>(x);
+  T* r = reinterpret_cast<T*>(out);
+  const float inverse = 1 / scale;
+  const float lo = static_cast<float>(std::numeric_limits<T>::min());
+  // 2^7, 2^15 or 2^31, and the largest float below it
+  const float hi = -lo;
+  const float below_hi = std::nextafter(hi, 0.0f);
+  C10_VEC_LOOP
+  for (int64_t i = 0; i < 2 * n; i++) {
+    float v = a[i] * inverse;
+    v = select(v == v, v, 0.0f);
+    // values from 2^22 on are integers already
+    v = select(abs(v) < 4194304.0f, round_int(v), v);
+    // all ones where v is 2^31 or more, which no float converts to
+    const int32_t over = -static_cast<int32_t>(v >= hi);
+    v = max(lo, min(below_hi, v));
+    const int32_t k = static_cast<int32_t>(v);
+    r[i] = static_cast<T>((k & ~over) | (std::numeric_limits<T>::max() & over));
+  }
+}
+
+} // namespace bulk
+} // namespace c10
@@ -0,0 +1,669 @@
+#pragma once
+
+#include <c10/util/complex.h>
+#include <c10/util/complex_file.h>
+#include <c10/util/complex_format.h>
+#include <c10/util/complex_parse.h>
+
+#include <algorithm>
+#include <cmath>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <exception>
+#include <initializer_list>
+#include <limits>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+// Streaming reader and writer of raw IQ sample files, with SigMF metadata
+//
+// [IQ files]
+//
+// Software defined radios record interleaved I (real) and Q (imaginary)
+// samples in raw files, described by a SigMF (https://sigmf.org) metadata
+// file next to them: name.sigmf-data and name.sigmf-meta. The classes below
+// stream such files from and to c10::complex<float>, converting on the fly:
+//
+//   c10::iq_reader r = c10::iq_reader::open_sigmf("name");   // or (path, datatype)
+//   while (int64_t n = r.read(block, block_size)) { ... }
+//
+//   c10::iq_writer w = c10::iq_writer::create_sigmf("name", metadata);
+//   w.write(block, n);
+//
+// The sample formats are the SigMF datatypes cf64, cf32, ci32, ci16, ci8 and
+// cu8, with _le or _be for the byte order of those larger than a byte. Each
+// part of an integer sample x is read as (x - offset) * scale, where offset
+// is 128 for cu8 and 0 otherwise, and written back as the nearest integer to
+// value / scale + offset, saturated to the range of the format; NaN is
+// written as offset, which reads back as 0, like bulk::convert_int. scale
+// defaults to 1, so integers keep their values; 1 / 32768 for ci16, say,
+// maps them to [-1, 1). Floating point samples ignore scale.
+//
+// iq_reader overlaps reading and conversion: a thread reads the file in
+// blocks of iq_options::block_samples samples into one of two buffers while
+// read() converts the other one (double buffering), so the disk stays busy
+// while the caller computes. This is portable and needs no kernel support
+// like io_uring; blocks of a few hundred KiB are enough to reach the
+// sequential bandwidth of a disk. A trailing partial sample is ignored.
+// I/O errors of the thread are rethrown by read(). iq_writer writes through
+// stdio, which returns once the data is in the page cache.
+//
+// read_sigmf_metadata reads the "global" object of a .sigmf-meta file:
+// core:datatype, which is required, core:sample_rate, core:num_channels and
+// core:version; the other fields, captures and annotations are ignored.
+// write_sigmf_metadata writes these with one capture at sample 0.
+// Multi-channel files are read as one stream of interleaved channels.
+// Malformed files and I/O errors throw std::runtime_error, see
+// [Complex files].
+
+namespace c10 {
+
+enum class iq_format {
+  cf64,
+  cf32,
+  ci32,
+  ci16,
+  ci8,
+  cu8,
+};
+
+struct iq_datatype {
+  iq_format format = iq_format::cf32;
+  bool little_endian = true;
+};
+
+inline bool operator==(const iq_datatype& a, const iq_datatype& b) {
+  return a.format == b.format && (a.little_endian == b.little_endian || a.format == iq_format::ci8 || a.format == iq_format::cu8);
+}
+
+inline bool operator!=(const iq_datatype& a, const iq_datatype& b) {
+  return !(a == b);
+}
+
+// Bytes of one complex sample
+inline size_t iq_sample_size(iq_datatype datatype) {
+  switch (datatype.format) {
+    case iq_format::cf64:
+      return 16;
+    case iq_format::cf32:
+    case iq_format::ci32:
+      return 8;
+    case iq_format::ci16:
+      return 4;
+    case iq_format::ci8:
+    case iq_format::cu8:
+      return 2;
+  }
+  return 0;
+}
+
+// The SigMF name, e.g. "ci16_le"
+inline std::string to_string(iq_datatype datatype) {
+  static const char* names[] = {"cf64", "cf32", "ci32", "ci16", "ci8", "cu8"};
+  std::string name = names[static_cast<int>(datatype.format)];
+  if (iq_sample_size(datatype) > 2) {
+    name += datatype.little_endian ? "_le" : "_be";
+  }
+  return name;
+}
+
+// Parses a SigMF datatype, throws std::invalid_argument for the others
+// (real samples, unsigned 16 and 32 bit integers)
+inline iq_datatype parse_iq_datatype(const std::string& name) {
+  for (int f = 0; f <= static_cast<int>(iq_format::cu8); f++) {
+    for (bool little_endian : {true, false}) {
+      const iq_datatype datatype{static_cast<iq_format>(f), little_endian};
+      if (to_string(datatype) == name) {
+        return datatype;
+      }
+    }
+  }
+  throw std::invalid_argument("c10::parse_iq_datatype: unsupported datatype " + name);
+}
+
+struct sigmf_metadata {
+  iq_datatype datatype;
+  double sample_rate = 0;  // 0 if unknown
+  int64_t num_channels = 1;
+  std::string version = "1.0.0";
+};
+
+struct iq_options {
+  int64_t block_samples = int64_t(1) << 16;
+  float scale = 1;
+};
+
+namespace detail {
+
+// Minimal JSON, enough to read the global object of SigMF metadata
+
+struct json_scanner {
+  const char* p;
+  const char* last;
+  const std::string& path;
+
+  [[noreturn]] void fail() const {
+    complex_file_error("c10::read_sigmf_metadata", path, "invalid JSON");
+  }
+
+  void skip_spaces() {
+    while (p != last && (*p == ' ' || *p == '\t' || *p == '\n' || *p == '\r')) {
+      p++;
+    }
+  }
+
+  bool consume(char c) {
+    skip_spaces();
+    if (p != last && *p == c) {
+      p++;
+      return true;
+    }
+    return false;
+  }
+
+  void expect(char c) {
+    if (!consume(c)) {
+      fail();
+    }
+  }
+
+  // A string, with the escapes of ASCII characters decoded
+  std::string string() {
+    expect('"');
+    std::string s;
+    while (p != last && *p != '"') {
+      if (*p == '\\') {
+        if (++p == last) {
+          fail();
+        }
+        switch (*p) {
+          case 'n': s += '\n'; break;
+          case 't': s += '\t'; break;
+          case 'r': s += '\r'; break;
+          case 'b': s += '\b'; break;
+          case 'f': s += '\f'; break;
+          case 'u': {
+            if (last - p < 5) {
+              fail();
+            }
+            const unsigned code = std::stoul(std::string(p + 1, p + 5), nullptr, 16);
+            s += code < 0x80 ? static_cast<char>(code) : '?';
+            p += 4;
+            break;
+          }
+          default: s += *p; break;
+        }
+        p++;
+      } else {
+        s += *p++;
+      }
+    }
+    expect('"');
+    return s;
+  }
+
+  double number() {
+    skip_spaces();
+    double value;
+    const from_chars_result r = parse_real(p, last, value);
+    if (r.ec != std::errc()) {
+      fail();
+    }
+    p = r.ptr;
+    return value;
+  }
+
+  void skip_value() {
+    skip_spaces();
+    if (p == last) {
+      fail();
+    }
+    if (*p == '"') {
+      string();
+    } else if (*p == '{' || *p == '[') {
+      const char close = *p == '{' ? '}' : ']';
+      p++;
+      if (consume(close)) {
+        return;
+      }
+      do {
+        if (close == '}') {
+          string();
+          expect(':');
+        }
+        skip_value();
+      } while (consume(','));
+      expect(close);
+    } else {
+      // number, true, false or null
+      const char* start = p;
+      while (p != last && *p != ',' && *p != '}' && *p != ']' && *p != ' ' && *p != '\n' && *p != '\r' && *p != '\t') {
+        p++;
+      }
+      if (p == start) {
+        fail();
+      }
+    }
+  }
+
+  // Calls f(key) at the value of each key of an object
+  template<typename F>
+  void object(F f) {
+    expect('{');
+    if (consume('}')) {
+      return;
+    }
+    do {
+      const std::string key = string();
+      expect(':');
+      f(key);
+    } while (consume(','));
+    expect('}');
+  }
+};
+
+inline const char* iq_function(bool reader) {
+  return reader ? "c10::iq_reader" : "c10::iq_writer";
+}
+
+template<typename S>
+S load_swapped(const unsigned char* p, bool swap) {
+  S value;
+  if (swap) {
+    unsigned char bytes[sizeof(S)];
+    for (size_t i = 0; i < sizeof(S); i++) {
+      bytes[i] = p[sizeof(S) - 1 - i];
+    }
+    std::memcpy(&value, bytes, sizeof(S));
+  } else {
+    std::memcpy(&value, p, sizeof(S));
+  }
+  return value;
+}
+
+template<typename S>
+void store_swapped(unsigned char* p, S value, bool swap) {
+  std::memcpy(p, &value, sizeof(S));
+  if (swap) {
+    std::reverse(p, p + sizeof(S));
+  }
+}
+
+// count real numbers of type S at in to float
+template<typename S>
+void iq_to_float(const unsigned char* in, float* out, int64_t count, bool swap, float scale, float offset) {
+  if (std::is_floating_point<S>::value) {
+    scale = 1;
+  }
+  if (swap) {
+    for (int64_t i = 0; i < count; i++) {
+      out[i] = (static_cast<float>(load_swapped<S>(in + i * sizeof(S), true)) - offset) * scale;
+    }
+  } else {
+    for (int64_t i = 0; i < count; i++) {
+      out[i] = (static_cast<float>(load_swapped<S>(in + i * sizeof(S), false)) - offset) * scale;
+    }
+  }
+}
+
+template<typename S>
+S float_to_iq(float x, float scale, float offset) {
+  if (std::is_floating_point<S>::value) {
+    return static_cast<S>(x);
+  }
+  if (!(x == x)) {
+    return static_cast<S>(offset);
+  }
+  const double y = std::nearbyint(static_cast<double>(x) / scale + offset);
+  if (y <= static_cast<double>(std::numeric_limits<S>::lowest())) {
+    return std::numeric_limits<S>::lowest();
+  }
+  return y >= static_cast<double>(std::numeric_limits<S>::max()) ? std::numeric_limits<S>::max() : static_cast<S>(y);
+}
+
+template<typename S>
+void float_to_iq(const float* in, unsigned char* out, int64_t count, bool swap, float scale, float offset) {
+  for (int64_t i = 0; i < count; i++) {
+    store_swapped<S>(out + i * sizeof(S), float_to_iq<S>(in[i], scale, offset), swap);
+  }
+}
+
+} // namespace detail
+
+namespace bulk {
+
+// n samples of datatype at in to out, see [IQ files]
+inline void convert_iq(const void* in, iq_datatype datatype, c10::complex<float>* out, int64_t n, float scale = 1) {
+  const unsigned char* bytes = static_cast<const unsigned char*>(in);
+  float* reals = reinterpret_cast<float*>(out);
+  const bool swap = datatype.little_endian != c10::detail::host_little_endian();
+  switch (datatype.format) {
+    case iq_format::cf64:
+      return c10::detail::iq_to_float<double>(bytes, reals, 2 * n, swap, scale, 0);
+    case iq_format::cf32:
+      return c10::detail::iq_to_float<float>(bytes, reals, 2 * n, swap, scale, 0);
+    case iq_format::ci32:
+      return c10::detail::iq_to_float<int32_t>(bytes, reals, 2 * n, swap, scale, 0);
+    case iq_format::ci16:
+      return c10::detail::iq_to_float<int16_t>(bytes, reals, 2 * n, swap, scale, 0);
+    case iq_format::ci8:
+      return c10::detail::iq_to_float<int8_t>(bytes, reals, 2 * n, false, scale, 0);
+    case iq_format::cu8:
+      return c10::detail::iq_to_float<uint8_t>(bytes, reals, 2 * n, false, scale, 128);
+  }
+}
+
+// n samples at in to datatype at out, see [IQ files]
+inline void convert_iq(const c10::complex<float>* in, int64_t n, iq_datatype datatype, void* out, float scale = 1) {
+  const float* reals = reinterpret_cast<const float*>(in);
+  unsigned char* bytes = static_cast<unsigned char*>(out);
+  const bool swap = datatype.little_endian != c10::detail::host_little_endian();
+  switch (datatype.format) {
+    case iq_format::cf64:
+      return c10::detail::float_to_iq<double>(reals, bytes, 2 * n, swap, scale, 0);
+    case iq_format::cf32:
+      return c10::detail::float_to_iq<float>(reals, bytes, 2 * n, swap, scale, 0);
+    case iq_format::ci32:
+      return c10::detail::float_to_iq<int32_t>(reals, bytes, 2 * n, swap, scale, 0);
+    case iq_format::ci16:
+      return c10::detail::float_to_iq<int16_t>(reals, bytes, 2 * n, swap, scale, 0);
+    case iq_format::ci8:
+      return c10::detail::float_to_iq<int8_t>(reals, bytes, 2 * n, false, scale, 0);
+    case iq_format::cu8:
+      return c10::detail::float_to_iq<uint8_t>(reals, bytes, 2 * n, false, scale, 128);
+  }
+}
+
+} // namespace bulk
+
+// Reads the .sigmf-meta file at path, see [IQ files]
+inline sigmf_metadata read_sigmf_metadata(const std::string& path) {
+  const detail::mapped_file file(path, "c10::read_sigmf_metadata");
+  detail::json_scanner json{file.data(), file.data() + file.size(), path};
+  sigmf_metadata metadata;
+  bool has_datatype = false;
+  json.object([&](const std::string& key) {
+    if (key != "global") {
+      json.skip_value();
+      return;
+    }
+    json.object([&](const std::string& field) {
+      if (field == "core:datatype") {
+        const std::string name = json.string();
+        try {
+          metadata.datatype = parse_iq_datatype(name);
+        } catch (const std::invalid_argument&) {
+          detail::complex_file_error("c10::read_sigmf_metadata", path, "unsupported datatype " + name);
+        }
+        has_datatype = true;
+      } else if (field == "core:sample_rate") {
+        metadata.sample_rate = json.number();
+      } else if (field == "core:num_channels") {
+        metadata.num_channels = static_cast<int64_t>(json.number());
+      } else if (field == "core:version") {
+        metadata.version = json.string();
+      } else {
+        json.skip_value();
+      }
+    });
+  });
+  if (!has_datatype) {
+    detail::complex_file_error("c10::read_sigmf_metadata", path, "missing core:datatype");
+  }
+  return metadata;
+}
+
+// Writes metadata to a .sigmf-meta file at path, see [IQ files]
+inline void write_sigmf_metadata(const std::string& path, const sigmf_metadata& metadata) {
+  char rate[32];
+  char* rate_end = detail::format_real(rate, metadata.sample_rate);
+  std::string json = "{\n  \"global\": {\n";
+  json += "    \"core:datatype\": \"" + to_string(metadata.datatype) + "\",\n";
+  if (metadata.sample_rate > 0) {
+    json += "    \"core:sample_rate\": " + std::string(rate, rate_end) + ",\n";
+  }
+  json += "    \"core:num_channels\": " + std::to_string(metadata.num_channels) + ",\n";
+  json += "    \"core:version\": \"" + metadata.version + "\"\n";
+  json += "  },\n  \"captures\": [\n    {\n      \"core:sample_start\": 0\n    }\n  ],\n  \"annotations\": []\n}\n";
+  detail::file_ptr f = detail::open_file(path, "wb", "c10::write_sigmf_metadata");
+  if (std::fwrite(json.data(), 1, json.size(), f.get()) != json.size() || std::fclose(f.release()) != 0) {
+    detail::complex_file_errno("c10::write_sigmf_metadata", path);
+  }
+}
+
+// Reads IQ samples as c10::complex<float>, see [IQ files]
+class iq_reader {
+ public:
+  iq_reader(const std::string& path, iq_datatype datatype, const iq_options& options = iq_options())
+    : state_(new state(path, datatype, options)) {
+    state_->metadata.datatype = datatype;
+    state_->thread = std::thread([s = state_.get()] {
+      s->read_blocks();
+    });
+  }
+
+  // name.sigmf-data described by name.sigmf-meta
+  static iq_reader open_sigmf(const std::string& name, const iq_options& options = iq_options()) {
+    const sigmf_metadata metadata = read_sigmf_metadata(name + ".sigmf-meta");
+    iq_reader reader(name + ".sigmf-data", metadata.datatype, options);
+    reader.state_->metadata = metadata;
+    return reader;
+  }
+
+  iq_reader(iq_reader&&) = default;
+  iq_reader& operator=(iq_reader&& other) {
+    stop();
+    state_ = std::move(other.state_);
+    return *this;
+  }
+
+  ~iq_reader() {
+    stop();
+  }
+
+  // Converts the next min(n, available) samples to out and returns their
+  // number, 0 at the end of the file
+  int64_t read(c10::complex<float>* out, int64_t n) {
+    state& s = *state_;
+    const size_t sample_size = iq_sample_size(s.metadata.datatype);
+    int64_t done = 0;
+    while (done < n) {
+      block& b = s.blocks[s.current];
+      {
+        std::unique_lock<std::mutex> lock(s.mutex);
+        s.changed.wait(lock, [&] {
+          return b.full || s.error;
+        });
+        if (s.error && !b.full) {
+          std::rethrow_exception(s.error);
+        }
+      }
+      const int64_t available = (b.size - s.position) / sample_size;
+      const int64_t count = std::min(n - done, available);
+      bulk::convert_iq(b.data.data() + s.position, s.metadata.datatype, out + done, count, s.options.scale);
+      done += count;
+      s.position += count * sample_size;
+      if (s.position + sample_size > b.size) {
+        if (b.size < b.data.size()) {
+          // the last block
+          break;
+        }
+        std::lock_guard<std::mutex> lock(s.mutex);
+        b.full = false;
+        s.position = 0;
+        s.current ^= 1;
+        s.changed.notify_all();
+      }
+    }
+    return done;
+  }
+
+  int64_t read(span<c10::complex<float>> s) {
+    return read(s.data(), s.size());
+  }
+
+  const sigmf_metadata& metadata() const {
+    return state_->metadata;
+  }
+
+ private:
+  struct block {
+    std::vector<unsigned char> data;
+    size_t size = 0;  // bytes read
+    bool full = false;
+  };
+
+  struct state {
+    state(const std::string& path, iq_datatype datatype, const iq_options& options)
+      : path(path), file(detail::open_file(path, "rb", "c10::iq_reader")), options(options) {
+      if (options.block_samples <= 0) {
+        throw std::invalid_argument("c10::iq_reader: block_samples must be positive");
+      }
+      for (block& b : blocks) {
+        b.data.resize(options.block_samples * iq_sample_size(datatype));
+      }
+    }
+
+    // the thread: fills the blocks in turn until the end of the file
+    void read_blocks() {
+      for (int i = 0;; i ^= 1) {
+        block& b = blocks[i];
+        {
+          std::unique_lock<std::mutex> lock(mutex);
+          changed.wait(lock, [&] {
+            return !b.full || stopping;
+          });
+          if (stopping) {
+            return;
+          }
+        }
+        const size_t size = std::fread(b.data.data(), 1, b.data.size(), file.get());
+        std::lock_guard<std::mutex> lock(mutex);
+        if (size < b.data.size() && std::ferror(file.get())) {
+          try {
+            detail::complex_file_errno("c10::iq_reader", path);
+          } catch (...) {
+            error = std::current_exception();
+          }
+          changed.notify_all();
+          return;
+        }
+        b.size = size;
+        b.full = true;
+        changed.notify_all();
+        if (size < b.data.size()) {
+          return;
+        }
+      }
+    }
+
+    std::string path;
+    detail::file_ptr file;
+    iq_options options;
+    sigmf_metadata metadata;
+    block blocks[2];
+    int current = 0;
+    size_t position = 0;  // in blocks[current]
+    std::mutex mutex;
+    std::condition_variable changed;
+    bool stopping = false;
+    std::exception_ptr error;
+    std::thread thread;
+  };
+
+  void stop() {
+    if (state_ != nullptr && state_->thread.joinable()) {
+      {
+        std::lock_guard<std::mutex> lock(state_->mutex);
+        state_->stopping = true;
+        state_->changed.notify_all();
+      }
+      state_->thread.join();
+    }
+  }
+
+  std::unique_ptr<state> state_;
+};
+
+// Writes c10::complex<float> as IQ samples, see [IQ files]
+class iq_writer {
+ public:
+  iq_writer(const std::string& path, iq_datatype datatype, const iq_options& options = iq_options())
+    : path_(path), file_(detail::open_file(path, "wb", "c10::iq_writer")), datatype_(datatype), options_(options) {
+    if (options.block_samples <= 0) {
+      throw std::invalid_argument("c10::iq_writer: block_samples must be positive");
+    }
+    buffer_.resize(options.block_samples * iq_sample_size(datatype));
+  }
+
+  // name.sigmf-data, and metadata written to name.sigmf-meta
+  static iq_writer create_sigmf(const std::string& name, const sigmf_metadata& metadata, const iq_options& options = iq_options()) {
+    write_sigmf_metadata(name + ".sigmf-meta", metadata);
+    return iq_writer(name + ".sigmf-data", metadata.datatype, options);
+  }
+
+  iq_writer(iq_writer&&) = default;
+  // Closes the file of *this first, so that its errors are reported
+  iq_writer& operator=(iq_writer&& other) {
+    if (this != &other) {
+      close();
+      path_ = std::move(other.path_);
+      file_ = std::move(other.file_);
+      datatype_ = other.datatype_;
+      options_ = other.options_;
+      buffer_ = std::move(other.buffer_);
+    }
+    return *this;
+  }
+
+  ~iq_writer() {
+    try {
+      close();
+    } catch (const std::exception&) {
+      // errors can only be reported by calling close
+    }
+  }
+
+  void write(const c10::complex<float>* data, int64_t n) {
+    if (file_ == nullptr) {
+      throw std::logic_error("c10::iq_writer: the file is closed");
+    }
+    const size_t sample_size = iq_sample_size(datatype_);
+    for (int64_t done = 0; done < n;) {
+      const int64_t count = std::min(n - done, options_.block_samples);
+      bulk::convert_iq(data + done, count, datatype_, buffer_.data(), options_.scale);
+      if (std::fwrite(buffer_.data(), sample_size, count, file_.get()) != static_cast<size_t>(count)) {
+        detail::complex_file_errno("c10::iq_writer", path_);
+      }
+      done += count;
+    }
+  }
+
+  void write(span<const c10::complex<float>> s) {
+    write(s.data(), s.size());
+  }
+
+  void close() {
+    if (file_ != nullptr && std::fclose(file_.release()) != 0) {
+      detail::complex_file_errno("c10::iq_writer", path_);
+    }
+  }
+
+ private:
+  std::string path_;
+  detail::file_ptr file_;
+  iq_datatype datatype_;
+  iq_options options_;
+  std::vector<unsigned char> buffer_;
+};
+
+} // namespace c10
@@ -0,0 +1,505 @@
+#pragma once
+
+// This file is included at the end of c10/util/complex.h, do not include it directly.
+//
+// Math functions for c10::complex
+//
+// Like std::abs, std::arg, etc. in complex.h, these functions are overloads of the
+// corresponding functions in namespace std, so that generic code calling `std::exp(x)`
+// works for c10::complex. They are implemented by casting to std::complex on host and
+// thrust::complex on device.
+//
+// Reference: https://en.cppreference.com/w/cpp/numeric/complex
+//
+// The inverse trigonometric and hyperbolic functions are the exception: they are
+// implemented here directly, see [Inverse functions] below.
+//
+// Bulk (vectorized) versions of these functions that work on arrays live in
+// c10/util/complex_bulk.h
+//
+// constexpr versions of exp, sin, cos and polar for compile-time tables live in
+// c10/util/complex_constexpr.h
+//
+// c10::fma and c10::fma_conj at the end of this file are not overloads of std
+// functions, because there is no std::fma for complex numbers.
+
+#include <cmath>
+#include <limits>
+
+namespace std {
+
+// Exponential functions
+
+template<typename T>
+C10_HOST_DEVICE c10::complex<T> exp(const c10::complex<T>& x) {
+#if defined(__CUDACC__) || defined(__HIPCC__)
+  return static_cast<c10::complex<T>>(thrust::exp(static_cast<thrust::complex<T>>(x)));
+#else
+  return static_cast<c10::complex<T>>(std::exp(static_cast<std::complex<T>>(x)));
+#endif
+}
+
+template<typename T>
+C10_HOST_DEVICE c10::complex<T> log(const c10::complex<T>& x) {
+#if defined(__CUDACC__) || defined(__HIPCC__)
+  return static_cast<c10::complex<T>>(thrust::log(static_cast<thrust::complex<T>>(x)));
+#else
+  return static_cast<c10::complex<T>>(std::log(static_cast<std::complex<T>>(x)));
+#endif
+}
+
+template<typename T>
+C10_HOST_DEVICE c10::complex<T> log10(const c10::complex<T>& x) {
+#if defined(__CUDACC__) || defined(__HIPCC__)
+  return static_cast<c10::complex<T>>(thrust::log10(static_cast<thrust::complex<T>>(x)));
+#else
+  return static_cast<c10::complex<T>>(std::log10(static_cast<std::complex<T>>(x)));
+#endif
+}
+
+// Power functions
+//
+// Like std::pow, there are three versions:
+// - complex ^ complex
+// - complex ^ real
+// - real ^ complex
+
+template<typename T>
+C10_HOST_DEVICE c10::complex<T> pow(const c10::complex<T>& x, const c10::complex<T>& y) {
+#if defined(__CUDACC__) || defined(__HIPCC__)
+  return static_cast<c10::complex<T>>(thrust::pow(static_cast<thrust::complex<T>>(x), static_cast<thrust::complex<T>>(y)));
+#else
+  return static_cast<c10::complex<T>>(std::pow(static_cast<std::complex<T>>(x), static_cast<std::complex<T>>(y)));
+#endif
+}
+
+template<typename T>
+C10_HOST_DEVICE c10::complex<T> pow(const c10::complex<T>& x, const T& y) {
+#if defined(__CUDACC__) || defined(__HIPCC__)
+  return static_cast<c10::complex<T>>(thrust::pow(static_cast<thrust::complex<T>>(x), y));
+#else
+  return static_cast<c10::complex<T>>(std::pow(static_cast<std::complex<T>>(x), y));
+#endif
+}
+
+template<typename T>
+C10_HOST_DEVICE c10::complex<T> pow(const T& x, const c10::complex<T>& y) {
+#if defined(__CUDACC__) || defined(__HIPCC__)
+  return static_cast<c10::complex<T>>(thrust::pow(x, static_cast<thrust::complex<T>>(y)));
+#else
+  return static_cast<c10::complex<T>>(std::pow(x, static_cast<std::complex<T>>(y)));
+#endif
+}
+
+template<typename T>
+C10_HOST_DEVICE c10::complex<T> sqrt(const c10::complex<T>& x) {
+#if defined(__CUDACC__) || defined(__HIPCC__)
+  return static_cast<c10::complex<T>>(thrust::sqrt(static_cast<thrust::complex<T>>(x)));
+#else
+  return static_cast<c10::complex<T>>(std::sqrt(static_cast<std::complex<T>>(x)));
+#endif
+}
+
+// Trigonometric functions
+
+template<typename T>
+C10_HOST_DEVICE c10::complex<T> sin(const c10::complex<T>& x) {
+#if defined(__CUDACC__) || defined(__HIPCC__)
+  return static_cast<c10::complex<T>>(thrust::sin(static_cast<thrust::complex<T>>(x)));
+#else
+  return static_cast<c10::complex<T>>(std::sin(static_cast<std::complex<T>>(x)));
+#endif
+}
+
+template<typename T>
+C10_HOST_DEVICE c10::complex<T> cos(const c10::complex<T>& x) {
+#if defined(__CUDACC__) || defined(__HIPCC__)
+  return static_cast<c10::complex<T>>(thrust::cos(static_cast<thrust::complex<T>>(x)));
+#else
+  return static_cast<c10::complex<T>>(std::cos(static_cast<std::complex<T>>(x)));
+#endif
+}
+
+template<typename T>
+C10_HOST_DEVICE c10::complex<T> tan(const c10::complex<T>& x) {
+#if defined(__CUDACC__) || defined(__HIPCC__)
+  return static_cast<c10::complex<T>>(thrust::tan(static_cast<thrust::complex<T>>(x)));
+#else
+  return static_cast<c10::complex<T>>(std::tan(static_cast<std::complex<T>>(x)));
+#endif
+}
+
+// Hyperbolic functions
+
+template<typename T>
+C10_HOST_DEVICE c10::complex<T> sinh(const c10::complex<T>& x) {
+#if defined(__CUDACC__) || defined(__HIPCC__)
+  return static_cast<c10::complex<T>>(thrust::sinh(static_cast<thrust::complex<T>>(x)));
+#else
+  return static_cast<c10::complex<T>>(std::sinh(static_cast<std::complex<T>>(x)));
+#endif
+}
+
+template<typename T>
+C10_HOST_DEVICE c10::complex<T> cosh(const c10::complex<T>& x) {
+#if defined(__CUDACC__) || defined(__HIPCC__)
+  return static_cast<c10::complex<T>>(thrust::cosh(static_cast<thrust::complex<T>>(x)));
+#else
+  return static_cast<c10::complex<T>>(std::cosh(static_cast<std::complex<T>>(x)));
+#endif
+}
+
+template<typename T>
+C10_HOST_DEVICE c10::complex<T> tanh(const c10::complex<T>& x) {
+#if defined(__CUDACC__) || defined(__HIPCC__)
+  return static_cast<c10::complex<T>>(thrust::tanh(static_cast<thrust::complex<T>>(x)));
+#else
+  return static_cast<c10::complex<T>>(std::tanh(static_cast<std::complex<T>>(x)));
+#endif
+}
+
+// [Inverse functions]
+//
+// asin and acos follow the algorithm of
+//   T. E. Hull, T. F. Fairgrieve and P. T. P. Tang, "Implementing the complex
+//   arcsine and arccosine functions using exception handling", ACM TOMS 23(3), 1997
+// and atanh follows the same scheme of a main region in which the textbook formulas
+// are evaluated carefully, plus exception regions near 0, 1 and infinity where they
+// would overflow, underflow or cancel. asinh, acosh and atan are derived from them:
+//   asinh(z) = -i asin(i z),   acosh(z) = +-i acos(z),   atan(z) = -i atanh(i z)
+// Special values follow C99 Annex G, like std::complex.
+//
+// The main regions are also the fast paths of the bulk versions in
+// c10/util/complex_bulk.h, which call these functions for the other lanes.
+
+template<typename T>
+C10_HOST_DEVICE c10::complex<T> asin(const c10::complex<T>& z) {
+  const T inf = std::numeric_limits<T>::infinity();
+  const T eps = std::numeric_limits<T>::epsilon();
+  const T half_pi = T(1.57079632679489661923);
+  const T quarter_pi = T(0.78539816339744830962);
+  const T log_two = T(0.69314718055994530942);
+  const T safe_max = std::sqrt(std::numeric_limits<T>::max()) / T(8);
+  const T safe_min = std::sqrt(std::numeric_limits<T>::min()) * T(4);
+  const T a_crossover = T(1.5);
+  const T b_crossover = T(0.6417);
+  T x = std::fabs(z.real());
+  T y = std::fabs(z.imag());
+  T real, imag;
+  if (std::isnan(x)) {
+    if (std::isinf(y)) {
+      real = x;
+      imag = inf;
+    } else {
+      return c10::complex<T>(x, x);
+    }
+  } else if (std::isnan(y)) {
+    if (x == T(0)) {
+      real = T(0);
+      imag = y;
+    } else if (std::isinf(x)) {
+      real = y;
+      imag = inf;
+    } else {
+      return c10::complex<T>(y, y);
+    }
+  } else if (std::isinf(x)) {
+    real = std::isinf(y) ? quarter_pi : half_pi;
+    imag = inf;
+  } else if (std::isinf(y)) {
+    real = T(0);
+    imag = inf;
+  } else {
+    T xp1 = T(1) + x;
+    T xm1 = x - T(1);
+    if (x > safe_min && x < safe_max && y > safe_min && y < safe_max) {
+      T yy = y * y;
+      T r = std::sqrt(xp1 * xp1 + yy);
+      T s = std::sqrt(xm1 * xm1 + yy);
+      T a = T(0.5) * (r + s);
+      T b = x / a;
+      if (b <= b_crossover) {
+        real = std::asin(b);
+      } else {
+        T apx = a + x;
+        if (x <= T(1)) {
+          real = std::atan(x / std::sqrt(T(0.5) * apx * (yy / (r + xp1) + (s - xm1))));
+        } else {
+          real = std::atan(x / (y * std::sqrt(T(0.5) * (apx / (r + xp1) + apx / (s + xm1)))));
+        }
+      }
+      if (a <= a_crossover) {
+        T am1 = x < T(1) ? T(0.5) * (yy / (r + xp1) + yy / (s - xm1)) : T(0.5) * (yy / (r + xp1) + (s + xm1));
+        imag = std::log1p(am1 + std::sqrt(am1 * (a + T(1))));
+      } else {
+        imag = std::log(a + std::sqrt(a * a - T(1)));
+      }
+    } else if (y <= eps * std::fabs(xm1)) {
+      if (x < T(1)) {
+        real = std::asin(x);
+        imag = y / std::sqrt(xp1 * (T(1) - x));
+      } else {
+        real = half_pi;
+        imag = std::numeric_limits<T>::max() / xp1 > xm1 ? std::log1p(xm1 + std::sqrt(xp1 * xm1)) : log_two + std::log(x);
+      }
+    } else if (y <= safe_min) {
+      // x == 1 here
+      real = half_pi - std::sqrt(y);
+      imag = std::sqrt(y);
+    } else if (eps * y - T(1) >= x) {
+      real = x / y;
+      imag = log_two + std::log(y);
+    } else if (x > T(1)) {
+      T xoy = x / y;
+      real = std::atan(xoy);
+      imag = log_two + std::log(y) + T(0.5) * std::log1p(xoy * xoy);
+    } else {
+      T a = std::sqrt(T(1) + y * y);
+      real = x / a;
+      imag = T(0.5) * std::log1p(T(2) * y * (y + a));
+    }
+  }
+  return c10::complex<T>(std::copysign(real, z.real()), std::copysign(imag, z.imag()));
+}
+
+template<typename T>
+C10_HOST_DEVICE c10::complex<T> acos(const c10::complex<T>& z) {
+  const T inf = std::numeric_limits<T>::infinity();
+  const T eps = std::numeric_limits<T>::epsilon();
+  const T pi = T(3.14159265358979323846);
+  const T half_pi = T(1.57079632679489661923);
+  const T quarter_pi = T(0.78539816339744830962);
+  const T log_two = T(0.69314718055994530942);
+  const T safe_max = std::sqrt(std::numeric_limits<T>::max()) / T(8);
+  const T safe_min = std::sqrt(std::numeric_limits<T>::min()) * T(4);
+  const T a_crossover = T(1.5);
+  const T b_crossover = T(0.6417);
+  T x = std::fabs(z.real());
+  T y = std::fabs(z.imag());
+  T real, imag;
+  if (std::isnan(x)) {
+    if (std::isinf(y)) {
+      return c10::complex<T>(x, std::signbit(z.imag()) ? inf : -inf);
+    }
+    return c10::complex<T>(x, x);
+  } else if (std::isnan(y)) {
+    if (std::isinf(x)) {
+      return c10::complex<T>(y, -inf);
+    } else if (x == T(0)) {
+      return c10::complex<T>(half_pi, y);
+    }
+    return c10::complex<T>(y, y);
+  } else if (std::isinf(x)) {
+    real = std::isinf(y) ? quarter_pi : T(0);
+    imag = inf;
+  } else if (std::isinf(y)) {
+    real = half_pi;
+    imag = inf;
+  } else {
+    T xp1 = T(1) + x;
+    T xm1 = x - T(1);
+    if (x > safe_min && x < safe_max && y > safe_min && y < safe_max) {
+      T yy = y * y;
+      T r = std::sqrt(xp1 * xp1 + yy);
+      T s = std::sqrt(xm1 * xm1 + yy);
+      T a = T(0.5) * (r + s);
+      T b = x / a;
+      if (b <= b_crossover) {
+        real = std::acos(b);
+      } else {
+        T apx = a + x;
+        if (x <= T(1)) {
+          real = std::atan(std::sqrt(T(0.5) * apx * (yy / (r + xp1) + (s - xm1))) / x);
+        } else {
+          real = std::atan(y * std::sqrt(T(0.5) * (apx / (r + xp1) + apx / (s + xm1))) / x);
+        }
+      }
+      if (a <= a_crossover) {
+        T am1 = x < T(1) ? T(0.5) * (yy / (r + xp1) + yy / (s - xm1)) : T(0.5) * (yy / (r + xp1) + (s + xm1));
+        imag = std::log1p(am1 + std::sqrt(am1 * (a + T(1))));
+      } else {
+        imag = std::log(a + std::sqrt(a * a - T(1)));
+      }
+    } else if (y <= eps * std::fabs(xm1)) {
+      if (x < T(1)) {
+        real = std::acos(x);
+        imag = y / std::sqrt(xp1 * (T(1) - x));
+      } else if (std::numeric_limits<T>::max() / xp1 > xm1) {
+        real = y == T(0) ? T(0) : y / std::sqrt(xp1 * xm1);
+        imag = std::log1p(xm1 + std::sqrt(xp1 * xm1));
+      } else {
+        real = y / x;
+        imag = log_two + std::log(x);
+      }
+    } else if (y <= safe_min) {
+      // x == 1 here
+      real = std::sqrt(y);
+      imag = std::sqrt(y);
+    } else if (eps * y - T(1) >= x) {
+      real = half_pi;
+      imag = log_two + std::log(y);
+    } else if (x > T(1)) {
+      T xoy = x / y;
+      real = std::atan(y / x);
+      imag = log_two + std::log(y) + T(0.5) * std::log1p(xoy * xoy);
+    } else {
+      T a = std::sqrt(T(1) + y * y);
+      real = half_pi;
+      imag = T(0.5) * std::log1p(T(2) * y * (y + a));
+    }
+  }
+  if (std::signbit(z.real())) {
+    real = pi - real;
+  }
+  return c10::complex<T>(real, std::signbit(z.imag()) ? imag : -imag);
+}
+
+template<typename T>
+C10_HOST_DEVICE c10::complex<T> atanh(const c10::complex<T>& z) {
+  const T pi = T(3.14159265358979323846);
+  const T half_pi = T(1.57079632679489661923);
+  const T log_two = T(0.69314718055994530942);
+  const T safe_max = std::sqrt(std::numeric_limits<T>::max()) / T(2);
+  const T safe_min = std::sqrt(std::numeric_limits<T>::min()) * T(2);
+  T x = std::fabs(z.real());
+  T y = std::fabs(z.imag());
+  T real, imag;
+  if (std::isnan(x)) {
+    if (std::isinf(y)) {
+      return c10::complex<T>(std::copysign(T(0), z.real()), std::copysign(half_pi, z.imag()));
+    }
+    return c10::complex<T>(x, x);
+  } else if (std::isnan(y)) {
+    if (x == T(0) || std::isinf(x)) {
+      return c10::complex<T>(std::copysign(T(0), z.real()), y);
+    }
+    return c10::complex<T>(y, y);
+  } else if (x > safe_min && x < safe_max && y > safe_min && y < safe_max) {
+    // real(atanh(z)) = log1p(4x / ((1 - x)^2 + y^2)) / 4
+    // imag(atanh(z)) = atan2(2y, (1 - x)(1 + x) - y^2) / 2
+    T yy = y * y;
+    T mxm1 = T(1) - x;
+    real = std::log1p(T(4) * x / (mxm1 * mxm1 + yy)) / T(4);
+    imag = std::atan2(T(2) * y, mxm1 * (T(1) + x) - yy) / T(2);
+  } else {
+    // Evaluate the formulas above without overflow or underflow in the squares
+    T mxm1 = T(1) - x;
+    if (x >= safe_max) {
+      if (std::isinf(x) || std::isinf(y)) {
+        real = T(0);
+      } else if (y >= safe_max) {
+        real = std::log1p((T(4) / y) / (x / y + y / x));
+      } else if (y > T(1)) {
+        real = std::log1p(T(4) / (x + y * y / x));
+      } else {
+        real = std::log1p(T(4) / x);
+      }
+    } else if (y >= safe_max) {
+      if (std::isinf(y)) {
+        real = T(0);
+      } else if (x > T(1)) {
+        real = std::log1p((T(4) * x / y) / (y + mxm1 * mxm1 / y));
+      } else {
+        real = T(4) * x / y / y;
+      }
+    } else if (x != T(1)) {
+      T div = mxm1 * mxm1;
+      if (y > safe_min) {
+        div += y * y;
+      }
+      real = std::log1p(T(4) * x / div);
+    } else {
+      real = -T(2) * (std::log(y) - log_two);
+    }
+    real /= T(4);
+    // If x or y is large, (1 - x)(1 + x) - y^2 dominates 2y
+    if (x >= safe_max || y >= safe_max) {
+      imag = pi;
+    } else if (x <= safe_min) {
+      if (y <= safe_min) {
+        imag = std::atan2(T(2) * y, T(1));
+      } else {
+        imag = std::atan2(T(2) * y, T(1) - y * y);
+      }
+    } else {
+      imag = (y == T(0) && x == T(1)) ? T(0) : std::atan2(T(2) * y, mxm1 * (T(1) + x));
+    }
+    imag /= T(2);
+  }
+  return c10::complex<T>(std::copysign(real, z.real()), std::copysign(imag, z.imag()));
+}
+
+// asinh(z) = -i asin(i z)
+template<typename T>
+C10_HOST_DEVICE c10::complex<T> asinh(const c10::complex<T>& z) {
+  c10::complex<T> w = std::asin(c10::complex<T>(-z.imag(), z.real()));
+  return c10::complex<T>(w.imag(), -w.real());
+}
+
+// acosh(z) = +-i acos(z), with the sign that makes the real part non-negative
+template<typename T>
+C10_HOST_DEVICE c10::complex<T> acosh(const c10::complex<T>& z) {
+  c10::complex<T> w = std::acos(z);
+  if (std::isnan(w.imag())) {
+    return c10::complex<T>(w.imag(), std::fabs(w.real()));
+  } else if (std::signbit(w.imag())) {
+    return c10::complex<T>(-w.imag(), w.real());
+  }
+  return c10::complex<T>(w.imag(), -w.real());
+}
+
+// atan(z) = -i atanh(i z)
+template<typename T>
+C10_HOST_DEVICE c10::complex<T> atan(const c10::complex<T>& z) {
+  c10::complex<T> w = std::atanh(c10::complex<T>(-z.imag(), z.real()));
+  return c10::complex<T>(w.imag(), -w.real());
+}
+
+} // namespace std
+
+namespace c10 {
+
+// Fused multiply-add
+//
+// fma(a, b, c) computes a * b + c with each part of the result rounded twice
+// instead of four times:
+//
+//   real = fma(a.real, b.real, fma(-a.imag, b.imag, c.real))
+//   imag = fma(a.real, b.imag, fma( a.imag, b.real, c.imag))
+//
+// so accumulating with `acc = c10::fma(x, y, acc)` is both faster (on targets
+// with FMA instructions) and more accurate than `acc += x * y`. Like std::fma
+// the products are always fused, so on targets without FMA instructions this
+// is a slower library call. Results are not the same as `a * b + c`, whose
+// products are rounded before they are added.
+
+namespace detail {
+
+template<typename T>
+C10_HOST_DEVICE T fma(T a, T b, T c) {
+#if defined(__CUDACC__) || defined(__HIPCC__)
+  return ::fma(a, b, c);
+#else
+  return std::fma(a, b, c);
+#endif
+}
+
+} // namespace detail
+
+// a * b + c
+template<typename T>
+C10_HOST_DEVICE c10::complex<T> fma(const c10::complex<T>& a, const c10::complex<T>& b, const c10::complex<T>& c) {
+  return c10::complex<T>(
+    detail::fma<T>(a.real(), b.real(), detail::fma<T>(-a.imag(), b.imag(), c.real())),
+    detail::fma<T>(a.real(), b.imag(), detail::fma<T>(a.imag(), b.real(), c.imag())));
+}
+
+// a * conj(b) + c, the multiply-accumulate of correlations and inner products
+template<typename T>
+C10_HOST_DEVICE c10::complex<T> fma_conj(const c10::complex<T>& a, const c10::complex<T>& b, const c10::complex<T>& c) {
+  return c10::complex<T>(
+    detail::fma<T>(a.real(), b.real(), detail::fma<T>(a.imag(), b.imag(), c.real())),
+    detail::fma<T>(a.imag(), b.real(), detail::fma<T>(-a.real(), b.imag(), c.imag())));
+}
+
+} // namespace c10
@@ -0,0 +1,139 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+#if defined(__AVX__)
+#include <immintrin.h>
+#endif
+
+// Non-temporal (streaming) stores for bulk kernels with large outputs
+//
+// [Non-temporal stores]
+//
+// A normal store first reads the cache line it writes to (read for
+// ownership) and leaves it in the caches, which for an output much larger
+// than the last level cache costs a read of the whole output and evicts
+// data that is still needed. Non-temporal stores write complete cache lines
+// through write-combining buffers to memory instead.
+//
+// The elementwise kernels in c10/util/complex_bulk.h switch to non-temporal
+// stores when the output is at least c10::bulk::get_streaming_threshold()
+// bytes and is not also an input (in-place kernels read every line of the
+// output anyway). The output is written with normal stores up to the first
+// 64-byte boundary and for the last partial block, and with non-temporal
+// stores of whole cache lines in between. Non-temporal stores are weakly
+// ordered, so the kernels end with a store fence (sfence), after which the
+// results are visible to other threads like normal stores.
+//
+// The threshold defaults to default_streaming_threshold, about the size of
+// the last level cache of a server socket. Outputs that are read again
+// right away (e.g. by the next kernel of a fused sequence) are better
+// written normally even when larger; set_streaming_threshold changes it for
+// the process, and a threshold of 0 always streams. Targets without SSE2
+// always use normal stores.
+
+namespace c10 {
+namespace bulk {
+
+constexpr int64_t default_streaming_threshold = int64_t(1) << 25;  // 32 MiB
+
+namespace detail {
+
+inline std::atomic<int64_t>& streaming_threshold_setting() {
+  static std::atomic<int64_t> threshold(default_streaming_threshold);
+  return threshold;
+}
+
+} // namespace detail
+
+// Size in bytes from which the elementwise kernels write their output with
+// non-temporal stores
+inline int64_t get_streaming_threshold() {
+  return detail::streaming_threshold_setting().load(std::memory_order_relaxed);
+}
+
+// bytes < 0 restores the default
+inline void set_streaming_threshold(int64_t bytes) {
+  detail::streaming_threshold_setting().store(bytes < 0 ? default_streaming_threshold : bytes, std::memory_order_relaxed);
+}
+
+namespace detail {
+
+constexpr size_t stream_line = 64;
+
+#if defined(__SSE2__)
+constexpr bool has_stream_stores = true;
+
+// Copies bytes, a multiple of 64, from src to dst with non-temporal stores.
+// Both are aligned to 64 bytes.
+inline void stream_lines(void* dst, const void* src, size_t bytes) {
+  char* d = static_cast<char*>(dst);
+  const char* s = static_cast<const char*>(src);
+  for (size_t offset = 0; offset < bytes; offset += stream_line) {
+#if defined(__AVX__)
+    _mm256_stream_si256(reinterpret_cast<__m256i*>(d + offset), _mm256_load_si256(reinterpret_cast<const __m256i*>(s + offset)));
+    _mm256_stream_si256(reinterpret_cast<__m256i*>(d + offset + 32), _mm256_load_si256(reinterpret_cast<const __m256i*>(s + offset + 32)));
+#else
+    for (size_t k = 0; k < stream_line; k += 16) {
+      _mm_stream_si128(reinterpret_cast<__m128i*>(d + offset + k), _mm_load_si128(reinterpret_cast<const __m128i*>(s + offset + k)));
+    }
+#endif
+  }
+}
+
+// Copies with non-temporal stores where dst is 16-byte aligned
+inline void stream_copy(void* dst, const void* src, size_t bytes) {
+  char* d = static_cast<char*>(dst);
+  const char* s = static_cast<const char*>(src);
+  size_t head = (16 - reinterpret_cast<uintptr_t>(d) % 16) % 16;
+  head = head < bytes ? head : bytes;
+  std::memcpy(d, s, head);
+  d += head;
+  s += head;
+  bytes -= head;
+  for (; bytes >= 16; d += 16, s += 16, bytes -= 16) {
+    _mm_stream_si128(reinterpret_cast<__m128i*>(d), _mm_loadu_si128(reinterpret_cast<const __m128i*>(s)));
+  }
+  std::memcpy(d, s, bytes);
+}
+
+// Orders the non-temporal stores before any later store, so that they are
+// visible to other threads once the thread that made them has finished
+inline void stream_fence() {
+  _mm_sfence();
+}
+#else
+constexpr bool has_stream_stores = false;
+
+inline void stream_lines(void* dst, const void* src, size_t bytes) {
+  std::memcpy(dst, src, bytes);
+}
+
+inline void stream_copy(void* dst, const void* src, size_t bytes) {
+  std::memcpy(dst, src, bytes);
+}
+
+inline void stream_fence() {}
+#endif
+
+// Whether an elementwise kernel writes out, of bytes, with non-temporal
+// stores, see [Non-temporal stores]
+inline bool use_stream_stores(int64_t bytes, bool in_place) {
+  return has_stream_stores && !in_place && bytes >= get_streaming_threshold();
+}
+
+// Number of elements of type E before out reaches a 64-byte boundary
+template<typename E>
+int64_t stream_head(const E* out) {
+  return static_cast<int64_t>((stream_line - reinterpret_cast<uintptr_t>(out) % stream_line) % stream_line / sizeof(E));
+}
+
+} // namespace detail
+} // namespace bulk
+} // namespace c10
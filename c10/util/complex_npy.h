@@ -0,0 +1,846 @@
+#pragma once
+
+#include <c10/util/complex.h>
+#include <c10/util/complex_buffer.h>
+#include <c10/util/complex_file.h>
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+// NumPy .npy and .npz files of complex64 and complex128 arrays
+//
+// [NumPy files]
+//
+//   c10::save_npy(path, data, shape);               // C order
+//   c10::save_npy(path, data, shape, true);         // data in Fortran order
+//   c10::npy_array<T> a = c10::map_npy<T>(path);    // zero-copy if possible
+//   c10::complex_buffer<T> b = c10::load_npy<T>(path, &shape);  // C order
+//
+//   c10::npz_writer w(path);  w.add("x", data, shape);  w.close();
+//   c10::npz_file f(path);    f.map<T>("x");  f.load<T>("x", &shape);
+//
+// c10::complex<float> is stored as complex64 ('c8') and c10::complex<double>
+// as complex128 ('c16'). NumPy has no complex type of two halves, so
+// c10::complex<c10::Half> is not supported.
+//
+// map_npy maps the file read-only and returns an npy_array that points into
+// the mapping when the dtype is T, the byte order is the one of the host and
+// the data is aligned for c10::complex<T>; otherwise it copies the data into
+// a buffer, swapping bytes if needed. npy_array keeps the order of the
+// file: for Fortran-order arrays, fortran_order() is true and the first
+// index varies fastest. load_npy reads the file in a stream instead of
+// mapping it, and always returns the data in C (row-major) order,
+// transposing Fortran-order arrays. A dtype other than T throws.
+//
+// save_npy writes the byte order of the host, with the header padded so
+// that the data starts at a multiple of 64 bytes, like NumPy does, which
+// makes the files written here mappable.
+//
+// .npz files are zip archives of .npy files, with the names of the arrays
+// followed by ".npy". npz_file reads the archives written by np.savez and
+// by npz_writer; archives with entries compressed by np.savez_compressed
+// throw std::runtime_error when opened, since reading them would need zlib. npz_file maps the
+// whole archive, and npy_arrays returned by map share the mapping, so they
+// stay valid after the npz_file is destroyed. npz_writer stores the arrays
+// uncompressed, with zip64 records for arrays or archives of 4 GiB or more,
+// and pads the local headers so that the data of each array is aligned to
+// 64 bytes within the archive and can be mapped.
+//
+// Malformed files and I/O errors throw std::runtime_error, see
+// [Complex files].
+
+namespace c10 {
+
+struct npy_header {
+  complex_dtype dtype;
+  bool little_endian;
+  bool fortran_order;
+  std::vector<int64_t> shape;
+  int64_t data_offset;  // in bytes from the start of the .npy data
+
+  int64_t numel() const {
+    int64_t n = 1;
+    for (int64_t d : shape) {
+      n *= d;
+    }
+    return n;
+  }
+};
+
+namespace detail {
+
+template<typename T>
+struct check_npy_type {
+  static_assert(std::is_same<T, float>::value || std::is_same<T, double>::value,
+    ".npy files only support c10::complex<float> and c10::complex<double>");
+};
+
+constexpr char npy_magic[6] = {'\x93', 'N', 'U', 'M', 'P', 'Y'};
+constexpr size_t npy_alignment = 64;
+
+inline std::string npy_descr(complex_dtype dtype) {
+  return std::string(host_little_endian() ? "<" : ">") + (dtype == complex_dtype::complex_float ? "c8" : "c16");
+}
+
+// The header of an array with the byte order of the host, up to the data
+inline std::string encode_npy_header(complex_dtype dtype, const std::vector<int64_t>& shape, bool fortran_order) {
+  std::string dict = "{'descr': '" + npy_descr(dtype) + "', 'fortran_order': " + (fortran_order ? "True" : "False") + ", 'shape': (";
+  for (size_t i = 0; i < shape.size(); i++) {
+    dict += (i > 0 ? ", " : "") + std::to_string(shape[i]);
+  }
+  dict += shape.size() == 1 ? ",), }" : "), }";
+  // version 1.0 has a 16 bit header length, 2.0 a 32 bit one
+  size_t prefix = 10;
+  size_t total = (prefix + dict.size() + 1 + npy_alignment - 1) / npy_alignment * npy_alignment;
+  if (total - prefix > 0xffff) {
+    prefix = 12;
+    total = (prefix + dict.size() + 1 + npy_alignment - 1) / npy_alignment * npy_alignment;
+  }
+  std::string header(npy_magic, sizeof(npy_magic));
+  header += static_cast<char>(prefix == 10 ? 1 : 2);
+  header += '\0';
+  const size_t length = total - prefix;
+  for (size_t i = 0; i < prefix - 8; i++) {
+    header += static_cast<char>((length >> (8 * i)) & 0xff);
+  }
+  header += dict;
+  header.append(total - header.size() - 1, ' ');
+  header += '\n';
+  return header;
+}
+
+// The text after "'key':" in the header dictionary, without leading spaces
+inline std::string npy_dict_value(const std::string& dict, const char* key, const char* function, const std::string& path) {
+  const std::string quoted = std::string("'") + key + "'";
+  size_t p = dict.find(quoted);
+  if (p == std::string::npos) {
+    p = dict.find(std::string("\"") + key + "\"");
+  }
+  if (p == std::string::npos || (p = dict.find(':', p + quoted.size())) == std::string::npos) {
+    complex_file_error(function, path, std::string("missing '") + key + "' in the .npy header");
+  }
+  p = dict.find_first_not_of(' ', p + 1);
+  return p == std::string::npos ? std::string() : dict.substr(p);
+}
+
+inline npy_header parse_npy_dict(const std::string& dict, const char* function, const std::string& path) {
+  npy_header header;
+  // descr, e.g. '<c16'
+  const std::string descr_value = npy_dict_value(dict, "descr", function, path);
+  const size_t end = descr_value.find(descr_value.empty() ? '\'' : descr_value[0], 1);
+  if (descr_value.empty() || (descr_value[0] != '\'' && descr_value[0] != '"') || end == std::string::npos) {
+    complex_file_error(function, path, "invalid descr in the .npy header");
+  }
+  std::string descr = descr_value.substr(1, end - 1);
+  header.little_endian = host_little_endian();
+  if (!descr.empty() && (descr[0] == '<' || descr[0] == '>' || descr[0] == '=' || descr[0] == '|')) {
+    if (descr[0] == '<' || descr[0] == '>') {
+      header.little_endian = descr[0] == '<';
+    }
+    descr = descr.substr(1);
+  }
+  if (descr == "c8") {
+    header.dtype = complex_dtype::complex_float;
+  } else if (descr == "c16") {
+    header.dtype = complex_dtype::complex_double;
+  } else {
+    complex_file_error(function, path, "unsupported dtype '" + descr_value.substr(1, end - 1) + "', only complex64 and complex128 are supported");
+  }
+  // fortran_order
+  const std::string fortran = npy_dict_value(dict, "fortran_order", function, path);
+  if (fortran.compare(0, 4, "True") == 0) {
+    header.fortran_order = true;
+  } else if (fortran.compare(0, 5, "False") == 0) {
+    header.fortran_order = false;
+  } else {
+    complex_file_error(function, path, "invalid fortran_order in the .npy header");
+  }
+  // shape, e.g. (3, 4) or (3,) or ()
+  const std::string shape = npy_dict_value(dict, "shape", function, path);
+  const size_t close = shape.find(')');
+  if (shape.empty() || shape[0] != '(' || close == std::string::npos) {
+    complex_file_error(function, path, "invalid shape in the .npy header");
+  }
+  size_t p = 1;
+  while (true) {
+    p = shape.find_first_not_of(", ", p);
+    if (p >= close) {
+      break;
+    }
+    size_t digits = p;
+    while (digits < close && shape[digits] >= '0' && shape[digits] <= '9') {
+      digits++;
+    }
+    if (digits == p || digits - p > 18) {
+      complex_file_error(function, path, "invalid shape in the .npy header");
+    }
+    header.shape.push_back(std::stoll(shape.substr(p, digits - p)));
+    // Python 2 wrote long integers as 3L
+    p = digits < close && shape[digits] == 'L' ? digits + 1 : digits;
+  }
+  check_complex_file_shape(header.shape, header.dtype, function, path);
+  return header;
+}
+
+// Parses the header of a .npy, reading bytes with read(dst, n), which
+// returns false at the end of the data
+template<typename Read>
+npy_header read_npy_header(Read read, const char* function, const std::string& path) {
+  unsigned char prefix[12];
+  if (!read(prefix, 10) || std::memcmp(prefix, npy_magic, sizeof(npy_magic)) != 0) {
+    complex_file_error(function, path, "not a .npy file");
+  }
+  const int major = prefix[6];
+  if (major < 1 || major > 3) {
+    complex_file_error(function, path, "unsupported .npy version " + std::to_string(major));
+  }
+  size_t prefix_size = 10;
+  size_t length = prefix[8] | size_t(prefix[9]) << 8;
+  if (major >= 2) {
+    if (!read(prefix + 10, 2)) {
+      complex_file_error(function, path, "truncated .npy header");
+    }
+    prefix_size = 12;
+    length |= size_t(prefix[10]) << 16 | size_t(prefix[11]) << 24;
+  }
+  std::string dict(length, '\0');
+  if (length > 0 && !read(&dict[0], length)) {
+    complex_file_error(function, path, "truncated .npy header");
+  }
+  npy_header header = parse_npy_dict(dict, function, path);
+  header.data_offset = prefix_size + length;
+  return header;
+}
+
+// Copies src, in Fortran order, to dst in C order
+template<typename V>
+void fortran_to_c_order(const V* src, V* dst, const std::vector<int64_t>& shape) {
+  const int64_t ndim = shape.size();
+  int64_t n = 1;
+  std::vector<int64_t> strides(ndim);
+  for (int64_t k = 0; k < ndim; k++) {
+    strides[k] = n;
+    n *= shape[k];
+  }
+  if (n == 0) {
+    return;
+  }
+  const int64_t last = ndim - 1;
+  const int64_t inner = shape[last];
+  const int64_t inner_stride = strides[last];
+  std::vector<int64_t> index(ndim, 0);
+  int64_t offset = 0;
+  for (int64_t i = 0; i < n; i += inner) {
+    for (int64_t j = 0; j < inner; j++) {
+      dst[i + j] = src[offset + j * inner_stride];
+    }
+    for (int64_t k = last - 1; k >= 0; k--) {
+      offset += strides[k];
+      if (++index[k] < shape[k]) {
+        break;
+      }
+      offset -= index[k] * strides[k];
+      index[k] = 0;
+    }
+  }
+}
+
+// Puts data, as read from a file with header, in the byte order of the host
+// and in C order if c_order
+template<typename T>
+complex_buffer<T> npy_to_host(complex_buffer<T> data, const npy_header& header, bool c_order) {
+  if (header.little_endian != host_little_endian()) {
+    swap_bytes(data.data(), 2 * data.size(), sizeof(T));
+  }
+  if (c_order && header.fortran_order && header.shape.size() > 1) {
+    complex_buffer<T> transposed(data.size());
+    fortran_to_c_order(data.data(), transposed.data(), header.shape);
+    return transposed;
+  }
+  return data;
+}
+
+template<typename T>
+void check_npy_dtype(const npy_header& header, const char* function, const std::string& path) {
+  check_npy_type<T>();
+  if (header.dtype != complex_dtype_of<T>::value) {
+    complex_file_error(function, path, "dtype does not match");
+  }
+}
+
+// CRC-32 of zip archives, computed 8 bytes at a time ("slicing-by-8")
+struct crc32_tables {
+  uint32_t t[8][256];
+
+  crc32_tables() {
+    for (uint32_t i = 0; i < 256; i++) {
+      uint32_t c = i;
+      for (int k = 0; k < 8; k++) {
+        c = c & 1 ? 0xedb88320u ^ (c >> 1) : c >> 1;
+      }
+      t[0][i] = c;
+    }
+    for (int k = 1; k < 8; k++) {
+      for (int i = 0; i < 256; i++) {
+        t[k][i] = (t[k - 1][i] >> 8) ^ t[0][t[k - 1][i] & 0xff];
+      }
+    }
+  }
+};
+
+inline uint32_t crc32_update(uint32_t crc, const void* data, size_t n) {
+  static const crc32_tables tables;
+  const auto& t = tables.t;
+  const unsigned char* p = static_cast<const unsigned char*>(data);
+  crc = ~crc;
+  if (host_little_endian()) {
+    for (; n >= 8; n -= 8, p += 8) {
+      uint32_t lo, hi;
+      std::memcpy(&lo, p, 4);
+      std::memcpy(&hi, p + 4, 4);
+      lo ^= crc;
+      crc = t[7][lo & 0xff] ^ t[6][(lo >> 8) & 0xff] ^ t[5][(lo >> 16) & 0xff] ^ t[4][lo >> 24] ^
+            t[3][hi & 0xff] ^ t[2][(hi >> 8) & 0xff] ^ t[1][(hi >> 16) & 0xff] ^ t[0][hi >> 24];
+    }
+  }
+  for (; n > 0; n--, p++) {
+    crc = t[0][(crc ^ *p) & 0xff] ^ (crc >> 8);
+  }
+  return ~crc;
+}
+
+// Little-endian fields of zip archives
+
+inline void put_le(std::string& out, uint64_t value, int bytes) {
+  for (int i = 0; i < bytes; i++) {
+    out += static_cast<char>((value >> (8 * i)) & 0xff);
+  }
+}
+
+inline uint64_t get_le(const char* p, int bytes) {
+  uint64_t value = 0;
+  for (int i = 0; i < bytes; i++) {
+    value |= uint64_t(static_cast<unsigned char>(p[i])) << (8 * i);
+  }
+  return value;
+}
+
+constexpr uint32_t zip_local_signature = 0x04034b50;
+constexpr uint32_t zip_central_signature = 0x02014b50;
+constexpr uint32_t zip_end_signature = 0x06054b50;
+constexpr uint32_t zip64_end_signature = 0x06064b50;
+constexpr uint32_t zip64_locator_signature = 0x07064b50;
+constexpr uint16_t zip64_extra_id = 0x0001;
+constexpr uint16_t zip_align_extra_id = 0xd935;  // padding, as by Android's zipalign
+constexpr uint64_t zip32_max = 0xffffffff;
+constexpr uint16_t zip_dos_date = (0 << 9) | (1 << 5) | 1;  // 1980-01-01
+
+} // namespace detail
+
+// An array of a .npy file, either pointing into a mapping of the file or
+// copied, see [NumPy files]
+template<typename T>
+class npy_array {
+ public:
+  using value_type = c10::complex<T>;
+
+  npy_array() = default;
+
+  // The .npy stored in bytes [begin, end) of file
+  npy_array(std::shared_ptr<const detail::mapped_file> file, size_t begin, size_t end, const char* function, const std::string& path) {
+    const char* data = file->data() + begin;
+    size_t position = 0;
+    auto read = [&](void* dst, size_t n) {
+      if (end - begin - position < n) {
+        return false;
+      }
+      std::memcpy(dst, data + position, n);
+      position += n;
+      return true;
+    };
+    header_ = detail::read_npy_header(read, function, path);
+    detail::check_npy_dtype<T>(header_, function, path);
+    const int64_t n = header_.numel();
+    if (static_cast<int64_t>(end - begin) < header_.data_offset + n * int64_t(sizeof(value_type))) {
+      detail::complex_file_error(function, path, "truncated data");
+    }
+    const char* start = data + header_.data_offset;
+    if (n == 0) {
+      return;
+    }
+    if (header_.little_endian == detail::host_little_endian() &&
+        reinterpret_cast<uintptr_t>(start) % alignof(value_type) == 0) {
+      file_ = std::move(file);
+      data_ = reinterpret_cast<const value_type*>(start);
+    } else {
+      complex_buffer<T> copy(n);
+      std::memcpy(static_cast<void*>(copy.data()), start, n * sizeof(value_type));
+      copy_ = detail::npy_to_host(std::move(copy), header_, false);
+      data_ = copy_.data();
+    }
+  }
+
+  const value_type* data() const {
+    return data_;
+  }
+  int64_t size() const {
+    return data_ == nullptr ? 0 : header_.numel();
+  }
+  const std::vector<int64_t>& shape() const {
+    return header_.shape;
+  }
+  bool fortran_order() const {
+    return header_.fortran_order;
+  }
+  // whether data() points into the file
+  bool is_mapped() const {
+    return file_ != nullptr;
+  }
+  const value_type* begin() const {
+    return data();
+  }
+  const value_type* end() const {
+    return data() + size();
+  }
+  const value_type& operator[](int64_t i) const {
+    return data_[i];
+  }
+
+ private:
+  std::shared_ptr<const detail::mapped_file> file_;
+  complex_buffer<T> copy_;
+  npy_header header_{complex_dtype_of<T>::value, true, false, {}, 0};
+  const value_type* data_ = nullptr;
+};
+
+// Reads the header of the .npy file at path
+inline npy_header read_npy_header(const std::string& path) {
+  const char* function = "c10::read_npy_header";
+  detail::file_ptr f = detail::open_file(path, "rb", function);
+  auto read = [&](void* dst, size_t n) {
+    return std::fread(dst, 1, n, f.get()) == n;
+  };
+  return detail::read_npy_header(read, function, path);
+}
+
+// Writes n = prod(shape) elements to a new .npy file at path. data is in
+// Fortran order if fortran_order, and in C order otherwise.
+template<typename T>
+void save_npy(const std::string& path, const c10::complex<T>* data, const std::vector<int64_t>& shape, bool fortran_order = false) {
+  detail::check_npy_type<T>();
+  const char* function = "c10::save_npy";
+  detail::check_complex_file_shape(shape, complex_dtype_of<T>::value, function, path);
+  detail::file_ptr f = detail::open_file(path, "wb", function);
+  const std::string header = detail::encode_npy_header(complex_dtype_of<T>::value, shape, fortran_order);
+  npy_header h{complex_dtype_of<T>::value, true, fortran_order, shape, 0};
+  const size_t bytes = h.numel() * sizeof(c10::complex<T>);
+  if (std::fwrite(header.data(), 1, header.size(), f.get()) != header.size() ||
+      (bytes > 0 && std::fwrite(data, 1, bytes, f.get()) != bytes) ||
+      std::fclose(f.release()) != 0) {
+    detail::complex_file_errno(function, path);
+  }
+}
+
+// Maps the .npy file at path, see [NumPy files]
+template<typename T>
+npy_array<T> map_npy(const std::string& path) {
+  const char* function = "c10::map_npy";
+  auto file = std::make_shared<const detail::mapped_file>(path, function);
+  const size_t size = file->size();
+  return npy_array<T>(std::move(file), 0, size, function, path);
+}
+
+// Reads the .npy file at path in C order, and its shape if shape is not
+// null
+template<typename T>
+complex_buffer<T> load_npy(const std::string& path, std::vector<int64_t>* shape = nullptr) {
+  const char* function = "c10::load_npy";
+  detail::file_ptr f = detail::open_file(path, "rb", function);
+  auto read = [&](void* dst, size_t n) {
+    return std::fread(dst, 1, n, f.get()) == n;
+  };
+  const npy_header header = detail::read_npy_header(read, function, path);
+  detail::check_npy_dtype<T>(header, function, path);
+  complex_buffer<T> data(header.numel());
+  if (!read(data.data(), data.size() * sizeof(c10::complex<T>))) {
+    detail::complex_file_error(function, path, "truncated data");
+  }
+  if (shape != nullptr) {
+    *shape = header.shape;
+  }
+  return detail::npy_to_host(std::move(data), header, true);
+}
+
+// The arrays of a .npz file, see [NumPy files]
+class npz_file {
+ public:
+  explicit npz_file(const std::string& path): path_(path) {
+    const char* function = "c10::npz_file";
+    file_ = std::make_shared<const detail::mapped_file>(path, function);
+    const char* data = file_->data();
+    const uint64_t size = file_->size();
+    auto fail = [&]() {
+      detail::complex_file_error(function, path, "not a valid zip archive");
+    };
+    auto signature_at = [&](uint64_t offset, uint32_t signature) {
+      return offset + 4 <= size && detail::get_le(data + offset, 4) == signature;
+    };
+
+    // the end of central directory record, followed by a comment of at most
+    // 64 KiB
+    const uint64_t end_size = 22;
+    if (size < end_size) {
+      fail();
+    }
+    uint64_t end = size - end_size;
+    const uint64_t lowest = size > end_size + 0xffff ? size - end_size - 0xffff : 0;
+    while (!signature_at(end, detail::zip_end_signature)) {
+      if (end == lowest) {
+        fail();
+      }
+      end--;
+    }
+    uint64_t count = detail::get_le(data + end + 10, 2);
+    uint64_t directory = detail::get_le(data + end + 16, 4);
+    if (count == 0xffff || directory == detail::zip32_max) {
+      // zip64
+      if (end < 20 || !signature_at(end - 20, detail::zip64_locator_signature)) {
+        fail();
+      }
+      const uint64_t end64 = detail::get_le(data + end - 20 + 8, 8);
+      if (end64 + 56 > size || !signature_at(end64, detail::zip64_end_signature)) {
+        fail();
+      }
+      count = detail::get_le(data + end64 + 32, 8);
+      directory = detail::get_le(data + end64 + 48, 8);
+    }
+
+    // the central directory
+    uint64_t p = directory;
+    for (uint64_t i = 0; i < count; i++) {
+      if (p + 46 > size || !signature_at(p, detail::zip_central_signature)) {
+        fail();
+      }
+      entry e;
+      const uint64_t method = detail::get_le(data + p + 10, 2);
+      uint64_t compressed_size = detail::get_le(data + p + 20, 4);
+      e.size = detail::get_le(data + p + 24, 4);
+      const uint64_t name_size = detail::get_le(data + p + 28, 2);
+      const uint64_t extra_size = detail::get_le(data + p + 30, 2);
+      const uint64_t comment_size = detail::get_le(data + p + 32, 2);
+      uint64_t local = detail::get_le(data + p + 42, 4);
+      if (p + 46 + name_size + extra_size + comment_size > size) {
+        fail();
+      }
+      e.name.assign(data + p + 46, name_size);
+      // the zip64 extra field has the 64 bit values of the saturated fields
+      for (uint64_t q = p + 46 + name_size; q + 4 <= p + 46 + name_size + extra_size;) {
+        const uint64_t id = detail::get_le(data + q, 2);
+        const uint64_t length = detail::get_le(data + q + 2, 2);
+        uint64_t field = q + 4;
+        if (id == detail::zip64_extra_id) {
+          auto take = [&](uint64_t& value) {
+            if (value == detail::zip32_max && field + 8 <= q + 4 + length) {
+              value = detail::get_le(data + field, 8);
+              field += 8;
+            }
+          };
+          take(e.size);
+          take(compressed_size);
+          take(local);
+        }
+        q += 4 + length;
+      }
+      p += 46 + name_size + extra_size + comment_size;
+      // the data follows the local header, whose extra field may differ
+      if (local + 30 > size || !signature_at(local, detail::zip_local_signature)) {
+        fail();
+      }
+      if (method != 0) {
+        detail::complex_file_error(function, path, e.name + " is compressed, only archives written by np.savez are supported");
+      }
+      // header() and map() read [offset, offset + size), which must be in
+      // the mapping
+      e.offset = local + 30 + detail::get_le(data + local + 26, 2) + detail::get_le(data + local + 28, 2);
+      if (e.size != compressed_size || e.offset > size || e.size > size - e.offset) {
+        fail();
+      }
+      if (e.name.size() > 4 && e.name.compare(e.name.size() - 4, 4, ".npy") == 0) {
+        e.name.resize(e.name.size() - 4);
+      }
+      entries_.push_back(std::move(e));
+    }
+  }
+
+  // The names of the arrays
+  std::vector<std::string> names() const {
+    std::vector<std::string> result;
+    for (const entry& e : entries_) {
+      result.push_back(e.name);
+    }
+    return result;
+  }
+
+  bool contains(const std::string& name) const {
+    return find(name) != nullptr;
+  }
+
+  npy_header header(const std::string& name) const {
+    const entry& e = get(name, "c10::npz_file::header");
+    size_t position = 0;
+    auto read = [&](void* dst, size_t n) {
+      if (e.size - position < n) {
+        return false;
+      }
+      std::memcpy(dst, file_->data() + e.offset + position, n);
+      position += n;
+      return true;
+    };
+    return detail::read_npy_header(read, "c10::npz_file::header", path_ + ":" + name);
+  }
+
+  // The array name, pointing into the mapping of the archive when possible
+  template<typename T>
+  npy_array<T> map(const std::string& name) const {
+    const entry& e = get(name, "c10::npz_file::map");
+    return npy_array<T>(file_, e.offset, e.offset + e.size, "c10::npz_file::map", path_ + ":" + name);
+  }
+
+  // A copy of the array name in C order, and its shape if shape is not null
+  template<typename T>
+  complex_buffer<T> load(const std::string& name, std::vector<int64_t>* shape = nullptr) const {
+    npy_array<T> array = map<T>(name);
+    complex_buffer<T> data(array.size());
+    if (array.size() > 0) {
+      std::memcpy(static_cast<void*>(data.data()), array.data(), array.size() * sizeof(c10::complex<T>));
+    }
+    if (shape != nullptr) {
+      *shape = array.shape();
+    }
+    // the bytes are already swapped by map
+    npy_header h{complex_dtype_of<T>::value, detail::host_little_endian(), array.fortran_order(), array.shape(), 0};
+    return detail::npy_to_host(std::move(data), h, true);
+  }
+
+ private:
+  struct entry {
+    std::string name;
+    uint64_t size;
+    uint64_t offset;
+  };
+
+  const entry* find(const std::string& name) const {
+    for (const entry& e : entries_) {
+      if (e.name == name) {
+        return &e;
+      }
+    }
+    return nullptr;
+  }
+
+  const entry& get(const std::string& name, const char* function) const {
+    const entry* e = find(name);
+    if (e == nullptr) {
+      detail::complex_file_error(function, path_, "no array named " + name);
+    }
+    return *e;
+  }
+
+  std::string path_;
+  std::shared_ptr<const detail::mapped_file> file_;
+  std::vector<entry> entries_;
+};
+
+// Writes a .npz file, see [NumPy files]
+class npz_writer {
+ public:
+  explicit npz_writer(const std::string& path)
+    : path_(path), file_(detail::open_file(path, "wb", "c10::npz_writer")) {}
+
+  npz_writer(npz_writer&&) = default;
+  // Closes the archive of *this first, which writes its central directory
+  npz_writer& operator=(npz_writer&& other) {
+    if (this != &other) {
+      close();
+      path_ = std::move(other.path_);
+      file_ = std::move(other.file_);
+      entries_ = std::move(other.entries_);
+      offset_ = other.offset_;
+    }
+    return *this;
+  }
+
+  ~npz_writer() {
+    try {
+      close();
+    } catch (const std::exception&) {
+      // errors can only be reported by calling close
+    }
+  }
+
+  // Adds the array name of shape, like save_npy
+  template<typename T>
+  void add(const std::string& name, const c10::complex<T>* data, const std::vector<int64_t>& shape, bool fortran_order = false) {
+    detail::check_npy_type<T>();
+    if (file_ == nullptr) {
+      throw std::logic_error("c10::npz_writer: the archive is closed");
+    }
+    const char* function = "c10::npz_writer";
+    detail::check_complex_file_shape(shape, complex_dtype_of<T>::value, function, path_);
+    const std::string header = detail::encode_npy_header(complex_dtype_of<T>::value, shape, fortran_order);
+    npy_header h{complex_dtype_of<T>::value, true, fortran_order, shape, 0};
+    const uint64_t bytes = h.numel() * sizeof(c10::complex<T>);
+
+    entry e;
+    e.name = name + ".npy";
+    e.size = header.size() + bytes;
+    e.offset = offset_;
+    e.crc = detail::crc32_update(0, header.data(), header.size());
+    e.crc = detail::crc32_update(e.crc, data, bytes);
+    const bool zip64 = e.size >= detail::zip32_max;
+
+    std::string extra;
+    if (zip64) {
+      detail::put_le(extra, detail::zip64_extra_id, 2);
+      detail::put_le(extra, 16, 2);
+      detail::put_le(extra, e.size, 8);
+      detail::put_le(extra, e.size, 8);
+    }
+    // pad so that the .npy, whose header is a multiple of 64 bytes, starts
+    // at a multiple of 64 bytes
+    const uint64_t unpadded = offset_ + 30 + e.name.size() + extra.size() + 4;
+    const uint64_t padding = (detail::npy_alignment - unpadded % detail::npy_alignment) % detail::npy_alignment;
+    detail::put_le(extra, detail::zip_align_extra_id, 2);
+    detail::put_le(extra, padding, 2);
+    extra.append(padding, '\0');
+
+    std::string local;
+    detail::put_le(local, detail::zip_local_signature, 4);
+    detail::put_le(local, zip64 ? 45 : 20, 2);  // version needed
+    detail::put_le(local, 0, 2);                // flags
+    detail::put_le(local, 0, 2);                // stored
+    detail::put_le(local, 0, 2);                // time
+    detail::put_le(local, detail::zip_dos_date, 2);
+    detail::put_le(local, e.crc, 4);
+    detail::put_le(local, zip64 ? detail::zip32_max : e.size, 4);
+    detail::put_le(local, zip64 ? detail::zip32_max : e.size, 4);
+    detail::put_le(local, e.name.size(), 2);
+    detail::put_le(local, extra.size(), 2);
+    local += e.name;
+    local += extra;
+    write(local.data(), local.size());
+    write(header.data(), header.size());
+    write(data, bytes);
+    entries_.push_back(std::move(e));
+  }
+
+  // Writes the central directory and closes the file
+  void close() {
+    if (file_ == nullptr) {
+      return;
+    }
+    const uint64_t directory = offset_;
+    std::string central;
+    for (const entry& e : entries_) {
+      const bool large_size = e.size >= detail::zip32_max;
+      const bool large_offset = e.offset >= detail::zip32_max;
+      std::string extra;
+      if (large_size || large_offset) {
+        detail::put_le(extra, detail::zip64_extra_id, 2);
+        detail::put_le(extra, (large_size ? 16 : 0) + (large_offset ? 8 : 0), 2);
+        if (large_size) {
+          detail::put_le(extra, e.size, 8);
+          detail::put_le(extra, e.size, 8);
+        }
+        if (large_offset) {
+          detail::put_le(extra, e.offset, 8);
+        }
+      }
+      const int version = extra.empty() ? 20 : 45;
+      detail::put_le(central, detail::zip_central_signature, 4);
+      detail::put_le(central, version, 2);  // version made by
+      detail::put_le(central, version, 2);  // version needed
+      detail::put_le(central, 0, 2);        // flags
+      detail::put_le(central, 0, 2);        // stored
+      detail::put_le(central, 0, 2);        // time
+      detail::put_le(central, detail::zip_dos_date, 2);
+      detail::put_le(central, e.crc, 4);
+      detail::put_le(central, large_size ? detail::zip32_max : e.size, 4);
+      detail::put_le(central, large_size ? detail::zip32_max : e.size, 4);
+      detail::put_le(central, e.name.size(), 2);
+      detail::put_le(central, extra.size(), 2);
+      detail::put_le(central, 0, 2);  // comment
+      detail::put_le(central, 0, 2);  // disk
+      detail::put_le(central, 0, 2);  // internal attributes
+      detail::put_le(central, 0, 4);  // external attributes
+      detail::put_le(central, large_offset ? detail::zip32_max : e.offset, 4);
+      central += e.name;
+      central += extra;
+    }
+    const uint64_t count = entries_.size();
+    const uint64_t directory_size = central.size();
+    const bool zip64 = count >= 0xffff || directory >= detail::zip32_max || directory_size >= detail::zip32_max;
+    std::string end;
+    if (zip64) {
+      const uint64_t end64 = directory + directory_size;
+      detail::put_le(end, detail::zip64_end_signature, 4);
+      detail::put_le(end, 44, 8);  // size of the rest of the record
+      detail::put_le(end, 45, 2);
+      detail::put_le(end, 45, 2);
+      detail::put_le(end, 0, 4);
+      detail::put_le(end, 0, 4);
+      detail::put_le(end, count, 8);
+      detail::put_le(end, count, 8);
+      detail::put_le(end, directory_size, 8);
+      detail::put_le(end, directory, 8);
+      detail::put_le(end, detail::zip64_locator_signature, 4);
+      detail::put_le(end, 0, 4);
+      detail::put_le(end, end64, 8);
+      detail::put_le(end, 1, 4);
+    }
+    detail::put_le(end, detail::zip_end_signature, 4);
+    detail::put_le(end, 0, 2);
+    detail::put_le(end, 0, 2);
+    detail::put_le(end, zip64 ? 0xffff : count, 2);
+    detail::put_le(end, zip64 ? 0xffff : count, 2);
+    detail::put_le(end, zip64 ? detail::zip32_max : directory_size, 4);
+    detail::put_le(end, zip64 ? detail::zip32_max : directory, 4);
+    detail::put_le(end, 0, 2);  // comment
+    write(central.data(), central.size());
+    write(end.data(), end.size());
+    if (std::fclose(file_.release()) != 0) {
+      detail::complex_file_errno("c10::npz_writer", path_);
+    }
+  }
+
+ private:
+  struct entry {
+    std::string name;
+    uint64_t size;
+    uint64_t offset;
+    uint32_t crc;
+  };
+
+  void write(const void* data, size_t bytes) {
+    if (bytes > 0 && std::fwrite(data, 1, bytes, file_.get()) != bytes) {
+      detail::complex_file_errno("c10::npz_writer", path_);
+    }
+    offset_ += bytes;
+  }
+
+  std::string path_;
+  detail::file_ptr file_;
+  std::vector<entry> entries_;
+  uint64_t offset_ = 0;
+};
+
+} // namespace c10
@@ -0,0 +1,108 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <exception>
+#include <mutex>
+#include <system_error>
+#include <thread>
+#include <vector>
+
+// A minimal parallel loop for bulk kernels on large buffers
+//
+// c10::parallel_for(begin, end, grain_size, f) calls f(chunk_begin, chunk_end)
+// on disjoint chunks that cover [begin, end), following at::parallel_for in
+// PyTorch:
+// - if the range has at most grain_size elements, or only one thread is
+//   allowed, f is called once on the calling thread
+// - otherwise the range is split into at most c10::get_num_threads() chunks
+//   of at least grain_size elements each. The calling thread runs the first
+//   chunk and a new thread is started for each of the others.
+// If f throws, the first exception is rethrown once every chunk has finished.
+//
+// Threads are started for every call, so grain_size should be large enough
+// that a chunk takes much longer than starting a thread (tens of
+// microseconds).
+
+namespace c10 {
+namespace detail {
+
+inline std::atomic<int>& num_threads_setting() {
+  static std::atomic<int> num_threads(0);
+  return num_threads;
+}
+
+} // namespace detail
+
+// Number of threads used by parallel_for, std::thread::hardware_concurrency()
+// unless it was changed by set_num_threads
+inline int get_num_threads() {
+  int n = detail::num_threads_setting().load(std::memory_order_relaxed);
+  if (n > 0) {
+    return n;
+  }
+  return std::max(1, static_cast<int>(std::thread::hardware_concurrency()));
+}
+
+// n <= 0 restores the default
+inline void set_num_threads(int n) {
+  detail::num_threads_setting().store(n, std::memory_order_relaxed);
+}
+
+namespace detail {
+
+// Number of chunks parallel_for splits size elements into. Chunks have
+// ceil(size / num_chunks) elements, except the last one.
+inline int64_t parallel_num_chunks(int64_t size, int64_t grain_size) {
+  const int64_t max_chunks = std::max<int64_t>(1, size / std::max<int64_t>(grain_size, 1));
+  return std::min<int64_t>(get_num_threads(), max_chunks);
+}
+
+} // namespace detail
+
+template<typename F>
+void parallel_for(int64_t begin, int64_t end, int64_t grain_size, const F& f) {
+  if (begin >= end) {
+    return;
+  }
+  const int64_t size = end - begin;
+  const int64_t num_chunks = detail::parallel_num_chunks(size, grain_size);
+  if (num_chunks == 1) {
+    f(begin, end);
+    return;
+  }
+  const int64_t chunk_size = (size + num_chunks - 1) / num_chunks;
+  std::exception_ptr error;
+  std::mutex error_mutex;
+  auto run = [&](int64_t chunk_begin, int64_t chunk_end) {
+    try {
+      f(chunk_begin, chunk_end);
+    } catch (...) {
+      std::lock_guard<std::mutex> guard(error_mutex);
+      if (!error) {
+        error = std::current_exception();
+      }
+    }
+  };
+  std::vector<std::thread> threads;
+  threads.reserve(num_chunks - 1);
+  for (int64_t chunk_begin = begin + chunk_size; chunk_begin < end; chunk_begin += chunk_size) {
+    const int64_t chunk_end = std::min(end, chunk_begin + chunk_size);
+    try {
+      threads.emplace_back(run, chunk_begin, chunk_end);
+    } catch (const std::system_error&) {
+      // out of threads, run the chunk here instead
+      run(chunk_begin, chunk_end);
+    }
+  }
+  run(begin, std::min(end, begin + chunk_size));
+  for (auto& thread : threads) {
+    thread.join();
+  }
+  if (error) {
+    std::rethrow_exception(error);
+  }
+}
+
+} // namespace c10
@@ -0,0 +1,548 @@
+#pragma once
+
+#include <c10/util/complex.h>
+#include <c10/util/complex_buffer.h>
+#include <c10/util/complex_file.h>
+#include <c10/util/complex_parallel.h>
+
+#include <algorithm>
+#include <cerrno>
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <exception>
+#include <limits>
+#include <stdexcept>
+#include <string>
+#include <system_error>
+#include <type_traits>
+#include <vector>
+
+#if defined(__GLIBC__) || defined(__APPLE__) || defined(__FreeBSD__)
+#define C10_HAS_STRTOD_L 1
+#include <locale.h>
+#if defined(__APPLE__) || defined(__FreeBSD__)
+#include <xlocale.h>
+#endif
+#endif
+
+// Fast text parsing of c10::complex
+//
+// [Complex parsing]
+//
+// operator>> reads through std::complex and the locale of the stream. The
+// functions below parse text in memory instead, like std::from_chars:
+//
+//   c10::from_chars(first, last, z)                    one number
+//   c10::parse_csv_column<T>(first, last, column, options)
+//   c10::read_csv_column<T>(path, column, options)     maps the file
+//
+// from_chars accepts, with optional spaces inside the parentheses:
+//
+//   (1.5,-2)   (1.5)         like operator>>
+//   1.5-2j     1.5-2i        like Python and NumPy, also in parentheses
+//   -2j  2i  1+j  1.5        pure imaginary, unit imaginary, real
+//
+// which covers the styles of c10::to_chars, see [Complex formatting]. Real
+// and imaginary parts are decimal numbers like those of strtod, without
+// hexadecimal floats, or inf, infinity and nan in any case. from_chars does
+// not skip leading spaces, stops at the first character that does not
+// belong to the number, and returns the position of that character. If no
+// number starts at first, it returns {first, std::errc::invalid_argument};
+// if a part overflows, it returns std::errc::result_out_of_range. z is only
+// changed on success.
+//
+// Numbers of at most 19 significant digits with small exponents (up to
+// 10^22 for double, 10^10 for float) are converted exactly with a single
+// multiplication or division (Clinger's fast path), others with strtod_l in
+// the "C" locale, or strtod on systems without strtod_l.
+//
+// parse_csv_column reads one column of complex numbers in any of these
+// forms, or with csv_options::imag_column two columns of real and
+// imaginary parts, into a complex_buffer with one element per non-empty
+// line. Delimiters inside parentheses or double quotes do not split fields,
+// so "(1,2)" is one field, and the quotes around a field are removed; line
+// breaks are "\n" or "\r\n", and fields must not contain line breaks. Inputs
+// of more than csv_grain_size bytes are split at line breaks between
+// threads with c10::parallel_for: a first pass counts the rows and lines
+// of each part, and a second parses each part directly into its place in
+// the result. A field that is missing or can not be parsed entirely throws
+// std::runtime_error with its line number in the text, from 1, counting
+// the skipped and empty lines; with several, the first one is reported,
+// whatever the number of threads.
+
+namespace c10 {
+
+struct from_chars_result {
+  const char* ptr;
+  std::errc ec;
+};
+
+namespace detail {
+
+template<typename T>
+struct check_parse_type {
+  static_assert(std::is_same<T, float>::value || std::is_same<T, double>::value,
+    "parsing only supports c10::complex<float> and c10::complex<double>");
+};
+
+inline bool is_digit(char c) {
+  return c >= '0' && c <= '9';
+}
+
+inline char to_lower(char c) {
+  return c >= 'A' && c <= 'Z' ? c - 'A' + 'a' : c;
+}
+
+// Whether [p, last) starts with word, in any case
+inline bool starts_with_word(const char* p, const char* last, const char* word) {
+  for (; *word != '\0'; p++, word++) {
+    if (p == last || to_lower(*p) != *word) {
+      return false;
+    }
+  }
+  return true;
+}
+
+// Mantissas and powers of ten that T represents exactly, so that their
+// product or quotient is correctly rounded
+template<typename T>
+struct fast_path;
+template<>
+struct fast_path<float> {
+  static constexpr uint64_t max_mantissa = uint64_t(1) << 24;
+  static constexpr int max_exponent = 10;
+};
+template<>
+struct fast_path<double> {
+  static constexpr uint64_t max_mantissa = uint64_t(1) << 53;
+  static constexpr int max_exponent = 22;
+};
+
+template<typename T>
+T exact_pow10(int k) {
+  static const T powers[] = {
+    T(1e0), T(1e1), T(1e2), T(1e3), T(1e4), T(1e5), T(1e6), T(1e7), T(1e8), T(1e9), T(1e10), T(1e11),
+    T(1e12), T(1e13), T(1e14), T(1e15), T(1e16), T(1e17), T(1e18), T(1e19), T(1e20), T(1e21), T(1e22)};
+  return powers[k];
+}
+
+#if defined(C10_HAS_STRTOD_L)
+inline locale_t c_locale() {
+  static const locale_t locale = newlocale(LC_ALL_MASK, "C", static_cast<locale_t>(0));
+  return locale;
+}
+#endif
+
+// strtod on [first, last), a number without inf or nan
+template<typename T>
+T slow_parse(const char* first, const char* last) {
+  char small[64];
+  std::string large;
+  char* text = small;
+  const size_t size = last - first;
+  if (size >= sizeof(small)) {
+    large.assign(first, last);
+    text = &large[0];
+  } else {
+    std::memcpy(small, first, size);
+    small[size] = '\0';
+  }
+#if defined(C10_HAS_STRTOD_L)
+  if (std::is_same<T, float>::value) {
+    return static_cast<T>(strtof_l(text, nullptr, c_locale()));
+  }
+  return static_cast<T>(strtod_l(text, nullptr, c_locale()));
+#else
+  if (std::is_same<T, float>::value) {
+    return static_cast<T>(std::strtof(text, nullptr));
+  }
+  return static_cast<T>(std::strtod(text, nullptr));
+#endif
+}
+
+// Parses a real number at first, see [Complex parsing]
+template<typename T>
+from_chars_result parse_real(const char* first, const char* last, T& value) {
+  const char* p = first;
+  bool negative = false;
+  if (p != last && (*p == '+' || *p == '-')) {
+    negative = *p == '-';
+    p++;
+  }
+  if (p != last && (*p == 'i' || *p == 'I' || *p == 'n' || *p == 'N')) {
+    if (starts_with_word(p, last, "infinity")) {
+      value = negative ? -std::numeric_limits<T>::infinity() : std::numeric_limits<T>::infinity();
+      return {p + 8, std::errc()};
+    }
+    if (starts_with_word(p, last, "inf")) {
+      value = negative ? -std::numeric_limits<T>::infinity() : std::numeric_limits<T>::infinity();
+      return {p + 3, std::errc()};
+    }
+    if (starts_with_word(p, last, "nan")) {
+      value = negative ? -std::numeric_limits<T>::quiet_NaN() : std::numeric_limits<T>::quiet_NaN();
+      return {p + 3, std::errc()};
+    }
+    return {first, std::errc::invalid_argument};
+  }
+
+  // up to 19 significant digits fit in mantissa, the others only change the
+  // exponent, and make the fast path inexact unless they are zeros
+  uint64_t mantissa = 0;
+  int digits = 0;
+  int64_t exponent = 0;
+  bool any_digit = false;
+  bool inexact = false;
+  for (; p != last && is_digit(*p); p++) {
+    any_digit = true;
+    const int d = *p - '0';
+    if (digits < 19) {
+      mantissa = mantissa * 10 + d;
+      digits += mantissa != 0;
+    } else {
+      exponent++;
+      inexact |= d != 0;
+    }
+  }
+  if (p != last && *p == '.') {
+    for (p++; p != last && is_digit(*p); p++) {
+      any_digit = true;
+      const int d = *p - '0';
+      if (digits < 19) {
+        mantissa = mantissa * 10 + d;
+        digits += mantissa != 0;
+        exponent--;
+      } else {
+        inexact |= d != 0;
+      }
+    }
+  }
+  if (!any_digit) {
+    return {first, std::errc::invalid_argument};
+  }
+  if (p != last && (*p == 'e' || *p == 'E')) {
+    const char* q = p + 1;
+    bool negative_exponent = false;
+    if (q != last && (*q == '+' || *q == '-')) {
+      negative_exponent = *q == '-';
+      q++;
+    }
+    if (q != last && is_digit(*q)) {
+      int64_t e = 0;
+      for (; q != last && is_digit(*q); q++) {
+        e = std::min<int64_t>(e * 10 + (*q - '0'), int64_t(1) << 32);
+      }
+      exponent += negative_exponent ? -e : e;
+      p = q;
+    }
+  }
+
+  T result;
+  if (mantissa == 0) {
+    result = T(0);
+  } else if (!inexact && mantissa <= fast_path<T>::max_mantissa &&
+             exponent >= -fast_path<T>::max_exponent && exponent <= fast_path<T>::max_exponent) {
+    result = static_cast<T>(mantissa);
+    result = exponent < 0 ? result / exact_pow10<T>(-exponent) : result * exact_pow10<T>(exponent);
+  } else {
+    result = slow_parse<T>(negative || *first == '+' ? first + 1 : first, p);
+    if (std::isinf(result)) {
+      return {p, std::errc::result_out_of_range};
+    }
+  }
+  value = negative ? -result : result;
+  return {p, std::errc()};
+}
+
+inline const char* skip_spaces(const char* p, const char* last) {
+  while (p != last && (*p == ' ' || *p == '\t')) {
+    p++;
+  }
+  return p;
+}
+
+inline bool is_imaginary_unit(const char* p, const char* last) {
+  return p != last && (*p == 'j' || *p == 'J' || *p == 'i' || *p == 'I');
+}
+
+// a+bj and its special cases, see [Complex parsing]
+template<typename T>
+from_chars_result parse_python_complex(const char* first, const char* last, T& re, T& im) {
+  T a;
+  from_chars_result r = parse_real(first, last, a);
+  if (r.ec == std::errc::invalid_argument) {
+    // j, +j, -j
+    const char* p = first;
+    const bool negative = p != last && *p == '-';
+    if (p != last && (*p == '+' || *p == '-')) {
+      p++;
+    }
+    if (is_imaginary_unit(p, last)) {
+      re = T(0);
+      im = negative ? T(-1) : T(1);
+      return {p + 1, std::errc()};
+    }
+    return r;
+  }
+  if (is_imaginary_unit(r.ptr, last)) {
+    re = T(0);
+    im = a;
+    return {r.ptr + 1, r.ec};
+  }
+  const char* p = r.ptr;
+  if (p != last && (*p == '+' || *p == '-')) {
+    T b;
+    from_chars_result s = parse_real(p, last, b);
+    if (s.ec != std::errc::invalid_argument && is_imaginary_unit(s.ptr, last)) {
+      re = a;
+      im = b;
+      return {s.ptr + 1, r.ec != std::errc() ? r.ec : s.ec};
+    }
+    if (s.ec == std::errc::invalid_argument && is_imaginary_unit(p + 1, last)) {
+      re = a;
+      im = *p == '-' ? T(-1) : T(1);
+      return {p + 2, r.ec};
+    }
+  }
+  re = a;
+  im = T(0);
+  return r;
+}
+
+} // namespace detail
+
+// Parses a complex number at first, see [Complex parsing]
+template<typename T>
+from_chars_result from_chars(const char* first, const char* last, c10::complex<T>& z) {
+  detail::check_parse_type<T>();
+  T re, im;
+  if (first != last && *first == '(') {
+    const char* p = detail::skip_spaces(first + 1, last);
+    // (re,im), or else (re) or (a+bj)
+    from_chars_result r = detail::parse_real(p, last, re);
+    const char* comma = r.ec == std::errc::invalid_argument ? last : detail::skip_spaces(r.ptr, last);
+    if (comma != last && *comma == ',') {
+      from_chars_result s = detail::parse_real(detail::skip_spaces(comma + 1, last), last, im);
+      if (s.ec == std::errc::invalid_argument) {
+        return {first, s.ec};
+      }
+      if (r.ec == std::errc()) {
+        r.ec = s.ec;
+      }
+      r.ptr = s.ptr;
+    } else {
+      r = detail::parse_python_complex(p, last, re, im);
+      if (r.ec == std::errc::invalid_argument) {
+        return {first, r.ec};
+      }
+    }
+    p = detail::skip_spaces(r.ptr, last);
+    if (p == last || *p != ')') {
+      return {first, std::errc::invalid_argument};
+    }
+    if (r.ec == std::errc()) {
+      z = c10::complex<T>(re, im);
+    }
+    return {p + 1, r.ec};
+  }
+  from_chars_result r = detail::parse_python_complex(first, last, re, im);
+  if (r.ec == std::errc()) {
+    z = c10::complex<T>(re, im);
+  }
+  return r;
+}
+
+// Number of bytes of CSV parsed by each thread at least
+constexpr int64_t csv_grain_size = int64_t(1) << 20;
+
+struct csv_options {
+  char delimiter = ',';
+  // lines skipped at the start, e.g. 1 for a header
+  int64_t skip_rows = 0;
+  // if not negative, the column of the imaginary parts, and the column
+  // passed to parse_csv_column is the one of the real parts
+  int64_t imag_column = -1;
+};
+
+namespace detail {
+
+// The end of the line that starts at p, without "\r"
+inline const char* line_end(const char* p, const char* last, const char*& next) {
+  const char* end = static_cast<const char*>(std::memchr(p, '\n', last - p));
+  if (end == nullptr) {
+    end = last;
+    next = last;
+  } else {
+    next = end + 1;
+  }
+  if (end != p && end[-1] == '\r') {
+    end--;
+  }
+  return end;
+}
+
+// Rows, i.e. non-empty lines, in [first, last), and all its lines
+inline int64_t count_csv_rows(const char* first, const char* last, int64_t& lines) {
+  int64_t rows = 0;
+  lines = 0;
+  const char* next;
+  for (const char* p = first; p != last; p = next) {
+    rows += line_end(p, last, next) != p;
+    lines++;
+  }
+  return rows;
+}
+
+// The field column of the line [p, end), without surrounding spaces and
+// quotes, or false if the line has fewer fields
+inline bool csv_field(const char* p, const char* end, int64_t column, char delimiter, const char*& field_begin, const char*& field_end) {
+  int64_t field = 0;
+  const char* begin = p;
+  int depth = 0;
+  bool quoted = false;
+  for (;; p++) {
+    if (p == end || (*p == delimiter && depth == 0 && !quoted)) {
+      if (field == column) {
+        begin = skip_spaces(begin, p);
+        const char* e = p;
+        while (e != begin && (e[-1] == ' ' || e[-1] == '\t')) {
+          e--;
+        }
+        if (e - begin >= 2 && *begin == '"' && e[-1] == '"') {
+          begin++;
+          e--;
+        }
+        field_begin = begin;
+        field_end = e;
+        return true;
+      }
+      if (p == end) {
+        return false;
+      }
+      field++;
+      begin = p + 1;
+    } else if (*p == '"') {
+      quoted = !quoted;
+    } else if (!quoted && *p == '(') {
+      depth++;
+    } else if (!quoted && *p == ')' && depth > 0) {
+      depth--;
+    }
+  }
+}
+
+[[noreturn]] inline void csv_parse_error(int64_t line_number, const std::string& what) {
+  throw std::runtime_error("c10::parse_csv_column: line " + std::to_string(line_number) + ": " + what);
+}
+
+template<typename T, typename Parse>
+void parse_csv_field(const char* line, const char* end, int64_t column, char delimiter, int64_t line_number, Parse parse) {
+  const char* begin;
+  const char* field_end;
+  if (!csv_field(line, end, column, delimiter, begin, field_end)) {
+    csv_parse_error(line_number, "missing column " + std::to_string(column));
+  }
+  const from_chars_result r = parse(begin, field_end);
+  if (r.ec != std::errc() || r.ptr != field_end) {
+    csv_parse_error(line_number, "can not parse '" + std::string(begin, field_end) + "'");
+  }
+}
+
+// Parses the rows of [first, last) to out, the first line of which is
+// line_number in the text
+template<typename T>
+void parse_csv_rows(const char* first, const char* last, int64_t column, const csv_options& options, int64_t line_number, c10::complex<T>* out) {
+  const char* next;
+  for (const char* p = first; p != last; p = next, line_number++) {
+    const char* end = line_end(p, last, next);
+    if (end == p) {
+      continue;
+    }
+    if (options.imag_column < 0) {
+      parse_csv_field<T>(p, end, column, options.delimiter, line_number, [&](const char* b, const char* e) {
+        return from_chars(b, e, *out);
+      });
+    } else {
+      T re, im;
+      parse_csv_field<T>(p, end, column, options.delimiter, line_number, [&](const char* b, const char* e) {
+        return parse_real(b, e, re);
+      });
+      parse_csv_field<T>(p, end, options.imag_column, options.delimiter, line_number, [&](const char* b, const char* e) {
+        return parse_real(b, e, im);
+      });
+      *out = c10::complex<T>(re, im);
+    }
+    out++;
+  }
+}
+
+} // namespace detail
+
+// Parses column of the CSV text [first, last), see [Complex parsing]
+template<typename T>
+complex_buffer<T> parse_csv_column(const char* first, const char* last, int64_t column, const csv_options& options = csv_options()) {
+  detail::check_parse_type<T>();
+  const char* next;
+  int64_t skipped = 0;
+  for (; skipped < options.skip_rows && first != last; skipped++) {
+    detail::line_end(first, last, next);
+    first = next;
+  }
+  // parts that start after a line break
+  const int64_t size = last - first;
+  const int64_t num_parts = std::max<int64_t>(1, std::min<int64_t>(size / csv_grain_size, 64 * c10::get_num_threads()));
+  std::vector<const char*> starts(num_parts + 1, last);
+  starts[0] = first;
+  for (int64_t k = 1; k < num_parts; k++) {
+    const char* p = first + k * (size / num_parts);
+    if (p <= starts[k - 1]) {
+      starts[k] = starts[k - 1];
+    } else {
+      const char* newline = static_cast<const char*>(std::memchr(p - 1, '\n', last - p + 1));
+      starts[k] = newline == nullptr ? last : newline + 1;
+    }
+  }
+  // rows and lines of each part, then the row and line each part starts at
+  std::vector<int64_t> offsets(num_parts + 1, 0);
+  std::vector<int64_t> lines(num_parts + 1, 0);
+  c10::parallel_for(0, num_parts, 1, [&](int64_t begin, int64_t end) {
+    for (int64_t k = begin; k < end; k++) {
+      offsets[k + 1] = detail::count_csv_rows(starts[k], starts[k + 1], lines[k + 1]);
+    }
+  });
+  lines[0] = skipped + 1;
+  for (int64_t k = 0; k < num_parts; k++) {
+    offsets[k + 1] += offsets[k];
+    lines[k + 1] += lines[k];
+  }
+  complex_buffer<T> result(offsets[num_parts]);
+  c10::complex<T>* out = result.data();
+  // each part stops at its first error; the error of the first part that
+  // has one is that of the lowest line, whatever the number of threads
+  std::vector<std::exception_ptr> errors(num_parts);
+  c10::parallel_for(0, num_parts, 1, [&](int64_t begin, int64_t end) {
+    for (int64_t k = begin; k < end; k++) {
+      try {
+        detail::parse_csv_rows(starts[k], starts[k + 1], column, options, lines[k], out + offsets[k]);
+      } catch (...) {
+        errors[k] = std::current_exception();
+      }
+    }
+  });
+  for (const std::exception_ptr& error : errors) {
+    if (error) {
+      std::rethrow_exception(error);
+    }
+  }
+  return result;
+}
+
+// Parses column of the CSV file at path, see [Complex parsing]
+template<typename T>
+complex_buffer<T> read_csv_column(const std::string& path, int64_t column, const csv_options& options = csv_options()) {
+  const detail::mapped_file file(path, "c10::read_csv_column");
+  return parse_csv_column<T>(file.data(), file.data() + file.size(), column, options);
+}
+
+} // namespace c10
@@ -0,0 +1,214 @@
+#pragma once
+
+#include <c10/util/complex.h>
+#include <c10/util/complex_constexpr.h>
+
+#include <cmath>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+
+// Tables of roots of unity and FFT twiddle factors
+//
+// [Roots of unity]
+//
+// For a size n, the view returned by c10::roots_of_unity<T>(n) gives
+//
+//   view[k]         = exp(2 pi i k / n)
+//   view.twiddle(k) = exp(-2 pi i k / n)
+//
+// for k in [0, n). Tables only store part of the circle and find the other
+// roots by symmetry, which is exact (it only swaps and negates parts):
+// - if 8 divides n, the first octant, k in [0, n / 8]
+// - else if 4 divides n, the first quadrant
+// - else if 2 divides n, the first half
+// - else all n roots
+// So a table of n = 4096 roots of c10::complex<double> takes 8 KB instead of
+// 64 KB, and the roots are exactly symmetric: view[n / 4] is exactly i, and
+// view[n - k] is exactly the conjugate of view[k].
+//
+// Tables come from two places:
+// - c10::static_roots_of_unity<T, N> is computed at compile time with
+//   c10::constexpr_math::root_of_unity, so it lives in read-only data and is
+//   correctly rounded. A table of size N also serves every n that divides
+//   N, by reading it with a stride of N / n.
+// - c10::roots_of_unity<T>(n) returns a view into the compile-time table of
+//   one of the default sizes 2^12, 3 * 2^10 and 5 * 2^10 if n divides it.
+//   Otherwise the table is built with long double sin and cos when n is
+//   first requested and kept for the lifetime of the program; building is
+//   thread-safe.
+
+namespace c10 {
+namespace detail {
+
+// Tables store the roots for k in [0, n / roots_symmetry(n)]
+constexpr int64_t roots_symmetry(int64_t n) {
+  return n % 8 == 0 ? 8 : (n % 4 == 0 ? 4 : (n % 2 == 0 ? 2 : 1));
+}
+
+constexpr int64_t roots_stored(int64_t n) {
+  return n / roots_symmetry(n) + 1;
+}
+
+template<typename T, int64_t Size>
+struct roots_table {
+  c10::complex<T> data[Size];
+};
+
+// Evaluating the Taylor series for every entry makes large tables slow to
+// compile, so first octant tables multiply by the first root instead, in
+// double-double, starting again from the series every 32 entries. The
+// accumulated error of at most 31 products stays below 2^-98, so the
+// entries are still correctly rounded.
+template<typename T, int64_t N>
+constexpr roots_table<T, roots_stored(N)> make_roots_table() {
+  namespace cm = c10::constexpr_math::detail;
+  using U = typename cm::check_constexpr_type<T>::type;
+  roots_table<T, roots_stored(N)> table{};
+  if (roots_symmetry(N) != 8) {
+    for (int64_t k = 0; k < roots_stored(N); k++) {
+      table.data[k] = c10::constexpr_math::root_of_unity<T>(k, N);
+    }
+    return table;
+  }
+  // root k is at the angle (pi / 4) * (8k / N)
+  const cm::sin_cos step = cm::sincos_octant(8, N);
+  cm::sin_cos w = step;
+  for (int64_t k = 0; k < roots_stored(N); k++) {
+    if (k % 32 == 0) {
+      w = cm::sincos_octant(8 * k, N);
+    } else {
+      w = cm::sin_cos{
+        cm::add(cm::mul(w.sin, step.cos), cm::mul(w.cos, step.sin)),
+        cm::sub(cm::mul(w.cos, step.cos), cm::mul(w.sin, step.sin))};
+    }
+    table.data[k] = c10::complex<T>(cm::rounding<U>::round(w.cos), cm::rounding<U>::round(w.sin));
+  }
+  return table;
+}
+
+} // namespace detail
+
+// A read-only view of the roots of unity of size n, see [Roots of unity]
+template<typename T>
+class roots_of_unity_view {
+ public:
+  // table stores the roots of size table_n, and n divides table_n
+  constexpr roots_of_unity_view(const c10::complex<T>* table, int64_t table_n, int64_t n)
+    : table_(table), table_n_(table_n), stride_(table_n / n), n_(n) {}
+
+  constexpr int64_t size() const {
+    return n_;
+  }
+
+  // exp(2 pi i k / n) for k in [0, n)
+  constexpr c10::complex<T> operator[](int64_t k) const {
+    return lookup(k * stride_);
+  }
+
+  // exp(-2 pi i k / n) for k in [0, n)
+  constexpr c10::complex<T> twiddle(int64_t k) const {
+    return lookup(k == 0 ? 0 : (n_ - k) * stride_);
+  }
+
+ private:
+  // root k of the table, k in [0, table_n)
+  constexpr c10::complex<T> lookup(int64_t k) const {
+    const int64_t symmetry = detail::roots_symmetry(table_n_);
+    if (symmetry == 1) {
+      return table_[k];
+    }
+    if (symmetry == 2) {
+      const int64_t half = table_n_ / 2;
+      return k < half ? table_[k] : negate(table_[k - half]);
+    }
+    // rotate the root of the first quadrant by quadrant * pi / 2, where the
+    // first quadrant itself is the first octant mirrored at pi / 4
+    const int64_t quarter = table_n_ / 4;
+    const int64_t quadrant = k / quarter;
+    const int64_t r = k % quarter;
+    const bool mirrored = symmetry == 8 && 2 * r > quarter;
+    const c10::complex<T> stored = table_[mirrored ? quarter - r : r];
+    const c10::complex<T> w = mirrored ? c10::complex<T>(stored.imag(), stored.real()) : stored;
+    switch (quadrant) {
+      case 0: return w;
+      case 1: return c10::complex<T>(T(0) - w.imag(), w.real());
+      case 2: return negate(w);
+      default: return c10::complex<T>(w.imag(), T(0) - w.real());
+    }
+  }
+
+  // 0 - x instead of -x, so that zeros stay positive
+  static constexpr c10::complex<T> negate(const c10::complex<T>& w) {
+    return c10::complex<T>(T(0) - w.real(), T(0) - w.imag());
+  }
+
+  const c10::complex<T>* table_;
+  int64_t table_n_;
+  int64_t stride_;
+  int64_t n_;
+};
+
+// Roots of unity of size N computed at compile time
+template<typename T, int64_t N>
+struct static_roots_of_unity {
+  static_assert(N >= 1 && N < (int64_t(1) << 59), "size of roots of unity out of range");
+  static constexpr detail::roots_table<T, detail::roots_stored(N)> table = detail::make_roots_table<T, N>();
+
+  // view of the roots of size n, which has to divide N
+  static constexpr roots_of_unity_view<T> view(int64_t n = N) {
+    return roots_of_unity_view<T>(table.data, N, n);
+  }
+};
+
+template<typename T, int64_t N>
+constexpr detail::roots_table<T, detail::roots_stored(N)> static_roots_of_unity<T, N>::table;
+
+namespace detail {
+
+// Entry k of the table of size n, computed in long double and reduced to
+// the first octant like constexpr_math::root_of_unity
+template<typename T>
+c10::complex<T> runtime_root_of_unity(int64_t k, int64_t n) {
+  constexpr long double pi_4 = 0.785398163397448309615660845819875721L;
+  c10::constexpr_math::detail::octant o = c10::constexpr_math::detail::reduce_octant(k, n);
+  long double phi = pi_4 * (static_cast<long double>(o.r) / static_cast<long double>(n));
+  T c = static_cast<T>(o.swap ? std::sin(phi) : std::cos(phi));
+  T s = static_cast<T>(o.swap ? std::cos(phi) : std::sin(phi));
+  c10::constexpr_math::detail::rotate_quadrant(s, c, o.quadrant);
+  return c10::complex<T>(c, s);
+}
+
+} // namespace detail
+
+// Roots of unity of size n >= 1, see [Roots of unity]
+template<typename T>
+roots_of_unity_view<T> roots_of_unity(int64_t n) {
+  using pow2_roots = static_roots_of_unity<T, 4096>;
+  using radix3_roots = static_roots_of_unity<T, 3 * 1024>;
+  using radix5_roots = static_roots_of_unity<T, 5 * 1024>;
+  if (4096 % n == 0) {
+    return pow2_roots::view(n);
+  }
+  if (3 * 1024 % n == 0) {
+    return radix3_roots::view(n);
+  }
+  if (5 * 1024 % n == 0) {
+    return radix5_roots::view(n);
+  }
+  static std::mutex mutex;
+  static std::unordered_map<int64_t, std::unique_ptr<c10::complex<T>[]>> tables;
+  std::lock_guard<std::mutex> guard(mutex);
+  auto& table = tables[n];
+  if (!table) {
+    const int64_t stored = detail::roots_stored(n);
+    table.reset(new c10::complex<T>[stored]);
+    for (int64_t k = 0; k < stored; k++) {
+      table[k] = detail::runtime_root_of_unity<T>(k, n);
+    }
+  }
+  return roots_of_unity_view<T>(table.get(), n, n);
+}
+
+} // namespace c10
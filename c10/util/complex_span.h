@@ -0,0 +1,248 @@
+#pragma once
+
+#include <c10/util/complex.h>
+
+#include <complex>
+#include <cstddef>
+#include <cstdint>
+#include <stdexcept>
+#include <type_traits>
+
+// Zero-copy views of arrays of complex numbers in different layouts
+//
+// [Complex spans]
+//
+// c10::span<T> is a non-owning view of contiguous elements, like std::span
+// in C++20. The functions below reinterpret a span of complex numbers as a
+// span of another complex type, without copying:
+//
+//   c10::as_std_complex(s)   c10::complex<T> -> std::complex<T>
+//   c10::as_c_complex(s)     c10::complex<T> -> C99 T _Complex
+//   c10::as_interleaved(s)   c10::complex<T> -> T, with twice as many elements
+//   c10::as_c10_complex(s)   any of the above -> c10::complex<T>
+//
+// All of these layouts store the real part followed by the imaginary part
+// without padding, which is checked with static_assert below. The only
+// difference is alignment: c10::complex<T> is aligned to 2 * sizeof(T),
+// while the others may only be aligned to alignof(T). So views of
+// c10::complex are always valid, but as_c10_complex checks the alignment at
+// runtime and throws std::invalid_argument for misaligned data, and for
+// interleaved arrays of odd size. const is kept: a view of const elements
+// is a view of const elements.
+//
+// std::complex and _Complex are supported for float and double, interleaved
+// arrays for c10::Half, float and double. _Complex is a C99 type that C++
+// compilers only have as an extension, so as_c_complex is only defined for
+// GCC and clang (C10_HAS_C_COMPLEX).
+
+#if defined(__GNUC__) || defined(__clang__)
+#define C10_HAS_C_COMPLEX 1
+#endif
+
+namespace c10 {
+
+template<typename T>
+class span {
+ public:
+  using element_type = T;
+
+  constexpr span(): data_(nullptr), size_(0) {}
+  constexpr span(T* data, int64_t size): data_(data), size_(size) {}
+  template<size_t N>
+  constexpr span(T (&array)[N]): data_(array), size_(N) {}
+  // containers with contiguous data() and size(), e.g. std::vector
+  template<typename Container, typename = typename std::enable_if<
+    std::is_convertible<decltype(std::declval<Container&>().data()), T*>::value>::type>
+  constexpr span(Container& container): data_(container.data()), size_(container.size()) {}
+  // span<const T> from span<T>
+  template<typename U, typename = typename std::enable_if<
+    !std::is_same<U, T>::value && std::is_convertible<U(*)[], T(*)[]>::value>::type>
+  constexpr span(const span<U>& other): data_(other.data()), size_(other.size()) {}
+
+  constexpr T* data() const {
+    return data_;
+  }
+  constexpr int64_t size() const {
+    return size_;
+  }
+  constexpr bool empty() const {
+    return size_ == 0;
+  }
+  constexpr T& operator[](int64_t i) const {
+    return data_[i];
+  }
+  constexpr T* begin() const {
+    return data_;
+  }
+  constexpr T* end() const {
+    return data_ + size_;
+  }
+  constexpr span subspan(int64_t offset, int64_t count) const {
+    return span(data_ + offset, count);
+  }
+
+ private:
+  T* data_;
+  int64_t size_;
+};
+
+template<typename T>
+constexpr span<T> make_span(T* data, int64_t size) {
+  return span<T>(data, size);
+}
+
+template<typename Container>
+constexpr span<typename std::remove_pointer<decltype(std::declval<Container&>().data())>::type> make_span(Container& container) {
+  return container;
+}
+
+namespace detail {
+
+#define C10_CHECK_COMPLEX_LAYOUT(other_t, T)                                               \
+  static_assert(sizeof(other_t) == 2 * sizeof(T), "complex layout mismatch");              \
+  static_assert(sizeof(c10::complex<T>) == sizeof(other_t), "complex layout mismatch");   \
+  static_assert(alignof(c10::complex<T>) % alignof(other_t) == 0, "complex layout mismatch")
+
+C10_CHECK_COMPLEX_LAYOUT(std::complex<float>, float);
+C10_CHECK_COMPLEX_LAYOUT(std::complex<double>, double);
+#if defined(C10_HAS_C_COMPLEX)
+C10_CHECK_COMPLEX_LAYOUT(float _Complex, float);
+C10_CHECK_COMPLEX_LAYOUT(double _Complex, double);
+#endif
+static_assert(std::is_standard_layout<c10::complex<float>>::value && std::is_standard_layout<c10::complex<double>>::value,
+  "c10::complex has to be standard layout to be reinterpreted");
+static_assert(offsetof(c10::complex<double>, storage) == 0, "c10::complex has to start with its real part");
+
+#undef C10_CHECK_COMPLEX_LAYOUT
+
+template<typename T>
+struct check_span_type {
+  static_assert(std::is_same<T, float>::value || std::is_same<T, double>::value,
+    "only complex<float> and complex<double> have std::complex and _Complex layouts");
+};
+
+template<typename To, typename From>
+span<To> reinterpret_span(span<From> s, int64_t size) {
+  return span<To>(reinterpret_cast<To*>(s.data()), size);
+}
+
+// views into c10::complex<T> have to be aligned to 2 * sizeof(T)
+template<typename T, typename From>
+span<T> checked_span(span<From> s, int64_t size) {
+  if (reinterpret_cast<uintptr_t>(s.data()) % alignof(T) != 0) {
+    throw std::invalid_argument("c10::as_c10_complex: data is not aligned to the alignment of c10::complex");
+  }
+  return reinterpret_span<T>(s, size);
+}
+
+} // namespace detail
+
+// c10::complex<T> -> std::complex<T>
+
+template<typename T>
+span<std::complex<T>> as_std_complex(span<c10::complex<T>> s) {
+  detail::check_span_type<T>();
+  return detail::reinterpret_span<std::complex<T>>(s, s.size());
+}
+
+template<typename T>
+span<const std::complex<T>> as_std_complex(span<const c10::complex<T>> s) {
+  detail::check_span_type<T>();
+  return detail::reinterpret_span<const std::complex<T>>(s, s.size());
+}
+
+// std::complex<T> -> c10::complex<T>
+
+template<typename T>
+span<c10::complex<T>> as_c10_complex(span<std::complex<T>> s) {
+  detail::check_span_type<T>();
+  return detail::checked_span<c10::complex<T>>(s, s.size());
+}
+
+template<typename T>
+span<const c10::complex<T>> as_c10_complex(span<const std::complex<T>> s) {
+  detail::check_span_type<T>();
+  return detail::checked_span<const c10::complex<T>>(s, s.size());
+}
+
+// c10::complex<T> -> T[2 * n], real and imaginary parts interleaved
+
+template<typename T>
+span<T> as_interleaved(span<c10::complex<T>> s) {
+  return detail::reinterpret_span<T>(s, 2 * s.size());
+}
+
+template<typename T>
+span<const T> as_interleaved(span<const c10::complex<T>> s) {
+  return detail::reinterpret_span<const T>(s, 2 * s.size());
+}
+
+// T[2 * n] -> c10::complex<T>
+
+template<typename T, typename = typename std::enable_if<std::is_arithmetic<T>::value && !std::is_const<T>::value>::type>
+span<c10::complex<T>> as_c10_complex(span<T> s) {
+  if (s.size() % 2 != 0) {
+    throw std::invalid_argument("c10::as_c10_complex: an interleaved array must have an even size");
+  }
+  return detail::checked_span<c10::complex<T>>(s, s.size() / 2);
+}
+
+template<typename T, typename = typename std::enable_if<std::is_arithmetic<T>::value>::type>
+span<const c10::complex<T>> as_c10_complex(span<const T> s) {
+  if (s.size() % 2 != 0) {
+    throw std::invalid_argument("c10::as_c10_complex: an interleaved array must have an even size");
+  }
+  return detail::checked_span<const c10::complex<T>>(s, s.size() / 2);
+}
+
+#if defined(C10_HAS_C_COMPLEX)
+
+// c10::complex<T> -> T _Complex
+
+namespace detail {
+
+// _Complex can not be applied to a template parameter
+template<typename T>
+struct c_complex;
+template<>
+struct c_complex<float> {
+  using type = float _Complex;
+};
+template<>
+struct c_complex<double> {
+  using type = double _Complex;
+};
+
+} // namespace detail
+
+template<typename T>
+span<typename detail::c_complex<T>::type> as_c_complex(span<c10::complex<T>> s) {
+  return detail::reinterpret_span<typename detail::c_complex<T>::type>(s, s.size());
+}
+
+template<typename T>
+span<const typename detail::c_complex<T>::type> as_c_complex(span<const c10::complex<T>> s) {
+  return detail::reinterpret_span<const typename detail::c_complex<T>::type>(s, s.size());
+}
+
+// T _Complex -> c10::complex<T>
+
+inline span<c10::complex<float>> as_c10_complex(span<float _Complex> s) {
+  return detail::checked_span<c10::complex<float>>(s, s.size());
+}
+
+inline span<const c10::complex<float>> as_c10_complex(span<const float _Complex> s) {
+  return detail::checked_span<const c10::complex<float>>(s, s.size());
+}
+
+inline span<c10::complex<double>> as_c10_complex(span<double _Complex> s) {
+  return detail::checked_span<c10::complex<double>>(s, s.size());
+}
+
+inline span<const c10::complex<double>> as_c10_complex(span<const double _Complex> s) {
+  return detail::checked_span<const c10::complex<double>>(s, s.size());
+}
+
+#endif
+
+} // namespace c10
@@ -0,0 +1,276 @@
+#pragma once
+
+#include <c10/util/complex.h>
+#include <c10/util/complex_fft.h>
+#include <c10/util/complex_parallel.h>
+#include <c10/util/complex_span.h>
+#include <c10/util/complex_vec_math.h>
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <limits>
+#include <stdexcept>
+#include <type_traits>
+#include <vector>
+
+// Short-time Fourier transforms and spectrograms of c10::complex streams
+//
+// [STFT]
+//
+// c10::stft<T> cuts a stream of c10::complex<T>, T float or double, into
+// frames of W inputs that start every hop inputs, multiplies each frame by
+// a window and transforms it with an FFT of size N >= W, padding with
+// zeros. The window is one of fft_window, or any W values given as a span,
+// which the stft copies:
+//
+//   c10::stft<float> s(c10::window_kind::hann, 1024, 256);        // W = N = 1024, hop 256
+//   int64_t frames = s.transform(x, n, out);                      // complex bins
+//   int64_t frames = s.transform(x, n, out, c10::spectrogram_scale::power_db);
+//
+// Frame f starts at input f hop and holds bins 0 ... N - 1 at out[f N],
+// bin k being the frequency k / N cycles per sample, so negative
+// frequencies come after N / 2. The bins are not normalized. The scaled
+// outputs are |X| and 20 log10(|X|), which is 10 log10 of the power without
+// its overflow; zero bins give the dB of the smallest normal T.
+//
+// transform() is a stream like c10::fir_decimator: it takes the next n
+// inputs and writes the output_frames(n) frames they complete, so any
+// chunking gives the same frames. It keeps at most W + stft_chunk inputs,
+// so memory does not grow with the length of the stream; the frames of a
+// call go to the caller's buffer, so long captures should be given in
+// chunks.
+//
+// The frames of a call are computed in parallel with c10::parallel_for, at
+// least stft_grain bins per thread. Each is windowed while the FFT permutes
+// its input, see fft_plan::forward_windowed, directly into out for complex
+// bins, and into a buffer per thread for the scaled ones.
+
+namespace c10 {
+
+enum class window_kind { rectangular, hann, hamming, blackman };
+
+enum class spectrogram_scale { magnitude, power_db };
+
+// Inputs copied into the buffer of an STFT at once
+constexpr int64_t stft_chunk = 1 << 16;
+
+// Bins computed by each thread of an STFT at least
+constexpr int64_t stft_grain = 1 << 16;
+
+// The periodic window of the given length, which is what STFTs use: the
+// symmetric window of length + 1 without its last value
+template<typename T>
+std::vector<T> fft_window(window_kind kind, int64_t length) {
+  if (length <= 0) {
+    throw std::invalid_argument("c10::fft_window: the length must be positive");
+  }
+  const double pi = 3.14159265358979323846;
+  std::vector<T> w(length);
+  for (int64_t k = 0; k < length; k++) {
+    const double a = 2 * pi * static_cast<double>(k) / static_cast<double>(length);
+    double v = 1;
+    switch (kind) {
+      case window_kind::rectangular: v = 1; break;
+      case window_kind::hann: v = 0.5 - 0.5 * std::cos(a); break;
+      case window_kind::hamming: v = 0.54 - 0.46 * std::cos(a); break;
+      case window_kind::blackman: v = 0.42 - 0.5 * std::cos(a) + 0.08 * std::cos(2 * a); break;
+    }
+    w[k] = static_cast<T>(v);
+  }
+  return w;
+}
+
+namespace detail {
+
+// out[k] = |x[k]|, or 20 log10 |x[k]| if Decibels is true. The parts are
+// scaled by the power of two 2^-e that brings the larger into [1, 2), so
+// that their squares neither overflow nor underflow, and
+//
+//   |x| = 2^e sqrt(p),  20 log10 |x| = 20 / ln(10) (log(p) / 2 + e ln(2))
+//
+// with p the sum of the scaled squares; decibels need no square root.
+template<bool Decibels, typename T>
+void spectrogram_scale_bins(const complex<T>* x, T* out, int64_t n) {
+  using traits = vec_math::float_traits<T>;
+  using int_t = typename traits::int_t;
+  constexpr int W = vec_math::lanes<T>::value;
+  constexpr T db = T(8.6858896380650365530225783783321);  // 20 / ln(10)
+  constexpr T ln2 = T(0.69314718055994530941723212145818);
+  constexpr T bias = traits::exponent_bias;
+  const T zero_db = db * std::log(std::numeric_limits<T>::min());
+  for (int64_t i = 0; i < n; i += W) {
+    const int count = n - i < W ? static_cast<int>(n - i) : W;
+    T re[W], im[W], y[W];
+    if (count == W) {
+      C10_VEC_LOOP
+      for (int l = 0; l < W; l++) {
+        re[l] = x[i + l].real();
+        im[l] = x[i + l].imag();
+      }
+    } else {
+      for (int l = 0; l < W; l++) {
+        re[l] = l < count ? x[i + l].real() : T(1);
+        im[l] = l < count ? x[i + l].imag() : T(0);
+      }
+    }
+    C10_VEC_LOOP
+    for (int l = 0; l < W; l++) {
+      const T a = vec_math::abs(re[l]), b = vec_math::abs(im[l]);
+      const T big = vec_math::max(a, b);
+      // the exponent of big, clamped to the normal range for zeros,
+      // subnormals and infinities
+      const T exponent = static_cast<T>(static_cast<int_t>(vec_math::to_bits(big) >> traits::mantissa_bits)) - bias;
+      const T e = vec_math::max(T(1) - bias, vec_math::min(bias - T(1), exponent));
+      const T scale = vec_math::pow2(-e);
+      const T p = (a * scale) * (a * scale) + (b * scale) * (b * scale);
+      T v;
+      if (Decibels) {
+        v = vec_math::select(big == T(0), zero_db,
+          db * (T(0.5) * vec_math::log(vec_math::select(big == T(0), T(1), p)) + ln2 * e));
+      } else {
+        v = vec_math::ldexp(vec_math::sqrt(p), e);
+      }
+      // infinite and NaN parts are passed through, infinities first
+      constexpr T inf = std::numeric_limits<T>::infinity();
+      const T special = vec_math::select(a == inf, a, vec_math::select(b == inf, b, a + b));
+      y[l] = vec_math::select(vec_math::is_finite(a), vec_math::select(vec_math::is_finite(b), v, special), special);
+    }
+    std::copy(y, y + count, out + i);
+  }
+}
+
+template<typename T>
+void spectrogram_scale_bins(const complex<T>* x, T* out, int64_t n, spectrogram_scale scale) {
+  if (scale == spectrogram_scale::power_db) {
+    spectrogram_scale_bins<true>(x, out, n);
+  } else {
+    spectrogram_scale_bins<false>(x, out, n);
+  }
+}
+
+} // namespace detail
+
+// Short-time Fourier transform of a stream, see [STFT]
+template<typename T>
+class stft {
+ public:
+  using value_type = complex<T>;
+
+  stft() = default;
+
+  // fft_size is at least the window size, or 0 for the window size
+  stft(span<const T> window, int64_t hop, int64_t fft_size = 0)
+    : window_(window.data(), window.data() + window.size()), hop_(hop) {
+    static_assert(std::is_same<T, float>::value || std::is_same<T, double>::value,
+      "STFTs only support c10::complex<float> and c10::complex<double>");
+    if (window.size() == 0 || hop <= 0) {
+      throw std::invalid_argument("c10::stft: the window and the hop must not be empty");
+    }
+    if (fft_size == 0) {
+      fft_size = window.size();
+    }
+    if (fft_size < window.size()) {
+      throw std::invalid_argument("c10::stft: the FFT size must be at least the window size");
+    }
+    plan_ = fft_plan<T>(fft_size);
+    buffer_.resize(window.size() + std::max(hop, stft_chunk));
+  }
+
+  stft(window_kind kind, int64_t window_size, int64_t hop, int64_t fft_size = 0) {
+    const std::vector<T> window = fft_window<T>(kind, window_size);
+    *this = stft(span<const T>(window), hop, fft_size);
+  }
+
+  // Number of frames that the next n inputs complete
+  int64_t output_frames(int64_t n) const {
+    if (n <= skip_) {
+      return 0;
+    }
+    return frames_in(buffered_ + n - skip_);
+  }
+
+  // Transforms the next n inputs into the output_frames(n) frames they
+  // complete, each of fft_size() complex bins, and returns their number
+  int64_t transform(const value_type* x, int64_t n, value_type* out) {
+    return run(x, n, [&](const value_type* frame, int64_t f, value_type*) {
+      plan_.forward_windowed(frame, window_.data(), window_.size(), out + f * fft_size());
+    }, false);
+  }
+
+  // Like transform(), with the magnitudes or decibels of the bins
+  int64_t transform(const value_type* x, int64_t n, T* out, spectrogram_scale scale) {
+    return run(x, n, [&](const value_type* frame, int64_t f, value_type* work) {
+      plan_.forward_windowed(frame, window_.data(), window_.size(), work);
+      detail::spectrogram_scale_bins(work, out + f * fft_size(), fft_size(), scale);
+    }, true);
+  }
+
+  void reset() {
+    buffered_ = 0;
+    skip_ = 0;
+  }
+
+  int64_t window_size() const {
+    return window_.size();
+  }
+
+  int64_t hop() const {
+    return hop_;
+  }
+
+  int64_t fft_size() const {
+    return plan_.size();
+  }
+
+ private:
+  int64_t frames_in(int64_t inputs) const {
+    const int64_t W = window_.size();
+    return inputs < W ? 0 : (inputs - W) / hop_ + 1;
+  }
+
+  // Buffers the inputs and calls frame_fn(first input, index, work) for
+  // each frame they complete, in parallel
+  template<typename FrameFn>
+  int64_t run(const value_type* x, int64_t n, const FrameFn& frame_fn, bool needs_work) {
+    const int64_t N = fft_size();
+    int64_t frames = 0;
+    int64_t i = std::min(skip_, n);
+    skip_ -= i;
+    while (i < n) {
+      const int64_t count = std::min<int64_t>(n - i, buffer_.size() - buffered_);
+      std::copy(x + i, x + i + count, buffer_.begin() + buffered_);
+      buffered_ += count;
+      i += count;
+      const int64_t ready = frames_in(buffered_);
+      parallel_for(0, ready, std::max<int64_t>(1, stft_grain / N), [&](int64_t begin, int64_t end) {
+        std::vector<value_type> work(needs_work ? N : 0);
+        for (int64_t f = begin; f < end; f++) {
+          frame_fn(buffer_.data() + f * hop_, frames + f, work.data());
+        }
+      });
+      frames += ready;
+      // drop the inputs before the next frame, which may be past the buffer
+      const int64_t consumed = ready * hop_;
+      if (consumed >= buffered_) {
+        const int64_t skipped = std::min(consumed - buffered_, n - i);
+        i += skipped;
+        skip_ = consumed - buffered_ - skipped;
+        buffered_ = 0;
+      } else {
+        std::copy(buffer_.begin() + consumed, buffer_.begin() + buffered_, buffer_.begin());
+        buffered_ -= consumed;
+      }
+    }
+    return frames;
+  }
+
+  std::vector<T> window_;
+  int64_t hop_ = 1;
+  fft_plan<T> plan_;
+  std::vector<value_type> buffer_;  // inputs from the start of the next frame
+  int64_t buffered_ = 0;
+  int64_t skip_ = 0;  // inputs before the next frame not yet seen
+};
+
+} // namespace c10
@@ -0,0 +1,593 @@
+#pragma once
+
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <limits>
+
+// Branch-free real math kernels used by the bulk complex functions in
+// c10/util/complex_bulk.h
+//
+// Every function in this file is a plain inline function of scalars that
+// contains no branches and no calls into libm, so that a loop applying it to
+// a fixed number of lanes is vectorized by the compiler. Values that the fast
+// path does not handle (infinities, NaNs, huge arguments of sin/cos, ...) are
+// reported by the *_fast_ok predicates, and callers recompute those lanes
+// with the scalar functions in c10/util/complex_math.h.
+//
+// The polynomial and rational approximations are those of the Cephes math
+// library (http://www.netlib.org/cephes/).
+
+// The lane functions must be inlined into the lane loops to be vectorized
+#if defined(__GNUC__) || defined(__clang__)
+#define C10_VEC_INLINE inline __attribute__((always_inline))
+#else
+#define C10_VEC_INLINE inline
+#endif
+
+#if defined(__clang__)
+#define C10_VEC_LOOP _Pragma("clang loop vectorize(enable) interleave(enable)")
+#elif defined(__GNUC__) && !defined(__CUDACC__)
+#define C10_VEC_LOOP _Pragma("GCC ivdep")
+#else
+#define C10_VEC_LOOP
+#endif
+
+namespace c10 {
+namespace vec_math {
+
+// Number of lanes processed together by the bulk kernels: 64 bytes of real
+// values, i.e. a full AVX-512 register, or two AVX2 / four SSE registers.
+template<typename T>
+struct lanes {
+  static constexpr int value = 64 / sizeof(T);
+};
+
+template<typename T>
+struct float_traits;
+
+template<>
+struct float_traits<float> {
+  using int_t = int32_t;
+  using uint_t = uint32_t;
+  static constexpr int mantissa_bits = 23;
+  static constexpr int exponent_bias = 127;
+  // adding and subtracting this rounds a value with |v| < 2^22 to an integer
+  static constexpr float round_magic = 12582912.0f;  // 1.5 * 2^23
+};
+
+template<>
+struct float_traits<double> {
+  using int_t = int64_t;
+  using uint_t = uint64_t;
+  static constexpr int mantissa_bits = 52;
+  static constexpr int exponent_bias = 1023;
+  static constexpr double round_magic = 6755399441055744.0;  // 1.5 * 2^52
+};
+
+template<typename T>
+C10_VEC_INLINE typename float_traits<T>::uint_t to_bits(T x) {
+  typename float_traits<T>::uint_t i;
+  std::memcpy(&i, &x, sizeof(T));
+  return i;
+}
+
+template<typename T>
+C10_VEC_INLINE T from_bits(typename float_traits<T>::uint_t i) {
+  T x;
+  std::memcpy(&x, &i, sizeof(T));
+  return x;
+}
+
+
+// mask ? a : b, written as a bitwise blend so that it never becomes a branch
+template<typename T>
+C10_VEC_INLINE T select(bool mask, T a, T b) {
+  using uint_t = typename float_traits<T>::uint_t;
+  uint_t m = uint_t(0) - static_cast<uint_t>(mask);
+  return from_bits<T>((to_bits(a) & m) | (to_bits(b) & ~m));
+}
+
+template<typename T>
+C10_VEC_INLINE T abs(T x) {
+  return from_bits<T>(to_bits(x) & ~(typename float_traits<T>::uint_t(1) << (sizeof(T) * 8 - 1)));
+}
+
+template<typename T>
+C10_VEC_INLINE T copysign(T magnitude, T sign) {
+  using uint_t = typename float_traits<T>::uint_t;
+  constexpr uint_t sign_bit = uint_t(1) << (sizeof(T) * 8 - 1);
+  return from_bits<T>((to_bits(magnitude) & ~sign_bit) | (to_bits(sign) & sign_bit));
+}
+
+template<typename T>
+C10_VEC_INLINE bool signbit(T x) {
+  return (to_bits(x) >> (sizeof(T) * 8 - 1)) != 0;
+}
+
+template<typename T>
+C10_VEC_INLINE T min(T a, T b) {
+  return select(a < b, a, b);
+}
+
+template<typename T>
+C10_VEC_INLINE T max(T a, T b) {
+  return select(a > b, a, b);
+}
+
+template<typename T>
+C10_VEC_INLINE bool is_finite(T x) {
+  return abs(x) <= std::numeric_limits<T>::max();
+}
+
+// a * b + c, fused when the target has FMA instructions. Otherwise std::fma
+// is a slow library call that keeps the loop from being vectorized, so the
+// product is rounded before the addition.
+template<typename T>
+C10_VEC_INLINE T fma(T a, T b, T c) {
+#if defined(__FP_FAST_FMA) || defined(__FMA__)
+  return std::fma(a, b, c);
+#else
+  return a * b + c;
+#endif
+}
+
+// Round to the nearest integer, valid for |x| < 2^(mantissa_bits - 1)
+template<typename T>
+C10_VEC_INLINE T round_int(T x) {
+  const T magic = float_traits<T>::round_magic;
+  return (x + magic) - magic;
+}
+
+// 2^n for an integer valued n in the normal exponent range
+template<typename T>
+C10_VEC_INLINE T pow2(T n) {
+  using traits = float_traits<T>;
+  using int_t = typename traits::int_t;
+  using uint_t = typename traits::uint_t;
+  return from_bits<T>(static_cast<uint_t>(static_cast<int_t>(n) + traits::exponent_bias) << traits::mantissa_bits);
+}
+
+// x * 2^n for an integer valued n in [-2 * (bias - 1), 2 * bias], split into
+// two multiplications so that overflow and gradual underflow happen only
+// in the final result, never in the scale factor
+template<typename T>
+C10_VEC_INLINE T ldexp(T x, T n) {
+  constexpr T lo = -2 * (float_traits<T>::exponent_bias - 1);
+  constexpr T hi = 2 * float_traits<T>::exponent_bias;
+  n = max(lo, min(hi, n));
+  T n1 = round_int(n * T(0.5));
+  T n2 = n - n1;
+  return x * pow2(n1) * pow2(n2);
+}
+
+// [Square root]
+//
+// std::sqrt may set errno, so unless errno is disabled (-fno-math-errno or
+// -ffast-math) compilers emit a branch around the sqrt instruction, which
+// keeps the loop from being vectorized. In that case we compute it from an
+// inverse square root estimate refined by Newton iterations, followed by a
+// correction step with the exact residual m - s^2, which is correctly
+// rounded except in rare halfway cases.
+
+template<typename T>
+struct sqrt_consts;
+template<>
+struct sqrt_consts<float> {
+  static constexpr uint32_t rsqrt_magic = 0x5f3759dfu;
+  static constexpr int newton_steps = 3;
+  static constexpr float split = 4097.0f;  // 2^12 + 1, for Dekker's exact product
+};
+template<>
+struct sqrt_consts<double> {
+  static constexpr uint64_t rsqrt_magic = 0x5fe6eb50c7b537a9ull;
+  static constexpr int newton_steps = 4;
+  static constexpr double split = 134217729.0;  // 2^27 + 1
+};
+
+// hi + lo = a * b exactly. With hardware FMA this is one fma; otherwise use
+// Dekker's splitting (which must not be used when the compiler is allowed to
+// contract a * b - c into an fma, as it does when FMA is available).
+template<typename T>
+C10_VEC_INLINE T two_product(T a, T b, T& lo) {
+  T hi = a * b;
+#if defined(__FP_FAST_FMA) || defined(__FMA__)
+  lo = std::fma(a, b, -hi);
+#else
+  T ca = sqrt_consts<T>::split * a;
+  T a_hi = ca - (ca - a);
+  T a_lo = a - a_hi;
+  T cb = sqrt_consts<T>::split * b;
+  T b_hi = cb - (cb - b);
+  T b_lo = b - b_hi;
+  lo = ((a_hi * b_hi - hi) + a_hi * b_lo + a_lo * b_hi) + a_lo * b_lo;
+#endif
+  return hi;
+}
+
+// For a positive normal x, returns m in [1, 4) and sets half_exp such that
+// x = m * 2^(2k) with k = half_exp - (bias + 1) / 2. Only unsigned integer
+// operations are used: 64 bit arithmetic shifts and conversions between
+// int64_t and double are not available before AVX-512, and would keep the
+// double loops from being vectorized on older targets.
+template<typename T>
+C10_VEC_INLINE T split_even_exponent(T x, typename float_traits<T>::uint_t& half_exp) {
+  using traits = float_traits<T>;
+  using uint_t = typename traits::uint_t;
+  constexpr uint_t mantissa_mask = (uint_t(1) << traits::mantissa_bits) - 1;
+  uint_t bits = to_bits(x);
+  uint_t biased = bits >> traits::mantissa_bits;
+  half_exp = (biased + 1) >> 1;
+  // the biased exponent of m is biased - 2k
+  uint_t m_biased = biased - 2 * half_exp + traits::exponent_bias + 1;
+  return from_bits<T>((bits & mantissa_mask) | (m_biased << traits::mantissa_bits));
+}
+
+// 2^k for the k of split_even_exponent
+template<typename T>
+C10_VEC_INLINE T pow2_half_exp(typename float_traits<T>::uint_t half_exp) {
+  using traits = float_traits<T>;
+  return from_bits<T>((half_exp + (traits::exponent_bias - 1) / 2) << traits::mantissa_bits);
+}
+
+template<typename T>
+C10_VEC_INLINE T sqrt(T x) {
+#if defined(__NO_MATH_ERRNO__) || defined(__FAST_MATH__)
+  return std::sqrt(x);
+#else
+  using traits = float_traits<T>;
+  using uint_t = typename traits::uint_t;
+  // scale subnormals by an even power of two
+  constexpr int sub_shift = traits::mantissa_bits + (traits::mantissa_bits & 1);
+  constexpr T subnormal_scale = T(uint64_t(1) << sub_shift);
+  constexpr T subnormal_unscale = T(1) / T(uint64_t(1) << (sub_shift / 2));
+  bool subnormal = x < std::numeric_limits<T>::min();
+  T xs = select(subnormal, x * subnormal_scale, x);
+  // xs = m * 2^(2k) with m in [1, 4)
+  uint_t half_exp;
+  T m = split_even_exponent(xs, half_exp);
+  // y ~ 1 / sqrt(m)
+  T y = from_bits<T>(static_cast<uint_t>(sqrt_consts<T>::rsqrt_magic - (to_bits(m) >> 1)));
+  for (int i = 0; i < sqrt_consts<T>::newton_steps; i++) {
+    y = y * (T(1.5) - T(0.5) * m * y * y);
+  }
+  T root = m * y;
+  T lo;
+  T hi = two_product(root, root, lo);
+  root = root + T(0.5) * y * ((m - hi) - lo);
+  root = root * pow2_half_exp<T>(half_exp) * select(subnormal, subnormal_unscale, T(1));
+  // zeros, infinities, negative numbers and NaN
+  root = select(x == T(0), x, root);
+  root = select(x == std::numeric_limits<T>::infinity(), x, root);
+  return select(x >= T(0), root, std::numeric_limits<T>::quiet_NaN());
+#endif
+}
+
+// sqrt(a^2 + b^2) for values whose squares neither overflow nor underflow
+template<typename T>
+C10_VEC_INLINE T hypot_unsafe(T a, T b) {
+  return sqrt(a * a + b * b);
+}
+
+// [Exponential]
+//
+// exp(x) = p * 2^n where n = round(x / ln2) and p = exp(x - n ln2). The
+// complex kernels keep p and n separate and scale only the final products,
+// so e^a * cos(b) does not overflow when e^a alone would. That requires n to
+// be in the range of ldexp, i.e. |x| <= exp_limit.
+
+template<typename T>
+struct exp_limit;
+template<>
+struct exp_limit<float> {
+  static constexpr float value = 170.0f;
+};
+template<>
+struct exp_limit<double> {
+  static constexpr double value = 1400.0;
+};
+
+template<typename T>
+C10_VEC_INLINE bool exp_fast_ok(T x) {
+  return abs(x) <= exp_limit<T>::value;
+}
+
+C10_VEC_INLINE float exp_mantissa(float x, float& n) {
+  const float ln2_hi = 0.693359375f;
+  const float ln2_lo = -2.12194440e-4f;
+  x = max(-200.0f, min(200.0f, x));
+  n = round_int(x * 1.44269504088896341f);
+  float r = x - n * ln2_hi - n * ln2_lo;
+  float z = r * r;
+  float p = 1.9875691500E-4f;
+  p = p * r + 1.3981999507E-3f;
+  p = p * r + 8.3334519073E-3f;
+  p = p * r + 4.1665795894E-2f;
+  p = p * r + 1.6666665459E-1f;
+  p = p * r + 5.0000001201E-1f;
+  return p * z + r + 1.0f;
+}
+
+C10_VEC_INLINE double exp_mantissa(double x, double& n) {
+  const double ln2_hi = 6.93145751953125E-1;
+  const double ln2_lo = 1.42860682030941723212E-6;
+  x = max(-1500.0, min(1500.0, x));
+  n = round_int(x * 1.4426950408889634073599);
+  double r = x - n * ln2_hi - n * ln2_lo;
+  double rr = r * r;
+  double px = r * ((1.26177193074810590878E-4 * rr + 3.02994407707441961300E-2) * rr + 9.99999999999999999910E-1);
+  double qx = ((3.00198505138664455042E-6 * rr + 2.52448340349684104192E-3) * rr + 2.27265548208155028766E-1) * rr
+      + 2.00000000000000000009E0;
+  return 1.0 + 2.0 * (px / (qx - px));
+}
+
+template<typename T>
+C10_VEC_INLINE T exp(T x) {
+  T n;
+  T p = exp_mantissa(x, n);
+  return ldexp(p, n);
+}
+
+// [Logarithm]
+//
+// For a positive finite x, write x = m * 2^e with m in [sqrt(1/2), sqrt(2)),
+// then log(x) = log1p(m - 1) + e * ln2.
+
+template<typename T>
+C10_VEC_INLINE T frexp_sqrt2(T x, T& e) {
+  using traits = float_traits<T>;
+  using uint_t = typename traits::uint_t;
+  using int_t = typename traits::int_t;
+  // scale subnormals into the normal range first
+  constexpr T subnormal_scale = T(uint64_t(1) << traits::mantissa_bits);
+  bool subnormal = x < std::numeric_limits<T>::min();
+  x = select(subnormal, x * subnormal_scale, x);
+  T e_adjust = select(subnormal, -T(traits::mantissa_bits), T(0));
+  constexpr uint_t mantissa_mask = (uint_t(1) << traits::mantissa_bits) - 1;
+  constexpr uint_t half_exponent = uint_t(traits::exponent_bias - 1) << traits::mantissa_bits;
+  uint_t bits = to_bits(x);
+  // m in [0.5, 1)
+  T m = from_bits<T>((bits & mantissa_mask) | half_exponent);
+  T ex = T(static_cast<int_t>(bits >> traits::mantissa_bits) - (traits::exponent_bias - 1)) + e_adjust;
+  bool small = m < T(0.70710678118654752440);
+  e = select(small, ex - T(1), ex);
+  return select(small, m + m, m);
+}
+
+// log(1 + x) for x in [sqrt(1/2) - 1, sqrt(2) - 1), without the e * ln2 term
+C10_VEC_INLINE float log1p_reduced(float x, float e) {
+  float z = x * x;
+  float y = 7.0376836292E-2f;
+  y = y * x - 1.1514610310E-1f;
+  y = y * x + 1.1676998740E-1f;
+  y = y * x - 1.2420140846E-1f;
+  y = y * x + 1.4249322787E-1f;
+  y = y * x - 1.6668057665E-1f;
+  y = y * x + 2.0000714765E-1f;
+  y = y * x - 2.4999993993E-1f;
+  y = y * x + 3.3333331174E-1f;
+  y = y * x * z;
+  y += -2.12194440e-4f * e;
+  y += -0.5f * z;
+  return x + y + 0.693359375f * e;
+}
+
+C10_VEC_INLINE double log1p_reduced(double x, double e) {
+  double z = x * x;
+  double p = 1.01875663804580931796E-4;
+  p = p * x + 4.97494994976747001425E-1;
+  p = p * x + 4.70579119878881725854E0;
+  p = p * x + 1.44989225341610930846E1;
+  p = p * x + 1.79368678507819816313E1;
+  p = p * x + 7.70838733755885391666E0;
+  double q = x + 1.12873587189167450590E1;
+  q = q * x + 4.52279145837532221105E1;
+  q = q * x + 8.29875266912776603211E1;
+  q = q * x + 7.11544750618563894466E1;
+  q = q * x + 2.31251620126765340583E1;
+  double y = x * (z * p / q);
+  y -= e * 2.121944400546905827679e-4;
+  y -= 0.5 * z;
+  return x + y + e * 0.693359375;
+}
+
+// log(x) for positive finite x
+template<typename T>
+C10_VEC_INLINE T log(T x) {
+  T e;
+  T m = frexp_sqrt2(x, e);
+  return log1p_reduced(m - T(1), e);
+}
+
+// log(1 + x) for x > -1, accurate also for tiny x
+template<typename T>
+C10_VEC_INLINE T log1p(T x) {
+  T w = T(1) + x;
+  T d = w - T(1);
+  // log(w) * x / (w - 1) corrects for the rounding error of 1 + x
+  return select(d == T(0), x, log(w) * (x / d));
+}
+
+// [Trigonometric]
+//
+// x is reduced to r = x - q * pi/2 with |r| <= pi/4 using pi/2 split into
+// three parts (Cody-Waite). This is accurate for |x| below sincos_limit,
+// larger arguments need a Payne-Hanek reduction and take the slow path.
+
+template<typename T>
+struct sincos_limit;
+template<>
+struct sincos_limit<float> {
+  static constexpr float value = 8192.0f;
+};
+template<>
+struct sincos_limit<double> {
+  static constexpr double value = 1048576.0;
+};
+
+template<typename T>
+C10_VEC_INLINE bool sincos_fast_ok(T x) {
+  return abs(x) <= sincos_limit<T>::value;
+}
+
+C10_VEC_INLINE float sin_poly(float r, float z) {
+  float y = -1.9515295891E-4f;
+  y = y * z + 8.3321608736E-3f;
+  y = y * z - 1.6666654611E-1f;
+  return r + r * z * y;
+}
+
+C10_VEC_INLINE float cos_poly(float z) {
+  float y = 2.443315711809948E-5f;
+  y = y * z - 1.388731625493765E-3f;
+  y = y * z + 4.166664568298827E-2f;
+  return 1.0f - 0.5f * z + z * z * y;
+}
+
+C10_VEC_INLINE double sin_poly(double r, double z) {
+  double y = 1.58962301576546568060E-10;
+  y = y * z - 2.50507477628578072866E-8;
+  y = y * z + 2.75573136213857245213E-6;
+  y = y * z - 1.98412698295895385996E-4;
+  y = y * z + 8.33333333332211858878E-3;
+  y = y * z - 1.66666666666666307295E-1;
+  return r + r * z * y;
+}
+
+C10_VEC_INLINE double cos_poly(double z) {
+  double y = -1.13585365213876817300E-11;
+  y = y * z + 2.08757008419747316778E-9;
+  y = y * z - 2.75573141792967388112E-7;
+  y = y * z + 2.48015872888517045348E-5;
+  y = y * z - 1.38888888888730564116E-3;
+  y = y * z + 4.16666666666665929218E-2;
+  return 1.0 - 0.5 * z + z * z * y;
+}
+
+template<typename T>
+struct pio2_parts;
+template<>
+struct pio2_parts<float> {
+  static constexpr float p1 = 1.5703125f;
+  static constexpr float p2 = 4.837512969970703125e-4f;
+  static constexpr float p3 = 7.54978995489188216e-8f;
+};
+template<>
+struct pio2_parts<double> {
+  static constexpr double p1 = 1.57079625129699707031E0;
+  static constexpr double p2 = 7.54978941586159635335E-8;
+  static constexpr double p3 = 5.39030285815811905290E-15;
+};
+
+// sin(x) and cos(x) together, sharing the argument reduction
+template<typename T>
+C10_VEC_INLINE void sincos(T x, T& s, T& c) {
+  using traits = float_traits<T>;
+  using int_t = typename traits::int_t;
+  x = select(sincos_fast_ok(x), x, T(0));
+  T q = round_int(x * T(0.63661977236758134308));
+  T r = ((x - q * pio2_parts<T>::p1) - q * pio2_parts<T>::p2) - q * pio2_parts<T>::p3;
+  T z = r * r;
+  T sr = sin_poly(r, z);
+  T cr = cos_poly(z);
+  int_t quadrant = static_cast<int_t>(q) & 3;
+  bool swap = (quadrant & 1) != 0;
+  T s0 = select(swap, cr, sr);
+  T c0 = select(swap, sr, cr);
+  s = select((quadrant & 2) != 0, -s0, s0);
+  c = select(((quadrant + 1) & 2) != 0, -c0, c0);
+}
+
+// [Hyperbolic]
+//
+// For |x| >= 1, sinh and cosh are computed from e^|x| (see exp_mantissa);
+// below that, sinh(x) = (e^x - e^-x) / 2 cancels and a polynomial is used.
+
+C10_VEC_INLINE float sinh_poly(float x) {
+  float z = x * x;
+  return ((2.03721912945E-4f * z + 8.33028376239E-3f) * z + 1.66667160211E-1f) * z * x + x;
+}
+
+C10_VEC_INLINE double sinh_poly(double x) {
+  double z = x * x;
+  double p = -7.89474443963537015605E-1;
+  p = p * z - 1.63725857525983828727E2;
+  p = p * z - 1.15614435765005216044E4;
+  p = p * z - 3.51754964808151394800E5;
+  double q = z - 2.77711081420602794433E2;
+  q = q * z + 3.61578279834431989373E4;
+  q = q * z - 2.11052978884890840399E6;
+  return x + x * z * (p / q);
+}
+
+// Beyond this |x|, tanh(x) rounds to +-1 and 1 - tanh(x)^2 ~ 4 e^(-2|x|)
+template<typename T>
+struct tanh_limit;
+template<>
+struct tanh_limit<float> {
+  static constexpr float value = 10.0f;
+};
+template<>
+struct tanh_limit<double> {
+  static constexpr double value = 20.0;
+};
+
+// [Inverse tangent]
+
+// atan(t) for t in [0, 1]
+C10_VEC_INLINE float atan_unit(float t) {
+  bool reduce = t > 0.4142135623730950f;
+  float x = select(reduce, (t - 1.0f) / (t + 1.0f), t);
+  float z = x * x;
+  float y = 8.05374449538e-2f;
+  y = y * z - 1.38776856032E-1f;
+  y = y * z + 1.99777106478E-1f;
+  y = y * z - 3.33329491539E-1f;
+  y = y * z * x + x;
+  return select(reduce, y + 0.78539816339744830962f, y);
+}
+
+C10_VEC_INLINE double atan_unit(double t) {
+  bool reduce = t > 0.66;
+  double x = select(reduce, (t - 1.0) / (t + 1.0), t);
+  double z = x * x;
+  double p = -8.750608600031904122785E-1;
+  p = p * z - 1.615753718733365076637E1;
+  p = p * z - 7.500855792314704667340E1;
+  p = p * z - 1.228866684490136173410E2;
+  p = p * z - 6.485021904942025371773E1;
+  double q = z + 2.485846490142306297962E1;
+  q = q * z + 1.650270098316988542046E2;
+  q = q * z + 4.328810604912902668951E2;
+  q = q * z + 4.853903996359136964868E2;
+  q = q * z + 1.945506571482613964425E2;
+  double y = x * (z * p / q) + x;
+  // pi/4 split into a head and the bits that do not fit in a double
+  return select(reduce, (y + 3.06161699786838294307E-17) + 7.85398163397448309616E-1, y);
+}
+
+// atan2(y, x) given the ratio of the smaller to the larger of |x| and |y|.
+// The complex logarithm reuses this ratio for log|z|, so it is computed once.
+template<typename T>
+C10_VEC_INLINE T atan2_from_ratio(T y, T x, T ratio, bool y_larger) {
+  const T pio2 = T(1.57079632679489661923);
+  const T pi = T(3.14159265358979323846);
+  T a = atan_unit(ratio);
+  a = select(y_larger, pio2 - a, a);
+  a = select(signbit(x), pi - a, a);
+  return copysign(a, y);
+}
+
+template<typename T>
+C10_VEC_INLINE T atan2(T y, T x) {
+  T ax = abs(x);
+  T ay = abs(y);
+  bool y_larger = ay > ax;
+  T hi = max(ax, ay);
+  T lo = min(ax, ay);
+  T ratio = select(hi == T(0), T(0), lo / hi);
+  return atan2_from_ratio(y, x, ratio, y_larger);
+}
+
+} // namespace vec_math
+} // namespace c10